@@ -20,6 +20,7 @@
 #include "engine/core/render/base/ShaderProgram.h"
 #include "engine/core/render/base/editor/shader/shader_editor.h"
 #include "engine/core/render/base/TextureCube.h"
+#include "engine/core/render/base/TextureVideo.h"
 #include "engine/core/scene/render_node.h"
 #include "engine/core/scene/node_tree.h"
 #include "engine/core/util/Timer.h"
@@ -149,6 +150,7 @@ namespace Echo
 		Class::registerType<Mesh>();
 		Class::registerType<LuaScript>();
 		Class::registerType<TextureCube>();
+		Class::registerType<TextureVideo>();
 		Class::registerType<GameSettings>();
 		Class::registerType<Gizmos>();
 		Class::registerType<Input>();
@@ -321,6 +323,7 @@ namespace Echo
 		// update logic
 		Module::updateAll(m_frameTime);
 		NodeTree::instance()->update(m_frameTime);
+		Module::lateUpdateAll(m_frameTime);
 
 		// input update
 		Input::instance()->update();
@@ -23,6 +23,9 @@ namespace Echo
         // update this module
 		virtual void update(float elapsedTime) {}
 
+		// update this module after the node tree, work kicked here can overlap rendering
+		virtual void lateUpdate(float elapsedTime) {}
+
 		// enable
 		virtual void setEnable(bool isEnable) { m_isEnable = isEnable; }
 		bool isEnable() const { return m_isEnable; }
@@ -48,6 +51,7 @@ namespace Echo
 
 		// update all modules every frame(ms)
 		static void updateAll(float elapsedTime);
+		static void lateUpdateAll(float elapsedTime);
         
         // clear all
         static void clear();
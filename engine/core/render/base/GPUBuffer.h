@@ -41,6 +41,9 @@ namespace Echo
 		virtual ~GPUBuffer();
 
 		virtual bool updateData(const Buffer& buff) = 0;
+
+		// overwrite [offset, offset + size) of the current data, false if the backend can't
+		virtual bool updateSubData(ui32 offset, const Buffer& buff) { return false; }
 		virtual ui32 getSize() const { return m_size; }
 
 	protected:
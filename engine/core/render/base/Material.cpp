@@ -68,6 +68,7 @@ namespace Echo
 			}
 			else
 			{
+				m_atla = nullptr;
 				m_texture = (Texture*)Res::get(path);
 			}
 		}
@@ -92,6 +93,7 @@ namespace Echo
 
 	Texture* Material::UniformTextureValue::setTexture(TexturePtr texture)
 	{
+		m_atla = nullptr;
 		m_texture = texture;
 		return m_texture;
 	}
@@ -33,6 +33,9 @@ namespace Echo
 			// texture
 			virtual Texture* setTexture(const String& uri) { return nullptr; }
 			virtual Texture* setTexture(TexturePtr texture) { return nullptr; }
+
+			// atla, if texture is a part of an atlas
+			virtual TextureAtla* getAtla() { return nullptr; }
 		};
 
 		struct UniformNormalValue : public UniformValue
@@ -70,6 +73,9 @@ namespace Echo
 			// texture
 			virtual Texture* setTexture(const String& uri) override;
 			virtual Texture* setTexture(TexturePtr texture) override;
+
+			// atla
+			virtual TextureAtla* getAtla() override { getTexture(); return m_atla; }
 		};
 		typedef map<String, UniformValue*>::type UniformValueMap;
 
@@ -44,6 +44,11 @@ precision mediump float;
 layout(binding = 0) uniform UBO
 {
     float u_Alpha;
+#ifdef SDF
+    float u_SdfSmoothing;
+    float u_SdfOutline;
+    vec4  u_SdfOutlineColor;
+#endif
 } fs_ubo;
 
 // uniforms
@@ -60,6 +65,16 @@ void main(void)
     vec4 textureColor = texture(BaseColor, v_TexCoord);
     vec4 finalColor = textureColor;
 
+#ifdef SDF
+    // distance is stored in alpha, 0.5 is the glyph edge
+    float distance = textureColor.a;
+    float fillAlpha = smoothstep(0.5 - fs_ubo.u_SdfSmoothing, 0.5 + fs_ubo.u_SdfSmoothing, distance);
+    float outlineEdge = 0.5 - fs_ubo.u_SdfOutline;
+    float outlineAlpha = smoothstep(outlineEdge - fs_ubo.u_SdfSmoothing, outlineEdge + fs_ubo.u_SdfSmoothing, distance) * fs_ubo.u_SdfOutlineColor.a;
+    finalColor.a = max(fillAlpha, outlineAlpha);
+    finalColor.rgb = mix(fs_ubo.u_SdfOutlineColor.rgb, textureColor.rgb, fillAlpha / max(finalColor.a, 0.0001));
+#endif
+
 #ifdef ALPHA_ADJUST
     finalColor.a = finalColor.a * fs_ubo.u_Alpha;
 #endif
@@ -37,8 +37,11 @@ namespace Echo
 	{
 		CLASS_BIND_METHOD(Texture, isMipmapEnable, DEF_METHOD("isMipmapEnable"));
 		CLASS_BIND_METHOD(Texture, setMipmapEnable, DEF_METHOD("setMipmapEnable"));
+		CLASS_BIND_METHOD(Texture, isSRGB, DEF_METHOD("isSRGB"));
+		CLASS_BIND_METHOD(Texture, setSRGB, DEF_METHOD("setSRGB"));
 
 		CLASS_REGISTER_PROPERTY(Texture, "MipMap", Variant::Type::Bool, "isMipmapEnable", "setMipmapEnable");
+		CLASS_REGISTER_PROPERTY(Texture, "SRGB", Variant::Type::Bool, "isSRGB", "setSRGB");
 	}
 
 	Res* Texture::load(const ResourcePath& path)
@@ -89,6 +89,10 @@ namespace Echo
 		void setMipmapEnable(bool isEanble) { m_isMipMapEnable = isEanble; }
 		ui32 getNumMipmaps() const { return m_numMipmaps; }
 
+		// color data in sRGB space, mipmaps are filtered in linear space. normal maps and masks stay linear
+		bool isSRGB() const { return m_isSRGB; }
+		void setSRGB(bool isSRGB) { m_isSRGB = isSRGB; }
+
 		// update texture by rect
         virtual bool updateTexture2D(PixelFormat format, TexUsage usage, i32 width, i32 height, void* data, ui32 size) { return false; }
 		virtual bool updateSubTex2D(ui32 level, const Rect& rect, void* pData, ui32 size) { return false; }
@@ -123,6 +127,7 @@ namespace Echo
 		ui32				m_height = 0;
 		ui32				m_depth = 1;
 		bool				m_isMipMapEnable;
+		bool				m_isSRGB = false;
 		ui32				m_numMipmaps = 1;
 		ui32				m_faceNum = 1;
 		ui32				m_blockSize = 0;
@@ -1,9 +1,10 @@
 #include "TextureVideo.h"
+#include "Renderer.h"
 
 namespace Echo
 {
 	TextureVideo::TextureVideo()
-		: Texture()
+		: Res()
 	{
 
 	}
@@ -16,5 +17,44 @@ namespace Echo
 	// bind methods to script
 	void TextureVideo::bindMethods()
 	{
+		CLASS_BIND_METHOD(TextureVideo, getWidth, DEF_METHOD("getWidth"));
+		CLASS_BIND_METHOD(TextureVideo, getHeight, DEF_METHOD("getHeight"));
 	}
-}
\ No newline at end of file
+
+	void TextureVideo::updateFrame(i32 width, i32 height, const ui8* y, const ui8* cb, const ui8* cr)
+	{
+		bool isResized = m_width != width || m_height != height;
+		m_width = width;
+		m_height = height;
+
+		if (isResized)
+		{
+			for (TexturePtr& plane : m_planes)
+				plane.reset();
+		}
+
+		updatePlane(Plane_Y, width, height, y);
+		updatePlane(Plane_Cb, width / 2, height / 2, cb);
+		updatePlane(Plane_Cr, width / 2, height / 2, cr);
+	}
+
+	void TextureVideo::updatePlane(Plane plane, i32 width, i32 height, const ui8* data)
+	{
+		TexturePtr& texture = m_planes[plane];
+		ui32 size = ui32(width * height);
+		if (!texture)
+		{
+			// every frame is a full upload, no mipmaps
+			texture = Renderer::instance()->createTexture2D();
+			if (texture)
+			{
+				texture->setMipmapEnable(false);
+				texture->updateTexture2D(PF_R8_UNORM, Texture::TU_DYNAMIC, width, height, (void*)data, size);
+			}
+		}
+		else
+		{
+			texture->updateSubTex2D(0, Rect(0.f, 0.f, float(width), float(height)), (void*)data, size);
+		}
+	}
+}
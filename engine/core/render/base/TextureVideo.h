@@ -4,15 +4,46 @@
 
 namespace Echo
 {
-	class TextureVideo : public Texture
+	/**
+	 * Video texture
+	 * Decoded frames are uploaded as three single channel planes (Y, Cb, Cr),
+	 * the conversion to rgb happens in the shader sampling them.
+	 */
+	class TextureVideo : public Res
 	{
 		ECHO_RES(TextureVideo, Res, ".mp4", Res::create<TextureVideo>, Res::load)
 
+	public:
+		enum Plane
+		{
+			Plane_Y = 0,
+			Plane_Cb,
+			Plane_Cr,
+			Plane_Count,
+		};
+
 	public:
 		TextureVideo();
 		virtual ~TextureVideo();
 
+		// upload a frame, chroma planes are half size. textures are recreated only when the size changes
+		void updateFrame(i32 width, i32 height, const ui8* y, const ui8* cb, const ui8* cr);
+
+		// plane
+		TexturePtr& getPlane(Plane plane) { return m_planes[plane]; }
+
+		// size of luma plane
+		i32 getWidth() const { return m_width; }
+		i32 getHeight() const { return m_height; }
+
+	private:
+		// upload one plane
+		void updatePlane(Plane plane, i32 width, i32 height, const ui8* data);
+
 	private:
-		ResourcePath	m_cubeDiffuseTextureNames[6];
+		i32				m_width = 0;
+		i32				m_height = 0;
+		TexturePtr		m_planes[Plane_Count];
 	};
-}
\ No newline at end of file
+	typedef ResRef<TextureVideo> TextureVideoPtr;
+}
@@ -18,6 +18,9 @@ namespace Echo
         // get texture
         TexturePtr getTexture() { return m_owner ? m_owner->getTexture() : nullptr; }
 
+        // owner atlas
+        TextureAtlas* getAtlas() { return m_owner; }
+
         // view port
         Vector4 getViewport();
         Vector4 getViewportNormalized();
@@ -1,9 +1,12 @@
 #include "TextureAtlas.h"
 #include "engine/core/io/IO.h"
+#include "engine/core/log/Log.h"
 #include <thirdparty/pugixml/pugixml.hpp>
 #include <thirdparty/pugixml/pugiconfig.hpp>
 #include "engine/core/render/base/Texture.h"
 #include "engine/core/util/PathUtil.h"
+#include "engine/core/render/base/image/Image.h"
+#include "engine/core/render/base/image/PixelUtil.h"
 
 namespace Echo
 {
@@ -19,7 +22,7 @@ namespace Echo
     
     TextureAtlas::~TextureAtlas()
     {
-
+		EchoSafeDelete(m_packer, TextureAtlasPacker);
     }
 
     void TextureAtlas::bindMethods()
@@ -27,6 +30,11 @@ namespace Echo
 		CLASS_BIND_METHOD(TextureAtlas, getTextureRes, DEF_METHOD("getTextureRes"));
 		CLASS_BIND_METHOD(TextureAtlas, setTextureRes, DEF_METHOD("setTextureRes"));
 
+		CLASS_BIND_METHOD(TextureAtlas, packAtlaFromFile, DEF_METHOD("packAtlaFromFile"));
+		CLASS_BIND_METHOD(TextureAtlas, removeAtla, DEF_METHOD("removeAtla"));
+		CLASS_BIND_METHOD(TextureAtlas, defragment, DEF_METHOD("defragment"));
+		CLASS_BIND_METHOD(TextureAtlas, getOccupancy, DEF_METHOD("getOccupancy"));
+
 		CLASS_REGISTER_PROPERTY(TextureAtlas, "Texture", Variant::Type::ResourcePath, "getTextureRes", "setTextureRes");
     }
 
@@ -53,6 +61,13 @@ namespace Echo
 				break;
 			}
 		}
+
+		auto it = m_packIds.find(name);
+		if (it != m_packIds.end())
+		{
+			m_packer->remove(it->second);
+			m_packIds.erase(it);
+		}
 	}
 
 	bool TextureAtlas::getViewport(const String& name, Vector4& viewPort)
@@ -84,6 +99,127 @@ namespace Echo
 	void TextureAtlas::clear()
 	{
 		m_atlas.clear();
+		m_packIds.clear();
+		if (m_packer)
+		{
+			m_packer->clear();
+			std::fill(m_packPixels.begin(), m_packPixels.end(), 0);
+			m_version++;
+		}
+	}
+
+	void TextureAtlas::setPackSize(i32 width, i32 height, i32 padding)
+	{
+		clear();
+
+		EchoSafeDelete(m_packer, TextureAtlasPacker);
+		m_packer = EchoNew(TextureAtlasPacker(width, height, padding));
+		m_packPixels.assign(width * height * 4, 0);
+		m_texture = Texture::createTexture2D(PF_RGBA8_UNORM, Texture::TU_DYNAMIC, width, height, m_packPixels.data(), ui32(m_packPixels.size()));
+	}
+
+	bool TextureAtlas::packAtla(const String& name, Image* image)
+	{
+		if (!m_packer || !image || m_packIds.find(name) != m_packIds.end())
+			return false;
+
+		i32 id = m_packer->insert(image->getWidth(), image->getHeight());
+		if (id == -1)
+		{
+			EchoLogWarning("TextureAtlas [%s] is full, can't pack atla [%s]", getPath().c_str(), name.c_str());
+			return false;
+		}
+
+		// convert to rgba8
+		PixelBox srcBox = image->getPixelBox();
+		vector<Byte>::type pixels(image->getWidth() * image->getHeight() * 4);
+		PixelBox dstBox(image->getWidth(), image->getHeight(), 1, PF_RGBA8_UNORM, pixels.data());
+		PixelUtil::BulkPixelConversion(srcBox, dstBox);
+
+		blitPackedAtla(id, pixels.data());
+
+		TextureAtlasPacker::IRect rc;
+		m_packer->getRect(id, rc);
+		m_packIds[name] = id;
+		addAtla(name, Vector4(float(rc.left), float(rc.top), float(rc.width), float(rc.height)));
+
+		// upload the packed region only
+		if (m_texture)
+			m_texture->updateSubTex2D(0, Rect(float(rc.left), float(rc.top), float(rc.left + rc.width), float(rc.top + rc.height)), pixels.data(), ui32(pixels.size()));
+
+		return true;
+	}
+
+	bool TextureAtlas::packAtlaFromFile(const String& name, const String& imagePath)
+	{
+		Image* image = Image::loadFromFile(imagePath);
+		if (image)
+		{
+			bool result = packAtla(name, image);
+			EchoSafeDelete(image, Image);
+
+			return result;
+		}
+
+		return false;
+	}
+
+	bool TextureAtlas::defragment()
+	{
+		if (!m_packer)
+			return false;
+
+		// remember old pixels of every atla
+		map<i32, vector<Byte>::type>::type oldPixels;
+		for (const TextureAtlasPacker::Item& item : m_packer->getItems())
+		{
+			vector<Byte>::type& pixels = oldPixels[item.m_id];
+			pixels.resize(item.m_rect.width * item.m_rect.height * 4);
+			for (i32 row = 0; row < item.m_rect.height; row++)
+			{
+				const Byte* src = &m_packPixels[((item.m_rect.top + row) * m_packer->getWidth() + item.m_rect.left) * 4];
+				std::memcpy(&pixels[row * item.m_rect.width * 4], src, item.m_rect.width * 4);
+			}
+		}
+
+		if (!m_packer->defragment())
+			return false;
+
+		// rebuild pixels and viewports
+		std::fill(m_packPixels.begin(), m_packPixels.end(), 0);
+		for (auto& it : m_packIds)
+		{
+			TextureAtlasPacker::IRect rc;
+			if (m_packer->getRect(it.second, rc))
+			{
+				blitPackedAtla(it.second, oldPixels[it.second].data());
+				for (Atla& atla : m_atlas)
+				{
+					if (atla.m_name == it.first)
+						atla.m_viewPort = Vector4(float(rc.left), float(rc.top), float(rc.width), float(rc.height));
+				}
+			}
+		}
+
+		if (m_texture)
+			m_texture->updateTexture2D(PF_RGBA8_UNORM, Texture::TU_DYNAMIC, m_packer->getWidth(), m_packer->getHeight(), m_packPixels.data(), ui32(m_packPixels.size()));
+
+		m_version++;
+
+		return true;
+	}
+
+	void TextureAtlas::blitPackedAtla(i32 id, const Byte* pixels)
+	{
+		TextureAtlasPacker::IRect rc;
+		if (m_packer->getRect(id, rc))
+		{
+			for (i32 row = 0; row < rc.height; row++)
+			{
+				Byte* dst = &m_packPixels[((rc.top + row) * m_packer->getWidth() + rc.left) * 4];
+				std::memcpy(dst, pixels + row * rc.width * 4, rc.width * 4);
+			}
+		}
 	}
 
     Res* TextureAtlas::load(const ResourcePath& path)
@@ -2,9 +2,11 @@
 
 #include "engine/core/resource/Res.h"
 #include "engine/core/render/base/Texture.h"
+#include "TextureAtlasPacker.h"
 
 namespace Echo
 {
+	class Image;
     class TextureAtlas : public Res
     {
         ECHO_RES(TextureAtlas, Res, ".atlas", Res::create<TextureAtlas>, TextureAtlas::load);
@@ -50,6 +52,23 @@ namespace Echo
 		// clear
 		void clear();
 
+	public:
+		// runtime packing. atlas with a pack size owns a dynamic texture and packs images into it
+		void setPackSize(i32 width, i32 height, i32 padding = 1);
+
+		// pack image, uploads only the packed region
+		bool packAtla(const String& name, Image* image);
+		bool packAtlaFromFile(const String& name, const String& imagePath);
+
+		// repack all atlas to reclaim space freed by removeAtla, viewports change
+		bool defragment();
+
+		// occupancy of packed space
+		float getOccupancy() const { return m_packer ? m_packer->getOccupancy() : 0.f; }
+
+		// changes every time viewports of existing atlas move
+		ui32 getVersion() const { return m_version; }
+
         // load | save
         static Res* load(const ResourcePath& path);
         virtual void save() override;
@@ -58,10 +77,17 @@ namespace Echo
 		// enum files
 		virtual void enumFilesInDir(StringArray& ret, const String& rootPath, bool bIncDir = false, bool bIncSubDirs = false, bool isAbsPath = false) override ;
 
+		// blit pixels of packed atla into pack image
+		void blitPackedAtla(i32 id, const Byte* pixels);
+
     protected:
 		vector<Atla>::type	m_atlas;
 		ResourcePath		m_textureRes = ResourcePath("", ".png");
 		TexturePtr			m_texture;
+		ui32				m_version = 0;
+		TextureAtlasPacker*	m_packer = nullptr;
+		vector<Byte>::type	m_packPixels;		// rgba8 copy of the packed texture
+		map<String, i32>::type m_packIds;		// atla name to packer id
     };
     typedef ResRef<TextureAtlas> TextureAtlasPtr;
 }
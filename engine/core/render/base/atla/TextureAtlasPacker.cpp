@@ -0,0 +1,261 @@
+#include "TextureAtlasPacker.h"
+#include <algorithm>
+#include <limits>
+
+namespace Echo
+{
+	bool TextureAtlasPacker::IRect::isContainedIn(const IRect& other) const
+	{
+		return left >= other.left && top >= other.top && left + width <= other.left + other.width && top + height <= other.top + other.height;
+	}
+
+	bool TextureAtlasPacker::IRect::isIntersect(const IRect& other) const
+	{
+		return left < other.left + other.width && left + width > other.left && top < other.top + other.height && top + height > other.top;
+	}
+
+	TextureAtlasPacker::TextureAtlasPacker(i32 width, i32 height, i32 padding)
+		: m_width(width)
+		, m_height(height)
+		, m_padding(padding)
+	{
+		clear();
+	}
+
+	TextureAtlasPacker::~TextureAtlasPacker()
+	{
+	}
+
+	void TextureAtlasPacker::clear()
+	{
+		m_items.clear();
+		m_freeRects.clear();
+		m_freeRects.emplace_back(0, 0, m_width, m_height);
+		m_usedArea = 0;
+	}
+
+	i32 TextureAtlasPacker::insert(i32 width, i32 height)
+	{
+		if (width <= 0 || height <= 0)
+			return -1;
+
+		IRect rect;
+		if (!findPosition(width + m_padding, height + m_padding, rect))
+			return -1;
+
+		place(rect);
+
+		Item item;
+		item.m_id = m_nextId++;
+		item.m_rect = IRect(rect.left, rect.top, width, height);
+		m_items.emplace_back(item);
+		m_usedArea += rect.getArea();
+
+		return item.m_id;
+	}
+
+	bool TextureAtlasPacker::remove(i32 id)
+	{
+		for (auto it = m_items.begin(); it != m_items.end(); it++)
+		{
+			if (it->m_id == id)
+			{
+				IRect rect(it->m_rect.left, it->m_rect.top, it->m_rect.width + m_padding, it->m_rect.height + m_padding);
+				m_usedArea -= rect.getArea();
+				m_items.erase(it);
+
+				// the released space is free again, merge it with its neighbours
+				m_freeRects.emplace_back(rect);
+				mergeFreeRects();
+				pruneFreeRects();
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool TextureAtlasPacker::getRect(i32 id, IRect& rect) const
+	{
+		for (const Item& item : m_items)
+		{
+			if (item.m_id == id)
+			{
+				rect = item.m_rect;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	float TextureAtlasPacker::getOccupancy() const
+	{
+		return m_width && m_height ? float(m_usedArea) / float(i64(m_width) * m_height) : 0.f;
+	}
+
+	bool TextureAtlasPacker::defragment()
+	{
+		// largest first packs best
+		vector<Item>::type items = m_items;
+		std::sort(items.begin(), items.end(), [](const Item& a, const Item& b)
+		{
+			i32 sideA = std::max(a.m_rect.width, a.m_rect.height);
+			i32 sideB = std::max(b.m_rect.width, b.m_rect.height);
+			return sideA != sideB ? sideA > sideB : a.m_rect.getArea() > b.m_rect.getArea();
+		});
+
+		vector<Item>::type oldItems = m_items;
+		vector<IRect>::type oldFreeRects = m_freeRects;
+		i64 oldUsedArea = m_usedArea;
+
+		clear();
+		for (Item& item : items)
+		{
+			IRect rect;
+			if (!findPosition(item.m_rect.width + m_padding, item.m_rect.height + m_padding, rect))
+			{
+				m_items = oldItems;
+				m_freeRects = oldFreeRects;
+				m_usedArea = oldUsedArea;
+				return false;
+			}
+
+			place(rect);
+			item.m_rect.left = rect.left;
+			item.m_rect.top = rect.top;
+			m_items.emplace_back(item);
+			m_usedArea += rect.getArea();
+		}
+
+		return true;
+	}
+
+	bool TextureAtlasPacker::findPosition(i32 width, i32 height, IRect& result) const
+	{
+		i32 bestShortSide = std::numeric_limits<i32>::max();
+		i32 bestLongSide = std::numeric_limits<i32>::max();
+		for (const IRect& freeRect : m_freeRects)
+		{
+			if (freeRect.width >= width && freeRect.height >= height)
+			{
+				i32 leftoverX = freeRect.width - width;
+				i32 leftoverY = freeRect.height - height;
+				i32 shortSide = std::min(leftoverX, leftoverY);
+				i32 longSide = std::max(leftoverX, leftoverY);
+				if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+				{
+					result = IRect(freeRect.left, freeRect.top, width, height);
+					bestShortSide = shortSide;
+					bestLongSide = longSide;
+				}
+			}
+		}
+
+		return bestShortSide != std::numeric_limits<i32>::max();
+	}
+
+	void TextureAtlasPacker::place(const IRect& rect)
+	{
+		m_newFreeRects.clear();
+		for (size_t i = 0; i < m_freeRects.size();)
+		{
+			if (splitFreeRect(m_freeRects[i], rect))
+			{
+				m_freeRects[i] = m_freeRects.back();
+				m_freeRects.pop_back();
+			}
+			else
+			{
+				i++;
+			}
+		}
+
+		m_freeRects.insert(m_freeRects.end(), m_newFreeRects.begin(), m_newFreeRects.end());
+		pruneFreeRects();
+	}
+
+	bool TextureAtlasPacker::splitFreeRect(const IRect& freeRect, const IRect& usedRect)
+	{
+		if (!freeRect.isIntersect(usedRect))
+			return false;
+
+		// top
+		if (usedRect.top > freeRect.top)
+			m_newFreeRects.emplace_back(freeRect.left, freeRect.top, freeRect.width, usedRect.top - freeRect.top);
+
+		// bottom
+		if (usedRect.top + usedRect.height < freeRect.top + freeRect.height)
+		{
+			i32 top = usedRect.top + usedRect.height;
+			m_newFreeRects.emplace_back(freeRect.left, top, freeRect.width, freeRect.top + freeRect.height - top);
+		}
+
+		// left
+		if (usedRect.left > freeRect.left)
+			m_newFreeRects.emplace_back(freeRect.left, freeRect.top, usedRect.left - freeRect.left, freeRect.height);
+
+		// right
+		if (usedRect.left + usedRect.width < freeRect.left + freeRect.width)
+		{
+			i32 left = usedRect.left + usedRect.width;
+			m_newFreeRects.emplace_back(left, freeRect.top, freeRect.left + freeRect.width - left, freeRect.height);
+		}
+
+		return true;
+	}
+
+	void TextureAtlasPacker::pruneFreeRects()
+	{
+		for (size_t i = 0; i < m_freeRects.size(); i++)
+		{
+			for (size_t j = i + 1; j < m_freeRects.size();)
+			{
+				if (m_freeRects[i].isContainedIn(m_freeRects[j]))
+				{
+					m_freeRects.erase(m_freeRects.begin() + i);
+					i--;
+					break;
+				}
+
+				if (m_freeRects[j].isContainedIn(m_freeRects[i]))
+					m_freeRects.erase(m_freeRects.begin() + j);
+				else
+					j++;
+			}
+		}
+	}
+
+	void TextureAtlasPacker::mergeFreeRects()
+	{
+		bool isMerged = true;
+		while (isMerged)
+		{
+			isMerged = false;
+			for (size_t i = 0; i < m_freeRects.size() && !isMerged; i++)
+			{
+				for (size_t j = i + 1; j < m_freeRects.size() && !isMerged; j++)
+				{
+					IRect& a = m_freeRects[i];
+					const IRect& b = m_freeRects[j];
+					if (a.left == b.left && a.width == b.width && (a.top + a.height == b.top || b.top + b.height == a.top))
+					{
+						a.top = std::min(a.top, b.top);
+						a.height += b.height;
+						isMerged = true;
+					}
+					else if (a.top == b.top && a.height == b.height && (a.left + a.width == b.left || b.left + b.width == a.left))
+					{
+						a.left = std::min(a.left, b.left);
+						a.width += b.width;
+						isMerged = true;
+					}
+
+					if (isMerged)
+						m_freeRects.erase(m_freeRects.begin() + j);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "engine/core/base/type_def.h"
+#include "engine/core/memory/MemAllocDef.h"
+
+namespace Echo
+{
+	/**
+	 * MaxRects rectangle packer (best short side fit)
+	 * Supports incremental insertion, removal and defragmentation
+	 */
+	class TextureAtlasPacker
+	{
+	public:
+		// Rect
+		struct IRect
+		{
+			i32 left = 0;
+			i32 top = 0;
+			i32 width = 0;
+			i32 height = 0;
+
+			IRect() {}
+			IRect(i32 l, i32 t, i32 w, i32 h) : left(l), top(t), width(w), height(h) {}
+
+			// area
+			i32 getArea() const { return width * height; }
+
+			// is contained by other
+			bool isContainedIn(const IRect& other) const;
+
+			// is intersect with other
+			bool isIntersect(const IRect& other) const;
+		};
+
+		// Item
+		struct Item
+		{
+			i32		m_id = -1;
+			IRect	m_rect;			// rect without padding
+		};
+
+	public:
+		TextureAtlasPacker(i32 width, i32 height, i32 padding = 1);
+		~TextureAtlasPacker();
+
+		// width & height
+		i32 getWidth() const { return m_width; }
+		i32 getHeight() const { return m_height; }
+
+		// insert a rect, return item id, -1 if there is no space
+		i32 insert(i32 width, i32 height);
+
+		// remove item, the space can be reused by following inserts
+		bool remove(i32 id);
+
+		// get item rect
+		bool getRect(i32 id, IRect& rect) const;
+
+		// all items
+		const vector<Item>::type& getItems() const { return m_items; }
+
+		// used area / total area
+		float getOccupancy() const;
+
+		// repack all items (largest first) to reclaim fragmented space, ids are kept
+		// return false if items don't fit anymore, the packer is unchanged in that case
+		bool defragment();
+
+		// clear
+		void clear();
+
+	private:
+		// find best free rect
+		bool findPosition(i32 width, i32 height, IRect& result) const;
+
+		// place rect, split intersected free rects
+		void place(const IRect& rect);
+
+		// split free rect by used rect
+		bool splitFreeRect(const IRect& freeRect, const IRect& usedRect);
+
+		// remove free rects contained by others
+		void pruneFreeRects();
+
+		// merge free rects share one full edge
+		void mergeFreeRects();
+
+	private:
+		i32						m_width;
+		i32						m_height;
+		i32						m_padding;
+		i32						m_nextId = 0;
+		i64						m_usedArea = 0;
+		vector<Item>::type		m_items;
+		vector<IRect>::type		m_freeRects;
+		vector<IRect>::type		m_newFreeRects;
+	};
+}
@@ -3,6 +3,7 @@
 #include <engine/core/util/PathUtil.h>
 #include <engine/core/io/IO.h>
 #include <engine/core/io/stream/MemoryDataStream.h>
+#include <engine/core/thread/OpenMPTaskMgr.h>
 #include "Image.h"
 #include "ImageResampler.h"
 #include "ImageCodec.h"
@@ -428,6 +429,93 @@ namespace Echo
 		return true;
 	}
 
+	bool Image::generateMipmaps(ImageFilter filter, bool gammaCorrect)
+	{
+		if (!m_data || hasFlag(IMGFLAG_COMPRESSED) || hasFlag(IMGFLAG_3DTEX) || !PixelUtil::IsAccessible(m_format))
+		{
+			EchoLogError("Image::generateMipmaps. Only uncompressed 2d and cube images are supported.");
+			return false;
+		}
+
+		const ui32 numLevels = CalculateMipmapLevels(m_width, m_height);
+		const ui32 numFaces = getNumFaces();
+		const ui32 rowsPerJob = 32;
+		const bool isSRGB = gammaCorrect && !PixelUtil::IsFloatingPoint(m_format);
+
+		// reallocate for the full chain, keep the top level of every face
+		ui32 size = CalculateSize(numLevels, numFaces, m_width, m_height, 1, m_format);
+		ui32 topLevelSize = PixelUtil::GetMemorySize(m_width, m_height, 1, m_format);
+		Byte* data = ECHO_ALLOC_T(Byte, size);
+		for (ui32 face = 0; face < numFaces; face++)
+		{
+			memcpy(data + face * (size / numFaces), getPixelBox(face, 0).pData, topLevelSize);
+		}
+
+		EchoSafeFree(m_data);
+		m_data = data;
+		m_size = size;
+		m_numMipmaps = numLevels - 1;
+
+		// linear colors of the current and the next level of every face
+		vector<vector<Color>::type>::type current(numFaces);
+		vector<vector<Color>::type>::type next(numFaces);
+
+		CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+
+		// decode top level
+		ui32 jobsPerFace = (m_height + rowsPerJob - 1) / rowsPerJob;
+		for (ui32 face = 0; face < numFaces; face++)
+			current[face].resize(m_width * m_height);
+
+		threadPool->parallelFor(jobsPerFace * numFaces, [&](ui32 idx)
+		{
+			ui32 face = idx / jobsPerFace;
+			ui32 rowBegin = (idx % jobsPerFace) * rowsPerJob;
+			ui32 rowEnd = std::min<ui32>(rowBegin + rowsPerJob, m_height);
+			MipmapResampler::Unpack(getPixelBox(face, 0), current[face].data(), rowBegin, rowEnd, isSRGB);
+		});
+
+		// every level is filtered from the previous one, faces and rows are independent
+		ui32 srcWidth = m_width;
+		ui32 srcHeight = m_height;
+		for (ui32 level = 1; level < numLevels; level++)
+		{
+			ui32 dstWidth = std::max<ui32>(srcWidth / 2, 1);
+			ui32 dstHeight = std::max<ui32>(srcHeight / 2, 1);
+
+			MipmapResampler::Kernel kernelX, kernelY;
+			if (filter == IMGFILTER_KAISER)
+			{
+				MipmapResampler::BuildKaiserKernel(srcWidth, dstWidth, kernelX);
+				MipmapResampler::BuildKaiserKernel(srcHeight, dstHeight, kernelY);
+			}
+			else
+			{
+				MipmapResampler::BuildBoxKernel(srcWidth, dstWidth, kernelX);
+				MipmapResampler::BuildBoxKernel(srcHeight, dstHeight, kernelY);
+			}
+
+			for (ui32 face = 0; face < numFaces; face++)
+				next[face].resize(dstWidth * dstHeight);
+
+			jobsPerFace = (dstHeight + rowsPerJob - 1) / rowsPerJob;
+			threadPool->parallelFor(jobsPerFace * numFaces, [&](ui32 idx)
+			{
+				ui32 face = idx / jobsPerFace;
+				ui32 rowBegin = (idx % jobsPerFace) * rowsPerJob;
+				ui32 rowEnd = std::min<ui32>(rowBegin + rowsPerJob, dstHeight);
+				MipmapResampler::Downsample(current[face].data(), srcWidth, srcHeight, next[face].data(), dstWidth, kernelX, kernelY, rowBegin, rowEnd);
+				MipmapResampler::Pack(next[face].data(), getPixelBox(face, level), rowBegin, rowEnd, isSRGB);
+			});
+
+			std::swap(current, next);
+			srcWidth = dstWidth;
+			srcHeight = dstHeight;
+		}
+
+		return true;
+	}
+
 	String Image::getImageFormatExt(ImageFormat imgFmt)
 	{
 		switch(imgFmt)
@@ -488,6 +576,15 @@ namespace Echo
 		return size;
 	}
 
+	ui32 Image::CalculateMipmapLevels(ui32 width, ui32 height)
+	{
+		ui32 levels = 1;
+		for (ui32 size = std::max<ui32>(width, height); size > 1; size /= 2)
+			levels++;
+
+		return levels;
+	}
+
 	bool Image::Scale(const PixelBox &src, const PixelBox &dst, ImageFilter filter)
 	{
 		EchoAssert(PixelUtil::IsAccessible(src.pixFmt));
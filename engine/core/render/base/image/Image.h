@@ -29,6 +29,7 @@ namespace Echo
             IMGFILTER_BOX,
             IMGFILTER_TRIANGLE,
             IMGFILTER_BICUBIC,
+            IMGFILTER_KAISER,
         };
 
         struct ImageInfo
@@ -89,6 +90,10 @@ namespace Echo
 		// convert format
 		bool convertFormat(PixelFormat targetFormat);
 
+		// Generate the full mipmap chain on cpu, replacing existing mipmaps. Supports IMGFILTER_BOX
+		// and IMGFILTER_KAISER. sRGB color data should pass gammaCorrect to be filtered in linear space.
+		bool generateMipmaps(ImageFilter filter = IMGFILTER_BOX, bool gammaCorrect = false);
+
 		static String getImageFormatExt(ImageFormat imgFmt);
 		static ImageFormat GetImageFormat(const String &filename);
 		static ImageFormat GetImageFormatByExt(const String &imgExt);
@@ -96,6 +101,9 @@ namespace Echo
 		// Static function to calculate size in bytes from the number of mipmaps, faces and the dimensions
 		static ui32	CalculateSize(ui32 mipmaps, ui32 faces, ui32 width, ui32 height, ui32 depth, PixelFormat pixFmt);
 
+		// Number of levels of a full mipmap chain, include the top level
+		static ui32 CalculateMipmapLevels(ui32 width, ui32 height);
+
 		/** Scale a 1D, 2D or 3D image volume. 
 		@param 	src			PixelBox containing the source pointer, dimensions and format
 		@param 	dst			PixelBox containing the destination pointer, dimensions and format
@@ -1,2 +1,263 @@
 #include "PixelFormat.h"
-#include "ImageResampler.h"
\ No newline at end of file
+#include "ImageResampler.h"
+
+namespace Echo
+{
+	// srgb 8bit to linear lookup table
+	static const float* SRGBToLinearTable()
+	{
+		static float table[256];
+		static const bool isInited = [&]()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				float c = i / 255.f;
+				table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+
+			return true;
+		}();
+		(void)isInited;
+
+		return table;
+	}
+
+	// linear to srgb lookup table, 12bit precision
+	static const float* LinearToSRGBTable()
+	{
+		static float table[4096];
+		static const bool isInited = [&]()
+		{
+			for (int i = 0; i < 4096; i++)
+			{
+				float c = i / 4095.f;
+				table[i] = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+			}
+
+			return true;
+		}();
+		(void)isInited;
+
+		return table;
+	}
+
+	static float BesselI0(float x)
+	{
+		// power series, converges fast for the small arguments used here
+		float sum = 1.f;
+		float term = 1.f;
+		float halfX = x * 0.5f;
+		for (int k = 1; k < 32; k++)
+		{
+			term *= (halfX / k) * (halfX / k);
+			sum += term;
+			if (term < sum * 1e-7f)
+				break;
+		}
+
+		return sum;
+	}
+
+	static void NormalizeKernel(MipmapResampler::Kernel& kernel, ui32 dstSize)
+	{
+		for (ui32 i = 0; i < dstSize; i++)
+		{
+			float* weights = &kernel.m_weights[i * kernel.m_taps];
+
+			float total = 0.f;
+			for (ui32 k = 0; k < kernel.m_taps; k++)
+				total += weights[k];
+
+			if (total != 0.f)
+			{
+				for (ui32 k = 0; k < kernel.m_taps; k++)
+					weights[k] /= total;
+			}
+		}
+	}
+
+	void MipmapResampler::BuildBoxKernel(ui32 srcSize, ui32 dstSize, Kernel& kernel)
+	{
+		float scale = float(srcSize) / float(dstSize);
+
+		kernel.m_taps = ui32(std::ceil(scale)) + 1;
+		kernel.m_first.resize(dstSize);
+		kernel.m_weights.assign(dstSize * kernel.m_taps, 0.f);
+		for (ui32 i = 0; i < dstSize; i++)
+		{
+			float begin = i * scale;
+			float end = begin + scale;
+
+			kernel.m_first[i] = i32(begin);
+			for (ui32 k = 0; k < kernel.m_taps; k++)
+			{
+				// coverage of src texel [j, j+1] by the dst footprint
+				float j = float(kernel.m_first[i] + k);
+				float coverage = std::min(end, j + 1.f) - std::max(begin, j);
+				kernel.m_weights[i * kernel.m_taps + k] = std::max(coverage, 0.f);
+			}
+		}
+
+		NormalizeKernel(kernel, dstSize);
+	}
+
+	void MipmapResampler::BuildKaiserKernel(ui32 srcSize, ui32 dstSize, Kernel& kernel)
+	{
+		const float width = 3.f;
+		const float alpha = 4.f;
+		const float scale = float(srcSize) / float(dstSize);
+		const float radius = width * scale;
+		const float i0Alpha = BesselI0(alpha);
+
+		kernel.m_taps = ui32(std::ceil(radius * 2.f)) + 1;
+		kernel.m_first.resize(dstSize);
+		kernel.m_weights.assign(dstSize * kernel.m_taps, 0.f);
+		for (ui32 i = 0; i < dstSize; i++)
+		{
+			float center = (i + 0.5f) * scale;
+
+			kernel.m_first[i] = i32(std::floor(center - radius + 0.5f));
+			for (ui32 k = 0; k < kernel.m_taps; k++)
+			{
+				// distance in dst texels
+				float x = (kernel.m_first[i] + k + 0.5f - center) / scale;
+				float t = x / width;
+				if (t <= -1.f || t >= 1.f)
+					continue;
+
+				float sinc = std::abs(x) < 1e-5f ? 1.f : std::sin(Math::PI * x) / (Math::PI * x);
+				float window = BesselI0(alpha * std::sqrt(1.f - t * t)) / i0Alpha;
+				kernel.m_weights[i * kernel.m_taps + k] = sinc * window;
+			}
+		}
+
+		NormalizeKernel(kernel, dstSize);
+	}
+
+	// 8bit unorm formats are filtered per byte channel, the 4th channel is alpha
+	static ui32 ByteChannels(PixelFormat pixFmt)
+	{
+		switch (pixFmt)
+		{
+		case PF_R8_UNORM:
+		case PF_A8_UNORM:		return 1;
+		case PF_RG8_UNORM:		return 2;
+		case PF_RGB8_UNORM:
+		case PF_BGR8_UNORM:		return 3;
+		case PF_RGBA8_UNORM:
+		case PF_BGRA8_UNORM:	return 4;
+		default:				return 0;
+		}
+	}
+
+	void MipmapResampler::Unpack(const PixelBox& src, Color* dst, ui32 rowBegin, ui32 rowEnd, bool isSRGB)
+	{
+		const float* toLinear = SRGBToLinearTable();
+		const ui32 elemSize = PixelUtil::GetPixelSize(src.pixFmt);
+		const ui32 channels = ByteChannels(src.pixFmt);
+		const ui32 colorChannels = isSRGB && channels >= 3 ? 3 : 0;
+		const ui32 width = src.getWidth();
+		for (ui32 y = rowBegin; y < rowEnd; y++)
+		{
+			const Byte* psrc = (const Byte*)src.pData + elemSize * (y * src.rowPitch);
+			Color* pdst = dst + y * width;
+			for (ui32 x = 0; x < width; x++, psrc += elemSize, pdst++)
+			{
+				if (channels)
+				{
+					Real* values = &pdst->r;
+					values[3] = 1.f;
+					for (ui32 i = 0; i < channels; i++)
+						values[i] = i < colorChannels ? toLinear[psrc[i]] : psrc[i] / 255.f;
+				}
+				else
+				{
+					PixelUtil::UnpackColor(*pdst, src.pixFmt, psrc);
+				}
+			}
+		}
+	}
+
+	void MipmapResampler::Pack(const Color* src, const PixelBox& dst, ui32 rowBegin, ui32 rowEnd, bool isSRGB)
+	{
+		const float* toSRGB = LinearToSRGBTable();
+		const ui32 elemSize = PixelUtil::GetPixelSize(dst.pixFmt);
+		const ui32 channels = ByteChannels(dst.pixFmt);
+		const ui32 colorChannels = isSRGB && channels >= 3 ? 3 : 0;
+		const ui32 width = dst.getWidth();
+		for (ui32 y = rowBegin; y < rowEnd; y++)
+		{
+			const Color* psrc = src + y * width;
+			Byte* pdst = (Byte*)dst.pData + elemSize * (y * dst.rowPitch);
+			for (ui32 x = 0; x < width; x++, psrc++, pdst += elemSize)
+			{
+				if (channels)
+				{
+					// sharp filters ring, keep results in range
+					const Real* values = &psrc->r;
+					for (ui32 i = 0; i < channels; i++)
+					{
+						float value = Math::Clamp(values[i], 0.f, 1.f);
+						if (i < colorChannels)
+							value = toSRGB[ui32(value * 4095.f + 0.5f)];
+
+						pdst[i] = Byte(value * 255.f + 0.5f);
+					}
+				}
+				else
+				{
+					PixelUtil::PackColor(*psrc, dst.pixFmt, pdst);
+				}
+			}
+		}
+	}
+
+	void MipmapResampler::Downsample(const Color* src, ui32 srcWidth, ui32 srcHeight, Color* dst, ui32 dstWidth, const Kernel& kernelX, const Kernel& kernelY, ui32 rowBegin, ui32 rowEnd)
+	{
+		vector<Color>::type row(srcWidth);
+		for (ui32 y = rowBegin; y < rowEnd; y++)
+		{
+			// vertical pass into a single source-width row
+			std::fill(row.begin(), row.end(), Color(0.f, 0.f, 0.f, 0.f));
+			const float* weightsY = &kernelY.m_weights[y * kernelY.m_taps];
+			for (ui32 k = 0; k < kernelY.m_taps; k++)
+			{
+				float weight = weightsY[k];
+				if (weight == 0.f)
+					continue;
+
+				i32 sy = Math::Clamp<i32>(kernelY.m_first[y] + k, 0, i32(srcHeight) - 1);
+				const Color* psrc = src + sy * srcWidth;
+				for (ui32 x = 0; x < srcWidth; x++)
+				{
+					row[x].r += psrc[x].r * weight;
+					row[x].g += psrc[x].g * weight;
+					row[x].b += psrc[x].b * weight;
+					row[x].a += psrc[x].a * weight;
+				}
+			}
+
+			// horizontal pass
+			Color* pdst = dst + y * dstWidth;
+			for (ui32 x = 0; x < dstWidth; x++)
+			{
+				Color accum(0.f, 0.f, 0.f, 0.f);
+				const float* weightsX = &kernelX.m_weights[x * kernelX.m_taps];
+				for (ui32 k = 0; k < kernelX.m_taps; k++)
+				{
+					float weight = weightsX[k];
+					if (weight == 0.f)
+						continue;
+
+					const Color& c = row[Math::Clamp<i32>(kernelX.m_first[x] + k, 0, i32(srcWidth) - 1)];
+					accum.r += c.r * weight;
+					accum.g += c.g * weight;
+					accum.b += c.b * weight;
+					accum.a += c.a * weight;
+				}
+
+				pdst[x] = accum;
+			}
+		}
+	}
+}
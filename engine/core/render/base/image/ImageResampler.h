@@ -319,4 +319,34 @@ namespace Echo
 			}
 		}
 	};
+
+	// mipmap down sampler. works on linear float colors, so filtering is gamma
+	// correct and precision doesn't degrade while walking down the chain.
+	// separable, every dst row only reads rows of the previous level, so rows
+	// of one level can be processed in parallel.
+	struct MipmapResampler
+	{
+		// filter weights of one axis
+		struct Kernel
+		{
+			ui32					m_taps = 0;
+			vector<i32>::type		m_first;		// first src index of each dst index
+			vector<float>::type		m_weights;		// m_taps weights of each dst index
+		};
+
+		// area weighted box filter
+		static void BuildBoxKernel(ui32 srcSize, ui32 dstSize, Kernel& kernel);
+
+		// kaiser windowed sinc (width 3, alpha 4)
+		static void BuildKaiserKernel(ui32 srcSize, ui32 dstSize, Kernel& kernel);
+
+		// decode rows [rowBegin, rowEnd) of src to linear colors
+		static void Unpack(const PixelBox& src, Color* dst, ui32 rowBegin, ui32 rowEnd, bool isSRGB);
+
+		// encode rows [rowBegin, rowEnd) of linear colors to dst
+		static void Pack(const Color* src, const PixelBox& dst, ui32 rowBegin, ui32 rowEnd, bool isSRGB);
+
+		// filter dst rows [rowBegin, rowEnd) from src
+		static void Downsample(const Color* src, ui32 srcWidth, ui32 srcHeight, Color* dst, ui32 dstWidth, const Kernel& kernelX, const Kernel& kernelY, ui32 rowBegin, ui32 rowEnd);
+	};
 }
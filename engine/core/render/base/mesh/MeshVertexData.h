@@ -17,6 +17,9 @@ namespace Echo
 		VS_BLENDWEIGHTS,            // Blending weights(Vector4) Bone + Height field
 		VS_TANGENT,                 // Tangent (X axis if normal is Z)
 		VS_BINORMAL,
+		VS_INSTANCE0,               // Per instance data, advanced once per drawn instance
+		VS_INSTANCE1,
+		VS_INSTANCE2,
 		VS_MAX
 	};
 
@@ -1,6 +1,7 @@
 #include "engine/core/log/Log.h"
 #include "mesh.h"
 #include "engine/core/render/base/Renderer.h"
+#include "engine/core/render/base/image/PixelUtil.h"
 #include <algorithm>
 #include <thirdparty/pugixml/pugixml.hpp>
 #include "engine/core/util/magic_enum.hpp"
@@ -100,6 +101,10 @@ namespace Echo
 
 		EchoSafeDelete(m_vertexBuffer, GPUBuffer);
 		EchoSafeDelete(m_indexBuffer, GPUBuffer);
+		EchoSafeDelete(m_instanceBuffer, GPUBuffer);
+
+		m_instances.clear();
+		m_instanceCount = 0;
 
 		m_vertData.reset();
 	}
@@ -228,7 +233,7 @@ namespace Echo
 
 			// calculate local aabb
 			m_box.reset();
-			for (i32 i = 0; i < m_vertData.getVertexCount(); i++)
+			for (ui32 i = 0; i < m_vertData.getVertexCount(); i++)
 			{
 				m_box.addPoint(m_vertData.getPosition(i));
 			}
@@ -244,7 +249,7 @@ namespace Echo
 
 		// calculate local aabb
 		m_box.reset();
-		for (i32 i = 0; i < m_vertData.getVertexCount(); i++)
+		for (ui32 i = 0; i < m_vertData.getVertexCount(); i++)
 		{
 			m_box.addPoint(m_vertData.getPosition(i));
 		}
@@ -252,6 +257,62 @@ namespace Echo
 		buildVertexBuffer();
 	}
 
+	Byte* Mesh::lockVertexs(const MeshVertexFormat& format, ui32 vertCount)
+	{
+		m_vertData.set(format, vertCount);
+
+		return m_vertData.getVertices();
+	}
+
+	void Mesh::unlockVertexs(const AABB& box)
+	{
+		m_box = box;
+
+		buildVertexBuffer();
+	}
+
+	void Mesh::updateVertexRange(ui32 first, ui32 count)
+	{
+		count = std::min<ui32>(count, m_vertData.getVertexCount() - std::min<ui32>(first, m_vertData.getVertexCount()));
+		if (!count)
+			return;
+
+		m_box.reset();
+		for (ui32 i = 0; i < m_vertData.getVertexCount(); i++)
+		{
+			m_box.addPoint(m_vertData.getPosition(i));
+		}
+
+		// backends without partial updates get the whole buffer
+		ui32 stride = m_vertData.getVertexStride();
+		Buffer rangeBuff(count * stride, m_vertData.getVertices() + first * stride);
+		if (!m_isDynamicVertexBuffer || !m_vertexBuffer || !m_vertexBuffer->updateSubData(first * stride, rangeBuff))
+			buildVertexBuffer();
+	}
+
+	Byte* Mesh::lockInstances(const VertexElementList& elements, ui32 instanceCount)
+	{
+		m_instanceElements = elements;
+		m_instanceStride = 0;
+		for (const VertexElement& element : elements)
+			m_instanceStride += PixelUtil::GetPixelSize(element.m_pixFmt);
+
+		m_instanceCount = instanceCount;
+		m_instances.resize(m_instanceCount * m_instanceStride);
+
+		return m_instances.data();
+	}
+
+	void Mesh::unlockInstances()
+	{
+		// instances are rewritten every time, keep the buffer dynamic
+		Buffer instanceBuff(static_cast<ui32>(m_instances.size()), m_instances.data());
+		if (!m_instanceBuffer)
+			m_instanceBuffer = Renderer::instance()->createVertexBuffer(GPUBuffer::GBU_DYNAMIC, instanceBuff);
+		else
+			m_instanceBuffer->updateData(instanceBuff);
+	}
+
 	Res* Mesh::load(const ResourcePath& path)
 	{
 		if (!path.isEmpty())
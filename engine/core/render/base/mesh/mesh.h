@@ -110,6 +110,24 @@ namespace Echo
 		void updateVertexs(const MeshVertexFormat& format, ui32 vertCount, const Byte* vertices);
 		void updateVertexs(const MeshVertexData& vertexData);
 
+		// write vertex data in place, unlock uploads it with the given bounds
+		Byte* lockVertexs(const MeshVertexFormat& format, ui32 vertCount);
+		void unlockVertexs(const AABB& box);
+
+		// vertices [first, first + count) were rewritten through getVertexData, upload only them
+		void updateVertexRange(ui32 first, ui32 count);
+
+		// per instance data, the vertex data is drawn once for every instance
+		bool isInstanced() const { return m_instanceBuffer != nullptr; }
+		ui32 getInstanceCount() const { return m_instanceCount; }
+		ui32 getInstanceStride() const { return m_instanceStride; }
+		const VertexElementList& getInstanceElements() const { return m_instanceElements; }
+		GPUBuffer* getInstanceBuffer() const { return m_instanceBuffer; }
+
+		// write instance data in place, unlock uploads it
+		Byte* lockInstances(const VertexElementList& elements, ui32 instanceCount);
+		void unlockInstances();
+
 		// clear
 		void clear();
 
@@ -148,6 +166,11 @@ namespace Echo
 		bool						m_isDynamicIndicesBuffer = false;
 		GPUBuffer*					m_indexBuffer = nullptr;
 		vector<ui32>::type			m_boneIdxs;
+		VertexElementList			m_instanceElements;
+		ui32						m_instanceCount = 0;
+		ui32						m_instanceStride = 0;
+		vector<Byte>::type			m_instances;
+		GPUBuffer*					m_instanceBuffer = nullptr;
 	};
 	typedef Echo::ResRef<Echo::Mesh> MeshPtr;
 }
@@ -19,10 +19,10 @@ namespace Echo
 		Renderer* render = Renderer::instance();
 		if (render)
 		{
-			// sort
+			// sort, keeps submit order at equal depth
 			if (m_isSort)
 			{
-				std::sort(m_renderables.begin(), m_renderables.end(), [](RenderableID a, RenderableID b) -> bool
+				std::stable_sort(m_renderables.begin(), m_renderables.end(), [](RenderableID a, RenderableID b) -> bool
 				{
 					Renderable* renderableA = Renderer::instance()->getRenderable(a);
 					Renderable* renderableB = Renderer::instance()->getRenderable(b);
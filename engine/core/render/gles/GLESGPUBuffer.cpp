@@ -47,6 +47,19 @@ namespace Echo
 		return false;
 	}
 
+	bool GLES2GPUBuffer::updateSubData(ui32 offset, const Buffer& buff)
+	{
+		if (offset + buff.getSize() <= m_size && m_glUsage != GL_STATIC_DRAW)
+		{
+			OGLESDebug(glBindBuffer(m_target, m_hVBO));
+			OGLESDebug(glBufferSubData(m_target, offset, buff.getSize(), buff.getData()));
+
+			return true;
+		}
+
+		return false;
+	}
+
 	void GLES2GPUBuffer::bindBuffer()
 	{
 		OGLESDebug(glBindBuffer(m_target, m_hVBO));
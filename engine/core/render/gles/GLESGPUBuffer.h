@@ -11,6 +11,7 @@ namespace Echo
 		~GLES2GPUBuffer();
 
 		bool updateData(const Buffer& buff);
+		virtual bool updateSubData(ui32 offset, const Buffer& buff) override;
 		void bindBuffer();
 
 	private:
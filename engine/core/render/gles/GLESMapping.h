@@ -416,6 +416,9 @@ namespace Echo
 			case VS_TEXCOORD1:			return "a_UV1";
 			case VS_TANGENT:			return "a_Tangent";
 			case VS_BINORMAL:			return "a_Binormal";
+			case VS_INSTANCE0:			return "a_Instance0";
+			case VS_INSTANCE1:			return "a_Instance1";
+			case VS_INSTANCE2:			return "a_Instance2";
             default:                    return "";
 			}
 		}
@@ -88,6 +88,20 @@ namespace Echo
 			buildVertStreamDeclaration(&unit);
 
 			m_vertexStreams.emplace_back(unit);
+
+			// instance attributes advance once per instance
+			if (m_mesh->isInstanced())
+			{
+				StreamUnit instanceUnit;
+				instanceUnit.m_vertElements = m_mesh->getInstanceElements();
+				instanceUnit.m_buffer = m_mesh->getInstanceBuffer();
+				instanceUnit.m_divisor = 1;
+				buildVertStreamDeclaration(&instanceUnit);
+
+				m_vertexStreams.emplace_back(instanceUnit);
+			}
+
+			checkVertStreamDeclaration();
 		}
 	}
 
@@ -132,6 +146,7 @@ namespace Echo
 						// Enable the vertex array attributes.
 						OGLESDebug(glVertexAttribPointer(declaration.m_attribute, declaration.count, declaration.type, declaration.bNormalize, streamUnit.m_vertStride, (GLvoid*)declaration.elementOffset));
 						g_renderer->enableAttribLocation(declaration.m_attribute);
+						g_renderer->setAttribDivisor(declaration.m_attribute, streamUnit.m_divisor);
 					}
 				}
 			}
@@ -191,19 +206,29 @@ namespace Echo
 			elmOffset += PixelUtil::GetPixelSize(stream->m_vertElements[i].m_pixFmt);
 		}
 
-		// check
+		stream->m_vertStride = elmOffset;
+
+		return true;
+	}
+
+	bool GLES2Renderable::checkVertStreamDeclaration()
+	{
+		GLES2ShaderProgram* gles2Program = ECHO_DOWN_CAST<GLES2ShaderProgram*>(m_material->getShader());
 		for (i32 i = 0; i < VS_MAX; ++i)
 		{
 			i32 loc = gles2Program->getAtrribLocation((VertexSemantic)i);
 			if (loc >= 0)
 			{
 				bool found = false;
-				for (size_t size = 0; size < numVertElms; ++size)
+				for (const StreamUnit& stream : m_vertexStreams)
 				{
-					if (stream->m_vertElements[size].m_semantic == i)
+					for (const VertexElement& element : stream.m_vertElements)
 					{
-						found = true;
-						break;
+						if (element.m_semantic == i)
+						{
+							found = true;
+							break;
+						}
 					}
 				}
 
@@ -212,12 +237,11 @@ namespace Echo
 					String errorInfo = StringUtil::Format("Vertex Attribute [%s] name is NOT in Vertex Stream", GLES2Mapping::MapVertexSemanticString((VertexSemantic)i).c_str());
 					EchoLogFatal(errorInfo.c_str());
 					EchoAssertX(false, errorInfo.c_str());
+					return false;
 				}
 			}
 		}
 
-		stream->m_vertStride = elmOffset;
-
 		return true;
 	}
 }
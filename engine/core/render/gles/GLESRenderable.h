@@ -25,10 +25,12 @@ namespace Echo
 			VertexElementList		m_vertElements;
 			VertexDeclarationList	m_vertDeclaration;
 			ui32					m_vertStride;
+			ui32					m_divisor;
 			GPUBuffer*				m_buffer;
 
 			StreamUnit()
-				: m_buffer(nullptr)
+				: m_divisor(0)
+				, m_buffer(nullptr)
 			{}
 		};
 
@@ -58,6 +60,9 @@ namespace Echo
 		// build vertex declaration
 		virtual bool buildVertStreamDeclaration(StreamUnit* stream);
 
+		// check every shader attribute is fed by a stream
+		bool checkVertStreamDeclaration();
+
 	private:
 		vector<StreamUnit>::type		m_vertexStreams;
 		//GLuint						m_vao = -1;
@@ -49,6 +49,7 @@ namespace Echo
 	{
 		g_renderer = this;
 		std::fill(m_isVertexAttribArrayEnable.begin(), m_isVertexAttribArrayEnable.end(), false);
+		std::fill(m_vertexAttribDivisors.begin(), m_vertexAttribDivisors.end(), 0);
 	}
 
 	GLES2Renderer::~GLES2Renderer()
@@ -338,7 +339,14 @@ namespace Echo
 			Byte* idxOffset = 0; idxOffset += mesh->getStartIndex() * mesh->getIndexStride();
 
 			// draw
-			OGLESDebug(glDrawElements(glTopologyType, idxCount, idxType, idxOffset));
+			if (mesh->isInstanced())
+			{
+				OGLESDebug(glDrawElementsInstanced(glTopologyType, idxCount, idxType, idxOffset, mesh->getInstanceCount()));
+			}
+			else
+			{
+				OGLESDebug(glDrawElements(glTopologyType, idxCount, idxType, idxOffset));
+			}
 		}
 		else	// no using index buffer
 		{
@@ -346,7 +354,14 @@ namespace Echo
 			if (vertCount > 0)
 			{
 				ui32 startVert = mesh->getStartVertex();
-				OGLESDebug(glDrawArrays(glTopologyType, startVert, vertCount));
+				if (mesh->isInstanced())
+				{
+					OGLESDebug(glDrawArraysInstanced(glTopologyType, startVert, vertCount, mesh->getInstanceCount()));
+				}
+				else
+				{
+					OGLESDebug(glDrawArrays(glTopologyType, startVert, vertCount));
+				}
 			}
 			else
 			{
@@ -397,6 +412,15 @@ namespace Echo
 		}
 	}
 
+	void GLES2Renderer::setAttribDivisor(ui32 attribLocation, ui32 divisor)
+	{
+		if (m_vertexAttribDivisors[attribLocation] != divisor)
+		{
+			OGLESDebug(glVertexAttribDivisor(attribLocation, divisor));
+			m_vertexAttribDivisors[attribLocation] = divisor;
+		}
+	}
+
 	GPUBuffer* GLES2Renderer::createVertexBuffer(Dword usage, const Buffer& buff)
 	{
 		return EchoNew(GLES2GPUBuffer(GPUBuffer::GBT_VERTEX, usage, buff));
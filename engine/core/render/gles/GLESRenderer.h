@@ -32,7 +32,8 @@ namespace Echo
 	{
 		typedef vector<GLuint>::type			TexUintList;
 		typedef vector<SamplerState*>::type		SamplerList;
-		typedef array<bool, 9>					NineBoolArray;
+		typedef array<bool, 16>					AttribBoolArray;
+		typedef array<ui32, 16>					AttribDivisorArray;
 
 	public:
 		GLES2Renderer();
@@ -68,6 +69,7 @@ namespace Echo
 
 		void enableAttribLocation(ui32 attribLocation);
 		void disableAttribLocation(ui32 attribLocation);
+		void setAttribDivisor(ui32 attribLocation, ui32 divisor);
 
 		// gpu buffer
 		GPUBuffer*	createVertexBuffer(Dword usage, const Buffer& buff) override;
@@ -136,7 +138,8 @@ namespace Echo
 		ui32				m_screenWidth = 0;
 		ui32				m_screenHeight = 0;
 		std::set<GLES2SamplerState*> m_vecSamlerStates;
-		NineBoolArray		m_isVertexAttribArrayEnable;
+		AttribBoolArray		m_isVertexAttribArrayEnable;
+		AttribDivisorArray	m_vertexAttribDivisors;
         FrameBuffer*        m_windowFramebuffer = nullptr;
 
 #ifdef ECHO_EDITOR_MODE
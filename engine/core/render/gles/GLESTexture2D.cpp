@@ -115,15 +115,22 @@ namespace Echo
 				m_height = image->getHeight();
 				m_depth = image->getDepth();
 				m_pixFmt = image->getPixelFormat();
-				m_numMipmaps = image->getNumMipmaps() ? image->getNumMipmaps() : 1;
-				ui32 pixelsSize = PixelUtil::CalcSurfaceSize(m_width, m_height, m_depth, m_numMipmaps, m_pixFmt);
-				Buffer buff(pixelsSize, image->getData(), false);
 
-				set2DSurfaceData( 0, m_pixFmt, m_usage, m_width, m_height, buff);
+				// Generate mipmaps on cpu, driver generation is the fallback
+				bool isCpuMipmaps = image->getNumMipmaps() > 0;
+				if (m_isMipMapEnable && !m_compressType && !isCpuMipmaps)
+					isCpuMipmaps = image->generateMipmaps(Image::IMGFILTER_BOX, m_isSRGB);
+
+				m_numMipmaps = isCpuMipmaps ? image->getNumMipmaps() + 1 : 1;
+				for (ui32 level = 0; level < m_numMipmaps; level++)
+				{
+					PixelBox pixelBox = image->getPixelBox(0, level);
+					Buffer buff(pixelBox.getConsecutiveSize(), pixelBox.pData, false);
+					set2DSurfaceData(level, m_pixFmt, m_usage, pixelBox.getWidth(), pixelBox.getHeight(), buff);
+				}
 				EchoSafeDelete(image, Image);
 
-				// Generate mipmaps
-				if (m_isMipMapEnable && !m_compressType)
+				if (m_isMipMapEnable && !m_compressType && !isCpuMipmaps)
 				{
 					OGLESDebug(glBindTexture(GL_TEXTURE_2D, m_glesTexture));
 					OGLESDebug(glGenerateMipmap(GL_TEXTURE_2D));
@@ -1,6 +1,7 @@
 #include "engine/core/math/Rect.h"
 #include "engine/core/log/Log.h"
 #include "engine/core/io/IO.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
 #include "base/image/PixelFormat.h"
 #include "base/image/Image.h"
 #include "base/image/TextureLoader.h"
@@ -85,7 +86,9 @@ namespace Echo
 		// create gles texture
 		createCubeTexture();
 
-		// set surface data
+		// decode all faces
+		array<Image*, 6> images;
+		images.assign(nullptr);
 		for (size_t i = 0; i < m_surfaces.size(); i++)
 		{
 			const String& path = m_surfaces[i].getPath();
@@ -93,28 +96,48 @@ namespace Echo
 			if (memReader.getSize())
 			{
 				Buffer commonTextureBuffer(memReader.getSize(), memReader.getData<ui8*>(), false);
-				Image* image = Image::createFromMemory(commonTextureBuffer, Image::GetImageFormat(path));
-				if (image)
+				images[i] = Image::createFromMemory(commonTextureBuffer, Image::GetImageFormat(path));
+			}
+		}
+
+		// generate mipmaps of all faces in parallel, driver generation is the fallback
+		std::atomic<bool> isCpuMipmaps(m_isMipMapEnable && !m_compressType);
+		if (isCpuMipmaps)
+		{
+			OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(ui32(images.size()), [&](ui32 i)
+			{
+				if (!images[i] || (!images[i]->getNumMipmaps() && !images[i]->generateMipmaps(Image::IMGFILTER_BOX, m_isSRGB)))
+					isCpuMipmaps = false;
+			});
+		}
+
+		// set surface data
+		for (size_t i = 0; i < images.size(); i++)
+		{
+			Image* image = images[i];
+			if (image)
+			{
+				m_isCompressed = false;
+				m_compressType = Texture::CompressType_Unknown;
+				PixelFormat pixFmt = image->getPixelFormat();
+				m_width = image->getWidth();
+				m_height = image->getHeight();
+				m_depth = image->getDepth();
+				m_pixFmt = pixFmt;
+				m_numMipmaps = isCpuMipmaps ? image->getNumMipmaps() + 1 : 1;
+				for (ui32 level = 0; level < m_numMipmaps; level++)
 				{
-					m_isCompressed = false;
-					m_compressType = Texture::CompressType_Unknown;
-					PixelFormat pixFmt = image->getPixelFormat();
-					m_width = image->getWidth();
-					m_height = image->getHeight();
-					m_depth = image->getDepth();
-					m_pixFmt = pixFmt;
-					m_numMipmaps = image->getNumMipmaps() ? image->getNumMipmaps() : 1;
-					ui32 pixelsSize = PixelUtil::CalcSurfaceSize(m_width, m_height, m_depth, m_numMipmaps, m_pixFmt);
-					Buffer buff(pixelsSize, image->getData(), false);
-					
-					setCubeSurfaceData( static_cast<int>(i), 0, m_pixFmt, m_usage, m_width, m_height, m_numMipmaps, buff);
-					EchoSafeDelete(image, Image);
+					PixelBox pixelBox = image->getPixelBox(0, level);
+					Buffer buff(pixelBox.getConsecutiveSize(), pixelBox.pData, false);
+					setCubeSurfaceData(static_cast<int>(i), level, m_pixFmt, m_usage, pixelBox.getWidth(), pixelBox.getHeight(), m_numMipmaps, buff);
 				}
+
+				EchoSafeDelete(image, Image);
 			}
 		}
 
 		// generate mip maps
-		if (m_isMipMapEnable && !m_compressType)
+		if (m_isMipMapEnable && !m_compressType && !isCpuMipmaps)
 		{
 			OGLESDebug(glBindTexture(GL_TEXTURE_CUBE_MAP, m_glesTexture));
 			OGLESDebug(glGenerateMipmap(GL_TEXTURE_CUBE_MAP));
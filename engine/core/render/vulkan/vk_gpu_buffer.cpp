@@ -53,6 +53,22 @@ namespace Echo
         return false;
     }
 
+    bool VKBuffer::updateSubData(ui32 offset, const Buffer& buff)
+    {
+        if (m_vkBuffer && offset + buff.getSize() <= m_size)
+        {
+            // memory is host coherent, no flush needed
+            void* data = nullptr;
+            VKDebug(vkMapMemory(VKRenderer::instance()->getVkDevice(), m_vkBufferMemory, offset, buff.getSize(), 0, &data));
+            memcpy(data, buff.getData(), buff.getSize());
+            vkUnmapMemory(VKRenderer::instance()->getVkDevice(), m_vkBufferMemory);
+
+            return true;
+        }
+
+        return false;
+    }
+
     void VKBuffer::bindBuffer()
     {
 
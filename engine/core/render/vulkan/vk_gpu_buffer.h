@@ -12,6 +12,7 @@ namespace Echo
         ~VKBuffer();
 
         bool updateData(const Buffer& buff);
+        virtual bool updateSubData(ui32 offset, const Buffer& buff) override;
         void bindBuffer();
 
         // get vk buffer
@@ -28,18 +28,30 @@ namespace Echo
         {
             VKFramebuffer* vkFrameBuffer = VKFramebuffer::current();
 
-            VkVertexInputBindingDescription vertexInputBinding = {};
-            vertexInputBinding.binding = 0;
-            vertexInputBinding.stride = m_mesh->getVertexStride();
-            vertexInputBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            vector<VkVertexInputBindingDescription>::type vertexInputBindings(1);
+            vertexInputBindings[0].binding = 0;
+            vertexInputBindings[0].stride = m_mesh->getVertexStride();
+            vertexInputBindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
             vector<VkVertexInputAttributeDescription>::type viAttributeDescriptions;
-            buildVkVertexInputAttributeDescriptions(vkShaderProgram, m_mesh->getVertexElements(), viAttributeDescriptions);
+            buildVkVertexInputAttributeDescriptions(vkShaderProgram, 0, m_mesh->getVertexElements(), viAttributeDescriptions);
+
+            // instance attributes advance once per instance
+            if (m_mesh->isInstanced())
+            {
+                VkVertexInputBindingDescription instanceInputBinding = {};
+                instanceInputBinding.binding = 1;
+                instanceInputBinding.stride = m_mesh->getInstanceStride();
+                instanceInputBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+                vertexInputBindings.emplace_back(instanceInputBinding);
+
+                buildVkVertexInputAttributeDescriptions(vkShaderProgram, 1, m_mesh->getInstanceElements(), viAttributeDescriptions);
+            }
 
             VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {};
             vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-            vertexInputStateCreateInfo.pVertexBindingDescriptions = &vertexInputBinding;
+            vertexInputStateCreateInfo.vertexBindingDescriptionCount = vertexInputBindings.size();
+            vertexInputStateCreateInfo.pVertexBindingDescriptions = vertexInputBindings.data();
             vertexInputStateCreateInfo.vertexAttributeDescriptionCount = viAttributeDescriptions.size();
             vertexInputStateCreateInfo.pVertexAttributeDescriptions = viAttributeDescriptions.data();
 
@@ -101,11 +113,10 @@ namespace Echo
         return false;
     }
 
-    void VKRenderable::buildVkVertexInputAttributeDescriptions(VKShaderProgram* vkShaderProgram, const VertexElementList& vertElements, vector<VkVertexInputAttributeDescription>::type& viAttributeDescriptions)
+    void VKRenderable::buildVkVertexInputAttributeDescriptions(VKShaderProgram* vkShaderProgram, ui32 binding, const VertexElementList& vertElements, vector<VkVertexInputAttributeDescription>::type& viAttributeDescriptions)
     {
         if (!vertElements.empty())
         {
-            const i32 bufferIdx = 1;
             ui32 elementOffset = 0;
             for (size_t i = 0; i < vertElements.size(); i++)
             {
@@ -115,7 +126,7 @@ namespace Echo
                     const spirv_cross::Compiler* compiler = vkShaderProgram->getSpirvShaderCompiler(ShaderProgram::VS);
 
                     VkVertexInputAttributeDescription attributeDescription;
-                    attributeDescription.binding = compiler->get_decoration(spirvResource.id, spv::DecorationBinding);
+                    attributeDescription.binding = binding;
                     attributeDescription.location = compiler->get_decoration(spirvResource.id, spv::DecorationLocation);
                     attributeDescription.format = VKMapping::MapVertexFormat(vertElements[i].m_pixFmt);
                     attributeDescription.offset = elementOffset;
@@ -172,6 +183,14 @@ namespace Echo
             vkCmdBindVertexBuffers(VKFramebuffer::current()->getVkCommandbuffer(), 0, 1, &vkBuffer, offsets);
         }
 
+        VKBuffer* instanceBuffer = ECHO_DOWN_CAST<VKBuffer*>(m_mesh->getInstanceBuffer());
+        if (instanceBuffer)
+        {
+            VkDeviceSize offsets[1] = { 0 };
+            VkBuffer vkBuffer = instanceBuffer->getVkBuffer();
+            vkCmdBindVertexBuffers(VKFramebuffer::current()->getVkCommandbuffer(), 1, 1, &vkBuffer, offsets);
+        }
+
         VKBuffer* indexBuffer = ECHO_DOWN_CAST<VKBuffer*>(m_mesh->getIndexBuffer());
         if (indexBuffer)
         {
@@ -30,7 +30,7 @@ namespace Echo
 
 	private:
         // build vertex input attribute
-        void buildVkVertexInputAttributeDescriptions(VKShaderProgram* vkShaderProgram, const VertexElementList& vertElements, vector<VkVertexInputAttributeDescription>::type& viAttributeDescriptions);
+        void buildVkVertexInputAttributeDescriptions(VKShaderProgram* vkShaderProgram, ui32 binding, const VertexElementList& vertElements, vector<VkVertexInputAttributeDescription>::type& viAttributeDescriptions);
 
         // get vertex attribute by semantic
         bool getVkVertexAttributeBySemantic(VertexSemantic semantic, spirv_cross::Resource& oResource);
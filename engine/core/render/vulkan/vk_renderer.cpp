@@ -332,19 +332,20 @@ namespace Echo
             vkRenderable->bindGeometry();
 
 			MeshPtr mesh = renderable->getMesh();
+            ui32 instanceCount = mesh->isInstanced() ? mesh->getInstanceCount() : 1;
             if (mesh->getIndexBuffer())
             {
                 ui32 idxCount = mesh->getIndexCount();
                 ui32 idxOffset = mesh->getStartIndex();
 
-                vkCmdDrawIndexed(vkCommandbuffer, idxCount, 1, idxOffset, 0, 0);
+                vkCmdDrawIndexed(vkCommandbuffer, idxCount, instanceCount, idxOffset, 0, 0);
             }
             else
             {
                 ui32 vertCount = mesh->getVertexCount();
                 ui32 startVert = mesh->getStartVertex();
 
-                vkCmdDraw(vkCommandbuffer, vertCount, 1, startVert, 0);
+                vkCmdDraw(vkCommandbuffer, vertCount, instanceCount, startVert, 0);
             }
         }
     }
@@ -36,6 +36,9 @@ namespace Echo
 
 		virtual void update(float delta, bool bUpdateChildren) override;
 
+		// proxy in the 2d or 3d bvh of the node tree
+		i32 getBvhNodeId() const { return m_bvhNodeId; }
+
 	public:
 		// get global uniforms
 		virtual void* getGlobalUniformValue(const String& name);
@@ -37,6 +37,9 @@ namespace Echo
 		// wait finished
 		void waitForEffectSystemUpdateComplete();
 
+		// thread pool
+		CpuThreadPool* getThreadPool() { return m_threadPool; }
+
 	private:
 		OpenMPTaskMgr();
 
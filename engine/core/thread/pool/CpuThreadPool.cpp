@@ -5,103 +5,125 @@
 
 namespace Echo
 {
-	// 캯
+	// job used by parallelFor, every helper grabs indices until none left
+	struct ParallelForJob : public CpuThreadPool::Job
+	{
+		const std::function<void(ui32)>*	m_func = nullptr;
+		std::atomic<ui32>*					m_next = nullptr;
+		std::atomic<ui32>*					m_activeHelpers = nullptr;
+		ui32								m_count = 0;
+
+		virtual bool process() override
+		{
+			for (ui32 i = (*m_next)++; i < m_count; i = (*m_next)++)
+				(*m_func)(i);
+
+			(*m_activeHelpers)--;
+			return true;
+		}
+
+		virtual int getType() override { return -1; }
+	};
+
 	CpuThreadPool::CpuThreadPool(const CpuThreadPool::Cinfo& info, CpuThreadPool::StartThreadsMode mode)
 	{
-	//	m_numOfJobsProcessed.assign(0);
-
-	//	// źʼ
-	//	for (scl::semaphore& sem : m_semaphores)
-	//	{
-	//		sem.create();
-	//	}
-	//		
-	//	// ߳
-	//	if (mode == STM_OnConstruction)
-	//	{
-	//		startThreads( info);
-	//	}
+		m_numOfJobsProcessed.assign(0);
+
+		if (mode == STM_OnConstruction)
+		{
+			startThreads( info);
+		}
 	}
 
-	// 
 	CpuThreadPool::~CpuThreadPool()
 	{
-
+		stop();
 	}
 
-	// ߳,ֻеʱSTM_Manually²ſԵô˺
 	void CpuThreadPool::startThreads(const Cinfo& info)
 	{
 #ifdef ECHO_PLATFORM_HTML5
 		// do nothing
 #else
+		EchoAssert(!m_info.m_numThreads);
+
+		m_info = info;
+		if (m_info.m_numThreads > m_workerThreads.size())
+		{
+			EchoLogWarning( "You requested more threads than the CpuThreadPool supports - see m_workerThreads");
+			m_info.m_numThreads = ui32(m_workerThreads.size());
+		}
 
-		//EchoAssert(!m_info.m_numThreads && info.m_numThreads>0);
-
-		//// ȷ߳
-		//m_info = info;
-		//if (m_info.m_numThreads > m_workerThreads.size() || m_info.m_numThreads<1)
-		//{
-		//	EchoLogWarning( "You requested more or less threads than the CpuThreadPool supports - see MAX_NUM_THREADS");
-		//	m_info.m_numThreads = std::max<int>(m_info.m_numThreads, 1);
-		//	m_info.m_numThreads = std::min<int>(m_info.m_numThreads, m_workerThreads.size());
-		//}
-
-		//// ߳
-		//for (ui32 i = 0; i < m_info.m_numThreads; i++)
-		//{
-		//	ThreadData& threadData = m_workerThreads[i];
-		//	threadData.m_threadPool = this;
-		//	threadData.m_killThread = false;
-
- 	//		// Worker thread IDs start from 1, 0 is reserved for the main thread
- 	//		threadData.m_threadId = i + 1;
-  //          auto localThread = std::thread(CpuThreadPool::threadMainForwarder, std::ref(threadData));
- 	//		threadData.m_thread.swap(localThread);
- 	//		threadData.m_buffer.alloc(1024 * 32);
-		//}
+		m_isStopped = false;
+		for (ui32 i = 0; i < m_info.m_numThreads; i++)
+		{
+			ThreadData& threadData = m_workerThreads[i];
+			threadData.m_threadPool = this;
+
+			// Worker thread IDs start from 1, 0 is reserved for the main thread
+			threadData.m_threadId = i + 1;
+			threadData.m_thread = std::thread(CpuThreadPool::threadMainForwarder, std::ref(threadData));
+		}
 #endif
 	}
 
-	// ߳ں
 	void CpuThreadPool::threadMainForwarder(CpuThreadPool::ThreadData& threadData)
 	{
 		threadData.m_threadPool->threadMain(threadData.m_threadId - 1);
 	}
 
-	// ߳
 	void CpuThreadPool::threadMain(int threadIndex)
 	{
-	//	ThreadData& threadData = m_workerThreads[threadIndex];
-
-	//	// ѭ
-	//	while (true)
-	//	{
-	//		if (threadData.m_buffer.used()>=sizeof(JobInfo))
-	//		{
-	//			JobInfo jobInfo;
-	//			threadData.m_buffer.peek(&jobInfo, sizeof(JobInfo));
-	//			jobInfo.m_job->process();
-
-	//			threadData.m_buffer.drop(sizeof(JobInfo));
-
-	//			// ߳
-	//			if (m_info.m_isBlocking)
-	//				m_semaphores[jobInfo.m_job->getType()].post();
-	//		}
-	//		else
-	//		{
-	//			// ֹ߳
-	//			if (threadData.m_killThread)
-	//				return;
-
-	//			// ̹߳
-	//			threadData.m_semaphore.wait();
-	//		}
-	//	}
+		while (true)
+		{
+			JobInfo jobInfo;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_jobCondition.wait(lock, [this]() { return m_isStopped || !m_jobs.empty(); });
+				if (m_jobs.empty())
+					return;
+
+				jobInfo = m_jobs.front();
+				m_jobs.pop_front();
+			}
+
+			// the job may be released by its owner as soon as process returns
+			int type = jobInfo.m_job->getType();
+			jobInfo.m_job->process();
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (type >= 0)
+					m_numOfJobsProcessed[type]--;
+			}
+			m_completeCondition.notify_all();
+		}
+	}
+
+	bool CpuThreadPool::processOneJob()
+	{
+		JobInfo jobInfo;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_jobs.empty())
+				return false;
+
+			jobInfo = m_jobs.front();
+			m_jobs.pop_front();
+		}
+
+		// the job may be released by its owner as soon as process returns
+		int type = jobInfo.m_job->getType();
+		jobInfo.m_job->process();
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (type >= 0)
+				m_numOfJobsProcessed[type]--;
+		}
+		m_completeCondition.notify_all();
+
+		return true;
 	}
 
-	// 
 	void CpuThreadPool::processJobs(CpuThreadPool::Job** jobs, int numOfJobs)
 	{
 #ifdef ECHO_PLATFORM_HTML5
@@ -110,73 +132,112 @@ namespace Echo
 			jobs[i]->process();
 		}
 #else
-		//for (int i = 0; i < numOfJobs; i++)
-		//{
-		//	// ȡ߳
-		//	int taskNum = 65535;
-		//	int threadIdx = 0;
-		//	ThreadData& threadData = m_workerThreads[threadIdx];
-
-		//	JobInfo jobInfo;
-		//	jobInfo.m_job = jobs[i];
-
-		//	const int freelen = threadData.m_buffer.free();
-		//	if (freelen > sizeof(JobInfo))
-		//	{
-		//		threadData.m_buffer.write(&jobInfo, sizeof(JobInfo));
-		//		m_numOfJobsProcessed[jobInfo.m_job->getType()]++;
-
-		//		// ѶӦ߳
-		//		threadData.m_semaphore.post();
-		//	}
-		//	else
-		//	{
-		//		EchoLogWarning("CpuThreadPool::processJobs. RingBuffer don't have enough memory space.");
-		//	}
-		//}
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (int i = 0; i < numOfJobs; i++)
+			{
+				JobInfo jobInfo;
+				jobInfo.m_job = jobs[i];
+				m_jobs.push_back(jobInfo);
+
+				int type = jobs[i]->getType();
+				if (type >= 0)
+				{
+					EchoAssert(type < MAX_JOB_TYPES);
+					m_numOfJobsProcessed[type]++;
+				}
+			}
+		}
+		m_jobCondition.notify_all();
 #endif
 	}
 
-	// ȴ
 	void CpuThreadPool::waitForComplete(int type)
 	{
 #ifdef ECHO_PLATFORM_HTML5
 		// do nothing
 #else
-		//EchoAssert(m_info.m_isBlocking);
+		EchoAssert(m_info.m_isBlocking);
 
-		//// ߳
-		//if (m_info.m_isBlocking)
-		//{
-		//	for (int i = 0; i < m_numOfJobsProcessed[type]; i++)
-		//		m_semaphores[type].wait();
-
-		//	m_numOfJobsProcessed[type] = 0;
-		//}
+		// help the workers instead of sleeping, also makes zero thread pools work
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				if (m_numOfJobsProcessed[type] <= 0)
+					break;
+			}
+
+			if (!processOneJob())
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_completeCondition.wait(lock, [this, type]() { return m_numOfJobsProcessed[type] <= 0 || !m_jobs.empty(); });
+			}
+		}
 #endif
 	}
 
-	// ȡʹõ߳
+	void CpuThreadPool::parallelFor(ui32 count, const std::function<void(ui32)>& func)
+	{
+		ui32 numHelpers = std::min<ui32>(m_info.m_numThreads, count > 0 ? count - 1 : 0);
+		if (!numHelpers)
+		{
+			for (ui32 i = 0; i < count; i++)
+				func(i);
+
+			return;
+		}
+
+		std::atomic<ui32> next(0);
+		std::atomic<ui32> activeHelpers(numHelpers);
+
+		vector<ParallelForJob>::type helpers(numHelpers);
+		vector<Job*>::type jobs(numHelpers);
+		for (ui32 i = 0; i < numHelpers; i++)
+		{
+			helpers[i].m_func = &func;
+			helpers[i].m_next = &next;
+			helpers[i].m_activeHelpers = &activeHelpers;
+			helpers[i].m_count = count;
+			jobs[i] = &helpers[i];
+		}
+		processJobs(jobs.data(), int(jobs.size()));
+
+		// calling thread works too
+		for (ui32 i = next++; i < count; i = next++)
+			func(i);
+
+		// helpers reference this stack frame, wait until all of them returned
+		while (activeHelpers > 0)
+		{
+			if (!processOneJob())
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_completeCondition.wait(lock, [&activeHelpers, this]() { return activeHelpers <= 0 || !m_jobs.empty(); });
+			}
+		}
+	}
+
 	int CpuThreadPool::getNumThreads() const
 	{
 		return m_info.m_numThreads;
 	}
 
-	// ֹ
 	void CpuThreadPool::stop()
 	{
-		//// ִ˳
-		//for (int i = 0; i < getNumThreads(); i++)
-		//{
-		//	// ȡ߳
-		//	ThreadData& threadData = m_workerThreads[i];
-
-		//	// ѶӦ߳
-		//	threadData.m_killThread = true;
-		//	threadData.m_semaphore.post();
-
-		//	// ȴ
-		//	threadData.m_thread.join();
-		//}
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_isStopped = true;
+		}
+		m_jobCondition.notify_all();
+
+		for (ui32 i = 0; i < m_info.m_numThreads; i++)
+		{
+			ThreadData& threadData = m_workerThreads[i];
+			if (threadData.m_thread.joinable())
+				threadData.m_thread.join();
+		}
+
+		m_info.m_numThreads = 0;
 	}
 }
@@ -1,23 +1,30 @@
 #pragma once
 
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
 #include <engine/core/util/Array.hpp>
+#include <engine/core/memory/MemAllocDef.h>
 
 namespace Echo
 {
 	/**
-	 * CPU̳߳ʵ
+	 * Cpu thread pool
 	 */
 	class CpuThreadPool
 	{
 	public:
-		// Ϣ
+		// max job types
+		static const int MAX_JOB_TYPES = 24;
+
+		// create info
 		struct Cinfo
 		{
-			ui32		m_numThreads;		// ߳
-			bool		m_isBlocking;		// ִйʱǷ߳
+			ui32		m_numThreads;		// worker thread count
+			bool		m_isBlocking;		// main thread can wait for jobs of one type
 
-			// 캯
 			Cinfo()
 			{
 				m_numThreads = 0;
@@ -25,11 +32,11 @@ namespace Echo
 			}
 		};
 
-		// ̳߳ؿʼ״̬
+		// start mode
 		enum StartThreadsMode
 		{
-			STM_OnConstruction,		// 
-			STM_Manually,			// ֶstartThreads
+			STM_OnConstruction,		// start threads in constructor
+			STM_Manually,			// start threads by calling startThreads
 		};
 
 		/**
@@ -41,71 +48,75 @@ namespace Echo
 			Job(){}
 			virtual ~Job(){}
 
-			// 
+			// process (worker thread)
 			virtual bool process() = 0;
 
-			// ɺ(߳)
+			// called after process finished (main thread)
 			virtual bool onFinished() { return true; }
 
-			// ȡ
+			// job type, negative type jobs are not counted by waitForComplete
 			virtual int getType() = 0;
 		};
 
-
-		// Ϣ
+		// job info
 		struct JobInfo
 		{
 			Job*	m_job;
 		};
 
-		// ߳״̬
+		// worker thread data
 		struct ThreadData
 		{
-			CpuThreadPool*			m_threadPool;		// Ӧ̳߳
-			int						m_threadId;			// ߳Id (0-N)
-			std::thread				m_thread;			// ߳
-			//scl::semaphore			m_semaphore;		// źͣ߳
-			//scl::ring_buffer		m_buffer;			// 
-			bool					m_killThread;		// λ̱߳ҪرʱΪtrue
-
-			// 캯
+			CpuThreadPool*			m_threadPool;		// owner
+			int						m_threadId;			// thread id (1-N), 0 is main thread
+			std::thread				m_thread;			// thread
+
 			ThreadData()
 				: m_threadPool( NULL)
-			{
-				//m_semaphore.create();
-			}
+				, m_threadId(0)
+			{}
 		};
 
 	public:
 		CpuThreadPool(const Cinfo& info, StartThreadsMode mode=STM_OnConstruction);
 		virtual ~CpuThreadPool();
 
-		// ߳,ֻеʱSTM_Manually²ſԵô˺
+		// start threads, only call this when mode is STM_Manually
 		void startThreads(const Cinfo& info);
 
-		// ()
+		// process jobs (non blocking)
 		void processJobs(Job** jobs, int numOfJobs);
 
-		// ȴ(Ҫ߳Ϊģʽ)
+		// wait for all jobs of one type complete (blocking mode only)
 		void waitForComplete( int type);
 
-		// ȡʹõ߳
+		// run func(0..count-1) on workers and the calling thread, returns when all done
+		void parallelFor(ui32 count, const std::function<void(ui32)>& func);
+
+		// thread count
 		int getNumThreads() const;
 
-		// ֹ
+		// stop
 		void stop();
 
 	protected:
-		// ߳ں
+		// thread entry
 		static void threadMainForwarder(ThreadData& threadData);
 
-		// ߳
+		// worker thread loop
 		void threadMain(int threadIndex);
 
+		// pop and process one queued job, return false if queue is empty
+		bool processOneJob();
+
 	private:
-		Cinfo						m_info;								// ǰ߳
-		array<ThreadData, 32>		m_workerThreads;					// ߳
-		//array<scl::semaphore, 24>	m_semaphores;						// ź̵߳ȴ
-		//array<int, 24>				m_numOfJobsProcessed;				// ̴߳Ӧ
+		Cinfo						m_info;								// current info
+		array<ThreadData, 32>		m_workerThreads;					// worker threads
+		deque<JobInfo>::type		m_jobs;								// queued jobs
+		std::mutex					m_mutex;							// guards jobs and counters
+		std::condition_variable		m_jobCondition;						// signaled when a job is queued
+		std::condition_variable		m_completeCondition;				// signaled when a job is finished
+		array<int, MAX_JOB_TYPES>	m_numOfJobsProcessed;				// unfinished job count of each type
+		bool						m_isStopped = false;
 	};
 }
@@ -0,0 +1,371 @@
+#define DR_MP3_IMPLEMENTATION
+#include "audio_buffer.h"
+#include "dr_libs/dr_flac.h"
+#define DR_WAV_IMPLEMENTATION
+#include "dr_libs/dr_wav.h"
+#include "audio_device.h"
+#include "engine/core/log/Log.h"
+
+namespace Echo
+{
+	static bool initMp3(drmp3& mp3, MemoryReader* reader)
+	{
+		drmp3_config config;
+		config.outputChannels = 1;
+		config.outputSampleRate = DR_MP3_DEFAULT_SAMPLE_RATE;
+
+		return drmp3_init_memory(&mp3, reader->getData<const void*>(), reader->getSize(), &config) ? true : false;
+	}
+
+	AudioStream::AudioStream(MemoryReader* reader)
+		: m_reader(reader)
+		, m_isLoop(false)
+		, m_isEnd(false)
+	{
+		m_isValid = initMp3(m_mp3, m_reader);
+
+		// without a seek table every seek decodes from the start of the file
+		if (m_isValid)
+		{
+			drmp3_uint32 seekPointCount = SEEK_POINT_COUNT;
+			m_seekPoints.resize(seekPointCount);
+			if (drmp3_calculate_seek_points(&m_mp3, &seekPointCount, m_seekPoints.data()))
+			{
+				m_seekPoints.resize(seekPointCount);
+				drmp3_bind_seek_table(&m_mp3, seekPointCount, m_seekPoints.data());
+			}
+			else
+			{
+				m_seekPoints.clear();
+			}
+		}
+
+		alGenBuffers(BUFFER_COUNT, m_buffers);
+		m_freeBuffers.assign(m_buffers, m_buffers + BUFFER_COUNT);
+
+		if (m_isValid)
+			AudioDevice::instance()->getStreamDecoder()->addStream(this);
+	}
+
+	AudioStream::~AudioStream()
+	{
+		if (m_isValid)
+		{
+			AudioDevice::instance()->getStreamDecoder()->removeStream(this);
+			drmp3_uninit(&m_mp3);
+		}
+
+		alDeleteBuffers(BUFFER_COUNT, m_buffers);
+		EchoSafeDelete(m_reader, MemoryReader);
+	}
+
+	void AudioStream::play(ALuint source, float offset)
+	{
+		ALint state = AL_STOPPED;
+		alGetSourcei(source, AL_SOURCE_STATE, &state);
+		if (state == AL_PAUSED)
+		{
+			alSourcePlay(source);
+			return;
+		}
+
+		detach(source);
+		rewind(drmp3_uint64(std::max<float>(offset, 0.f) * m_mp3.sampleRate));
+
+		// don't wait for the decoder thread to hear the first chunks
+		for (ui32 i = 0; i < BUFFER_COUNT && decode(); i++) {}
+
+		m_isPlaying = true;
+		update(source);
+	}
+
+	void AudioStream::stop(ALuint source)
+	{
+		detach(source);
+		rewind(0);
+	}
+
+	void AudioStream::detach(ALuint source)
+	{
+		// detaching returns every queued buffer
+		alSourceStop(source);
+		alSourcei(source, AL_BUFFER, 0);
+		m_freeBuffers.assign(m_buffers, m_buffers + BUFFER_COUNT);
+		m_isPlaying = false;
+	}
+
+	void AudioStream::rewind(drmp3_uint64 frame)
+	{
+		std::lock_guard<std::mutex> decodeLock(m_decodeMutex);
+		drmp3_seek_to_pcm_frame(&m_mp3, frame);
+		m_isEnd = false;
+
+		std::lock_guard<std::mutex> chunkLock(m_chunkMutex);
+		m_chunks.clear();
+	}
+
+	void AudioStream::update(ALuint source)
+	{
+		if (!m_isPlaying)
+			return;
+
+#ifdef ECHO_PLATFORM_HTML5
+		while (decode()) {}
+#endif
+
+		ALint processed = 0;
+		alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+		for (ALint i = 0; i < processed; i++)
+		{
+			ALuint buffer = 0;
+			alSourceUnqueueBuffers(source, 1, &buffer);
+			m_freeBuffers.emplace_back(buffer);
+		}
+
+		bool isConsumed = false;
+		while (!m_freeBuffers.empty())
+		{
+			vector<i16>::type chunk;
+			{
+				std::lock_guard<std::mutex> lock(m_chunkMutex);
+				if (m_chunks.empty())
+					break;
+
+				chunk.swap(m_chunks.front());
+				m_chunks.pop_front();
+			}
+
+			ALuint buffer = m_freeBuffers.back();
+			m_freeBuffers.pop_back();
+			alBufferData(buffer, AL_FORMAT_MONO16, chunk.data(), ALsizei(chunk.size() * sizeof(i16)), m_mp3.sampleRate);
+			alSourceQueueBuffers(source, 1, &buffer);
+			isConsumed = true;
+		}
+
+		if (isConsumed)
+			AudioDevice::instance()->getStreamDecoder()->notify();
+
+		// first start, or starved and stopped by openal
+		ALint state = AL_STOPPED;
+		ALint queued = 0;
+		alGetSourcei(source, AL_SOURCE_STATE, &state);
+		alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+		if (state != AL_PLAYING && state != AL_PAUSED)
+		{
+			if (queued > 0)
+			{
+				alSourcePlay(source);
+			}
+			else if (m_isEnd)
+			{
+				std::lock_guard<std::mutex> lock(m_chunkMutex);
+				m_isPlaying = !m_chunks.empty();
+			}
+		}
+	}
+
+	bool AudioStream::decode()
+	{
+		std::lock_guard<std::mutex> decodeLock(m_decodeMutex);
+		if (m_isEnd)
+			return false;
+
+		{
+			std::lock_guard<std::mutex> chunkLock(m_chunkMutex);
+			if (m_chunks.size() >= BUFFER_COUNT)
+				return false;
+		}
+
+		m_pcm.resize(BUFFER_FRAMES);
+		drmp3_uint64 framesRead = drmp3_read_pcm_frames_f32(&m_mp3, BUFFER_FRAMES, m_pcm.data());
+		if (framesRead < BUFFER_FRAMES)
+		{
+			if (m_isLoop)
+				drmp3_seek_to_pcm_frame(&m_mp3, 0);
+			else
+				m_isEnd = true;
+		}
+
+		if (framesRead > 0)
+		{
+			vector<i16>::type chunk(static_cast<size_t>(framesRead));
+			drwav_f32_to_s16(chunk.data(), m_pcm.data(), size_t(framesRead));
+
+			std::lock_guard<std::mutex> chunkLock(m_chunkMutex);
+			m_chunks.emplace_back();
+			m_chunks.back().swap(chunk);
+		}
+
+		return framesRead > 0;
+	}
+
+	AudioStreamDecoder::AudioStreamDecoder()
+	{
+#ifndef ECHO_PLATFORM_HTML5
+		m_thread = std::thread(&AudioStreamDecoder::run, this);
+#endif
+	}
+
+	AudioStreamDecoder::~AudioStreamDecoder()
+	{
+#ifndef ECHO_PLATFORM_HTML5
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isExit = true;
+		}
+
+		m_condition.notify_one();
+		m_thread.join();
+#endif
+	}
+
+	void AudioStreamDecoder::addStream(AudioStream* stream)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_streams.emplace_back(stream);
+	}
+
+	void AudioStreamDecoder::removeStream(AudioStream* stream)
+	{
+		// waits for the stream being decoded
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_streams.erase(std::remove(m_streams.begin(), m_streams.end(), stream), m_streams.end());
+	}
+
+	void AudioStreamDecoder::notify()
+	{
+		m_condition.notify_one();
+	}
+
+	void AudioStreamDecoder::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_isExit)
+		{
+			bool isDecoded = false;
+			for (AudioStream* stream : m_streams)
+				isDecoded = stream->decode() || isDecoded;
+
+			// sleep until a chunk is consumed, wake up now and then in case a notify was missed
+			if (!isDecoded)
+				m_condition.wait_for(lock, std::chrono::milliseconds(50));
+		}
+	}
+
+	AudioClipCache::AudioClipCache()
+	{
+	}
+
+	AudioClipCache::~AudioClipCache()
+	{
+		for (Clip& clip : m_clips)
+			alDeleteBuffers(1, &clip.m_buffer);
+	}
+
+	bool AudioClipCache::load(const String& path, ALuint& oBuffer, AudioStream*& oStream)
+	{
+		oBuffer = 0;
+		oStream = nullptr;
+
+		for (ClipList::iterator it = m_clips.begin(); it != m_clips.end(); it++)
+		{
+			if (it->m_path == path)
+			{
+				it->m_refCount++;
+				m_clips.splice(m_clips.begin(), m_clips, it);
+				oBuffer = m_clips.front().m_buffer;
+				return true;
+			}
+		}
+
+		MemoryReader* reader = EchoNew(MemoryReader(path));
+		drmp3 mp3;
+		if (!reader->getSize() || !initMp3(mp3, reader))
+		{
+			EchoLogError("AudioClipCache: Could not decode [%s].", path.c_str());
+			EchoSafeDelete(reader, MemoryReader);
+			return false;
+		}
+
+		// estimated from the bitrate of the first frame, counting frames would decode the whole file
+		float duration = mp3.frameInfo.bitrate_kbps > 0 ? reader->getSize() * 8.f / (mp3.frameInfo.bitrate_kbps * 1000.f) : 0.f;
+		if (duration > m_streamingDuration)
+		{
+			drmp3_uninit(&mp3);
+
+			oStream = EchoNew(AudioStream(reader));
+			if (!oStream->isValid())
+			{
+				EchoSafeDelete(oStream, AudioStream);
+				return false;
+			}
+
+			oStream->setDuration(duration);
+
+			return true;
+		}
+
+		drmp3_uint64 frameCount = drmp3_get_pcm_frame_count(&mp3);
+		float* audioBuffer = new float[frameCount];
+		i16* audioBuffer16 = new i16[frameCount];
+		drmp3_uint64 framesRead = drmp3_read_pcm_frames_f32(&mp3, frameCount, audioBuffer);
+		if (framesRead > 0)
+		{
+			Clip clip;
+			clip.m_path = path;
+			clip.m_bytes = ui32(framesRead * sizeof(i16));
+			clip.m_refCount = 1;
+			alGenBuffers(1, &clip.m_buffer);
+
+			drwav_f32_to_s16(audioBuffer16, audioBuffer, framesRead);
+			alBufferData(clip.m_buffer, AL_FORMAT_MONO16, audioBuffer16, ALsizei(clip.m_bytes), mp3.sampleRate);
+
+			oBuffer = clip.m_buffer;
+			m_usedBytes += clip.m_bytes;
+			m_clips.emplace_front(clip);
+		}
+
+		delete[] audioBuffer;
+		delete[] audioBuffer16;
+		drmp3_uninit(&mp3);
+		EchoSafeDelete(reader, MemoryReader);
+
+		evict();
+
+		return oBuffer != 0;
+	}
+
+	void AudioClipCache::release(ALuint buffer)
+	{
+		for (Clip& clip : m_clips)
+		{
+			if (clip.m_buffer == buffer)
+			{
+				clip.m_refCount--;
+				break;
+			}
+		}
+
+		evict();
+	}
+
+	void AudioClipCache::setBudget(ui32 budget)
+	{
+		m_budget = budget;
+		evict();
+	}
+
+	void AudioClipCache::evict()
+	{
+		for (ClipList::iterator it = m_clips.end(); it != m_clips.begin() && m_usedBytes > m_budget;)
+		{
+			it--;
+			if (it->m_refCount == 0)
+			{
+				alDeleteBuffers(1, &it->m_buffer);
+				m_usedBytes -= it->m_bytes;
+				it = m_clips.erase(it);
+			}
+		}
+	}
+}
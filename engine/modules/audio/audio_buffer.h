@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "engine/core/io/MemoryReader.h"
+#include "audio_base.h"
+#include "dr_libs/dr_mp3.h"
+
+namespace Echo
+{
+	/**
+	 * Streamed clip
+	 * The compressed file stays in memory, pcm is decoded a chunk ahead on the
+	 * decoder thread and fed to the source through a rotating queue of buffers.
+	 */
+	class AudioStream
+	{
+	public:
+		static const ui32 BUFFER_COUNT = 4;
+		static const ui32 BUFFER_FRAMES = 16384;		// about 0.37s at 44.1khz
+		static const ui32 SEEK_POINT_COUNT = 512;		// spread over the file, seeks decode from the nearest one
+
+	public:
+		AudioStream(MemoryReader* reader);
+		~AudioStream();
+
+		// decoder is ready
+		bool isValid() const { return m_isValid; }
+
+		// loop, restarts decoding at the end instead of AL_LOOPING
+		void setLoop(bool isLoop) { m_isLoop = isLoop; }
+
+		// estimated duration in seconds
+		float getDuration() const { return m_duration; }
+		void setDuration(float duration) { m_duration = duration; }
+
+		// operates, main thread. paused source resumes, otherwise plays from offset seconds
+		void play(ALuint source, float offset = 0.f);
+		void stop(ALuint source);
+
+		// queue decoded chunks on source, main thread, every frame
+		void update(ALuint source);
+
+		// playing until the last chunk is drained
+		bool isPlaying() const { return m_isPlaying; }
+
+		// decode one chunk, return false if nothing to do
+		bool decode();
+
+	private:
+		// stop source and take back its buffers
+		void detach(ALuint source);
+
+		// seek to frame, drop decoded chunks
+		void rewind(drmp3_uint64 frame);
+
+	private:
+		MemoryReader*					m_reader = nullptr;
+		drmp3							m_mp3;
+		vector<drmp3_seek_point>::type	m_seekPoints;			// bound to m_mp3
+		bool							m_isValid = false;
+		ALuint							m_buffers[BUFFER_COUNT];
+		vector<ALuint>::type			m_freeBuffers;
+		std::mutex						m_decodeMutex;
+		std::mutex						m_chunkMutex;
+		vector<float>::type				m_pcm;					// decode scratch
+		list<vector<i16>::type>::type	m_chunks;				// decoded, waiting for a free buffer
+		std::atomic<bool>				m_isLoop;
+		std::atomic<bool>				m_isEnd;				// decoder reached the end
+		bool							m_isPlaying = false;
+		float							m_duration = 0.f;
+	};
+
+	/**
+	 * Decoder thread
+	 * Keeps every registered stream a few chunks ahead of it's source.
+	 */
+	class AudioStreamDecoder
+	{
+	public:
+		AudioStreamDecoder();
+		~AudioStreamDecoder();
+
+		// streams
+		void addStream(AudioStream* stream);
+		void removeStream(AudioStream* stream);
+
+		// a stream consumed chunks
+		void notify();
+
+	private:
+		// thread loop
+		void run();
+
+	private:
+		std::thread						m_thread;
+		std::mutex						m_mutex;
+		std::condition_variable			m_condition;
+		vector<AudioStream*>::type		m_streams;
+		bool							m_isExit = false;
+	};
+
+	/**
+	 * Clip cache
+	 * Short clips are fully decoded once and their buffer shared by every player,
+	 * unused ones are dropped least recently used first when over budget.
+	 * Clips longer than the streaming duration get an AudioStream instead.
+	 */
+	class AudioClipCache
+	{
+	public:
+		// decoded clip
+		struct Clip
+		{
+			String		m_path;
+			ALuint		m_buffer = 0;
+			ui32		m_bytes = 0;
+			ui32		m_refCount = 0;
+		};
+		typedef list<Clip>::type ClipList;
+
+	public:
+		AudioClipCache();
+		~AudioClipCache();
+
+		// short clip sets oBuffer, long one sets oStream
+		bool load(const String& path, ALuint& oBuffer, AudioStream*& oStream);
+
+		// player doesn't use buffer anymore
+		void release(ALuint buffer);
+
+		// memory budget of decoded clips in bytes
+		ui32 getBudget() const { return m_budget; }
+		void setBudget(ui32 budget);
+
+		// clips longer than this are streamed
+		float getStreamingDuration() const { return m_streamingDuration; }
+		void setStreamingDuration(float duration) { m_streamingDuration = duration; }
+
+		// stats
+		ui32 getUsedBytes() const { return m_usedBytes; }
+
+	private:
+		// drop unused clips until under budget
+		void evict();
+
+	private:
+		ClipList	m_clips;							// most recently used first
+		ui32		m_budget = 32 * 1024 * 1024;
+		ui32		m_usedBytes = 0;
+		float		m_streamingDuration = 10.f;
+	};
+}
@@ -27,10 +27,17 @@ namespace Echo
 			EchoLogError("make openal context failed.");
 		}
 
+		m_clipCache = EchoNew(AudioClipCache);
+		m_streamDecoder = EchoNew(AudioStreamDecoder);
+		m_voiceManager = EchoNew(AudioVoiceManager(32));
 	}
 
 	AudioDevice::~AudioDevice()
 	{
+		EchoSafeDelete(m_voiceManager, AudioVoiceManager);
+		EchoSafeDelete(m_streamDecoder, AudioStreamDecoder);
+		EchoSafeDelete(m_clipCache, AudioClipCache);
+
 		alcMakeContextCurrent(nullptr);
 		alcDestroyContext(m_context);
 		alcCloseDevice(m_device);
@@ -38,6 +45,33 @@ namespace Echo
 
 	void AudioDevice::bindMethods()
 	{
+		CLASS_BIND_METHOD(AudioDevice, getClipCacheBudget, DEF_METHOD("getClipCacheBudget"));
+		CLASS_BIND_METHOD(AudioDevice, setClipCacheBudget, DEF_METHOD("setClipCacheBudget"));
+		CLASS_BIND_METHOD(AudioDevice, getStreamingDuration, DEF_METHOD("getStreamingDuration"));
+		CLASS_BIND_METHOD(AudioDevice, setStreamingDuration, DEF_METHOD("setStreamingDuration"));
+		CLASS_BIND_METHOD(AudioDevice, getVoiceLimit, DEF_METHOD("getVoiceLimit"));
+		CLASS_BIND_METHOD(AudioDevice, setVoiceLimit, DEF_METHOD("setVoiceLimit"));
+		CLASS_BIND_METHOD(AudioDevice, getAudibilityThreshold, DEF_METHOD("getAudibilityThreshold"));
+		CLASS_BIND_METHOD(AudioDevice, setAudibilityThreshold, DEF_METHOD("setAudibilityThreshold"));
+
+		CLASS_REGISTER_PROPERTY(AudioDevice, "ClipCacheBudget", Variant::Type::Int, "getClipCacheBudget", "setClipCacheBudget");
+		CLASS_REGISTER_PROPERTY(AudioDevice, "StreamingDuration", Variant::Type::Real, "getStreamingDuration", "setStreamingDuration");
+		CLASS_REGISTER_PROPERTY(AudioDevice, "AudibilityThreshold", Variant::Type::Real, "getAudibilityThreshold", "setAudibilityThreshold");
+	}
+
+	i32 AudioDevice::getVoiceLimit(const String& category)
+	{
+		i32 index = AudioVoiceManager::getCategoryIndex(category);
+		return index >= 0 ? i32(std::min<ui32>(m_voiceManager->getCategoryLimit(index), m_voiceManager->getSourceCount())) : 0;
+	}
+
+	void AudioDevice::setVoiceLimit(const String& category, i32 limit)
+	{
+		i32 index = AudioVoiceManager::getCategoryIndex(category);
+		if (index >= 0)
+			m_voiceManager->setCategoryLimit(index, ui32(std::max<i32>(limit, 0)));
+		else
+			EchoLogWarning("AudioDevice: Unknown voice category [%s].", category.c_str());
 	}
 
 	AudioDevice* AudioDevice::instance()
@@ -72,8 +106,11 @@ namespace Echo
 				alListenerfv(AL_ORIENTATION, listenOri);
 
 				lastPosition = position;
+				m_listenerPosition = position;
 			}
 		}
+
+		m_voiceManager->update(elapsedTime, m_listenerPosition);
 	}
 
 	void AudioDevice::listAudioDevices()
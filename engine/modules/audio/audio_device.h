@@ -2,6 +2,8 @@
 
 #include "engine/core/scene/node.h"
 #include "audio_base.h"
+#include "audio_buffer.h"
+#include "audio_voice.h"
 
 namespace Echo
 {
@@ -20,6 +22,29 @@ namespace Echo
 		// step
 		void step(float elapsedTime);
 
+		// voices
+		AudioVoiceManager* getVoiceManager() { return m_voiceManager; }
+
+		// voice limit of a category, see AudioVoiceManager::getCategoryNames
+		i32 getVoiceLimit(const String& category);
+		void setVoiceLimit(const String& category, i32 limit);
+
+		// voices quieter than this (gain after distance attenuation) give up their source
+		float getAudibilityThreshold() const { return m_voiceManager->getAudibilityThreshold(); }
+		void setAudibilityThreshold(float threshold) { m_voiceManager->setAudibilityThreshold(threshold); }
+
+		// decoded clips & streaming
+		AudioClipCache* getClipCache() { return m_clipCache; }
+		AudioStreamDecoder* getStreamDecoder() { return m_streamDecoder; }
+
+		// clip cache budget in megabytes
+		i32 getClipCacheBudget() const { return i32(m_clipCache->getBudget() / (1024 * 1024)); }
+		void setClipCacheBudget(i32 megabytes) { m_clipCache->setBudget(ui32(std::max<i32>(megabytes, 0)) * 1024 * 1024); }
+
+		// clips longer than this (seconds) are streamed
+		float getStreamingDuration() const { return m_clipCache->getStreamingDuration(); }
+		void setStreamingDuration(float duration) { m_clipCache->setStreamingDuration(duration); }
+
 	private:
 		// list audio devices
 		void listAudioDevices();
@@ -30,5 +55,9 @@ namespace Echo
 		bool				m_isSupportEnumeration;
 		String				m_audioDevices;
 		AudioListener*		m_currentListener;
+		AudioClipCache*		m_clipCache = nullptr;
+		AudioStreamDecoder*	m_streamDecoder = nullptr;
+		AudioVoiceManager*	m_voiceManager = nullptr;
+		Vector3				m_listenerPosition = Vector3::ZERO;
 	};
 }
@@ -1,31 +1,24 @@
 #include "audio_player.h"
-#define DR_MP3_IMPLEMENTATION
-#include "dr_libs/dr_mp3.h"
-#include "dr_libs/dr_flac.h"
-#define DR_WAV_IMPLEMENTATION
-#include "dr_libs/dr_wav.h"
+#include "audio_device.h"
 #include "engine/core/main/Engine.h"
 #include "engine/core/io/IO.h"
 
 namespace Echo
 {
 	AudioPlayer::AudioPlayer()
+		: m_category(AudioVoiceManager::getCategoryNames()[0], AudioVoiceManager::getCategoryNames())
 	{
-		alGenSources(1, &m_source);
-		alGenBuffers(1, &m_buffer);
+		m_voice = AudioDevice::instance()->getVoiceManager()->createVoice();
 	}
 
 	AudioPlayer::~AudioPlayer()
 	{
-        if(m_source!=-1)
-        {
-            stop();
-            
-            alDeleteSources(1, &m_source);
-            alDeleteBuffers(1, &m_buffer);
-        }
+		AudioVoiceManager* voiceManager = AudioDevice::instance()->getVoiceManager();
+		voiceManager->destroyVoice(m_voice);
+		for (AudioVoice* voice : m_oneShotVoices)
+			voiceManager->destroyVoice(voice);
 
-		EchoSafeDeleteContainer(m_oneShotPlayers, AudioPlayer);
+		m_oneShotVoices.clear();
 	}
 
 	void AudioPlayer::bindMethods()
@@ -39,6 +32,10 @@ namespace Echo
         CLASS_BIND_METHOD(AudioPlayer, setVolume,           DEF_METHOD("setVolume"));
         CLASS_BIND_METHOD(AudioPlayer, isPlayOnAwake,       DEF_METHOD("isPlayOnAwake"));
         CLASS_BIND_METHOD(AudioPlayer, setPlayOnAwake,      DEF_METHOD("setPlayOnAwake"));
+        CLASS_BIND_METHOD(AudioPlayer, getPriority,         DEF_METHOD("getPriority"));
+        CLASS_BIND_METHOD(AudioPlayer, setPriority,         DEF_METHOD("setPriority"));
+        CLASS_BIND_METHOD(AudioPlayer, getCategory,         DEF_METHOD("getCategory"));
+        CLASS_BIND_METHOD(AudioPlayer, setCategory,         DEF_METHOD("setCategory"));
         CLASS_BIND_METHOD(AudioPlayer, getAudio,	        DEF_METHOD("getAudio"));
         CLASS_BIND_METHOD(AudioPlayer, setAudio,	        DEF_METHOD("setAudio"));
 
@@ -46,6 +43,8 @@ namespace Echo
         CLASS_REGISTER_PROPERTY(AudioPlayer, "Loop", Variant::Type::Bool, "isLoop", "setLoop");
         CLASS_REGISTER_PROPERTY(AudioPlayer, "PlayOnAwake", Variant::Type::Bool, "isPlayOnAwake", "setPlayOnAwake");
         CLASS_REGISTER_PROPERTY(AudioPlayer, "Volume", Variant::Type::Real, "getVolume", "setVolume");
+        CLASS_REGISTER_PROPERTY(AudioPlayer, "Priority", Variant::Type::Int, "getPriority", "setPriority");
+        CLASS_REGISTER_PROPERTY(AudioPlayer, "Category", Variant::Type::StringOption, "getCategory", "setCategory");
         CLASS_REGISTER_PROPERTY(AudioPlayer, "Audio", Variant::Type::ResourcePath, "getAudio", "setAudio");
 	}
 
@@ -53,45 +52,47 @@ namespace Echo
 	{
 		m_pitch = pitch;
 
-		alSourcef(m_source, AL_PITCH, 1);
+		applyParams(m_voice, getWorldPosition());
 	}
 
 	void AudioPlayer::setVolume(float gain)
 	{
 		m_gain = gain;
 
-		alSourcef(m_source, AL_GAIN, m_gain);
+		applyParams(m_voice, getWorldPosition());
 	}
 
 	void AudioPlayer::setLoop(bool loop)
 	{
 		m_isLoop = loop;
 
-		alSourcei( m_source, AL_LOOPING, m_isLoop);
+		applyParams(m_voice, getWorldPosition());
 	}
     
     void AudioPlayer::set2d(bool is2d)
     {
-        if(is2d)
-        {
-            alSourcei( m_source, AL_SOURCE_RELATIVE, AL_TRUE);
-            alSource3f(m_source, AL_POSITION, 0.0f, 0.0f, 0.0f);
-        }
-        else
-        {
-            alSourcei( m_source, AL_SOURCE_RELATIVE, AL_FALSE);
-        }
-        
         m_is2D = is2d;
+
+        applyParams(m_voice, getWorldPosition());
     }
 
-	bool AudioPlayer::isPlaying()
-	{
-		ALenum state;
+    void AudioPlayer::setPriority(i32 priority)
+    {
+        m_priority = priority;
 
-		alGetSourcei(m_source, AL_SOURCE_STATE, &state);
+        applyParams(m_voice, getWorldPosition());
+    }
+
+    void AudioPlayer::setCategory(const StringOption& category)
+    {
+        m_category.setValue(category.getValue());
+
+        applyParams(m_voice, getWorldPosition());
+    }
 
-		return (state == AL_PLAYING);
+	bool AudioPlayer::isPlaying()
+	{
+		return m_voice->m_state == AudioVoice::Playing;
 	}
     
     void AudioPlayer::start()
@@ -107,54 +108,64 @@ namespace Echo
 		const Vector3& position = getWorldPosition();
 		
 		// update self position
-		updatePosition(position);
+		if (!m_is2D)
+		{
+			m_voice->m_position = position;
+			AudioDevice::instance()->getVoiceManager()->applyParams(m_voice);
+		}
 
-		// one shot players
-		if (!m_oneShotPlayers.empty())
+		// one shot voices
+		if (!m_oneShotVoices.empty())
 		{
-			for (AudioPlayerArray::iterator it=m_oneShotPlayers.begin(); it!=m_oneShotPlayers.end(); )
+			AudioVoiceManager* voiceManager = AudioDevice::instance()->getVoiceManager();
+			for (AudioVoiceArray::iterator it=m_oneShotVoices.begin(); it!=m_oneShotVoices.end(); )
 			{
-				AudioPlayer* player = *it;
-				if (player->isPlaying())
+				AudioVoice* voice = *it;
+				if (voice->m_state != AudioVoice::Stopped)
 				{
-					player->updatePosition(position);
+					if (!voice->m_is2D)
+					{
+						voice->m_position = position;
+						voiceManager->applyParams(voice);
+					}
+
 					it++;
 				}
 				else
 				{
-					it = m_oneShotPlayers.erase(it);
-					EchoSafeDelete(player, AudioPlayer);
+					it = m_oneShotVoices.erase(it);
+					voiceManager->destroyVoice(voice);
 				}
 			}
 		}
 	}
 
-	void AudioPlayer::updatePosition(const Vector3& position)
+	void AudioPlayer::applyParams(AudioVoice* voice, const Vector3& position)
 	{
-        if(!m_is2D)
-        {
-            alSource3f(m_source, AL_POSITION, position.x, position.y, position.z);
-            alSource3f(m_source, AL_VELOCITY, 0.f, 0.f, 0.f);
-        }
+		voice->m_gain = m_gain;
+		voice->m_pitch = m_pitch;
+		voice->m_isLoop = m_isLoop;
+		voice->m_is2D = m_is2D;
+		voice->m_position = position;
+		voice->m_priority = m_priority;
+		voice->m_category = m_category.isValid() ? ui32(m_category.getIdx()) : 0;
+
+		AudioDevice::instance()->getVoiceManager()->applyParams(voice);
 	}
 
 	void AudioPlayer::play()
 	{    
-		//assign the buffer to this source
-		alSourcei(m_source, AL_BUFFER, m_buffer);
-
-        // play
-        alSourcePlay( m_source);
+		AudioDevice::instance()->getVoiceManager()->play(m_voice);
 	}
     
     void AudioPlayer::pause()
     {
-        alSourcePause( m_source);
+        AudioDevice::instance()->getVoiceManager()->pause(m_voice);
     }
     
     void AudioPlayer::stop()
     {
-        alSourceStop( m_source);
+        AudioDevice::instance()->getVoiceManager()->stop(m_voice);
     }
     
     void AudioPlayer::setAudio(const ResourcePath& res)
@@ -162,60 +173,29 @@ namespace Echo
         m_audioRes=res;
 		if (!m_audioRes.isEmpty())
 		{
-			loadBuff();
+			// short clips share a decoded buffer, long ones are streamed
+			if (AudioDevice::instance()->getVoiceManager()->setClip(m_voice, m_audioRes.getPath()))
+				applyParams(m_voice, getWorldPosition());
 		}
     }
-    
-    bool AudioPlayer::loadBuff()
-    {
-		MemoryReader memReader(m_audioRes.getPath());
-		if (memReader.getSize())
-		{
-			drmp3 mp3;
-			drmp3_config config;
-			config.outputChannels = 1;
-			config.outputSampleRate = DR_MP3_DEFAULT_SAMPLE_RATE;
-			if (drmp3_init_memory(&mp3, memReader.getData<const void*>(), memReader.getSize(), &config))
-			{
-				drmp3_uint64 frameCount = drmp3_get_pcm_frame_count(&mp3);
-
-				//drmp3_uint32 channels = mp3.channels;
-				float* audioBuffer = new float[frameCount];
-				i16* audioBuffer16 = new i16[frameCount];
-				drmp3_uint64 framesRead = drmp3_read_pcm_frames_f32(&mp3, frameCount, audioBuffer);
-				if (framesRead > 0)
-				{
-					ALenum  audioFormat = AL_FORMAT_MONO16;
-					ALint   audioBufferLen = static_cast<ALint>(framesRead * sizeof(i16));
-					ALint   audioFrequency = mp3.sampleRate;
-
-					drwav_f32_to_s16(audioBuffer16, audioBuffer, framesRead);
-					alBufferData(m_buffer, audioFormat, audioBuffer16, audioBufferLen, audioFrequency);
-				}
-
-				delete[] audioBuffer;
-				delete[] audioBuffer16;
-
-				return true;
-			}
-		}
-        
-        return false;
-    }
 
 	void AudioPlayer::playOneShot(const char* res, float volumeScale)
 	{
-		AudioPlayer* newPlayer = EchoNew(AudioPlayer);
-		if(newPlayer)
+		AudioVoiceManager* voiceManager = AudioDevice::instance()->getVoiceManager();
+		AudioVoice* voice = voiceManager->createVoice();
+		if (voiceManager->setClip(voice, res))
+		{
+			applyParams(voice, getWorldPosition());
+			voice->m_isLoop = false;
+			voice->m_gain = volumeScale;
+			voiceManager->applyParams(voice);
+			voiceManager->play(voice);
+
+			m_oneShotVoices.emplace_back(voice);
+		}
+		else
 		{
-			newPlayer->setAudio(ResourcePath(res));
-			newPlayer->updatePosition(getWorldPosition());
-			newPlayer->setLoop(false);
-			newPlayer->set2d(is2d());
-			newPlayer->setVolume(volumeScale);
-			newPlayer->play();
-
-			m_oneShotPlayers.emplace_back(newPlayer);
+			voiceManager->destroyVoice(voice);
 		}
 	}
 }
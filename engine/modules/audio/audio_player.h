@@ -5,12 +5,14 @@
 
 namespace Echo
 {
+	struct AudioVoice;
+
 	class AudioPlayer : public Node 
 	{
 		ECHO_CLASS(AudioPlayer, Node)
 
 	public:
-		typedef vector<AudioPlayer*>::type AudioPlayerArray;
+		typedef vector<AudioVoice*>::type AudioVoiceArray;
 
 	public:
 		AudioPlayer();
@@ -36,6 +38,14 @@ namespace Echo
         bool isPlayOnAwake() const { return m_isPlayOnAwake; }
         void setPlayOnAwake(bool isPlayOnAwake) { m_isPlayOnAwake = isPlayOnAwake;}
 
+        // priority, higher keeps it's source when voices run out
+        i32 getPriority() const { return m_priority; }
+        void setPriority(i32 priority);
+
+        // category, voices per category can be limited by AudioDevice
+        const StringOption& getCategory() const { return m_category; }
+        void setCategory(const StringOption& category);
+
 		// is playing
 		bool isPlaying();
 
@@ -58,22 +68,19 @@ namespace Echo
 		// update
 		virtual void update_self() override;
 
-		// update position
-		void updatePosition(const Vector3& position);
-        
-    private:
-        // load audio data from file
-        bool loadBuff();
+		// copy settings to voice
+		void applyParams(AudioVoice* voice, const Vector3& position);
 
 	private:
-		ALuint				m_source = -1;
-		ALuint				m_buffer;
-		float				m_pitch;
+		AudioVoice*			m_voice = nullptr;
+		float				m_pitch = 1.f;
 		float				m_gain = 1.f;
 		bool				m_isLoop = false;
 		bool				m_isPlayOnAwake = true;
 		bool				m_is2D = true;
+		i32					m_priority = 128;
+		StringOption		m_category;
         ResourcePath		m_audioRes = ResourcePath("", ".mp3|.flac|.wav|.audio");
-		AudioPlayerArray	m_oneShotPlayers;
+		AudioVoiceArray		m_oneShotVoices;
 	};
 }
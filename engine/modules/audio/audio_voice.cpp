@@ -0,0 +1,337 @@
+#include <algorithm>
+#include "audio_voice.h"
+#include "audio_device.h"
+#include "engine/core/log/Log.h"
+
+namespace Echo
+{
+	AudioVoiceManager::AudioVoiceManager(ui32 maxSources)
+	{
+		// as many as the device allows
+		alGetError();
+		for (ui32 i = 0; i < maxSources; i++)
+		{
+			ALuint source = 0;
+			alGenSources(1, &source);
+			if (alGetError() != AL_NO_ERROR)
+				break;
+
+			m_sources.emplace_back(source);
+		}
+
+		if (m_sources.size() < maxSources)
+			EchoLogWarning("AudioVoiceManager: Only %d of %d sources could be created.", i32(m_sources.size()), i32(maxSources));
+
+		m_freeSources = m_sources;
+		std::fill(m_categoryLimits, m_categoryLimits + MAX_CATEGORIES, ui32(-1));
+	}
+
+	AudioVoiceManager::~AudioVoiceManager()
+	{
+		while (!m_voices.empty())
+			destroyVoice(m_voices.back());
+
+		if (!m_sources.empty())
+			alDeleteSources(ALsizei(m_sources.size()), m_sources.data());
+	}
+
+	AudioVoice* AudioVoiceManager::createVoice()
+	{
+		AudioVoice* voice = EchoNew(AudioVoice);
+		m_voices.emplace_back(voice);
+
+		return voice;
+	}
+
+	void AudioVoiceManager::destroyVoice(AudioVoice* voice)
+	{
+		if (voice)
+		{
+			releaseClip(voice);
+
+			m_voices.erase(std::remove(m_voices.begin(), m_voices.end(), voice), m_voices.end());
+			EchoSafeDelete(voice, AudioVoice);
+		}
+	}
+
+	bool AudioVoiceManager::setClip(AudioVoice* voice, const String& path)
+	{
+		releaseClip(voice);
+
+		AudioClipCache* clipCache = AudioDevice::instance()->getClipCache();
+		if (!clipCache->load(path, voice->m_buffer, voice->m_stream))
+			return false;
+
+		if (voice->m_buffer)
+		{
+			ALint size = 0;
+			ALint frequency = 0;
+			alGetBufferi(voice->m_buffer, AL_SIZE, &size);
+			alGetBufferi(voice->m_buffer, AL_FREQUENCY, &frequency);
+			voice->m_duration = frequency > 0 ? float(size) / (frequency * sizeof(i16)) : 0.f;
+		}
+		else
+		{
+			voice->m_duration = voice->m_stream->getDuration();
+			voice->m_stream->setLoop(voice->m_isLoop);
+		}
+
+		return true;
+	}
+
+	void AudioVoiceManager::releaseClip(AudioVoice* voice)
+	{
+		stop(voice);
+
+		if (voice->m_buffer)
+		{
+			AudioDevice::instance()->getClipCache()->release(voice->m_buffer);
+			voice->m_buffer = 0;
+		}
+
+		EchoSafeDelete(voice->m_stream, AudioStream);
+		voice->m_duration = 0.f;
+	}
+
+	void AudioVoiceManager::play(AudioVoice* voice)
+	{
+		if (!voice->m_buffer && !voice->m_stream)
+			return;
+
+		if (voice->m_state == AudioVoice::Paused)
+		{
+			voice->m_state = AudioVoice::Playing;
+			if (voice->m_source)
+			{
+				if (voice->m_stream)
+					voice->m_stream->play(voice->m_source, voice->m_time);
+				else
+					alSourcePlay(voice->m_source);
+			}
+		}
+		else
+		{
+			stop(voice);
+
+			// a free source is taken right away, the next update may hand it to a better voice
+			voice->m_state = AudioVoice::Playing;
+			if (!m_freeSources.empty())
+				realize(voice);
+		}
+	}
+
+	void AudioVoiceManager::pause(AudioVoice* voice)
+	{
+		if (voice->m_state == AudioVoice::Playing)
+		{
+			if (voice->m_source)
+				alSourcePause(voice->m_source);
+
+			voice->m_state = AudioVoice::Paused;
+		}
+	}
+
+	void AudioVoiceManager::stop(AudioVoice* voice)
+	{
+		if (voice->m_source)
+			virtualize(voice);
+
+		voice->m_state = AudioVoice::Stopped;
+		voice->m_time = 0.f;
+	}
+
+	void AudioVoiceManager::applyParams(AudioVoice* voice)
+	{
+		if (voice->m_stream)
+			voice->m_stream->setLoop(voice->m_isLoop);
+
+		ALuint source = voice->m_source;
+		if (source)
+		{
+			alSourcef(source, AL_GAIN, voice->m_gain);
+			alSourcef(source, AL_PITCH, voice->m_pitch);
+
+			// streams loop by decoding from the start again
+			alSourcei(source, AL_LOOPING, voice->m_isLoop && !voice->m_stream);
+
+			if (voice->m_is2D)
+			{
+				alSourcei(source, AL_SOURCE_RELATIVE, AL_TRUE);
+				alSource3f(source, AL_POSITION, 0.f, 0.f, 0.f);
+			}
+			else
+			{
+				alSourcei(source, AL_SOURCE_RELATIVE, AL_FALSE);
+				alSource3f(source, AL_POSITION, voice->m_position.x, voice->m_position.y, voice->m_position.z);
+				alSource3f(source, AL_VELOCITY, 0.f, 0.f, 0.f);
+			}
+		}
+	}
+
+	void AudioVoiceManager::realize(AudioVoice* voice)
+	{
+		voice->m_source = m_freeSources.back();
+		m_freeSources.pop_back();
+
+		applyParams(voice);
+
+		float time = voice->m_time;
+		if (voice->m_stream)
+		{
+			voice->m_stream->play(voice->m_source, time);
+		}
+		else
+		{
+			alSourcei(voice->m_source, AL_BUFFER, voice->m_buffer);
+			alSourcef(voice->m_source, AL_SEC_OFFSET, time);
+			alSourcePlay(voice->m_source);
+		}
+
+		if (voice->m_state == AudioVoice::Paused)
+			alSourcePause(voice->m_source);
+	}
+
+	void AudioVoiceManager::virtualize(AudioVoice* voice)
+	{
+		if (voice->m_stream)
+		{
+			voice->m_stream->stop(voice->m_source);
+		}
+		else
+		{
+			alSourceStop(voice->m_source);
+			alSourcei(voice->m_source, AL_BUFFER, 0);
+		}
+
+		m_freeSources.emplace_back(voice->m_source);
+		voice->m_source = 0;
+	}
+
+	bool AudioVoiceManager::advance(AudioVoice* voice, float elapsedTime)
+	{
+		if (voice->m_source)
+		{
+			if (voice->m_stream)
+			{
+				voice->m_stream->update(voice->m_source);
+				if (!voice->m_stream->isPlaying())
+					return false;
+			}
+			else
+			{
+				ALint state = AL_STOPPED;
+				alGetSourcei(voice->m_source, AL_SOURCE_STATE, &state);
+				if (state == AL_STOPPED)
+					return false;
+
+				alGetSourcef(voice->m_source, AL_SEC_OFFSET, &voice->m_time);
+				return true;
+			}
+		}
+
+		if (voice->m_state == AudioVoice::Playing)
+		{
+			voice->m_time += elapsedTime * voice->m_pitch;
+			if (voice->m_duration > 0.f && voice->m_time >= voice->m_duration)
+			{
+				// streams know their end, the duration is only estimated
+				if (!voice->m_isLoop)
+					return voice->m_source != 0;
+
+				voice->m_time = std::fmod(voice->m_time, voice->m_duration);
+			}
+		}
+
+		return true;
+	}
+
+	void AudioVoiceManager::update(float elapsedTime, const Vector3& listenerPosition)
+	{
+		m_candidates.clear();
+		for (AudioVoice* voice : m_voices)
+		{
+			if (voice->m_state == AudioVoice::Stopped)
+				continue;
+
+			if (!advance(voice, elapsedTime))
+			{
+				stop(voice);
+				continue;
+			}
+
+			// same curve as openal's default AL_INVERSE_DISTANCE_CLAMPED, reference distance 1 & rolloff 1
+			float attenuation = 1.f;
+			if (!voice->m_is2D)
+				attenuation = 1.f / std::max<float>((voice->m_position - listenerPosition).len(), 1.f);
+
+			voice->m_audibility = voice->m_gain * attenuation;
+			m_candidates.emplace_back(voice);
+		}
+
+		selectVoices(m_candidates, getSourceCount(), m_categoryLimits, m_audibilityThreshold, m_reals);
+
+		// sources of voices that lost go to the ones that won
+		for (AudioVoice* voice : m_candidates)
+		{
+			if (voice->m_source && std::find(m_reals.begin(), m_reals.end(), voice) == m_reals.end())
+				virtualize(voice);
+		}
+
+		for (AudioVoice* voice : m_reals)
+		{
+			if (!voice->m_source)
+				realize(voice);
+		}
+	}
+
+	const StringArray& AudioVoiceManager::getCategoryNames()
+	{
+		static StringArray names = { "Effect", "Music", "Dialog", "Ambient", "UI" };
+		return names;
+	}
+
+	i32 AudioVoiceManager::getCategoryIndex(const String& name)
+	{
+		const StringArray& names = getCategoryNames();
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (names[i] == name)
+				return i32(i);
+		}
+
+		return -1;
+	}
+
+	void AudioVoiceManager::selectVoices(vector<AudioVoice*>::type& candidates, ui32 sourceCount, const ui32* categoryLimits, float audibilityThreshold, vector<AudioVoice*>::type& oReal)
+	{
+		// voices already holding a source win ties, so equal voices don't swap every frame
+		std::stable_sort(candidates.begin(), candidates.end(), [](const AudioVoice* a, const AudioVoice* b)
+		{
+			if (a->m_priority != b->m_priority)
+				return a->m_priority > b->m_priority;
+
+			if (a->m_audibility != b->m_audibility)
+				return a->m_audibility > b->m_audibility;
+
+			return a->m_source != 0 && b->m_source == 0;
+		});
+
+		ui32 categoryCounts[MAX_CATEGORIES] = { 0 };
+		oReal.clear();
+		for (AudioVoice* voice : candidates)
+		{
+			if (oReal.size() >= sourceCount)
+				break;
+
+			if (voice->m_audibility < audibilityThreshold)
+				continue;
+
+			ui32 category = std::min<ui32>(voice->m_category, MAX_CATEGORIES - 1);
+			if (categoryCounts[category] >= categoryLimits[category])
+				continue;
+
+			categoryCounts[category]++;
+			oReal.emplace_back(voice);
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "engine/core/math/Math.h"
+#include "audio_base.h"
+
+namespace Echo
+{
+	class AudioStream;
+
+	/**
+	 * Voice
+	 * One playing instance of a clip. Only audible voices hold an openal source,
+	 * virtual ones keep their timeline running and pick up from it when realized.
+	 */
+	struct AudioVoice
+	{
+		enum State
+		{
+			Stopped = 0,
+			Playing,
+			Paused,
+		};
+
+		ALuint			m_source = 0;				// 0 while virtual
+		ALuint			m_buffer = 0;				// shared by the clip cache
+		AudioStream*	m_stream = nullptr;			// long clips
+		float			m_duration = 0.f;
+		float			m_time = 0.f;				// seconds into the clip
+		Vector3			m_position = Vector3::ZERO;
+		float			m_gain = 1.f;
+		float			m_pitch = 1.f;
+		bool			m_isLoop = false;
+		bool			m_is2D = true;
+		i32				m_priority = 128;			// higher wins
+		ui32			m_category = 0;
+		State			m_state = Stopped;
+		float			m_audibility = 0.f;
+	};
+
+	/**
+	 * Voice manager
+	 * Owns a fixed pool of sources. Every update the playing voices are ranked by
+	 * priority then audibility, per category limits applied, and the best ones
+	 * get the sources. The rest play virtually.
+	 */
+	class AudioVoiceManager
+	{
+	public:
+		static const ui32 MAX_CATEGORIES = 8;
+
+	public:
+		AudioVoiceManager(ui32 maxSources);
+		~AudioVoiceManager();
+
+		// voices
+		AudioVoice* createVoice();
+		void destroyVoice(AudioVoice* voice);
+
+		// clip of voice, stops it
+		bool setClip(AudioVoice* voice, const String& path);
+
+		// operates
+		void play(AudioVoice* voice);
+		void pause(AudioVoice* voice);
+		void stop(AudioVoice* voice);
+
+		// push gain, pitch, loop and position to the source of a real voice
+		void applyParams(AudioVoice* voice);
+
+		// advance timelines, hand the sources to the best voices
+		void update(float elapsedTime, const Vector3& listenerPosition);
+
+		// voice limit of a category
+		ui32 getCategoryLimit(ui32 category) const { return m_categoryLimits[category]; }
+		void setCategoryLimit(ui32 category, ui32 limit) { m_categoryLimits[category] = limit; }
+
+		// voices less audible than this are virtual
+		float getAudibilityThreshold() const { return m_audibilityThreshold; }
+		void setAudibilityThreshold(float threshold) { m_audibilityThreshold = threshold; }
+
+		// stats
+		ui32 getSourceCount() const { return ui32(m_sources.size()); }
+		ui32 getVoiceCount() const { return ui32(m_voices.size()); }
+		ui32 getRealVoiceCount() const { return ui32(m_sources.size() - m_freeSources.size()); }
+
+	public:
+		// category names, index is AudioVoice::m_category
+		static const StringArray& getCategoryNames();
+		static i32 getCategoryIndex(const String& name);
+
+		// rank candidates, fill oReal with the ones that get a source. no openal, reorders candidates
+		static void selectVoices(vector<AudioVoice*>::type& candidates, ui32 sourceCount, const ui32* categoryLimits, float audibilityThreshold, vector<AudioVoice*>::type& oReal);
+
+	private:
+		// release the clip of voice
+		void releaseClip(AudioVoice* voice);
+
+		// give voice a source and start it at it's timeline
+		void realize(AudioVoice* voice);
+
+		// take the source back, timeline keeps running
+		void virtualize(AudioVoice* voice);
+
+		// advance timeline, return false if the voice finished
+		bool advance(AudioVoice* voice, float elapsedTime);
+
+	private:
+		vector<ALuint>::type		m_sources;
+		vector<ALuint>::type		m_freeSources;
+		vector<AudioVoice*>::type	m_voices;
+		vector<AudioVoice*>::type	m_candidates;
+		vector<AudioVoice*>::type	m_reals;
+		ui32						m_categoryLimits[MAX_CATEGORIES];
+		float						m_audibilityThreshold = 0.01f;
+	};
+}
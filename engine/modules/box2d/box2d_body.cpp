@@ -13,6 +13,7 @@ namespace Echo
 	{
 		if (m_body)
 		{
+			Box2DModule::instance()->removeBody(this);
 			Box2DModule::instance()->getWorld()->DestroyBody(m_body);
 			m_body = nullptr;
 		}
@@ -145,7 +146,46 @@ namespace Echo
             Echo::Vector3 pitchYawRoll;
             getWorldOrientation().toPitchYawRoll(pitchYawRoll.x, pitchYawRoll.y, pitchYawRoll.z);
             m_body->SetTransform( b2Vec2(getWorldPosition().x / pixelsPerUnit, getWorldPosition().y / pixelsPerUnit) , pitchYawRoll.z * Math::DEG2RAD);
+
+            // teleported, nothing to blend from
+            m_prevPosition = m_currPosition = m_body->GetPosition();
+            m_prevAngle = m_currAngle = m_body->GetAngle();
+        }
+    }
+
+    bool Box2DBody::onStepped(ui32 stepCount)
+    {
+        m_prevPosition = m_currPosition;
+        m_prevAngle = m_currAngle;
+        m_currPosition = m_body->GetPosition();
+        m_currAngle = m_body->GetAngle();
+        m_steppedCount = stepCount;
+
+        bool isWokeUp = !m_isMoving;
+        m_isMoving = true;
+
+        return isWokeUp;
+    }
+
+    bool Box2DBody::writeInterpolatedPose(ui32 stepCount, float alpha)
+    {
+        // slept through the last step, settle on the final pose
+        if (m_steppedCount != stepCount)
+        {
+            m_prevPosition = m_currPosition;
+            m_prevAngle = m_currAngle;
+            alpha = 1.f;
         }
+
+        float pixelsPerUnit = Box2DModule::instance()->getPixelsPerMeter();
+        b2Vec2 position = (1.f - alpha) * m_prevPosition + alpha * m_currPosition;
+        float angle = Math::Lerp(m_prevAngle, m_currAngle, alpha);
+
+        this->setWorldPosition(Vector3(position.x * pixelsPerUnit, position.y * pixelsPerUnit, getWorldPosition().z));
+        this->setWorldOrientation(Quaternion::fromPitchYawRoll(0.f, 0.f, angle * Math::RAD2DEG));
+
+        m_isMoving = m_steppedCount == stepCount;
+        return m_isMoving;
     }
 
 	void Box2DBody::update_self()
@@ -168,25 +208,15 @@ namespace Echo
 			bodyDef.angle = pitchYawRoll.z * Math::DEG2RAD;
 			m_body = Box2DModule::instance()->getWorld()->CreateBody(&bodyDef);
 			m_body->SetUserData(this);
+
+			m_prevPosition = m_currPosition = m_body->GetPosition();
+			m_prevAngle = m_currAngle = m_body->GetAngle();
 		}
 
-		if (m_body)
+		// in game, awake bodies are written back by Box2DModule in bulk
+		if (m_body && !Engine::instance()->getConfig().m_isGame)
 		{
-			if (Engine::instance()->getConfig().m_isGame)
-			{
-				if (m_body->GetType() != b2BodyType::b2_staticBody)
-				{
-					float pixelsPerUnit = Box2DModule::instance()->getPixelsPerMeter();
-
-					const b2Vec2& pos = m_body->GetPosition();
-					this->setWorldPosition(Vector3(pos.x * pixelsPerUnit, pos.y * pixelsPerUnit, getWorldPosition().z));
-					this->setWorldOrientation(Quaternion::fromPitchYawRoll(0.f, 0.f, m_body->GetAngle() * Math::RAD2DEG));
-				}
-			}
-			else
-			{
-                syncTransformTob2Body();
-			}
+            syncTransformTob2Body();
 		}
 	}
 }
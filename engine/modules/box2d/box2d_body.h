@@ -45,6 +45,12 @@ namespace Echo
 
 		// get body
 		b2Body* getb2Body() { return m_body; }
+
+		// body was awake after step, return true if it just woke up
+		bool onStepped(ui32 stepCount);
+
+		// blend the last two steps into the node, return false once settled
+		bool writeInterpolatedPose(ui32 stepCount, float alpha);
         
         // events
     public:
@@ -63,5 +69,11 @@ namespace Echo
 		StringOption	m_type;
 		bool			m_isFixRotation = false;
 		float			m_gravityScale = 1.f;			// set 0 to cancel the gravity, and set -1 to reverse the gravity
+		b2Vec2			m_prevPosition;
+		b2Vec2			m_currPosition;
+		float			m_prevAngle = 0.f;
+		float			m_currAngle = 0.f;
+		ui32			m_steppedCount = 0;
+		bool			m_isMoving = false;
 	};
 }
@@ -15,11 +15,54 @@
 #include "box2d_joint_weld.h"
 #include "box2d_joint_wheel.h"
 #include "engine/core/main/Engine.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
 
 namespace Echo
 {
 	DECLARE_MODULE(Box2DModule)
 
+	// keeps the closest fixture along the segment
+	struct Box2DClosestRayCallback : public b2RayCastCallback
+	{
+		b2Fixture*	m_fixture = nullptr;
+		b2Vec2		m_point;
+		b2Vec2		m_normal;
+		float32		m_fraction = 1.f;
+
+		virtual float32 ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float32 fraction) override
+		{
+			m_fixture = fixture;
+			m_point = point;
+			m_normal = normal;
+			m_fraction = fraction;
+
+			// clip the ray, only closer fixtures are reported after
+			return fraction;
+		}
+	};
+
+	// gathers fixtures whose bounds touch the query bounds
+	struct Box2DFixtureCollector : public b2QueryCallback
+	{
+		vector<b2Fixture*>::type	m_fixtures;
+
+		virtual bool ReportFixture(b2Fixture* fixture) override
+		{
+			m_fixtures.emplace_back(fixture);
+			return true;
+		}
+	};
+
+	static void writeQueryHit(const Box2DQueryHit& hit, double* oResult)
+	{
+		oResult[0] = hit.m_body ? hit.m_body->getId() : -1;
+		oResult[1] = hit.m_position.x;
+		oResult[2] = hit.m_position.y;
+		oResult[3] = hit.m_normal.x;
+		oResult[4] = hit.m_normal.y;
+		oResult[5] = hit.m_fraction;
+	}
+
 	Box2DModule::Box2DModule()
         : m_drawDebugOption("Editor", {"None","Editor","Game","All"})
 	{
@@ -53,14 +96,20 @@ namespace Echo
 	{
         CLASS_BIND_METHOD(Box2DModule, getFramesPerSecond, DEF_METHOD("getFramesPerSecond"));
         CLASS_BIND_METHOD(Box2DModule, setFramesPerSecond, DEF_METHOD("setFramesPerSecond"));
+        CLASS_BIND_METHOD(Box2DModule, getMaxSubSteps, DEF_METHOD("getMaxSubSteps"));
+        CLASS_BIND_METHOD(Box2DModule, setMaxSubSteps, DEF_METHOD("setMaxSubSteps"));
         CLASS_BIND_METHOD(Box2DModule, getPixelsPerMeter, DEF_METHOD("getPixelsPerMeter"));
         CLASS_BIND_METHOD(Box2DModule, setPixelsPerPeter, DEF_METHOD("setPixelsPerMeter"));
         CLASS_BIND_METHOD(Box2DModule, getGravity, DEF_METHOD("getGravity"));
         CLASS_BIND_METHOD(Box2DModule, setGravity, DEF_METHOD("setGravity"));
         CLASS_BIND_METHOD(Box2DModule, getDebugDrawOption, DEF_METHOD("getDebugDrawOption"));
         CLASS_BIND_METHOD(Box2DModule, setDebugDrawOption, DEF_METHOD("setDebugDrawOption"));
+        CLASS_BIND_METHOD(Box2DModule, raycastBatch, DEF_METHOD("raycastBatch"));
+        CLASS_BIND_METHOD(Box2DModule, sweepBatch, DEF_METHOD("sweepBatch"));
+        CLASS_BIND_METHOD(Box2DModule, overlapBatch, DEF_METHOD("overlapBatch"));
 
         CLASS_REGISTER_PROPERTY(Box2DModule, "FramesPerSecond", Variant::Type::Int, "getFramesPerSecond", "setFramesPerSecond");
+        CLASS_REGISTER_PROPERTY(Box2DModule, "MaxSubSteps", Variant::Type::Int, "getMaxSubSteps", "setMaxSubSteps");
         CLASS_REGISTER_PROPERTY(Box2DModule, "DebugDraw", Variant::Type::StringOption, "getDebugDrawOption", "setDebugDrawOption");
         CLASS_REGISTER_PROPERTY(Box2DModule, "PixelsPerMeter", Variant::Type::Real, "getPixelsPerMeter", "setPixelsPerMeter");
         CLASS_REGISTER_PROPERTY(Box2DModule, "Gravity", Variant::Type::Vector2, "getGravity", "setGravity");
@@ -103,16 +152,26 @@ namespace Echo
         {
             float timeStep = 1.f / m_framesPerSecond;
 
-            static float elapsedFixed = 0.f;
-            elapsedFixed += elapsedTime;
-            while (elapsedFixed >= timeStep)
+            m_accumulator += elapsedTime;
+            i32 subSteps = 0;
+            while (m_accumulator >= timeStep && subSteps < m_maxSubSteps)
             {
                 //move the world ahead , step ahead man!!
                 m_b2World->Step(timeStep, 8, 3);
                 m_b2World->ClearForces();
 
-                elapsedFixed -= timeStep;
+                m_accumulator -= timeStep;
+                m_stepCount++;
+                subSteps++;
+
+                collectAwakeBodies();
             }
+
+            // too far behind, drop the rest instead of stepping more next frame
+            m_accumulator = std::min<float>(m_accumulator, timeStep);
+
+            m_interpolationAlpha = m_accumulator / timeStep;
+            writeBackPoses();
         }
 
         // draw debug data
@@ -126,4 +185,281 @@ namespace Echo
         // emit signals
         m_contactListener->EmitSignals();
 	}
+
+    void Box2DModule::collectAwakeBodies()
+    {
+        for (b2Body* b2body = m_b2World->GetBodyList(); b2body; b2body = b2body->GetNext())
+        {
+            if (b2body->IsAwake() && b2body->GetType() != b2_staticBody)
+            {
+                Box2DBody* body = (Box2DBody*)b2body->GetUserData();
+                if (body && body->onStepped(m_stepCount))
+                    m_movingBodies.emplace_back(body);
+            }
+        }
+    }
+
+    void Box2DModule::writeBackPoses()
+    {
+        for (size_t i = 0; i < m_movingBodies.size();)
+        {
+            if (m_movingBodies[i]->writeInterpolatedPose(m_stepCount, m_interpolationAlpha))
+            {
+                i++;
+            }
+            else
+            {
+                m_movingBodies[i] = m_movingBodies.back();
+                m_movingBodies.pop_back();
+            }
+        }
+    }
+
+    void Box2DModule::removeBody(Box2DBody* body)
+    {
+        m_movingBodies.erase(std::remove(m_movingBodies.begin(), m_movingBodies.end(), body), m_movingBodies.end());
+    }
+
+    void Box2DModule::raycasts(const Box2DRaycast* rays, ui32 count, Box2DQueryHit* oHits)
+    {
+        float invPixelsPerMeter = 1.f / m_pixelsPerMeter;
+
+        // queries only read the world, workers don't touch each other's callback
+        OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(count, [&](ui32 i)
+        {
+            const Box2DRaycast& ray = rays[i];
+            b2Vec2 start(ray.m_start.x * invPixelsPerMeter, ray.m_start.y * invPixelsPerMeter);
+            b2Vec2 end(ray.m_end.x * invPixelsPerMeter, ray.m_end.y * invPixelsPerMeter);
+
+            oHits[i] = Box2DQueryHit();
+            if ((end - start).LengthSquared() <= 0.f)
+                return;
+
+            Box2DClosestRayCallback callback;
+            m_b2World->RayCast(&callback, start, end);
+            if (callback.m_fixture)
+            {
+                oHits[i].m_body = (Box2DBody*)callback.m_fixture->GetBody()->GetUserData();
+                oHits[i].m_position = Vector2(callback.m_point.x, callback.m_point.y) * m_pixelsPerMeter;
+                oHits[i].m_normal = Vector2(callback.m_normal.x, callback.m_normal.y);
+                oHits[i].m_fraction = callback.m_fraction;
+            }
+        });
+    }
+
+    void Box2DModule::sweeps(const Box2DSweep* sweeps, ui32 count, Box2DQueryHit* oHits)
+    {
+        float invPixelsPerMeter = 1.f / m_pixelsPerMeter;
+
+        // box2d has no shape cast, candidates from the swept bounds go through time of impact.
+        // b2Distance & b2TimeOfImpact write unguarded global stat counters, so sweeps stay on this thread
+        for (ui32 i = 0; i < count; i++)
+        {
+            const Box2DSweep& sweep = sweeps[i];
+            b2Vec2 start(sweep.m_start.x * invPixelsPerMeter, sweep.m_start.y * invPixelsPerMeter);
+            b2Vec2 end(sweep.m_end.x * invPixelsPerMeter, sweep.m_end.y * invPixelsPerMeter);
+
+            b2CircleShape circle;
+            circle.m_radius = sweep.m_radius * invPixelsPerMeter;
+
+            b2AABB aabb;
+            aabb.lowerBound = b2Min(start, end) - b2Vec2(circle.m_radius, circle.m_radius);
+            aabb.upperBound = b2Max(start, end) + b2Vec2(circle.m_radius, circle.m_radius);
+
+            Box2DFixtureCollector collector;
+            m_b2World->QueryAABB(&collector, aabb);
+
+            b2TOIInput input;
+            input.proxyA.Set(&circle, 0);
+            input.sweepA.localCenter.SetZero();
+            input.sweepA.c0 = start;
+            input.sweepA.c = end;
+            input.sweepA.a0 = input.sweepA.a = 0.f;
+            input.sweepA.alpha0 = 0.f;
+            input.tMax = 1.f;
+
+            b2Fixture* bestFixture = nullptr;
+            i32 bestChild = 0;
+            float32 bestT = 1.f;
+            for (b2Fixture* fixture : collector.m_fixtures)
+            {
+                const b2Body* body = fixture->GetBody();
+                input.sweepB.localCenter = body->GetLocalCenter();
+                input.sweepB.c0 = input.sweepB.c = body->GetWorldCenter();
+                input.sweepB.a0 = input.sweepB.a = body->GetAngle();
+                input.sweepB.alpha0 = 0.f;
+
+                for (i32 child = 0; child < fixture->GetShape()->GetChildCount(); child++)
+                {
+                    input.proxyB.Set(fixture->GetShape(), child);
+
+                    b2TOIOutput output;
+                    b2TimeOfImpact(&output, &input);
+                    if ((output.state == b2TOIOutput::e_touching || output.state == b2TOIOutput::e_overlapped) && output.t < bestT)
+                    {
+                        bestFixture = fixture;
+                        bestChild = child;
+                        bestT = output.state == b2TOIOutput::e_overlapped ? 0.f : output.t;
+                    }
+                }
+            }
+
+            oHits[i] = Box2DQueryHit();
+            if (bestFixture)
+            {
+                // contact point & normal at the time of impact
+                b2DistanceInput distanceInput;
+                distanceInput.proxyA.Set(&circle, 0);
+                distanceInput.proxyB.Set(bestFixture->GetShape(), bestChild);
+                distanceInput.transformA.Set(start + bestT * (end - start), 0.f);
+                distanceInput.transformB = bestFixture->GetBody()->GetTransform();
+                distanceInput.useRadii = true;
+
+                b2SimplexCache cache;
+                cache.count = 0;
+                b2DistanceOutput distanceOutput;
+                b2Distance(&distanceOutput, &cache, &distanceInput);
+
+                b2Vec2 normal = distanceOutput.pointA - distanceOutput.pointB;
+                if (normal.Normalize() < b2_epsilon)
+                {
+                    normal = start - end;
+                    normal.Normalize();
+                }
+
+                oHits[i].m_body = (Box2DBody*)bestFixture->GetBody()->GetUserData();
+                oHits[i].m_position = Vector2(distanceOutput.pointB.x, distanceOutput.pointB.y) * m_pixelsPerMeter;
+                oHits[i].m_normal = Vector2(normal.x, normal.y);
+                oHits[i].m_fraction = bestT;
+            }
+        }
+    }
+
+    void Box2DModule::overlaps(const Box2DOverlap* overlaps, ui32 count, vector<Box2DBody*>::type& oBodies, vector<ui32>::type& oOffsets, ui32 maxHitsPerQuery)
+    {
+        float invPixelsPerMeter = 1.f / m_pixelsPerMeter;
+
+        // every query owns maxHitsPerQuery slots, compacted afterwards
+        vector<Box2DBody*>::type touches(count * maxHitsPerQuery, nullptr);
+        vector<ui32>::type touchCounts(count, 0);
+        OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(count, [&](ui32 i)
+        {
+            const Box2DOverlap& overlap = overlaps[i];
+
+            b2CircleShape circle;
+            circle.m_radius = overlap.m_radius * invPixelsPerMeter;
+
+            b2Transform circleTransform;
+            circleTransform.Set(b2Vec2(overlap.m_center.x * invPixelsPerMeter, overlap.m_center.y * invPixelsPerMeter), 0.f);
+
+            b2AABB aabb;
+            circle.ComputeAABB(&aabb, circleTransform, 0);
+
+            Box2DFixtureCollector collector;
+            m_b2World->QueryAABB(&collector, aabb);
+
+            Box2DBody** bodies = touches.data() + i * maxHitsPerQuery;
+            ui32& bodyCount = touchCounts[i];
+            for (b2Fixture* fixture : collector.m_fixtures)
+            {
+                Box2DBody* body = (Box2DBody*)fixture->GetBody()->GetUserData();
+                if (!body || bodyCount == maxHitsPerQuery || std::find(bodies, bodies + bodyCount, body) != bodies + bodyCount)
+                    continue;
+
+                for (i32 child = 0; child < fixture->GetShape()->GetChildCount(); child++)
+                {
+                    if (b2TestOverlap(&circle, 0, fixture->GetShape(), child, circleTransform, fixture->GetBody()->GetTransform()))
+                    {
+                        bodies[bodyCount++] = body;
+                        break;
+                    }
+                }
+            }
+        });
+
+        oBodies.clear();
+        oOffsets.assign(count + 1, 0);
+        for (ui32 i = 0; i < count; i++)
+        {
+            oOffsets[i] = ui32(oBodies.size());
+            oBodies.insert(oBodies.end(), touches.begin() + i * maxHitsPerQuery, touches.begin() + i * maxHitsPerQuery + touchCounts[i]);
+        }
+        oOffsets[count] = ui32(oBodies.size());
+    }
+
+    // rays: [sx, sy, ex, ey] per segment
+    // result: [bodyId or -1, px, py, nx, ny, fraction] per segment
+    RealVector Box2DModule::raycastBatch(const RealVector& rays)
+    {
+        ui32 count = ui32(rays.size() / 4);
+        vector<Box2DRaycast>::type queries(count);
+        for (ui32 i = 0; i < count; i++)
+        {
+            const double* ray = rays.data() + i * 4;
+            queries[i].m_start = Vector2(float(ray[0]), float(ray[1]));
+            queries[i].m_end = Vector2(float(ray[2]), float(ray[3]));
+        }
+
+        vector<Box2DQueryHit>::type hits(count);
+        raycasts(queries.data(), count, hits.data());
+
+        RealVector result(count * 6);
+        for (ui32 i = 0; i < count; i++)
+            writeQueryHit(hits[i], result.data() + i * 6);
+
+        return result;
+    }
+
+    // sweeps: [sx, sy, ex, ey, radius] per circle sweep
+    // result: [bodyId or -1, px, py, nx, ny, fraction] per sweep
+    RealVector Box2DModule::sweepBatch(const RealVector& sweeps)
+    {
+        ui32 count = ui32(sweeps.size() / 5);
+        vector<Box2DSweep>::type queries(count);
+        for (ui32 i = 0; i < count; i++)
+        {
+            const double* sweep = sweeps.data() + i * 5;
+            queries[i].m_start = Vector2(float(sweep[0]), float(sweep[1]));
+            queries[i].m_end = Vector2(float(sweep[2]), float(sweep[3]));
+            queries[i].m_radius = float(sweep[4]);
+        }
+
+        vector<Box2DQueryHit>::type hits(count);
+        this->sweeps(queries.data(), count, hits.data());
+
+        RealVector result(count * 6);
+        for (ui32 i = 0; i < count; i++)
+            writeQueryHit(hits[i], result.data() + i * 6);
+
+        return result;
+    }
+
+    // circles: [cx, cy, radius] per circle
+    // result: [count, bodyId...] per circle
+    RealVector Box2DModule::overlapBatch(const RealVector& circles)
+    {
+        ui32 count = ui32(circles.size() / 3);
+        vector<Box2DOverlap>::type queries(count);
+        for (ui32 i = 0; i < count; i++)
+        {
+            const double* circle = circles.data() + i * 3;
+            queries[i].m_center = Vector2(float(circle[0]), float(circle[1]));
+            queries[i].m_radius = float(circle[2]);
+        }
+
+        vector<Box2DBody*>::type bodies;
+        vector<ui32>::type offsets;
+        overlaps(queries.data(), count, bodies, offsets);
+
+        RealVector result;
+        result.reserve(count + bodies.size());
+        for (ui32 i = 0; i < count; i++)
+        {
+            result.emplace_back(offsets[i + 1] - offsets[i]);
+            for (ui32 j = offsets[i]; j < offsets[i + 1]; j++)
+                result.emplace_back(bodies[j]->getId());
+        }
+
+        return result;
+    }
 }
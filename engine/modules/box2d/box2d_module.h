@@ -3,6 +3,7 @@
 #include "engine/core/main/module.h"
 #include "box2d_debug_draw.h"
 #include "box2d_contact_listener.h"
+#include "box2d_query.h"
 
 namespace Echo
 {
@@ -42,6 +43,37 @@ namespace Echo
         // frames per second
         i32 getFramesPerSecond() const { return m_framesPerSecond; }
         void setFramesPerSecond(i32 framesPerSecond) { m_framesPerSecond = Math::Clamp<i32>(framesPerSecond, 20, 240); }
+
+        // max steps per frame, time beyond is dropped so a slow frame can't snowball
+        i32 getMaxSubSteps() const { return m_maxSubSteps; }
+        void setMaxSubSteps(i32 maxSubSteps) { m_maxSubSteps = Math::Clamp<i32>(maxSubSteps, 1, 32); }
+
+        // step count, blend factor between the last two steps
+        ui32 getStepCount() const { return m_stepCount; }
+        float getInterpolationAlpha() const { return m_interpolationAlpha; }
+
+        // body is destroyed
+        void removeBody(Box2DBody* body);
+
+    public:
+        // world queries, one hit per query. raycasts run in parallel over the thread pool
+        void raycasts(const Box2DRaycast* rays, ui32 count, Box2DQueryHit* oHits);
+        void sweeps(const Box2DSweep* sweeps, ui32 count, Box2DQueryHit* oHits);
+
+        // bodies overlapped by query i are oBodies[oOffsets[i], oOffsets[i+1])
+        void overlaps(const Box2DOverlap* overlaps, ui32 count, vector<Box2DBody*>::type& oBodies, vector<ui32>::type& oOffsets, ui32 maxHitsPerQuery = 32);
+
+        // flat array versions for lua, see cpp for the layouts
+        RealVector raycastBatch(const RealVector& rays);
+        RealVector sweepBatch(const RealVector& sweeps);
+        RealVector overlapBatch(const RealVector& circles);
+
+    private:
+        // collect bodies awake after a step
+        void collectAwakeBodies();
+
+        // write moved bodies back to their nodes
+        void writeBackPoses();
         
     private:
         bool                    m_isGame;
@@ -52,5 +84,10 @@ namespace Echo
         Vector2                 m_gravity = Vector2( 0.f, -9.8f);
         float                   m_pixelsPerMeter = 32.f;
         i32                     m_framesPerSecond = 60;
+        i32                     m_maxSubSteps = 8;
+        float                   m_accumulator = 0.f;                            // fixed step state of m_b2World
+        ui32                    m_stepCount = 0;
+        float                   m_interpolationAlpha = 1.f;
+        vector<Box2DBody*>::type m_movingBodies;
 	};
 }
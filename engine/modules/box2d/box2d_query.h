@@ -0,0 +1,39 @@
+#pragma once
+
+#include <engine/core/math/Math.h>
+
+namespace Echo
+{
+	class Box2DBody;
+
+	// segment from start to end, in pixels
+	struct Box2DRaycast
+	{
+		Vector2		m_start;
+		Vector2		m_end;
+	};
+
+	// circle moved from start to end, in pixels
+	struct Box2DSweep
+	{
+		Vector2		m_start;
+		Vector2		m_end;
+		float		m_radius = 16.f;
+	};
+
+	// circle overlap, in pixels
+	struct Box2DOverlap
+	{
+		Vector2		m_center;
+		float		m_radius = 16.f;
+	};
+
+	// closest hit of a raycast or sweep, m_body is null if nothing was hit
+	struct Box2DQueryHit
+	{
+		Box2DBody*	m_body = nullptr;
+		Vector2		m_position = Vector2::ZERO;
+		Vector2		m_normal = Vector2::ZERO;
+		float		m_fraction = 1.f;		// of the segment or sweep
+	};
+}
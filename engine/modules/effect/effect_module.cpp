@@ -2,12 +2,43 @@
 #include "sprite.h"
 #include "particle_system.h"
 #include "editor/particle_system_editor.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
+#include "engine/core/scene/node_tree.h"
+#include "engine/core/util/Timer.h"
 
 namespace Echo
 {
 	DECLARE_MODULE(EffectModule)
 
+	// marks the proxies a camera query finds
+	class ParticleSystemQuery : public BvhCb
+	{
+	public:
+		ParticleSystemQuery(vector<ui32>::type& visibleFrames, ui32 frame)
+			: m_visibleFrames(visibleFrames), m_frame(frame)
+		{}
+
+		virtual bool queryCallback(i32 nodeId) override
+		{
+			if (nodeId >= i32(m_visibleFrames.size()))
+				m_visibleFrames.resize(nodeId + 1, 0);
+
+			m_visibleFrames[nodeId] = m_frame;
+			return true;
+		}
+
+		virtual float rayCastCallback(i32 nodeId) override
+		{
+			return -1.f;
+		}
+
+	private:
+		vector<ui32>::type&	m_visibleFrames;
+		ui32				m_frame;
+	};
+
 	EffectModule::EffectModule()
+		: m_budgetLeft(0)
 	{
 	}
 
@@ -19,7 +50,12 @@ namespace Echo
 
 	void EffectModule::bindMethods()
 	{
+		CLASS_BIND_METHOD(EffectModule, getParticleBudget,			DEF_METHOD("getParticleBudget"));
+		CLASS_BIND_METHOD(EffectModule, setParticleBudget,			DEF_METHOD("setParticleBudget"));
+		CLASS_BIND_METHOD(EffectModule, getParticleCount,			DEF_METHOD("getParticleCount"));
+		CLASS_BIND_METHOD(EffectModule, getSimulatedSystemCount,	DEF_METHOD("getSimulatedSystemCount"));
 
+		CLASS_REGISTER_PROPERTY(EffectModule, "ParticleBudget", Variant::Type::Int, "getParticleBudget", "setParticleBudget");
 	}
 
 	void EffectModule::registerTypes()
@@ -29,4 +65,123 @@ namespace Echo
         
         REGISTER_OBJECT_EDITOR(ParticleSystem, ParticleSystemEditor)
 	}
+
+	void EffectModule::addParticleSystem(ParticleSystem* system)
+	{
+		m_particleSystems.emplace_back(system);
+	}
+
+	void EffectModule::removeParticleSystem(ParticleSystem* system)
+	{
+		m_particleSystems.erase(std::remove(m_particleSystems.begin(), m_particleSystems.end(), system), m_particleSystems.end());
+	}
+
+	i32 EffectModule::acquireParticles(i32 count)
+	{
+		i32 left = m_budgetLeft.fetch_sub(count);
+		return Math::Clamp(left, 0, count);
+	}
+
+	void EffectModule::queryVisibleProxies()
+	{
+		Camera* camera3d = NodeTree::instance()->get3dCamera();
+		m_is3dCulling = camera3d != nullptr;
+		if (camera3d)
+		{
+			Frustum frustum;
+			frustum.setPerspective(camera3d->getFov(), float(camera3d->getWidth()) / float(camera3d->getHeight()), camera3d->getNear(), camera3d->getFar());
+			frustum.build(camera3d->getPosition(), camera3d->getDirection(), camera3d->getUp(), true);
+
+			ParticleSystemQuery query(m_3dVisibleFrames, m_frame);
+			NodeTree::instance()->get3dBvh().query(&query, frustum);
+		}
+
+		Camera* camera2d = NodeTree::instance()->get2dCamera();
+		m_is2dCulling = camera2d != nullptr;
+		if (camera2d)
+		{
+			// world box of the orthographic view volume
+			Matrix4 invViewProj = camera2d->getViewProjMatrix();
+			invViewProj.detInverse();
+			AABB viewBox = AABB(-1.f, -1.f, -1.f, 1.f, 1.f, 1.f).transform(invViewProj);
+
+			ParticleSystemQuery query(m_2dVisibleFrames, m_frame);
+			NodeTree::instance()->get2dBvh().query(&query, viewBox);
+		}
+	}
+
+	bool EffectModule::isVisible(ParticleSystem* system) const
+	{
+		// ui systems and systems without a proxy yet are never culled
+		i32 proxyId = system->getBvhNodeId();
+		i32 renderType = system->getRenderType().getIdx();
+		if (proxyId == -1 || renderType == 2)
+			return true;
+
+		if (renderType == 1)
+			return !m_is3dCulling || (proxyId < i32(m_3dVisibleFrames.size()) && m_3dVisibleFrames[proxyId] == m_frame);
+
+		return !m_is2dCulling || (proxyId < i32(m_2dVisibleFrames.size()) && m_2dVisibleFrames[proxyId] == m_frame);
+	}
+
+	void EffectModule::update(float elapsedTime)
+	{
+		m_frame++;
+		queryVisibleProxies();
+
+		m_activeSystems.clear();
+		m_simulatingSystems.clear();
+		m_simulatingMatrices.clear();
+		m_blockJobs.clear();
+		m_particleCount = 0;
+		for (ParticleSystem* system : m_particleSystems)
+		{
+			if (system->isSimulating())
+			{
+				m_activeSystems.emplace_back(system);
+				m_particleCount += system->getParticleCount();
+
+				// far and culled systems skip frames and catch up in one step
+				if (system->updateLod(m_frame, elapsedTime, isVisible(system)))
+				{
+					m_simulatingSystems.emplace_back(system);
+
+					// the node caches its world matrix lazily, workers must not touch it
+					m_simulatingMatrices.emplace_back(system->getWorldMatrix());
+
+					ParticleGroup& group = system->getGroup();
+					for (i32 i = 0; i < group.getBlockCount(); i++)
+						m_blockJobs.push_back({ system, group.getBlocks()[i] });
+				}
+			}
+		}
+
+		// emission shares what is left of the budget
+		m_budgetLeft = m_particleBudget - m_particleCount;
+
+		// blocks don't share data, any worker may take any of them
+		CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+		threadPool->parallelFor(ui32(m_blockJobs.size()), [&](ui32 i)
+		{
+			const BlockJob& job = m_blockJobs[i];
+			ulong startTime = Time::instance()->getMicroseconds();
+			ParticleGroup::simulate(*job.m_block, job.m_system->getModifiers(), job.m_system->getStepTime());
+			job.m_system->addUpdateTime(Time::instance()->getMicroseconds() - startTime);
+		});
+
+		// compaction and emission touch the whole group
+		threadPool->parallelFor(ui32(m_simulatingSystems.size()), [&](ui32 i)
+		{
+			ulong startTime = Time::instance()->getMicroseconds();
+			m_simulatingSystems[i]->postSimulate(m_simulatingMatrices[i]);
+			m_simulatingSystems[i]->addUpdateTime(Time::instance()->getMicroseconds() - startTime);
+		});
+
+		// the bvh is not thread safe
+		for (ParticleSystem* system : m_activeSystems)
+		{
+			system->updateBvhProxy();
+			system->flushUpdateTime();
+		}
+	}
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "engine/core/main/module.h"
+#include "particle/particle.h"
+#include <atomic>
 
 namespace Echo
 {
+	class ParticleSystem;
 	class EffectModule : public Module
 	{
 		ECHO_SINGLETON_CLASS(EffectModule, Module)
@@ -16,5 +19,53 @@ namespace Echo
 
 		// register all types of the module
 		virtual void registerTypes() override;
+
+		// simulate particle systems on the worker threads
+		virtual void update(float elapsedTime) override;
+
+		// particle systems
+		void addParticleSystem(ParticleSystem* system);
+		void removeParticleSystem(ParticleSystem* system);
+
+		// live particles allowed over all systems, emission stops at the limit
+		i32 getParticleBudget() const { return m_particleBudget; }
+		void setParticleBudget(i32 budget) { m_particleBudget = Math::Max(budget, 0); }
+
+		// profile, live particles and systems stepped in the last update
+		i32 getParticleCount() const { return m_particleCount; }
+		i32 getSimulatedSystemCount() const { return i32(m_simulatingSystems.size()); }
+
+		// take up to count particles from the budget, called by the workers
+		i32 acquireParticles(i32 count);
+
+	private:
+		// one job per block, systems are split over several workers
+		struct BlockJob
+		{
+			ParticleSystem*		m_system;
+			ParticleBlock*		m_block;
+		};
+
+	private:
+		// mark the bvh proxies inside the camera views
+		void queryVisibleProxies();
+
+		// is the system in view
+		bool isVisible(ParticleSystem* system) const;
+
+	private:
+		ui32							m_frame = 0;
+		i32								m_particleBudget = 100000;
+		i32								m_particleCount = 0;
+		std::atomic<i32>				m_budgetLeft;
+		bool							m_is2dCulling = false;
+		bool							m_is3dCulling = false;
+		vector<ui32>::type				m_2dVisibleFrames;
+		vector<ui32>::type				m_3dVisibleFrames;
+		vector<ParticleSystem*>::type	m_activeSystems;
+		vector<ParticleSystem*>::type	m_particleSystems;
+		vector<ParticleSystem*>::type	m_simulatingSystems;
+		vector<Matrix4>::type			m_simulatingMatrices;		// world matrices taken on the main thread
+		vector<BlockJob>::type			m_blockJobs;
 	};
 }
@@ -0,0 +1,130 @@
+#include "emitter.h"
+
+namespace Echo
+{
+    ParticleEmitter::ParticleEmitter()
+    {
+        // every emitter walks its own sequence, emitters run on different threads
+        m_seed = ui32(size_t(this) >> 4) | 1;
+    }
+
+    void ParticleEmitter::reset()
+    {
+        m_accumulator = 0.f;
+        m_isBurstDone = false;
+    }
+
+    float ParticleEmitter::random()
+    {
+        // xorshift32
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+
+        return (m_seed >> 8) * (1.f / 16777216.f);
+    }
+
+    i32 ParticleEmitter::advance(float elapsedTime, float rateScale)
+    {
+        i32 count = 0;
+        if (!m_isBurstDone)
+        {
+            count += m_burst;
+            m_isBurstDone = true;
+        }
+
+        // anything born longer than a life ago is already dead
+        m_accumulator += m_rate * rateScale * Math::Min(elapsedTime, m_life.y);
+        i32 rateCount = i32(m_accumulator);
+        m_accumulator -= rateCount;
+        count += rateCount;
+
+        return count;
+    }
+
+    i32 ParticleEmitter::emit(ParticleGroup& group, const Matrix4& worldMatrix, float elapsedTime, i32 count)
+    {
+        i32 spawned = 0;
+        if (count > 0)
+        {
+            i32 first = group.spawn(count, spawned);
+            spawn(group, first, spawned, worldMatrix, elapsedTime);
+        }
+
+        return spawned;
+    }
+
+    void ParticleEmitter::spawn(ParticleGroup& group, i32 first, i32 count, const Matrix4& worldMatrix, float elapsedTime)
+    {
+        Vector3 origin = Vector3::ZERO * worldMatrix;
+        Vector3 direction = m_direction * worldMatrix - origin;
+        if (direction.len() < 1e-6f)
+            direction = Vector3::UNIT_Y;
+
+        direction.normalize();
+
+        // basis around the direction for the spread cone
+        Vector3 side = std::abs(direction.y) < 0.99f ? direction.cross(Vector3::UNIT_Y) : direction.cross(Vector3::UNIT_X);
+        side.normalize();
+        Vector3 up = side.cross(direction);
+
+        float spread = m_spread * Math::DEG2RAD;
+        float cosSpread = std::cos(spread);
+        float birthTime = Math::Min(elapsedTime, m_life.y);
+        for (i32 i = first; i < first + count; i++)
+        {
+            ParticleBlock& block = group.getBlock(i);
+            i32 idx = i % ParticleBlock::Size;
+
+            Vector3 dir;
+            Vector3 offset;
+            if (m_isPlanar)
+            {
+                float angle = (random() * 2.f - 1.f) * spread;
+                float c = std::cos(angle), s = std::sin(angle);
+                dir = Vector3(direction.x * c - direction.y * s, direction.x * s + direction.y * c, 0.f);
+
+                float theta = random() * Math::PI_2;
+                float r = m_radius * std::sqrt(random());
+                offset = Vector3(std::cos(theta) * r, std::sin(theta) * r, 0.f);
+            }
+            else
+            {
+                float cosTheta = 1.f - random() * (1.f - cosSpread);
+                float sinTheta = std::sqrt(Math::Max(1.f - cosTheta * cosTheta, 0.f));
+                float phi = random() * Math::PI_2;
+                dir = direction * cosTheta + (side * std::cos(phi) + up * std::sin(phi)) * sinTheta;
+
+                float z = random() * 2.f - 1.f;
+                float theta = random() * Math::PI_2;
+                float r = m_radius * std::cbrt(random());
+                float planar = std::sqrt(Math::Max(1.f - z * z, 0.f));
+                offset = Vector3(std::cos(theta) * planar, std::sin(theta) * planar, z) * r;
+            }
+
+            float speed = m_speed.x + (m_speed.y - m_speed.x) * random();
+            float life = m_life.x + (m_life.y - m_life.x) * random();
+
+            // born somewhere in the tick, long ticks of throttled systems stay continuous
+            float age = random() * birthTime;
+            float invLife = 1.f / Math::Max(life, 0.001f);
+
+            Vector3 velocity = dir * speed;
+            Vector3 position = origin + offset + velocity * age;
+            block.m_positionX[idx] = position.x;
+            block.m_positionY[idx] = position.y;
+            block.m_positionZ[idx] = position.z;
+            block.m_velocityX[idx] = velocity.x;
+            block.m_velocityY[idx] = velocity.y;
+            block.m_velocityZ[idx] = velocity.z;
+            block.m_age[idx] = Math::Min(age * invLife, 1.f);
+            block.m_invLife[idx] = invLife;
+            block.m_size[idx] = m_size;
+            block.m_rotation[idx] = random() * Math::PI_2;
+            block.m_colorR[idx] = m_color.r;
+            block.m_colorG[idx] = m_color.g;
+            block.m_colorB[idx] = m_color.b;
+            block.m_colorA[idx] = m_color.a;
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../particle/particle_group.h"
+
+namespace Echo
+{
+    // spawns particles into a group, everything emitted in a tick is
+    // written block by block in one go
+    class ParticleEmitter
+    {
+    public:
+        ParticleEmitter();
+
+        // particles per second
+        float getRate() const { return m_rate; }
+        void setRate(float rate) { m_rate = Math::Max(rate, 0.f); }
+
+        // particles emitted at start
+        i32 getBurst() const { return m_burst; }
+        void setBurst(i32 burst) { m_burst = Math::Max(burst, 0); }
+
+        // life range in seconds
+        const Vector2& getLife() const { return m_life; }
+        void setLife(const Vector2& life) { m_life = life; }
+
+        // speed range
+        const Vector2& getSpeed() const { return m_speed; }
+        void setSpeed(const Vector2& speed) { m_speed = speed; }
+
+        // direction in local space
+        const Vector3& getDirection() const { return m_direction; }
+        void setDirection(const Vector3& direction) { m_direction = direction; }
+
+        // spread angle around the direction in degrees
+        float getSpread() const { return m_spread; }
+        void setSpread(float spread) { m_spread = spread; }
+
+        // spawn radius
+        float getRadius() const { return m_radius; }
+        void setRadius(float radius) { m_radius = radius; }
+
+        // planar emitters keep z, used by 2d systems
+        bool isPlanar() const { return m_isPlanar; }
+        void setPlanar(bool isPlanar) { m_isPlanar = isPlanar; }
+
+        // start values
+        float getSize() const { return m_size; }
+        void setSize(float size) { m_size = size; }
+        const Color& getColor() const { return m_color; }
+        void setColor(const Color& color) { m_color = color; }
+
+        // emit burst again
+        void reset();
+
+        // particles due in this tick, rate scaled by the lod
+        i32 advance(float elapsedTime, float rateScale);
+
+        // spawn particles born during this tick in world space, returns count
+        i32 emit(ParticleGroup& group, const Matrix4& worldMatrix, float elapsedTime, i32 count);
+
+        // fill particles [first, first + count) of a group, births are spread over the tick
+        void spawn(ParticleGroup& group, i32 first, i32 count, const Matrix4& worldMatrix, float elapsedTime);
+
+    private:
+        // random in [0, 1)
+        float random();
+
+    private:
+        float       m_rate = 10.f;
+        i32         m_burst = 0;
+        Vector2     m_life = Vector2(1.f, 2.f);
+        Vector2     m_speed = Vector2(50.f, 100.f);
+        Vector3     m_direction = Vector3(0.f, 1.f, 0.f);
+        float       m_spread = 30.f;
+        float       m_radius = 0.f;
+        bool        m_isPlanar = true;
+        float       m_size = 16.f;
+        Color       m_color = Color::WHITE;
+        float       m_accumulator = 0.f;
+        bool        m_isBurstDone = false;
+        ui32        m_seed;
+    };
+}
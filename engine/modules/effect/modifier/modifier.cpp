@@ -0,0 +1,51 @@
+#include "modifier.h"
+#include "../particle/particle_simd.h"
+
+namespace Echo
+{
+    // lerp one attribute by the normalized age
+    static void lerpOverLife(const float* age, float* values, i32 count, float begin, float end)
+    {
+        ParticleFloat4 vBegin(begin);
+        ParticleFloat4 vDelta(end - begin);
+        for (i32 i = 0; i < count; i += 4)
+            (vBegin + vDelta * ParticleFloat4::load(age + i)).store(values + i);
+    }
+
+    void ParticleGravityModifier::apply(ParticleBlock& block, float elapsedTime)
+    {
+        ParticleFloat4 gx(m_gravity.x * elapsedTime);
+        ParticleFloat4 gy(m_gravity.y * elapsedTime);
+        ParticleFloat4 gz(m_gravity.z * elapsedTime);
+        for (i32 i = 0; i < block.m_count; i += 4)
+        {
+            (ParticleFloat4::load(block.m_velocityX + i) + gx).store(block.m_velocityX + i);
+            (ParticleFloat4::load(block.m_velocityY + i) + gy).store(block.m_velocityY + i);
+            (ParticleFloat4::load(block.m_velocityZ + i) + gz).store(block.m_velocityZ + i);
+        }
+    }
+
+    void ParticleDragModifier::apply(ParticleBlock& block, float elapsedTime)
+    {
+        ParticleFloat4 scale(Math::Max(1.f - m_drag * elapsedTime, 0.f));
+        for (i32 i = 0; i < block.m_count; i += 4)
+        {
+            (ParticleFloat4::load(block.m_velocityX + i) * scale).store(block.m_velocityX + i);
+            (ParticleFloat4::load(block.m_velocityY + i) * scale).store(block.m_velocityY + i);
+            (ParticleFloat4::load(block.m_velocityZ + i) * scale).store(block.m_velocityZ + i);
+        }
+    }
+
+    void ParticleColorModifier::apply(ParticleBlock& block, float elapsedTime)
+    {
+        lerpOverLife(block.m_age, block.m_colorR, block.m_count, m_begin.r, m_end.r);
+        lerpOverLife(block.m_age, block.m_colorG, block.m_count, m_begin.g, m_end.g);
+        lerpOverLife(block.m_age, block.m_colorB, block.m_count, m_begin.b, m_end.b);
+        lerpOverLife(block.m_age, block.m_colorA, block.m_count, m_begin.a, m_end.a);
+    }
+
+    void ParticleSizeModifier::apply(ParticleBlock& block, float elapsedTime)
+    {
+        lerpOverLife(block.m_age, block.m_size, block.m_count, m_begin, m_end);
+    }
+}
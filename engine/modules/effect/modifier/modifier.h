@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../particle/particle.h"
+
+namespace Echo
+{
+    // changes particles of a block every tick, runs on worker threads
+    class ParticleModifier
+    {
+    public:
+        virtual ~ParticleModifier() {}
+
+        // apply to the live particles of a block
+        virtual void apply(ParticleBlock& block, float elapsedTime) = 0;
+    };
+    typedef vector<ParticleModifier*>::type ParticleModifiers;
+
+    // constant acceleration
+    class ParticleGravityModifier : public ParticleModifier
+    {
+    public:
+        ParticleGravityModifier(const Vector3& gravity) : m_gravity(gravity) {}
+
+        // gravity
+        const Vector3& getGravity() const { return m_gravity; }
+        void setGravity(const Vector3& gravity) { m_gravity = gravity; }
+
+        // apply
+        virtual void apply(ParticleBlock& block, float elapsedTime) override;
+
+    private:
+        Vector3     m_gravity;
+    };
+
+    // velocity loses drag per second
+    class ParticleDragModifier : public ParticleModifier
+    {
+    public:
+        ParticleDragModifier(float drag) : m_drag(drag) {}
+
+        // drag
+        float getDrag() const { return m_drag; }
+        void setDrag(float drag) { m_drag = drag; }
+
+        // apply
+        virtual void apply(ParticleBlock& block, float elapsedTime) override;
+
+    private:
+        float       m_drag;
+    };
+
+    // colour over life, linear from begin to end
+    class ParticleColorModifier : public ParticleModifier
+    {
+    public:
+        ParticleColorModifier(const Color& begin, const Color& end) : m_begin(begin), m_end(end) {}
+
+        // colors
+        void setColors(const Color& begin, const Color& end) { m_begin = begin; m_end = end; }
+
+        // apply
+        virtual void apply(ParticleBlock& block, float elapsedTime) override;
+
+    private:
+        Color       m_begin;
+        Color       m_end;
+    };
+
+    // size over life, linear from begin to end
+    class ParticleSizeModifier : public ParticleModifier
+    {
+    public:
+        ParticleSizeModifier(float begin, float end) : m_begin(begin), m_end(end) {}
+
+        // sizes
+        void setSizes(float begin, float end) { m_begin = begin; m_end = end; }
+
+        // apply
+        virtual void apply(ParticleBlock& block, float elapsedTime) override;
+
+    private:
+        float       m_begin;
+        float       m_end;
+    };
+}
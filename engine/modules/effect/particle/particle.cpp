@@ -2,11 +2,27 @@
 
 namespace Echo
 {
-    Particle::Particle()
+    ParticleBlock::ParticleBlock()
     {
+        // stale lanes still go through the modifiers, keep them finite
+        memset(m_positionX, 0, sizeof(ParticleBlock) - offsetof(ParticleBlock, m_positionX));
     }
 
-    Particle::~Particle()
+    void ParticleBlock::copy(i32 dst, const ParticleBlock& src, i32 srcIdx)
     {
+        m_positionX[dst] = src.m_positionX[srcIdx];
+        m_positionY[dst] = src.m_positionY[srcIdx];
+        m_positionZ[dst] = src.m_positionZ[srcIdx];
+        m_velocityX[dst] = src.m_velocityX[srcIdx];
+        m_velocityY[dst] = src.m_velocityY[srcIdx];
+        m_velocityZ[dst] = src.m_velocityZ[srcIdx];
+        m_age[dst] = src.m_age[srcIdx];
+        m_invLife[dst] = src.m_invLife[srcIdx];
+        m_size[dst] = src.m_size[srcIdx];
+        m_rotation[dst] = src.m_rotation[srcIdx];
+        m_colorR[dst] = src.m_colorR[srcIdx];
+        m_colorG[dst] = src.m_colorG[srcIdx];
+        m_colorB[dst] = src.m_colorB[srcIdx];
+        m_colorA[dst] = src.m_colorA[srcIdx];
     }
 }
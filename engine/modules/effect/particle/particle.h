@@ -4,17 +4,33 @@
 
 namespace Echo
 {
-    class Particle
+    // a fixed number of particles stored attribute by attribute, so
+    // modifiers stream over contiguous floats four lanes at a time.
+    // lanes past m_count hold stale values and may be processed freely
+    struct ParticleBlock
     {
-    public:
-        Particle();
-        ~Particle();
-        
-    private:
-        Vector3 m_position;
-        Vector3 m_velocity;
-        Color   m_color;
-        float   m_life;
+        static const i32 Size = 256;
+
+        i32     m_count = 0;
+        float   m_positionX[Size];
+        float   m_positionY[Size];
+        float   m_positionZ[Size];
+        float   m_velocityX[Size];
+        float   m_velocityY[Size];
+        float   m_velocityZ[Size];
+        float   m_age[Size];            // 0 at birth, 1 at end of life
+        float   m_invLife[Size];
+        float   m_size[Size];
+        float   m_rotation[Size];
+        float   m_colorR[Size];
+        float   m_colorG[Size];
+        float   m_colorB[Size];
+        float   m_colorA[Size];
+
+        ParticleBlock();
+
+        // copy one particle
+        void copy(i32 dst, const ParticleBlock& src, i32 srcIdx);
     };
+    typedef vector<ParticleBlock*>::type ParticleBlocks;
 }
-
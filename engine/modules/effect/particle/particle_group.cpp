@@ -1,4 +1,5 @@
 #include "particle_group.h"
+#include "particle_simd.h"
 
 namespace Echo
 {
@@ -8,10 +9,134 @@ namespace Echo
 
     ParticleGroup::~ParticleGroup()
     {
+        clear();
     }
 
-    void ParticleGroup::tick(float elapsedTime)
+    void ParticleGroup::setCapacity(i32 capacity)
     {
-        
+        m_capacity = Math::Max(capacity, 0);
+        if (m_count > m_capacity)
+        {
+            m_count = m_capacity;
+            updateBlockCounts();
+        }
+    }
+
+    i32 ParticleGroup::spawn(i32 count, i32& oCount)
+    {
+        i32 first = m_count;
+        oCount = Math::Max(Math::Min(count, m_capacity - m_count), 0);
+        m_count += oCount;
+
+        while (i32(m_blocks.size()) * ParticleBlock::Size < m_count)
+            m_blocks.emplace_back(EchoNew(ParticleBlock));
+
+        updateBlockCounts();
+
+        return first;
+    }
+
+    void ParticleGroup::simulate(ParticleBlock& block, const ParticleModifiers& modifiers, float elapsedTime)
+    {
+        ParticleFloat4 dt(elapsedTime);
+        for (i32 i = 0; i < block.m_count; i += 4)
+        {
+            ParticleFloat4 age = ParticleFloat4::load(block.m_age + i) + ParticleFloat4::load(block.m_invLife + i) * dt;
+            age.store(block.m_age + i);
+        }
+
+        for (ParticleModifier* modifier : modifiers)
+            modifier->apply(block, elapsedTime);
+
+        for (i32 i = 0; i < block.m_count; i += 4)
+        {
+            (ParticleFloat4::load(block.m_positionX + i) + ParticleFloat4::load(block.m_velocityX + i) * dt).store(block.m_positionX + i);
+            (ParticleFloat4::load(block.m_positionY + i) + ParticleFloat4::load(block.m_velocityY + i) * dt).store(block.m_positionY + i);
+            (ParticleFloat4::load(block.m_positionZ + i) + ParticleFloat4::load(block.m_velocityZ + i) * dt).store(block.m_positionZ + i);
+        }
+    }
+
+    void ParticleGroup::removeDead()
+    {
+        for (i32 i = 0; i < m_count;)
+        {
+            ParticleBlock& block = getBlock(i);
+            i32 idx = i % ParticleBlock::Size;
+            if (block.m_age[idx] >= 1.f)
+            {
+                i32 last = m_count - 1;
+                if (last != i)
+                    block.copy(idx, getBlock(last), last % ParticleBlock::Size);
+
+                m_count--;
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        updateBlockCounts();
+    }
+
+    void ParticleGroup::tick(const ParticleModifiers& modifiers, float elapsedTime)
+    {
+        for (i32 i = 0; i < getBlockCount(); i++)
+            simulate(*m_blocks[i], modifiers, elapsedTime);
+
+        removeDead();
+    }
+
+    AABB ParticleGroup::calcBounds() const
+    {
+        AABB box;
+        if (!m_count)
+            return box;
+
+        const ParticleBlock& first = *m_blocks[0];
+        ParticleFloat4 minX(first.m_positionX[0]), minY(first.m_positionY[0]), minZ(first.m_positionZ[0]);
+        ParticleFloat4 maxX = minX, maxY = minY, maxZ = minZ;
+        for (i32 b = 0; b < getBlockCount(); b++)
+        {
+            const ParticleBlock& block = *m_blocks[b];
+
+            // whole lanes only, the tail is done one by one
+            i32 lanes = block.m_count & ~3;
+            for (i32 i = 0; i < lanes; i += 4)
+            {
+                ParticleFloat4 x = ParticleFloat4::load(block.m_positionX + i);
+                ParticleFloat4 y = ParticleFloat4::load(block.m_positionY + i);
+                ParticleFloat4 z = ParticleFloat4::load(block.m_positionZ + i);
+                minX = ParticleFloat4::Min(minX, x); maxX = ParticleFloat4::Max(maxX, x);
+                minY = ParticleFloat4::Min(minY, y); maxY = ParticleFloat4::Max(maxY, y);
+                minZ = ParticleFloat4::Min(minZ, z); maxZ = ParticleFloat4::Max(maxZ, z);
+            }
+
+            for (i32 i = lanes; i < block.m_count; i++)
+                box.addPoint(Vector3(block.m_positionX[i], block.m_positionY[i], block.m_positionZ[i]));
+        }
+
+        float lanes[6][4];
+        minX.store(lanes[0]); minY.store(lanes[1]); minZ.store(lanes[2]);
+        maxX.store(lanes[3]); maxY.store(lanes[4]); maxZ.store(lanes[5]);
+        for (i32 i = 0; i < 4; i++)
+        {
+            box.addPoint(Vector3(lanes[0][i], lanes[1][i], lanes[2][i]));
+            box.addPoint(Vector3(lanes[3][i], lanes[4][i], lanes[5][i]));
+        }
+
+        return box;
+    }
+
+    void ParticleGroup::clear()
+    {
+        EchoSafeDeleteContainer(m_blocks, ParticleBlock);
+        m_count = 0;
+    }
+
+    void ParticleGroup::updateBlockCounts()
+    {
+        for (size_t i = 0; i < m_blocks.size(); i++)
+            m_blocks[i]->m_count = Math::Clamp(m_count - i32(i) * ParticleBlock::Size, 0, ParticleBlock::Size);
     }
 }
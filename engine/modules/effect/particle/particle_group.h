@@ -1,20 +1,58 @@
 #pragma once
 
+#include "engine/core/geom/AABB.h"
 #include "particle.h"
+#include "../modifier/modifier.h"
 
 namespace Echo
 {
+    // live particles packed at the front of a list of blocks
     class ParticleGroup
     {
     public:
         ParticleGroup();
         ~ParticleGroup();
-        
-        // tick
-        void tick(float elapsedTime);
-        
+
+        // live particles
+        i32 getCount() const { return m_count; }
+
+        // max live particles
+        i32 getCapacity() const { return m_capacity; }
+        void setCapacity(i32 capacity);
+
+        // blocks, only the first ones hold particles
+        const ParticleBlocks& getBlocks() const { return m_blocks; }
+        i32 getBlockCount() const { return (m_count + ParticleBlock::Size - 1) / ParticleBlock::Size; }
+
+        // append count particles behind the live ones, returns the first index.
+        // oCount is less than count when the capacity is reached
+        i32 spawn(i32 count, i32& oCount);
+
+        // particle by index
+        ParticleBlock& getBlock(i32 index) { return *m_blocks[index / ParticleBlock::Size]; }
+
+        // age, modifiers and integration of one block, blocks are independent
+        static void simulate(ParticleBlock& block, const ParticleModifiers& modifiers, float elapsedTime);
+
+        // remove particles at end of life, the last particles fill the gaps
+        void removeDead();
+
+        // simulate all blocks then remove dead ones
+        void tick(const ParticleModifiers& modifiers, float elapsedTime);
+
+        // bounds of the live particle positions
+        AABB calcBounds() const;
+
+        // remove all
+        void clear();
+
     private:
-        vector<Particle>::type  m_particles;
+        // block counts follow the group count
+        void updateBlockCounts();
+
+    private:
+        i32             m_count = 0;
+        i32             m_capacity = 10000;
+        ParticleBlocks  m_blocks;
     };
 }
-
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "engine/core/base/echo_def.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define ECHO_PARTICLE_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define ECHO_PARTICLE_NEON
+#endif
+
+namespace Echo
+{
+	// four lanes of a particle attribute, loads and stores are unaligned
+	struct ParticleFloat4
+	{
+#if defined(ECHO_PARTICLE_SSE)
+		__m128			m_v;
+
+		ParticleFloat4() {}
+		ParticleFloat4(__m128 v) : m_v(v) {}
+		explicit ParticleFloat4(float v) : m_v(_mm_set1_ps(v)) {}
+
+		static ParticleFloat4 load(const float* data) { return _mm_loadu_ps(data); }
+		void store(float* data) const { _mm_storeu_ps(data, m_v); }
+
+		ParticleFloat4 operator + (const ParticleFloat4& b) const { return _mm_add_ps(m_v, b.m_v); }
+		ParticleFloat4 operator - (const ParticleFloat4& b) const { return _mm_sub_ps(m_v, b.m_v); }
+		ParticleFloat4 operator * (const ParticleFloat4& b) const { return _mm_mul_ps(m_v, b.m_v); }
+
+		static ParticleFloat4 Min(const ParticleFloat4& a, const ParticleFloat4& b) { return _mm_min_ps(a.m_v, b.m_v); }
+		static ParticleFloat4 Max(const ParticleFloat4& a, const ParticleFloat4& b) { return _mm_max_ps(a.m_v, b.m_v); }
+#elif defined(ECHO_PARTICLE_NEON)
+		float32x4_t		m_v;
+
+		ParticleFloat4() {}
+		ParticleFloat4(float32x4_t v) : m_v(v) {}
+		explicit ParticleFloat4(float v) : m_v(vdupq_n_f32(v)) {}
+
+		static ParticleFloat4 load(const float* data) { return vld1q_f32(data); }
+		void store(float* data) const { vst1q_f32(data, m_v); }
+
+		ParticleFloat4 operator + (const ParticleFloat4& b) const { return vaddq_f32(m_v, b.m_v); }
+		ParticleFloat4 operator - (const ParticleFloat4& b) const { return vsubq_f32(m_v, b.m_v); }
+		ParticleFloat4 operator * (const ParticleFloat4& b) const { return vmulq_f32(m_v, b.m_v); }
+
+		static ParticleFloat4 Min(const ParticleFloat4& a, const ParticleFloat4& b) { return vminq_f32(a.m_v, b.m_v); }
+		static ParticleFloat4 Max(const ParticleFloat4& a, const ParticleFloat4& b) { return vmaxq_f32(a.m_v, b.m_v); }
+#else
+		float			m_v[4];
+
+		ParticleFloat4() {}
+		explicit ParticleFloat4(float v) { m_v[0] = m_v[1] = m_v[2] = m_v[3] = v; }
+
+		static ParticleFloat4 load(const float* data) { ParticleFloat4 r; for (int i = 0; i < 4; i++) r.m_v[i] = data[i]; return r; }
+		void store(float* data) const { for (int i = 0; i < 4; i++) data[i] = m_v[i]; }
+
+		ParticleFloat4 operator + (const ParticleFloat4& b) const { ParticleFloat4 r; for (int i = 0; i < 4; i++) r.m_v[i] = m_v[i] + b.m_v[i]; return r; }
+		ParticleFloat4 operator - (const ParticleFloat4& b) const { ParticleFloat4 r; for (int i = 0; i < 4; i++) r.m_v[i] = m_v[i] - b.m_v[i]; return r; }
+		ParticleFloat4 operator * (const ParticleFloat4& b) const { ParticleFloat4 r; for (int i = 0; i < 4; i++) r.m_v[i] = m_v[i] * b.m_v[i]; return r; }
+
+		static ParticleFloat4 Min(const ParticleFloat4& a, const ParticleFloat4& b) { ParticleFloat4 r; for (int i = 0; i < 4; i++) r.m_v[i] = a.m_v[i] < b.m_v[i] ? a.m_v[i] : b.m_v[i]; return r; }
+		static ParticleFloat4 Max(const ParticleFloat4& a, const ParticleFloat4& b) { ParticleFloat4 r; for (int i = 0; i < 4; i++) r.m_v[i] = a.m_v[i] > b.m_v[i] ? a.m_v[i] : b.m_v[i]; return r; }
+#endif
+	};
+}
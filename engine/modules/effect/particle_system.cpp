@@ -1,19 +1,113 @@
 #include "particle_system.h"
+#include "effect_module.h"
 #include "engine/core/log/Log.h"
 #include "engine/core/scene/node_tree.h"
 #include "base/Renderer.h"
 #include "base/ShaderProgram.h"
 #include "engine/core/main/Engine.h"
 
+static const char* g_particleVsCode = R"(#version 450
+
+// uniforms
+layout(binding = 0) uniform UBO
+{
+	mat4 u_ViewProjMatrix;
+	vec3 u_BillboardRight;
+	vec3 u_BillboardUp;
+	vec2 u_FrameGrid;
+} vs_ubo;
+
+// inputs, quad corner
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec2 a_UV;
+
+// inputs, per particle (position size) (color) (rotation frame)
+layout(location = 2) in vec4 a_Instance0;
+layout(location = 3) in vec4 a_Instance1;
+layout(location = 4) in vec2 a_Instance2;
+
+// outputs
+layout(location = 0) out vec4 v_Color;
+layout(location = 1) out vec2 v_TexCoord;
+
+void main(void)
+{
+    float c = cos(a_Instance2.x) * a_Instance0.w;
+    float s = sin(a_Instance2.x) * a_Instance0.w;
+    vec3 axisX = vs_ubo.u_BillboardRight * c + vs_ubo.u_BillboardUp * s;
+    vec3 axisY = vs_ubo.u_BillboardUp * c - vs_ubo.u_BillboardRight * s;
+    vec3 position = a_Instance0.xyz + axisX * a_Position.x + axisY * a_Position.y;
+    gl_Position = vs_ubo.u_ViewProjMatrix * vec4(position, 1.0);
+
+    vec2 cell = vec2(mod(a_Instance2.y, vs_ubo.u_FrameGrid.x), floor(a_Instance2.y / vs_ubo.u_FrameGrid.x));
+    v_Color = a_Instance1;
+    v_TexCoord = (cell + a_UV) / vs_ubo.u_FrameGrid;
+}
+)";
+
+static const char* g_particlePsCode = R"(#version 450
+
+precision mediump float;
+
+// uniforms
+layout(binding = 3) uniform sampler2D BaseColor;
+
+// inputs
+layout(location = 0) in vec4 v_Color;
+layout(location = 1) in vec2 v_TexCoord;
+
+// outputs
+layout(location = 0) out vec4 o_FragColor;
+
+void main(void)
+{
+    o_FragColor = texture(BaseColor, v_TexCoord) * v_Color;
+}
+)";
+
 namespace Echo
 {
+    // particles blend over the scene, 3d ones are hidden by geometry in front
+    static ShaderProgramPtr getParticleShader(bool is3d)
+    {
+        String shaderVirtualPath = is3d ? "echo_particle_3d_shader" : "echo_particle_2d_shader";
+        ShaderProgramPtr shader = ECHO_DOWN_CAST<ShaderProgram*>(ShaderProgram::get(shaderVirtualPath));
+        if (!shader)
+        {
+            shader = ECHO_CREATE_RES(ShaderProgram);
+            shader->setBlendMode("Transparent");
+
+            DepthStencilState::DepthStencilDesc depthDesc;
+            depthDesc.bDepthEnable = is3d;
+            depthDesc.bWriteDepth = false;
+            shader->setDepthState(Renderer::instance()->createDepthStencilState(depthDesc));
+
+            shader->setCullMode("CULL_NONE");
+            shader->setPath(shaderVirtualPath);
+            shader->setType("glsl");
+            shader->setVsCode(g_particleVsCode);
+            shader->setPsCode(g_particlePsCode);
+        }
+
+        return shader;
+    }
+
     ParticleSystem::ParticleSystem()
         : Render()
+        , m_updateMicroseconds(0)
     {
+        m_modifiers = { &m_gravity, &m_drag, &m_color, &m_size };
+
+        // systems sharing an update interval step on different frames
+        m_lodPhase = ui32(size_t(this) >> 4);
+
+        EffectModule::instance()->addParticleSystem(this);
     }
 
     ParticleSystem::~ParticleSystem()
     {
+        EffectModule::instance()->removeParticleSystem(this);
+
         EchoSafeRelease(m_renderable);
         m_mesh.reset();
     }
@@ -22,9 +116,65 @@ namespace Echo
     {
         CLASS_BIND_METHOD(ParticleSystem, getMaterial,        DEF_METHOD("getMaterial"));
         CLASS_BIND_METHOD(ParticleSystem, setMaterial,        DEF_METHOD("setMaterial"));
+        CLASS_BIND_METHOD(ParticleSystem, getMaxParticles,    DEF_METHOD("getMaxParticles"));
+        CLASS_BIND_METHOD(ParticleSystem, setMaxParticles,    DEF_METHOD("setMaxParticles"));
+        CLASS_BIND_METHOD(ParticleSystem, getRate,            DEF_METHOD("getRate"));
+        CLASS_BIND_METHOD(ParticleSystem, setRate,            DEF_METHOD("setRate"));
+        CLASS_BIND_METHOD(ParticleSystem, getBurst,           DEF_METHOD("getBurst"));
+        CLASS_BIND_METHOD(ParticleSystem, setBurst,           DEF_METHOD("setBurst"));
+        CLASS_BIND_METHOD(ParticleSystem, getLife,            DEF_METHOD("getLife"));
+        CLASS_BIND_METHOD(ParticleSystem, setLife,            DEF_METHOD("setLife"));
+        CLASS_BIND_METHOD(ParticleSystem, getSpeed,           DEF_METHOD("getSpeed"));
+        CLASS_BIND_METHOD(ParticleSystem, setSpeed,           DEF_METHOD("setSpeed"));
+        CLASS_BIND_METHOD(ParticleSystem, getDirection,       DEF_METHOD("getDirection"));
+        CLASS_BIND_METHOD(ParticleSystem, setDirection,       DEF_METHOD("setDirection"));
+        CLASS_BIND_METHOD(ParticleSystem, getSpread,          DEF_METHOD("getSpread"));
+        CLASS_BIND_METHOD(ParticleSystem, setSpread,          DEF_METHOD("setSpread"));
+        CLASS_BIND_METHOD(ParticleSystem, getRadius,          DEF_METHOD("getRadius"));
+        CLASS_BIND_METHOD(ParticleSystem, setRadius,          DEF_METHOD("setRadius"));
+        CLASS_BIND_METHOD(ParticleSystem, getStartSize,       DEF_METHOD("getStartSize"));
+        CLASS_BIND_METHOD(ParticleSystem, setStartSize,       DEF_METHOD("setStartSize"));
+        CLASS_BIND_METHOD(ParticleSystem, getEndSize,         DEF_METHOD("getEndSize"));
+        CLASS_BIND_METHOD(ParticleSystem, setEndSize,         DEF_METHOD("setEndSize"));
+        CLASS_BIND_METHOD(ParticleSystem, getStartColor,      DEF_METHOD("getStartColor"));
+        CLASS_BIND_METHOD(ParticleSystem, setStartColor,      DEF_METHOD("setStartColor"));
+        CLASS_BIND_METHOD(ParticleSystem, getEndColor,        DEF_METHOD("getEndColor"));
+        CLASS_BIND_METHOD(ParticleSystem, setEndColor,        DEF_METHOD("setEndColor"));
+        CLASS_BIND_METHOD(ParticleSystem, getFrameGrid,       DEF_METHOD("getFrameGrid"));
+        CLASS_BIND_METHOD(ParticleSystem, setFrameGrid,       DEF_METHOD("setFrameGrid"));
+        CLASS_BIND_METHOD(ParticleSystem, getGravity,         DEF_METHOD("getGravity"));
+        CLASS_BIND_METHOD(ParticleSystem, setGravity,         DEF_METHOD("setGravity"));
+        CLASS_BIND_METHOD(ParticleSystem, getDrag,            DEF_METHOD("getDrag"));
+        CLASS_BIND_METHOD(ParticleSystem, setDrag,            DEF_METHOD("setDrag"));
+        CLASS_BIND_METHOD(ParticleSystem, getLodScreenSize,   DEF_METHOD("getLodScreenSize"));
+        CLASS_BIND_METHOD(ParticleSystem, setLodScreenSize,   DEF_METHOD("setLodScreenSize"));
+        CLASS_BIND_METHOD(ParticleSystem, getCulledInterval,  DEF_METHOD("getCulledInterval"));
+        CLASS_BIND_METHOD(ParticleSystem, setCulledInterval,  DEF_METHOD("setCulledInterval"));
+        CLASS_BIND_METHOD(ParticleSystem, getParticleCount,   DEF_METHOD("getParticleCount"));
+        CLASS_BIND_METHOD(ParticleSystem, getLod,             DEF_METHOD("getLod"));
+        CLASS_BIND_METHOD(ParticleSystem, isCulled,           DEF_METHOD("isCulled"));
+        CLASS_BIND_METHOD(ParticleSystem, getUpdateTime,      DEF_METHOD("getUpdateTime"));
+        CLASS_BIND_METHOD(ParticleSystem, restart,            DEF_METHOD("restart"));
 
-        CLASS_REGISTER_PROPERTY(Sprite, "Material", Variant::Type::Object, "getMaterial", "setMaterial");
-        CLASS_REGISTER_PROPERTY_HINT(Sprite, "Material", PropertyHintType::ResourceType, "Material");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Material", Variant::Type::Object, "getMaterial", "setMaterial");
+        CLASS_REGISTER_PROPERTY_HINT(ParticleSystem, "Material", PropertyHintType::ResourceType, "Material");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "MaxParticles", Variant::Type::Int, "getMaxParticles", "setMaxParticles");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Rate", Variant::Type::Real, "getRate", "setRate");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Burst", Variant::Type::Int, "getBurst", "setBurst");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Life", Variant::Type::Vector2, "getLife", "setLife");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Speed", Variant::Type::Vector2, "getSpeed", "setSpeed");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Direction", Variant::Type::Vector3, "getDirection", "setDirection");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Spread", Variant::Type::Real, "getSpread", "setSpread");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Radius", Variant::Type::Real, "getRadius", "setRadius");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "StartSize", Variant::Type::Real, "getStartSize", "setStartSize");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "EndSize", Variant::Type::Real, "getEndSize", "setEndSize");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "StartColor", Variant::Type::Color, "getStartColor", "setStartColor");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "EndColor", Variant::Type::Color, "getEndColor", "setEndColor");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "FrameGrid", Variant::Type::Vector2, "getFrameGrid", "setFrameGrid");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Gravity", Variant::Type::Vector3, "getGravity", "setGravity");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "Drag", Variant::Type::Real, "getDrag", "setDrag");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "LodScreenSize", Variant::Type::Real, "getLodScreenSize", "setLodScreenSize");
+        CLASS_REGISTER_PROPERTY(ParticleSystem, "CulledInterval", Variant::Type::Int, "getCulledInterval", "setCulledInterval");
     }
 
     void ParticleSystem::setMaterial(Object* material)
@@ -34,6 +184,156 @@ namespace Echo
         m_isRenderableDirty = true;
     }
 
+    void ParticleSystem::setStartSize(float size)
+    {
+        m_startSize = size;
+        m_emitter.setSize(size);
+        m_size.setSizes(m_startSize, m_endSize);
+    }
+
+    void ParticleSystem::setEndSize(float size)
+    {
+        m_endSize = size;
+        m_size.setSizes(m_startSize, m_endSize);
+    }
+
+    void ParticleSystem::setStartColor(const Color& color)
+    {
+        m_startColor = color;
+        m_emitter.setColor(color);
+        m_color.setColors(m_startColor, m_endColor);
+    }
+
+    void ParticleSystem::setEndColor(const Color& color)
+    {
+        m_endColor = color;
+        m_color.setColors(m_startColor, m_endColor);
+    }
+
+    void ParticleSystem::setFrameGrid(const Vector2& frameGrid)
+    {
+        m_frameGrid.x = Math::Max(std::floor(frameGrid.x), 1.f);
+        m_frameGrid.y = Math::Max(std::floor(frameGrid.y), 1.f);
+    }
+
+    void ParticleSystem::restart()
+    {
+        m_group.clear();
+        m_emitter.reset();
+    }
+
+    bool ParticleSystem::updateLod(ui32 frame, float elapsedTime, bool isVisible)
+    {
+        m_isCulled = !isVisible;
+        m_lod = 0;
+        if (isVisible && m_lodScreenSize > 0.f)
+        {
+            float screenSize = calcScreenSize();
+            while (m_lod < MaxLod && screenSize < m_lodScreenSize / float(1 << m_lod))
+                m_lod++;
+        }
+
+        // anything older than a life is dead, waiting longer changes nothing
+        float maxLife = Math::Max(m_emitter.getLife().x, m_emitter.getLife().y);
+        m_pendingTime = Math::Min(m_pendingTime + elapsedTime, maxLife);
+
+        i32 interval = isVisible ? (1 << m_lod) : m_culledInterval;
+        if (!interval || (frame + m_lodPhase) % interval)
+            return false;
+
+        m_stepTime = m_pendingTime;
+        m_pendingTime = 0.f;
+
+        return true;
+    }
+
+    float ParticleSystem::calcScreenSize() const
+    {
+        if (!m_particleBounds.isValid())
+            return 1.f;
+
+        if (m_renderType.getIdx() == 1)
+        {
+            Camera* camera = NodeTree::instance()->get3dCamera();
+            if (!camera)
+                return 1.f;
+
+            float radius = (m_particleBounds.vMax - m_particleBounds.vMin).len() * 0.5f;
+            float distance = (m_particleBounds.getCenter() - camera->getPosition()).len();
+            return distance > radius ? radius / (distance * std::tan(camera->getFov() * 0.5f)) : 1.f;
+        }
+        else
+        {
+            Camera* camera = m_renderType.getIdx() == 0 ? NodeTree::instance()->get2dCamera() : NodeTree::instance()->getUiCamera();
+            if (!camera)
+                return 1.f;
+
+            // clip space of the orthographic camera spans two units
+            AABB box = m_particleBounds.transform(camera->getViewProjMatrix());
+            return (box.vMax.y - box.vMin.y) * 0.5f;
+        }
+    }
+
+    void ParticleSystem::postSimulate(const Matrix4& worldMatrix)
+    {
+        m_group.removeDead();
+        m_emitter.setPlanar(m_renderType.getIdx() != 1);
+
+        // lod thins the emission, the module budget caps it
+        i32 count = m_emitter.advance(m_stepTime, 1.f / float(1 << m_lod));
+        count = EffectModule::instance()->acquireParticles(count);
+        m_emitter.emit(m_group, worldMatrix, m_stepTime, count);
+
+        m_particleBounds = m_group.calcBounds();
+        if (m_particleBounds.isValid())
+        {
+            float halfSize = Math::Max(m_startSize, m_endSize) * 0.5f;
+            m_particleBounds.vMin -= Vector3(halfSize, halfSize, halfSize);
+            m_particleBounds.vMax += Vector3(halfSize, halfSize, halfSize);
+        }
+    }
+
+    void ParticleSystem::updateBvhProxy()
+    {
+        if (m_renderType.getIdx() == 2)
+            return;
+
+        // the emitter area keeps the proxy in place while nothing is alive
+        Vector3 origin = Vector3::ZERO * getWorldMatrix();
+        float extent = m_emitter.getRadius() + Math::Max(m_startSize, m_endSize) * 0.5f;
+        AABB worldAABB(origin - Vector3(extent, extent, extent), origin + Vector3(extent, extent, extent));
+        if (m_particleBounds.isValid())
+            worldAABB.unionBox(m_particleBounds);
+
+        Bvh& bvh = m_renderType.getIdx() == 1 ? NodeTree::instance()->get3dBvh() : NodeTree::instance()->get2dBvh();
+        if (m_bvhNodeId == -1)
+            m_bvhNodeId = bvh.createProxy(worldAABB, getId());
+        else
+            bvh.moveProxy(m_bvhNodeId, worldAABB, worldAABB.getCenter() - bvh.getFatAABB(m_bvhNodeId).getCenter());
+
+        m_localAABB = worldAABB.transform(getInverseWorldMatrix());
+    }
+
+    void ParticleSystem::flushUpdateTime()
+    {
+        m_updateTime = m_updateMicroseconds.exchange(0) * 0.001f;
+    }
+
+    void* ParticleSystem::getGlobalUniformValue(const String& name)
+    {
+        // particles are simulated in world space
+        if (name == "u_WorldMatrix")
+            return (void*)(&Matrix4::IDENTITY);
+        else if (name == "u_BillboardRight")
+            return (void*)(&m_billboardRight);
+        else if (name == "u_BillboardUp")
+            return (void*)(&m_billboardUp);
+        else if (name == "u_FrameGrid")
+            return (void*)(&m_frameGrid);
+
+        return Render::getGlobalUniformValue(name);
+    }
+
     void ParticleSystem::buildRenderable()
     {
         if (m_isRenderableDirty)
@@ -42,16 +342,12 @@ namespace Echo
 
             if (!m_material)
             {
-                StringArray macros = { "ALPHA_ADJUST" };
-                ShaderProgramPtr shader = ShaderProgram::getDefault2D(macros);
+                ShaderProgramPtr shader = getParticleShader(m_renderType.getIdx() == 1);
 
                 m_material = ECHO_CREATE_RES(Material);
                 m_material->setShaderPath(shader->getPath());
             }
 
-            // mesh
-            updateMeshBuffer();
-
             // create render able
             m_renderable = Renderable::create(m_mesh, m_material, this);
 
@@ -63,9 +359,10 @@ namespace Echo
     {
         if (isNeedRender())
         {
-            buildRenderable();
-            if (m_renderable)
+            updateMeshBuffer();
+            if (m_group.getCount() > 0)
             {
+                buildRenderable();
                 m_renderable->submitToRenderQueue();
             }
         }
@@ -73,34 +370,66 @@ namespace Echo
 
     void ParticleSystem::updateMeshBuffer()
     {
-        if(!m_mesh)
-        {
-            m_mesh = Mesh::create(true, true);
-        }
-        
-        if(m_mesh)
-        {
-            // indices
-            IndiceArray indices = { 0, 1, 2, 0, 2, 3 };
-
-            float hw = 64 * 0.5f;
-            float hh = 64 * 0.5f;
+        i32 count = m_group.getCount();
+        if (!count)
+            return;
 
-            // vertices
+        // every particle draws the same quad
+        if (!m_mesh)
+        {
             VertexArray vertices;
-            vertices.emplace_back(Vector3(-hw, -hh, 0.f), Vector2(0.f, 1.f));
-            vertices.emplace_back(Vector3(-hw,  hh, 0.f), Vector2(0.f, 0.f));
-            vertices.emplace_back(Vector3(hw,   hh, 0.f), Vector2(1.f, 0.f));
-            vertices.emplace_back(Vector3(hw,  -hh, 0.f), Vector2(1.f, 1.f));
+            vertices.emplace_back(Vector3(-0.5f, -0.5f, 0.f), Vector2(0.f, 1.f));
+            vertices.emplace_back(Vector3(-0.5f,  0.5f, 0.f), Vector2(0.f, 0.f));
+            vertices.emplace_back(Vector3( 0.5f,  0.5f, 0.f), Vector2(1.f, 0.f));
+            vertices.emplace_back(Vector3( 0.5f, -0.5f, 0.f), Vector2(1.f, 1.f));
+
+            IndiceArray indices = { 0, 1, 2, 0, 2, 3 };
 
-            // format
             MeshVertexFormat define;
             define.m_isUseUV = true;
 
+            m_mesh = Mesh::create(false, false);
             m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
             m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+        }
 
-            m_localAABB = m_mesh->getLocalBox();
+        // billboard axes
+        m_billboardRight = Vector3::UNIT_X;
+        m_billboardUp = Vector3::UNIT_Y;
+        Camera* camera = NodeTree::instance()->get3dCamera();
+        if (m_renderType.getIdx() == 1 && camera)
+        {
+            m_billboardRight = camera->getRight();
+            m_billboardUp = camera->getUp();
         }
+
+        // write straight into the instance storage of the mesh
+        static const VertexElementList instanceElements =
+        {
+            VertexElement(VS_INSTANCE0, PF_RGBA32_FLOAT),
+            VertexElement(VS_INSTANCE1, PF_RGBA8_UNORM),
+            VertexElement(VS_INSTANCE2, PF_RG32_FLOAT),
+        };
+
+        float frameCount = m_frameGrid.x * m_frameGrid.y;
+        InstanceFormat* instances = (InstanceFormat*)m_mesh->lockInstances(instanceElements, count);
+        const ParticleBlocks& blocks = m_group.getBlocks();
+        for (i32 i = 0; i < count; i++)
+        {
+            const ParticleBlock& block = *blocks[i / ParticleBlock::Size];
+            i32 idx = i % ParticleBlock::Size;
+
+            Color rgba;
+            rgba.set(block.m_colorR[idx], block.m_colorG[idx], block.m_colorB[idx], block.m_colorA[idx]);
+
+            InstanceFormat& instance = instances[i];
+            instance.m_position = Vector3(block.m_positionX[idx], block.m_positionY[idx], block.m_positionZ[idx]);
+            instance.m_size = block.m_size[idx];
+            instance.m_color = rgba.getABGR();
+            instance.m_rotation = block.m_rotation[idx];
+            instance.m_frame = std::floor(Math::Min(block.m_age[idx] * frameCount, frameCount - 1.f));
+        }
+
+        m_mesh->unlockInstances();
     }
 }
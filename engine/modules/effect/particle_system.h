@@ -4,6 +4,8 @@
 #include "engine/core/render/base/mesh/mesh.h"
 #include "engine/core/render/base/Material.h"
 #include "engine/core/render/base/Renderable.h"
+#include "emitter/emitter.h"
+#include <atomic>
 
 namespace Echo
 {
@@ -12,6 +14,7 @@ namespace Echo
         ECHO_CLASS(ParticleSystem, Render)
 
     public:
+        // corner of the shared quad, expanded by the vertex shader
         struct VertexFormat
         {
             Vector3        m_position;
@@ -24,6 +27,19 @@ namespace Echo
         typedef vector<VertexFormat>::type    VertexArray;
         typedef vector<Word>::type    IndiceArray;
 
+        // each level halves emission and update rate
+        static const i32 MaxLod = 3;
+
+        // one record per particle
+        struct InstanceFormat
+        {
+            Vector3        m_position;
+            float          m_size;
+            Dword          m_color;
+            float          m_rotation;
+            float          m_frame;
+        };
+
     public:
         ParticleSystem();
         virtual ~ParticleSystem();
@@ -32,6 +48,94 @@ namespace Echo
         Material* getMaterial() const { return m_material; }
         void setMaterial(Object* material);
 
+        // max live particles
+        i32 getMaxParticles() const { return m_group.getCapacity(); }
+        void setMaxParticles(i32 maxParticles) { m_group.setCapacity(maxParticles); }
+
+        // emitter
+        float getRate() const { return m_emitter.getRate(); }
+        void setRate(float rate) { m_emitter.setRate(rate); }
+        i32 getBurst() const { return m_emitter.getBurst(); }
+        void setBurst(i32 burst) { m_emitter.setBurst(burst); }
+        const Vector2& getLife() const { return m_emitter.getLife(); }
+        void setLife(const Vector2& life) { m_emitter.setLife(life); }
+        const Vector2& getSpeed() const { return m_emitter.getSpeed(); }
+        void setSpeed(const Vector2& speed) { m_emitter.setSpeed(speed); }
+        const Vector3& getDirection() const { return m_emitter.getDirection(); }
+        void setDirection(const Vector3& direction) { m_emitter.setDirection(direction); }
+        float getSpread() const { return m_emitter.getSpread(); }
+        void setSpread(float spread) { m_emitter.setSpread(spread); }
+        float getRadius() const { return m_emitter.getRadius(); }
+        void setRadius(float radius) { m_emitter.setRadius(radius); }
+
+        // size over life
+        float getStartSize() const { return m_startSize; }
+        void setStartSize(float size);
+        float getEndSize() const { return m_endSize; }
+        void setEndSize(float size);
+
+        // color over life
+        const Color& getStartColor() const { return m_startColor; }
+        void setStartColor(const Color& color);
+        const Color& getEndColor() const { return m_endColor; }
+        void setEndColor(const Color& color);
+
+        // sprite sheet columns and rows, frames advance over life
+        const Vector2& getFrameGrid() const { return m_frameGrid; }
+        void setFrameGrid(const Vector2& frameGrid);
+
+        // forces
+        const Vector3& getGravity() const { return m_gravity.getGravity(); }
+        void setGravity(const Vector3& gravity) { m_gravity.setGravity(gravity); }
+        float getDrag() const { return m_drag.getDrag(); }
+        void setDrag(float drag) { m_drag.setDrag(drag); }
+
+        // screen height fraction below which each lod level halves emission and update rate, 0 disables
+        float getLodScreenSize() const { return m_lodScreenSize; }
+        void setLodScreenSize(float screenSize) { m_lodScreenSize = Math::Max(screenSize, 0.f); }
+
+        // frames between updates while culled, 0 waits until visible and fast forwards
+        i32 getCulledInterval() const { return m_culledInterval; }
+        void setCulledInterval(i32 interval) { m_culledInterval = Math::Max(interval, 0); }
+
+        // live particles
+        i32 getParticleCount() const { return m_group.getCount(); }
+
+        // profile, lod of the last update and its cost in milliseconds
+        i32 getLod() const { return m_lod; }
+        bool isCulled() const { return m_isCulled; }
+        float getUpdateTime() const { return m_updateTime; }
+
+        // restart emission
+        void restart();
+
+    public:
+        // is simulated by the effect module this frame
+        bool isSimulating() const { return m_isEnable && isNeedRender(); }
+
+        // particle data
+        ParticleGroup& getGroup() { return m_group; }
+        const ParticleModifiers& getModifiers() const { return m_modifiers; }
+
+        // pick the lod and accumulate time, returns true if the system steps this frame
+        bool updateLod(ui32 frame, float elapsedTime, bool isVisible);
+
+        // time covered by the current step
+        float getStepTime() const { return m_stepTime; }
+
+        // emit and compact after the blocks were simulated, called on a worker
+        void postSimulate(const Matrix4& worldMatrix);
+
+        // move the bvh proxy to the particle bounds
+        void updateBvhProxy();
+
+        // profile, workers add the time they spent on this system
+        void addUpdateTime(ulong microseconds) { m_updateMicroseconds += ui32(microseconds); }
+        void flushUpdateTime();
+
+        // get global uniforms
+        virtual void* getGlobalUniformValue(const String& name) override;
+
     protected:
         // build drawable
         void buildRenderable();
@@ -39,13 +143,40 @@ namespace Echo
         // update
         virtual void update_self() override;
 
-        // update vertex buffer
+        // upload one instance per particle
         void updateMeshBuffer();
 
+        // fraction of the screen height covered by the particle bounds
+        float calcScreenSize() const;
+
     private:
         bool                       m_isRenderableDirty = true;
         MeshPtr                    m_mesh;                        // Geometry Data for render
         MaterialPtr                m_material;                    // Material Instance
         Renderable*                m_renderable = nullptr;
+        ParticleGroup              m_group;
+        ParticleEmitter            m_emitter;
+        ParticleGravityModifier    m_gravity = ParticleGravityModifier(Vector3::ZERO);
+        ParticleDragModifier       m_drag = ParticleDragModifier(0.f);
+        ParticleColorModifier      m_color = ParticleColorModifier(Color::WHITE, Color::WHITE);
+        ParticleSizeModifier       m_size = ParticleSizeModifier(16.f, 16.f);
+        ParticleModifiers          m_modifiers;
+        float                      m_startSize = 16.f;
+        float                      m_endSize = 16.f;
+        Color                      m_startColor = Color::WHITE;
+        Color                      m_endColor = Color::WHITE;
+        Vector2                    m_frameGrid = Vector2(1.f, 1.f);
+        Vector3                    m_billboardRight = Vector3::UNIT_X;
+        Vector3                    m_billboardUp = Vector3::UNIT_Y;
+        AABB                       m_particleBounds;
+        float                      m_lodScreenSize = 0.f;
+        i32                        m_culledInterval = 0;
+        ui32                       m_lodPhase;
+        i32                        m_lod = 0;
+        bool                       m_isCulled = false;
+        float                      m_pendingTime = 0.f;
+        float                      m_stepTime = 0.f;
+        std::atomic<ui32>          m_updateMicroseconds;
+        float                      m_updateTime = 0.f;
     };
 }
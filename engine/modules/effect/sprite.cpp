@@ -87,6 +87,11 @@ namespace Echo
 	{
 		if (isNeedRender())
 		{
+			// atlas repacked, rewrite uvs or viewport
+			TextureAtla* atla = getBaseColorAtla();
+			if (m_mesh && atla && atla->getAtlas()->getVersion() != m_atlasVersion)
+				updateMeshBuffer();
+
 			buildRenderable();
 			if (m_renderable)
 			{
@@ -111,12 +116,31 @@ namespace Echo
             float hw = m_width * 0.5f;
             float hh = m_height * 0.5f;
 
+			// uv
+			Vector4 vp(0.f, 0.f, 1.f, 1.f);
+			TextureAtla* atla = getBaseColorAtla();
+			if (atla)
+			{
+				// materials with a viewport uniform map the sub rect in the shader
+				Vector4 atlaVp = atla->getViewportNormalized();
+				Material::UniformValue* viewportValue = m_material->getUniform("BaseColorViewport");
+				if (viewportValue)
+					viewportValue->setValue(&atlaVp);
+				else
+					vp = atlaVp;
+
+				m_atlasVersion = atla->getAtlas()->getVersion();
+			}
+
+			float u0 = vp.x, u1 = vp.x + vp.z;
+			float v0 = vp.y, v1 = vp.y + vp.w;
+
             // vertices
             VertexArray vertices;
-            vertices.emplace_back(Vector3(-hw, -hh, 0.f), Vector2(0.f, 1.f));
-            vertices.emplace_back(Vector3(-hw,  hh, 0.f), Vector2(0.f, 0.f));
-            vertices.emplace_back(Vector3(hw,   hh, 0.f), Vector2(1.f, 0.f));
-            vertices.emplace_back(Vector3(hw,  -hh, 0.f), Vector2(1.f, 1.f));
+            vertices.emplace_back(Vector3(-hw, -hh, 0.f), Vector2(u0, v1));
+            vertices.emplace_back(Vector3(-hw,  hh, 0.f), Vector2(u0, v0));
+            vertices.emplace_back(Vector3(hw,   hh, 0.f), Vector2(u1, v0));
+            vertices.emplace_back(Vector3(hw,  -hh, 0.f), Vector2(u1, v1));
 
             // format
             MeshVertexFormat define;
@@ -128,4 +152,12 @@ namespace Echo
 			m_localAABB = m_mesh->getLocalBox();
         }
 	}
+
+	TextureAtla* Sprite::getBaseColorAtla()
+	{
+		Material::UniformValue* baseColor = m_material ? m_material->getUniform("BaseColor") : nullptr;
+		TextureAtla* atla = baseColor ? baseColor->getAtla() : nullptr;
+
+		return atla && atla->getAtlas() ? atla : nullptr;
+	}
 }
@@ -49,6 +49,9 @@ namespace Echo
 		// update vertex buffer
 		void updateMeshBuffer();
 
+		// atla of base color texture, its viewport goes to the uvs or the BaseColorViewport uniform
+		TextureAtla* getBaseColorAtla();
+
 	private:
 		bool                    m_isRenderableDirty = true;
 		i32						m_width = 64;
@@ -56,5 +59,6 @@ namespace Echo
 		MeshPtr				    m_mesh;						// Geometry Data for render
 		MaterialPtr				m_material;		            // Material Instance
 		Renderable*				m_renderable = nullptr;
+		ui32					m_atlasVersion = 0;
 	};
 }
@@ -199,6 +199,7 @@ namespace Echo
 		resetCommonSettings();
 		m_navQuery = dtAllocNavMeshQuery();
 		m_crowd = dtAllocCrowd();
+		m_pathQueue = EchoNew(NavigationPathQueue);
 
 		m_ctx = EchoNew(BuildContext);
 
@@ -217,10 +218,21 @@ namespace Echo
 		dtFreeNavMeshQuery(m_navQuery);
 		cleanup();
 
+		EchoSafeDelete(m_largeCrowd, NavigationCrowd);
+		EchoSafeDelete(m_pathQueue, NavigationPathQueue);
+
 		EchoSafeDelete(m_ctx, BuildContext);
 		dtFreeObstacleAvoidanceDebugData(m_vod);
 	}
 
+	void Navigation::update(float delta)
+	{
+		m_pathQueue->update(m_navMesh);
+
+		if (m_largeCrowd)
+			m_largeCrowd->update(delta, m_navMesh);
+	}
+
 	void Navigation::resetCommonSettings()
 	{
 		m_cellSize = 0.2f;
@@ -282,6 +294,7 @@ namespace Echo
 			return;
 		}
 		m_filter.setAreaCost(i, cost);
+		m_pathQueue->clearCache();
 		if (m_crowd)
 		{
 			dtQueryFilter* pFilter = const_cast<dtQueryFilter*>(m_crowd->getEditableFilter(0));
@@ -322,6 +335,7 @@ namespace Echo
 	void Navigation::setIncludeFlag(unsigned int nFlag)
 	{
 		m_filter.setIncludeFlags(nFlag);
+		m_pathQueue->clearCache();
 		if (m_crowd)
 		{
 			dtQueryFilter* pFilter = const_cast<dtQueryFilter*>(m_crowd->getEditableFilter(0));
@@ -332,6 +346,7 @@ namespace Echo
 	void Navigation::setExcludeFlag(unsigned int nFlag)
 	{
 		m_filter.setExcludeFlags(nFlag);
+		m_pathQueue->clearCache();
 		if (m_crowd)
 		{
 			dtQueryFilter* pFilter = const_cast<dtQueryFilter*>(m_crowd->getEditableFilter(0));
@@ -384,6 +399,28 @@ namespace Echo
 		pathCount = m_nstraightPath;
 	}
 
+	ui32 Navigation::requestPath(const Vector3& startPos, const Vector3& endPos, const NavigationPathQueue::PathCallback& callback, int type)
+	{
+		EchoAssert(type >= 0 && type < DT_CROWD_MAX_QUERY_FILTER_TYPE);
+		const dtQueryFilter* filter = type > 0 ? m_crowd->getFilter(type) : &m_filter;
+
+		m_pathQueue->setPolyPickExtents(m_polyPickExt);
+		return m_pathQueue->request(startPos, endPos, filter, callback);
+	}
+
+	void Navigation::cancelPath(ui32 id)
+	{
+		m_pathQueue->cancel(id);
+	}
+
+	NavigationCrowd* Navigation::largeCrowdInit(float maxAgentRadius)
+	{
+		EchoSafeDelete(m_largeCrowd, NavigationCrowd);
+		m_largeCrowd = EchoNew(NavigationCrowd(m_pathQueue, &m_filter, maxAgentRadius));
+
+		return m_largeCrowd;
+	}
+
 	void Navigation::crowdInit(float agentRadius)
 	{
 		if (m_crowd)
@@ -1133,6 +1170,7 @@ namespace Echo
 		{
 			m_filter.setIncludeFlags(nFlag);
 		}
+		m_pathQueue->clearCache();
 
 		if (m_crowd)
 		{
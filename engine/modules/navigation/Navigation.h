@@ -5,6 +5,8 @@
 #include <recast/Recast/DetourNavMeshQuery.h>
 #include <recast/Recast/DetourCrowd.h>
 #include <engine/core/math/Math.h>
+#include "NavigationPathQueue.h"
+#include "NavigationCrowd.h"
 
 class dtNavMesh;
 class dtNavMeshQuery;
@@ -75,7 +77,7 @@ namespace Echo
 		virtual ~Navigation();
 
 		// ÿ֡
-		virtual void update(float delta) {}
+		virtual void update(float delta);
 
 		// ȡ
 		const dtNavMesh* getNavMesh() const { return m_navMesh; }
@@ -89,6 +91,13 @@ namespace Echo
 		void findPath(const float spos[], const float espos[], float*& smoothPath, int & nsmoothPath, int include_flags);
 		void findStraightPath(const Vector3& startPos, const Vector3& endPos, float*& path, int& pathCount);
 
+		// 첽Ѱ·, updateͨص
+		ui32 requestPath(const Vector3& startPos, const Vector3& endPos, const NavigationPathQueue::PathCallback& callback, int type = 0);
+		void cancelPath(ui32 id);
+
+		// Ѱ·
+		NavigationPathQueue* getPathQueue() { return m_pathQueue; }
+
 		// ĳλĶ
 		bool findNearestPoly(const Vector3& position, const Vector3& ext, Vector3& nearest);
 
@@ -184,6 +193,11 @@ namespace Echo
 		// ƳĿ
 		void crowdRemoveAgentTarget(int aIndex);
 
+	public:
+		// ģȺ(ǧ), updateвģ
+		NavigationCrowd* largeCrowdInit(float maxAgentRadius = 0.6f);
+		NavigationCrowd* getLargeCrowd() { return m_largeCrowd; }
+
 	public:
 		// ü
 		void setGeometry(InputGeometryData* inputData) { m_geom = inputData; }
@@ -245,6 +259,8 @@ namespace Echo
 		float						m_spos[3];
 		float						m_epos[3];
 		dtQueryFilter				m_filter;
+		NavigationPathQueue*		m_pathQueue;			// 첽Ѱ·
+		NavigationCrowd*			m_largeCrowd = nullptr;	// ģȺ
 
 		static const int			MAX_POLYS = 256;
 		dtPolyRef					m_startRef;
@@ -0,0 +1,427 @@
+#include "NavigationCrowd.h"
+#include "engine/core/scene/node.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
+#include <thirdparty/recast/Recast/DetourCommon.h>
+
+namespace Echo
+{
+	static const int MAX_SEARCH_NODES = 256;
+	static const int MAX_VISITED_POLYS = 16;
+	static const int MAX_NEIGHBOURS = 16;
+
+	NavigationCrowd::NavigationCrowd(NavigationPathQueue* pathQueue, const dtQueryFilter* filter, float maxAgentRadius)
+		: m_pathQueue(pathQueue)
+		, m_filter(filter)
+	{
+		// neighbours within separation range are always in the 3x3 cells around
+		m_cellSize = std::max(maxAgentRadius, 0.1f) * 4.f;
+		m_queryExt[0] = maxAgentRadius * 2.f;
+		m_queryExt[1] = maxAgentRadius * 1.5f;
+		m_queryExt[2] = maxAgentRadius * 2.f;
+	}
+
+	NavigationCrowd::~NavigationCrowd()
+	{
+		for (size_t i = 0; i < m_pathRequests.size(); i++)
+		{
+			if (m_pathRequests[i])
+				m_pathQueue->cancel(m_pathRequests[i]);
+		}
+
+		for (dtNavMeshQuery* query : m_queries)
+			dtFreeNavMeshQuery(query);
+	}
+
+	i32 NavigationCrowd::addAgent(const Vector3& pos, const AgentParams& params)
+	{
+		dtPolyRef polyRef = 0;
+		Vector3 nearest = pos;
+		if (m_navMesh)
+		{
+			m_queries[0]->findNearestPoly((const float*)&pos, m_queryExt, m_filter, &polyRef, (float*)&nearest);
+			if (!polyRef)
+				return -1;
+		}
+
+		i32 idx;
+		if (!m_freeAgents.empty())
+		{
+			idx = m_freeAgents.back();
+			m_freeAgents.pop_back();
+		}
+		else
+		{
+			idx = i32(m_states.size());
+			m_states.emplace_back(STATE_INVALID);
+			m_positions.emplace_back(Vector3::ZERO);
+			m_newPositions.emplace_back(Vector3::ZERO);
+			m_velocities.emplace_back(Vector3::ZERO);
+			m_targets.emplace_back(Vector3::ZERO);
+			m_radii.emplace_back(0.f);
+			m_maxSpeeds.emplace_back(0.f);
+			m_maxAccelerations.emplace_back(0.f);
+			m_separationWeights.emplace_back(0.f);
+			m_polyRefs.emplace_back(0);
+			m_isRepathNeeded.emplace_back(0);
+			m_pathRequests.emplace_back(0);
+			m_pathCursors.emplace_back(0);
+			m_paths.emplace_back();
+		}
+
+		m_states[idx] = STATE_IDLE;
+		m_positions[idx] = nearest;
+		m_newPositions[idx] = nearest;
+		m_velocities[idx] = Vector3::ZERO;
+		m_targets[idx] = nearest;
+		m_radii[idx] = params.m_radius;
+		m_maxSpeeds[idx] = params.m_maxSpeed;
+		m_maxAccelerations[idx] = params.m_maxAcceleration;
+		m_separationWeights[idx] = params.m_separationWeight;
+		m_polyRefs[idx] = polyRef;
+		m_isRepathNeeded[idx] = 0;
+		m_pathRequests[idx] = 0;
+		m_pathCursors[idx] = 0;
+		m_paths[idx].clear();
+
+		return idx;
+	}
+
+	void NavigationCrowd::removeAgent(i32 idx)
+	{
+		if (!isAgentActive(idx))
+			return;
+
+		if (m_pathRequests[idx])
+		{
+			m_pathQueue->cancel(m_pathRequests[idx]);
+			m_pathRequests[idx] = 0;
+		}
+
+		m_states[idx] = STATE_INVALID;
+		m_paths[idx].clear();
+		m_freeAgents.emplace_back(idx);
+	}
+
+	void NavigationCrowd::setTargets(const i32* agents, ui32 count, const Vector3& target)
+	{
+		for (ui32 i = 0; i < count; i++)
+			setTargets(agents + i, 1, &target);
+	}
+
+	void NavigationCrowd::setTargets(const i32* agents, ui32 count, const Vector3* targets)
+	{
+		for (ui32 i = 0; i < count; i++)
+		{
+			i32 idx = agents[i];
+			if (!isAgentActive(idx))
+				continue;
+
+			if (m_pathRequests[idx])
+				m_pathQueue->cancel(m_pathRequests[idx]);
+
+			m_targets[idx] = targets[i];
+			m_states[idx] = STATE_WAITING_PATH;
+			m_pathRequests[idx] = m_pathQueue->request(m_positions[idx], targets[i], m_filter, [this, idx](ui32 id, const vector<Vector3>::type& points, bool isPartial)
+			{
+				onPath(idx, id, points);
+			});
+		}
+	}
+
+	void NavigationCrowd::stopAgents(const i32* agents, ui32 count)
+	{
+		for (ui32 i = 0; i < count; i++)
+		{
+			i32 idx = agents[i];
+			if (!isAgentActive(idx))
+				continue;
+
+			if (m_pathRequests[idx])
+			{
+				m_pathQueue->cancel(m_pathRequests[idx]);
+				m_pathRequests[idx] = 0;
+			}
+
+			m_states[idx] = STATE_IDLE;
+			m_paths[idx].clear();
+		}
+	}
+
+	void NavigationCrowd::onPath(i32 idx, ui32 requestId, const vector<Vector3>::type& points)
+	{
+		if (m_pathRequests[idx] != requestId)
+			return;
+
+		m_pathRequests[idx] = 0;
+		m_paths[idx] = points;
+		m_pathCursors[idx] = 0;
+		m_states[idx] = points.empty() ? STATE_IDLE : STATE_MOVING;
+	}
+
+	void NavigationCrowd::setNavMesh(const dtNavMesh* navMesh)
+	{
+		m_navMesh = navMesh;
+		if (!m_navMesh)
+			return;
+
+		size_t queryCount = OpenMPTaskMgr::instance()->getThreadPool()->getNumThreads() + 1;
+		while (m_queries.size() < queryCount)
+			m_queries.emplace_back(dtAllocNavMeshQuery());
+
+		for (dtNavMeshQuery* query : m_queries)
+			query->init(m_navMesh, MAX_SEARCH_NODES);
+
+		// polygons of the old mesh are gone
+		for (size_t i = 0; i < m_states.size(); i++)
+		{
+			if (m_states[i] == STATE_INVALID)
+				continue;
+
+			m_polyRefs[i] = 0;
+			m_queries[0]->findNearestPoly((const float*)&m_positions[i], m_queryExt, m_filter, &m_polyRefs[i], (float*)&m_positions[i]);
+		}
+	}
+
+	ui32 NavigationCrowd::getCellHash(i32 x, i32 z) const
+	{
+		return (ui32(x) * 73856093u ^ ui32(z) * 19349663u) & m_cellMask;
+	}
+
+	void NavigationCrowd::buildGrid()
+	{
+		ui32 tableSize = 1;
+		while (tableSize < m_states.size() * 2)
+			tableSize <<= 1;
+
+		m_cellMask = tableSize - 1;
+		m_cellStarts.assign(tableSize + 1, 0);
+		m_cellAgents.resize(m_states.size());
+
+		// counting sort by cell hash
+		for (size_t i = 0; i < m_states.size(); i++)
+		{
+			if (m_states[i] == STATE_INVALID)
+				continue;
+
+			const Vector3& pos = m_positions[i];
+			m_cellStarts[getCellHash(i32(std::floor(pos.x / m_cellSize)), i32(std::floor(pos.z / m_cellSize))) + 1]++;
+		}
+
+		for (ui32 i = 0; i < tableSize; i++)
+			m_cellStarts[i + 1] += m_cellStarts[i];
+
+		vector<ui32>::type cursors(m_cellStarts.begin(), m_cellStarts.end() - 1);
+		for (size_t i = 0; i < m_states.size(); i++)
+		{
+			if (m_states[i] == STATE_INVALID)
+				continue;
+
+			const Vector3& pos = m_positions[i];
+			ui32 hash = getCellHash(i32(std::floor(pos.x / m_cellSize)), i32(std::floor(pos.z / m_cellSize)));
+			m_cellAgents[cursors[hash]++] = ui32(i);
+		}
+	}
+
+	void NavigationCrowd::update(float delta, const dtNavMesh* navMesh)
+	{
+		if (navMesh != m_navMesh)
+			setNavMesh(navMesh);
+
+		if (!m_navMesh || m_states.empty() || delta <= 0.f)
+			return;
+
+		buildGrid();
+
+		// contiguous ranges keep each worker on it's own cache lines and query
+		CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+		ui32 agentCount = ui32(m_states.size());
+		ui32 rangeCount = std::min<ui32>(ui32(m_queries.size()), agentCount);
+		ui32 rangeSize = (agentCount + rangeCount - 1) / rangeCount;
+		threadPool->parallelFor(rangeCount, [&](ui32 i)
+		{
+			steerAgents(i * rangeSize, std::min(agentCount, (i + 1) * rangeSize), delta, m_queries[i]);
+		});
+
+		// neighbours read old positions while steering
+		m_positions.swap(m_newPositions);
+
+		repathAgents();
+	}
+
+	bool NavigationCrowd::relocateAgent(ui32 idx, dtNavMeshQuery* query)
+	{
+		// tiles removed or rebuilt under the agent leave it's ref dead, agents off the mesh retry every step
+		dtPolyRef polyRef = 0;
+		Vector3 nearest;
+		query->findNearestPoly((const float*)&m_positions[idx], m_queryExt, m_filter, &polyRef, (float*)&nearest);
+		m_polyRefs[idx] = polyRef;
+		if (!polyRef)
+			return false;
+
+		m_isRepathNeeded[idx] = 1;
+		return true;
+	}
+
+	void NavigationCrowd::repathAgents()
+	{
+		for (size_t i = 0; i < m_isRepathNeeded.size(); i++)
+		{
+			if (!m_isRepathNeeded[i])
+				continue;
+
+			// the old path may run through the removed polygons
+			m_isRepathNeeded[i] = 0;
+			if (m_states[i] == STATE_MOVING || m_states[i] == STATE_WAITING_PATH)
+			{
+				i32 idx = i32(i);
+				Vector3 target = m_targets[i];
+				setTargets(&idx, 1, &target);
+			}
+		}
+	}
+
+	void NavigationCrowd::steerAgents(ui32 begin, ui32 end, float delta, dtNavMeshQuery* query)
+	{
+		for (ui32 i = begin; i < end; i++)
+		{
+			const Vector3& pos = m_positions[i];
+			if (m_states[i] == STATE_INVALID)
+			{
+				m_newPositions[i] = pos;
+				continue;
+			}
+
+			if (!m_polyRefs[i] || !m_navMesh->isValidPolyRef(m_polyRefs[i]))
+				relocateAgent(i, query);
+
+			const float radius = m_radii[i];
+			const float maxSpeed = m_maxSpeeds[i];
+
+			// follow path corners
+			Vector3 desiredVelocity = Vector3::ZERO;
+			if (m_states[i] == STATE_MOVING)
+			{
+				const vector<Vector3>::type& path = m_paths[i];
+				ui32& cursor = m_pathCursors[i];
+				Vector3 offset = path[cursor] - pos;
+				offset.y = 0.f;
+				while (cursor + 1 < path.size() && offset.lenSqr() < radius * radius)
+				{
+					cursor++;
+					offset = path[cursor] - pos;
+					offset.y = 0.f;
+				}
+
+				float distance = offset.len();
+				bool isLastCorner = cursor + 1 == path.size();
+				if (isLastCorner && distance < 0.05f + radius * 0.25f)
+				{
+					m_states[i] = STATE_IDLE;
+				}
+				else if (distance > 1e-4f)
+				{
+					// slow down when arriving
+					float speed = isLastCorner ? maxSpeed * std::min(distance / (radius * 2.f), 1.f) : maxSpeed;
+					desiredVelocity = offset * (speed / distance);
+				}
+			}
+
+			// separation
+			const float separationRange = radius * 2.f;
+			const i32 cx = i32(std::floor(pos.x / m_cellSize));
+			const i32 cz = i32(std::floor(pos.z / m_cellSize));
+			int neighbourCount = 0;
+			for (i32 z = cz - 1; z <= cz + 1 && neighbourCount < MAX_NEIGHBOURS; z++)
+			{
+				for (i32 x = cx - 1; x <= cx + 1 && neighbourCount < MAX_NEIGHBOURS; x++)
+				{
+					ui32 hash = getCellHash(x, z);
+					for (ui32 k = m_cellStarts[hash]; k < m_cellStarts[hash + 1] && neighbourCount < MAX_NEIGHBOURS; k++)
+					{
+						ui32 j = m_cellAgents[k];
+						if (j == i)
+							continue;
+
+						Vector3 diff = pos - m_positions[j];
+						diff.y = 0.f;
+						float range = separationRange + m_radii[j];
+						float distSqr = diff.lenSqr();
+						if (distSqr >= range * range || std::abs(pos.y - m_positions[j].y) > radius * 4.f)
+							continue;
+
+						// coincident agents push apart along an arbitrary but stable axis
+						float dist = std::sqrt(distSqr);
+						Vector3 dir = dist > 1e-4f ? diff / dist : (i < j ? Vector3::UNIT_X : -Vector3::UNIT_X);
+						desiredVelocity += dir * (maxSpeed * m_separationWeights[i] * (1.f - dist / range));
+						neighbourCount++;
+					}
+				}
+			}
+
+			// limit acceleration and speed
+			Vector3& velocity = m_velocities[i];
+			Vector3 deltaVelocity = desiredVelocity - velocity;
+			float maxDelta = m_maxAccelerations[i] * delta;
+			float deltaLen = deltaVelocity.len();
+			if (deltaLen > maxDelta)
+				deltaVelocity *= maxDelta / deltaLen;
+
+			velocity += deltaVelocity;
+			float speed = velocity.len();
+			if (speed > maxSpeed)
+				velocity *= maxSpeed / speed;
+
+			if (velocity.lenSqr() < 1e-6f)
+			{
+				velocity = Vector3::ZERO;
+				m_newPositions[i] = pos;
+				continue;
+			}
+
+			// move on the surface
+			Vector3 moveTarget = pos + velocity * delta;
+			Vector3 result = pos;
+			dtPolyRef visited[MAX_VISITED_POLYS];
+			int nvisited = 0;
+			bool isMoved = m_polyRefs[i] && dtStatusSucceed(query->moveAlongSurface(m_polyRefs[i], (const float*)&pos, (const float*)&moveTarget, m_filter, (float*)&result, visited, &nvisited, MAX_VISITED_POLYS));
+			if (!isMoved && m_polyRefs[i] && relocateAgent(i, query))
+				isMoved = dtStatusSucceed(query->moveAlongSurface(m_polyRefs[i], (const float*)&pos, (const float*)&moveTarget, m_filter, (float*)&result, visited, &nvisited, MAX_VISITED_POLYS));
+
+			if (isMoved)
+			{
+				if (nvisited)
+					m_polyRefs[i] = visited[nvisited - 1];
+
+				float h = 0.f;
+				if (dtStatusSucceed(query->getPolyHeight(m_polyRefs[i], (const float*)&result, &h)))
+					result.y = h;
+			}
+			else
+			{
+				result = pos;
+			}
+
+			m_newPositions[i] = result;
+		}
+	}
+
+	void NavigationCrowd::applyToNodes(Node* const* nodes, ui32 count) const
+	{
+		count = std::min(count, getAgentCount());
+		for (ui32 i = 0; i < count; i++)
+		{
+			Node* node = nodes[i];
+			if (!node || m_states[i] == STATE_INVALID)
+				continue;
+
+			node->setWorldPosition(m_positions[i]);
+
+			Vector3 dir(m_velocities[i].x, 0.f, m_velocities[i].z);
+			if (dir.lenSqr() > 1e-4f)
+			{
+				dir.normalize();
+				node->setWorldOrientation(Quaternion::fromVec3ToVec3(Vector3::UNIT_Z, dir));
+			}
+		}
+	}
+}
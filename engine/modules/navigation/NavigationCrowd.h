@@ -0,0 +1,122 @@
+#pragma once
+
+#include "NavigationPathQueue.h"
+
+namespace Echo
+{
+	class Node;
+
+	/**
+	 * Large crowd
+	 * Agent state is kept in structure of arrays, neighbours are found by a spatial hash grid,
+	 * steering, separation and surface movement run in parallel over the thread pool.
+	 * Paths come from the shared NavigationPathQueue, agents heading to the same place share cached corridors.
+	 */
+	class NavigationCrowd
+	{
+	public:
+		// agent params
+		struct AgentParams
+		{
+			float	m_radius = 0.6f;
+			float	m_maxSpeed = 3.5f;
+			float	m_maxAcceleration = 8.f;
+			float	m_separationWeight = 2.f;
+		};
+
+		// agent state
+		enum State
+		{
+			STATE_INVALID = 0,
+			STATE_IDLE,
+			STATE_WAITING_PATH,
+			STATE_MOVING,
+		};
+
+	public:
+		NavigationCrowd(NavigationPathQueue* pathQueue, const dtQueryFilter* filter, float maxAgentRadius);
+		~NavigationCrowd();
+
+		// add agent, return agent index, -1 if pos is not on the navmesh
+		i32 addAgent(const Vector3& pos, const AgentParams& params);
+
+		// remove agent, it's index is reused by following adds
+		void removeAgent(i32 idx);
+
+		// agent slot count, includes removed ones
+		ui32 getAgentCount() const { return ui32(m_states.size()); }
+
+		// state
+		State getAgentState(i32 idx) const { return State(m_states[idx]); }
+		bool isAgentActive(i32 idx) const { return idx >= 0 && idx < i32(m_states.size()) && m_states[idx] != STATE_INVALID; }
+
+		// move agents to one target, or each to it's own
+		void setTargets(const i32* agents, ui32 count, const Vector3& target);
+		void setTargets(const i32* agents, ui32 count, const Vector3* targets);
+
+		// stop agents
+		void stopAgents(const i32* agents, ui32 count);
+
+		// simulate one step
+		void update(float delta, const dtNavMesh* navMesh);
+
+		// agent data, indexed by agent
+		const vector<Vector3>::type& getPositions() const { return m_positions; }
+		const vector<Vector3>::type& getVelocities() const { return m_velocities; }
+
+		// node i follows agent i, faces the moving direction
+		void applyToNodes(Node* const* nodes, ui32 count) const;
+
+	private:
+		// (re)init queries and snap agents to navMesh
+		void setNavMesh(const dtNavMesh* navMesh);
+
+		// path arrived
+		void onPath(i32 idx, ui32 requestId, const vector<Vector3>::type& points);
+
+		// bucket agents by cell
+		void buildGrid();
+
+		// cell hash
+		ui32 getCellHash(i32 x, i32 z) const;
+
+		// steer and move agents [begin, end), worker thread
+		void steerAgents(ui32 begin, ui32 end, float delta, dtNavMeshQuery* query);
+
+		// find the polygon under a lost agent again and mark it for a new path, worker thread
+		bool relocateAgent(ui32 idx, dtNavMeshQuery* query);
+
+		// request new paths for relocated agents
+		void repathAgents();
+
+	private:
+		NavigationPathQueue*			m_pathQueue;
+		const dtQueryFilter*			m_filter;
+		const dtNavMesh*				m_navMesh = nullptr;
+		vector<dtNavMeshQuery*>::type	m_queries;					// one per thread
+		float							m_cellSize;
+		float							m_queryExt[3];
+
+		// agents
+		vector<ui8>::type				m_states;
+		vector<Vector3>::type			m_positions;
+		vector<Vector3>::type			m_newPositions;
+		vector<Vector3>::type			m_velocities;
+		vector<Vector3>::type			m_targets;
+		vector<float>::type				m_radii;
+		vector<float>::type				m_maxSpeeds;
+		vector<float>::type				m_maxAccelerations;
+		vector<float>::type				m_separationWeights;
+		vector<dtPolyRef>::type			m_polyRefs;
+		vector<ui8>::type				m_isRepathNeeded;			// polygon was found again, path goes through stale refs
+		vector<ui32>::type				m_pathRequests;
+		vector<ui32>::type				m_pathCursors;
+		vector<vector<Vector3>::type>::type	m_paths;
+		vector<i32>::type				m_freeAgents;
+
+		// grid
+		vector<ui32>::type				m_cellStarts;
+		vector<ui32>::type				m_cellAgents;
+		ui32							m_cellMask = 0;
+	};
+}
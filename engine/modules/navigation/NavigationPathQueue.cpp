@@ -0,0 +1,302 @@
+#include <algorithm>
+#include "NavigationPathQueue.h"
+#include "engine/core/log/Log.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
+#include <thirdparty/recast/Recast/DetourCommon.h>
+
+namespace Echo
+{
+	static const int MAX_PATH_POLYS = 256;
+	static const int MAX_SEARCH_NODES = 2048;
+
+	NavigationPathQueue::NavigationPathQueue()
+	{
+	}
+
+	NavigationPathQueue::~NavigationPathQueue()
+	{
+		clear();
+
+		dtFreeNavMeshQuery(m_query);
+		for (dtNavMeshQuery* query : m_queries)
+			dtFreeNavMeshQuery(query);
+	}
+
+	ui32 NavigationPathQueue::request(const Vector3& startPos, const Vector3& endPos, const dtQueryFilter* filter, const PathCallback& callback)
+	{
+		Request* request = EchoNew(Request);
+		request->m_id = m_nextId++;
+		request->m_filter = filter;
+		request->m_callback = callback;
+		dtVcopy(request->m_spos, (const float*)&startPos);
+		dtVcopy(request->m_epos, (const float*)&endPos);
+		m_requests.emplace_back(request);
+
+		return request->m_id;
+	}
+
+	void NavigationPathQueue::cancel(ui32 id)
+	{
+		for (auto it = m_requests.begin(); it != m_requests.end(); it++)
+		{
+			Request* request = *it;
+			if (request->m_id == id)
+			{
+				releaseQuery(request);
+				EchoSafeDelete(request, Request);
+				m_requests.erase(it);
+				break;
+			}
+		}
+	}
+
+	void NavigationPathQueue::clear()
+	{
+		for (Request* request : m_requests)
+			releaseQuery(request);
+
+		EchoSafeDeleteContainer(m_requests, Request);
+		m_cachedPaths.clear();
+	}
+
+	void NavigationPathQueue::setPolyPickExtents(const float* extents)
+	{
+		dtVcopy(m_polyPickExt, extents);
+	}
+
+	void NavigationPathQueue::setNavMesh(const dtNavMesh* navMesh)
+	{
+		m_navMesh = navMesh;
+		m_cachedPaths.clear();
+
+		// searches of the old mesh start over
+		for (Request* request : m_requests)
+		{
+			request->m_queryIndex = -1;
+			request->m_isPrepared = false;
+			request->m_isSearching = false;
+		}
+
+		if (!m_navMesh)
+			return;
+
+		// one query per thread, the calling thread included
+		size_t queryCount = OpenMPTaskMgr::instance()->getThreadPool()->getNumThreads() + 1;
+		while (m_queries.size() < queryCount)
+			m_queries.emplace_back(dtAllocNavMeshQuery());
+
+		m_queryOwners.assign(m_queries.size(), nullptr);
+
+		if (!m_query)
+			m_query = dtAllocNavMeshQuery();
+
+		if (dtStatusFailed(m_query->init(m_navMesh, MAX_SEARCH_NODES)))
+			EchoLogError("NavigationPathQueue: Could not init Detour navmesh query");
+
+		for (dtNavMeshQuery* query : m_queries)
+			query->init(m_navMesh, MAX_SEARCH_NODES);
+	}
+
+	void NavigationPathQueue::update(const dtNavMesh* navMesh)
+	{
+		if (navMesh != m_navMesh)
+			setNavMesh(navMesh);
+
+		if (!m_navMesh || m_requests.empty())
+			return;
+
+		// new requests, cache hits and unreachable ones are finished here
+		for (Request* request : m_requests)
+		{
+			if (!request->m_isPrepared)
+				prepareRequest(request);
+		}
+
+		// give free queries to waiting requests, oldest first
+		for (Request* request : m_requests)
+		{
+			if (request->m_isFinished || request->m_queryIndex != -1 || serveFromCache(request))
+				continue;
+
+			auto it = std::find(m_queryOwners.begin(), m_queryOwners.end(), nullptr);
+			if (it == m_queryOwners.end())
+				break;
+
+			*it = request;
+			request->m_queryIndex = int(it - m_queryOwners.begin());
+			request->m_isSearching = false;
+		}
+
+		// share the iteration budget, searches don't touch each other's query
+		vector<Request*>::type searchings;
+		for (Request* request : m_queryOwners)
+		{
+			if (request)
+				searchings.emplace_back(request);
+		}
+
+		if (!searchings.empty())
+		{
+			int iterations = std::max(m_maxIterationsPerFrame / int(searchings.size()), 1);
+			OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(ui32(searchings.size()), [&](ui32 i)
+			{
+				Request* request = searchings[i];
+				searchRequest(request, m_queries[request->m_queryIndex], iterations);
+			});
+		}
+
+		// callbacks may queue new requests, so take finished ones out first
+		vector<Request*>::type finishedRequests;
+		for (auto it = m_requests.begin(); it != m_requests.end();)
+		{
+			Request* request = *it;
+			if (request->m_isFinished)
+			{
+				if (request->m_queryIndex != -1 && !request->m_corridor.empty())
+					addCachedPath(request);
+
+				releaseQuery(request);
+				finishedRequests.emplace_back(request);
+				it = m_requests.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+
+		for (Request* request : finishedRequests)
+		{
+			if (request->m_callback)
+				request->m_callback(request->m_id, request->m_points, request->m_isPartial);
+
+			EchoSafeDelete(request, Request);
+		}
+	}
+
+	void NavigationPathQueue::prepareRequest(Request* request)
+	{
+		request->m_isPrepared = true;
+
+		m_query->findNearestPoly(request->m_spos, m_polyPickExt, request->m_filter, &request->m_startRef, 0);
+		m_query->findNearestPoly(request->m_epos, m_polyPickExt, request->m_filter, &request->m_endRef, 0);
+		if (!request->m_startRef || !request->m_endRef)
+		{
+			request->m_isFinished = true;
+			return;
+		}
+
+		serveFromCache(request);
+	}
+
+	bool NavigationPathQueue::serveFromCache(Request* request)
+	{
+		const CachedPath* cachedPath = findCachedPath(request);
+		if (!cachedPath)
+			return false;
+
+		request->m_corridor = cachedPath->m_corridor;
+		request->m_isPartial = cachedPath->m_isPartial;
+		buildStraightPath(request, m_query);
+		request->m_isFinished = true;
+
+		return true;
+	}
+
+	void NavigationPathQueue::releaseQuery(Request* request)
+	{
+		if (request->m_queryIndex != -1)
+		{
+			m_queryOwners[request->m_queryIndex] = nullptr;
+			request->m_queryIndex = -1;
+		}
+	}
+
+	void NavigationPathQueue::searchRequest(Request* request, dtNavMeshQuery* query, int iterations)
+	{
+		if (!request->m_isSearching)
+		{
+			request->m_isSearching = true;
+			dtStatus status = query->initSlicedFindPath(request->m_startRef, request->m_endRef, request->m_spos, request->m_epos, request->m_filter);
+			if (dtStatusFailed(status))
+			{
+				request->m_isFinished = true;
+				return;
+			}
+		}
+
+		int doneIterations = 0;
+		dtStatus status = query->updateSlicedFindPath(iterations, &doneIterations);
+		if (dtStatusInProgress(status))
+			return;
+
+		request->m_isFinished = true;
+		if (dtStatusSucceed(status))
+		{
+			dtPolyRef polys[MAX_PATH_POLYS];
+			int npolys = 0;
+			status = query->finalizeSlicedFindPath(polys, &npolys, MAX_PATH_POLYS);
+			if (dtStatusSucceed(status) && npolys)
+			{
+				request->m_corridor.assign(polys, polys + npolys);
+				request->m_isPartial = dtStatusDetail(status, DT_PARTIAL_RESULT) || polys[npolys - 1] != request->m_endRef;
+				buildStraightPath(request, query);
+			}
+		}
+	}
+
+	void NavigationPathQueue::buildStraightPath(Request* request, dtNavMeshQuery* query)
+	{
+		// In case of partial path, make sure the end point is clamped to the last polygon.
+		float epos[3];
+		dtVcopy(epos, request->m_epos);
+		if (request->m_corridor.back() != request->m_endRef)
+			query->closestPointOnPoly(request->m_corridor.back(), request->m_epos, epos, nullptr);
+
+		float straightPath[MAX_PATH_POLYS * 3];
+		int nstraightPath = 0;
+		query->findStraightPath(request->m_spos, epos, request->m_corridor.data(), int(request->m_corridor.size()), straightPath, nullptr, nullptr, &nstraightPath, MAX_PATH_POLYS);
+
+		request->m_points.resize(nstraightPath);
+		for (int i = 0; i < nstraightPath; i++)
+			request->m_points[i] = Vector3(straightPath[i * 3], straightPath[i * 3 + 1], straightPath[i * 3 + 2]);
+	}
+
+	const NavigationPathQueue::CachedPath* NavigationPathQueue::findCachedPath(const Request* request)
+	{
+		for (auto it = m_cachedPaths.begin(); it != m_cachedPaths.end(); it++)
+		{
+			if (it->m_startRef == request->m_startRef && it->m_endRef == request->m_endRef && it->m_filter == request->m_filter)
+			{
+				// rebuilt tiles get a new salt, a corridor through them is stale
+				for (dtPolyRef ref : it->m_corridor)
+				{
+					if (!m_navMesh->isValidPolyRef(ref))
+					{
+						m_cachedPaths.erase(it);
+						return nullptr;
+					}
+				}
+
+				m_cachedPaths.splice(m_cachedPaths.begin(), m_cachedPaths, it);
+				return &m_cachedPaths.front();
+			}
+		}
+
+		return nullptr;
+	}
+
+	void NavigationPathQueue::addCachedPath(const Request* request)
+	{
+		CachedPath cachedPath;
+		cachedPath.m_startRef = request->m_startRef;
+		cachedPath.m_endRef = request->m_endRef;
+		cachedPath.m_filter = request->m_filter;
+		cachedPath.m_isPartial = request->m_isPartial;
+		cachedPath.m_corridor = request->m_corridor;
+		m_cachedPaths.emplace_front(cachedPath);
+
+		if (m_cachedPaths.size() > m_maxCachedPaths)
+			m_cachedPaths.pop_back();
+	}
+}
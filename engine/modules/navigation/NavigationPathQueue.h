@@ -0,0 +1,115 @@
+#pragma once
+
+#include <functional>
+#include <recast/Recast/DetourNavMesh.h>
+#include <recast/Recast/DetourNavMeshQuery.h>
+#include <engine/core/math/Math.h>
+
+namespace Echo
+{
+	/**
+	 * Path request queue
+	 * Requests are searched with Detour's sliced A*, the iteration budget of one frame
+	 * is shared by the running searches, which run in parallel on their own dtNavMeshQuery.
+	 * Polygon corridors of recent start/end pairs are cached and reused by duplicate requests.
+	 */
+	class NavigationPathQueue
+	{
+	public:
+		// result, points is the straight path, empty if no path was found
+		typedef std::function<void(ui32 id, const vector<Vector3>::type& points, bool isPartial)> PathCallback;
+
+		// request
+		struct Request
+		{
+			ui32						m_id = 0;
+			float						m_spos[3];
+			float						m_epos[3];
+			dtPolyRef					m_startRef = 0;
+			dtPolyRef					m_endRef = 0;
+			const dtQueryFilter*		m_filter = nullptr;
+			PathCallback				m_callback;
+			int							m_queryIndex = -1;		// query owning the sliced search
+			bool						m_isPrepared = false;
+			bool						m_isSearching = false;
+			bool						m_isFinished = false;
+			bool						m_isPartial = false;
+			vector<dtPolyRef>::type		m_corridor;
+			vector<Vector3>::type		m_points;
+		};
+
+		// cached corridor
+		struct CachedPath
+		{
+			dtPolyRef					m_startRef;
+			dtPolyRef					m_endRef;
+			const dtQueryFilter*		m_filter;
+			bool						m_isPartial;
+			vector<dtPolyRef>::type		m_corridor;
+		};
+
+	public:
+		NavigationPathQueue();
+		~NavigationPathQueue();
+
+		// queue a request, callback is invoked from update, return request id
+		ui32 request(const Vector3& startPos, const Vector3& endPos, const dtQueryFilter* filter, const PathCallback& callback);
+
+		// cancel a request, it's callback won't be invoked
+		void cancel(ui32 id);
+
+		// run searches for one frame, a different mesh restarts running searches
+		void update(const dtNavMesh* navMesh);
+
+		// restart running searches on navMesh, call it when the mesh is freed
+		void setNavMesh(const dtNavMesh* navMesh);
+
+		// clear requests and cache
+		void clear();
+
+		// drop cached corridors, call it when filters change
+		void clearCache() { m_cachedPaths.clear(); }
+
+		// iteration budget of one frame
+		void setMaxIterationsPerFrame(int iterations) { m_maxIterationsPerFrame = std::max(iterations, 1); }
+		int getMaxIterationsPerFrame() const { return m_maxIterationsPerFrame; }
+
+		// polygon extents used to find start and end polygons
+		void setPolyPickExtents(const float* extents);
+
+		// pending request count
+		size_t getRequestCount() const { return m_requests.size(); }
+
+	private:
+		// find start and end polygons, serve cached corridors
+		void prepareRequest(Request* request);
+
+		// duplicate of a recent request, finish it with the cached corridor
+		bool serveFromCache(Request* request);
+
+		// release request's query
+		void releaseQuery(Request* request);
+
+		// advance one search by iterations, worker thread
+		void searchRequest(Request* request, dtNavMeshQuery* query, int iterations);
+
+		// corridor to straight path
+		void buildStraightPath(Request* request, dtNavMeshQuery* query);
+
+		// cache
+		const CachedPath* findCachedPath(const Request* request);
+		void addCachedPath(const Request* request);
+
+	private:
+		const dtNavMesh*				m_navMesh = nullptr;
+		dtNavMeshQuery*					m_query = nullptr;			// main thread
+		vector<dtNavMeshQuery*>::type	m_queries;					// one per running search
+		vector<Request*>::type			m_queryOwners;				// request running on each query
+		list<Request*>::type			m_requests;
+		list<CachedPath>::type			m_cachedPaths;				// front is the most recently used
+		size_t							m_maxCachedPaths = 64;
+		int								m_maxIterationsPerFrame = 2048;
+		float							m_polyPickExt[3] = { 2.f, 4.f, 2.f };
+		ui32							m_nextId = 1;
+	};
+}
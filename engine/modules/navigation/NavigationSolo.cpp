@@ -414,6 +414,8 @@ namespace Echo
 	// 
 	void NavigationSolo::cleanup()
 	{
+		m_pathQueue->setNavMesh(nullptr);
+
 		EchoSafeFree(m_triareas);
 		m_triareas = 0;
 		rcFreeHeightField(m_solid);
@@ -2,6 +2,7 @@
 #include "engine/core/util/PathUtil.h"
 #include "engine/core/log/Log.h"
 #include "engine/core/io/IO.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
 #include <engine/core/memory/MemAllocDef.h>
 #include <engine/core/base/echo_def.h>
 #include <thirdparty/recast/Recast/Recast.h>
@@ -15,6 +16,7 @@
 #include "fastlz.h"
 #include "BuildContext.h"
 #include "ChunkyTriMesh.h"
+#include "NavigationTileStreamer.h"
 
 namespace Echo
 {
@@ -101,6 +103,34 @@ namespace Echo
 		}
 	};
 
+	// rebuilds the navmesh data of one tile on a worker thread
+	struct NavTileJob : public CpuThreadPool::Job
+	{
+		dtTileCache*							m_tileCache = nullptr;
+		dtCompressedTileRef						m_ref = 0;
+		vector<dtTileCacheObstacle>::type		m_obstacles;		// snapshot, main thread may change obstacles meanwhile
+		LinearAllocator							m_talloc;
+		unsigned char*							m_navData = nullptr;
+		int										m_navDataSize = 0;
+		dtStatus								m_status = DT_FAILURE;
+		std::atomic<bool>						m_isFinished;
+
+		NavTileJob() : m_talloc(32000), m_isFinished(false) {}
+		~NavTileJob() { dtFree(m_navData); }
+
+		virtual bool process() override
+		{
+			m_status = m_tileCache->buildNavMeshTileData(m_ref, m_obstacles.data(), int(m_obstacles.size()), &m_talloc, &m_navData, &m_navDataSize);
+
+			// the main thread may delete the job once it's finished, publish the flag last
+			bool ok = dtStatusSucceed(m_status);
+			m_isFinished = true;
+			return ok;
+		}
+
+		virtual int getType() override { return -1; }
+	};
+
 	/**
 	 * ģʹ
 	 */
@@ -221,6 +251,10 @@ namespace Echo
 
 	void NavigationTempObstacles::cleanup()
 	{
+		waitTileJobs();
+		m_pathQueue->setNavMesh(nullptr);
+		EchoSafeDelete(m_tileStreamer, NavigationTileStreamer);
+
 		dtFreeNavMesh(m_navMesh);	m_navMesh = nullptr;
 		dtFreeTileCache(m_tileCache); m_tileCache = nullptr;
 		dtFreeNavMeshData(m_navMeshData); m_navMeshData = nullptr;
@@ -231,10 +265,120 @@ namespace Echo
 	void NavigationTempObstacles::update(float delta)
 	{
 		if (m_tileCache)
-			m_tileCache->update(delta, m_navMesh);
+		{
+			swapFinishedTiles();
+			m_tileCache->processRequests();
+			dispatchTileJobs();
+		}
+
+		if (m_tileStreamer)
+			m_tileStreamer->update();
+
+		Navigation::update(delta);
+	}
+
+	void NavigationTempObstacles::swapFinishedTiles()
+	{
+		int swapCount = 0;
+		for (size_t i = 0; i < m_tileJobs.size();)
+		{
+			NavTileJob* job = m_tileJobs[i];
+			if (!job->m_isFinished)
+			{
+				i++;
+				continue;
+			}
+
+			// the rest waits for next frame, keeps big obstacle changes from spiking
+			if (m_maxTileSwapsPerFrame > 0 && swapCount >= m_maxTileSwapsPerFrame)
+				break;
+
+			if (dtStatusSucceed(job->m_status))
+			{
+				m_tileCache->addNavMeshTileData(job->m_ref, m_navMesh, job->m_navData, job->m_navDataSize);
+				job->m_navData = nullptr;
+				swapCount++;
+			}
+
+			// obstacles changed while building, the requeued rebuild completes them
+			bool isRequeued = false;
+			for (int j = 0; j < m_tileCache->getUpdateCount() && !isRequeued; j++)
+				isRequeued = m_tileCache->getUpdate(j) == job->m_ref;
+
+			if (!isRequeued)
+				m_tileCache->completeTileUpdate(job->m_ref);
+
+			EchoSafeDelete(job, NavTileJob);
+			m_tileJobs.erase(m_tileJobs.begin() + i);
+		}
+	}
+
+	void NavigationTempObstacles::dispatchTileJobs()
+	{
+		CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+		const int numThreads = threadPool->getNumThreads();
+		const size_t maxJobs = numThreads > 0 ? numThreads * 2 : std::max(m_maxTileSwapsPerFrame, 1);
+		for (int i = 0; i < m_tileCache->getUpdateCount() && m_tileJobs.size() < maxJobs;)
+		{
+			// one build per tile at a time, it's picked up again once the running one is swapped in
+			const dtCompressedTileRef ref = m_tileCache->getUpdate(i);
+			bool isBuilding = false;
+			for (NavTileJob* job : m_tileJobs)
+				isBuilding = isBuilding || job->m_ref == ref;
+
+			if (isBuilding)
+			{
+				i++;
+				continue;
+			}
+
+			NavTileJob* job = EchoNew(NavTileJob);
+			job->m_tileCache = m_tileCache;
+			job->m_ref = ref;
+			for (int j = 0; j < m_tileCache->getObstacleCount(); j++)
+			{
+				const dtTileCacheObstacle* ob = m_tileCache->getObstacle(j);
+				if (ob->state == DT_OBSTACLE_EMPTY || ob->state == DT_OBSTACLE_REMOVING)
+					continue;
+
+				for (int k = 0; k < ob->ntouched; k++)
+				{
+					if (ob->touched[k] == ref)
+					{
+						job->m_obstacles.emplace_back(*ob);
+						break;
+					}
+				}
+			}
+
+			m_tileCache->removeUpdate(i);
+			m_tileJobs.emplace_back(job);
+
+			if (numThreads > 0)
+			{
+				CpuThreadPool::Job* jobs[] = { job };
+				threadPool->processJobs(jobs, 1);
+			}
+			else
+			{
+				job->process();
+			}
+		}
+	}
+
+	void NavigationTempObstacles::waitTileJobs()
+	{
+		// results are dropped, the tile cache is about to be rebuilt or freed
+		for (NavTileJob* job : m_tileJobs)
+		{
+			while (!job->m_isFinished)
+				std::this_thread::yield();
+		}
+
+		EchoSafeDeleteContainer(m_tileJobs, NavTileJob);
 	}
 
-	int NavigationTempObstacles::rasterizeTileLayers(const rcChunkyTriMesh* chunkyMesh, const int tx, const int ty, const rcConfig& cfg, TileCacheData* tiles, const int maxTiles)
+	int NavigationTempObstacles::rasterizeTileLayers(rcContext* ctx, const rcChunkyTriMesh* chunkyMesh, const int tx, const int ty, const rcConfig& cfg, TileCacheData* tiles, const int maxTiles)
 	{
 		if (!m_geom)
 		{
@@ -272,7 +416,7 @@ namespace Echo
 			EchoLogError("buildNavigation: Out of memory 'solid'.");
 			return 0;
 		}
-		if (!rcCreateHeightfield(m_ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch))
+		if (!rcCreateHeightfield(ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch))
 		{
 			EchoLogError("buildNavigation: Could not create solid heightfield.");
 			return 0;
@@ -293,8 +437,15 @@ namespace Echo
 		tbmin[1] = tcfg.bmin[2];
 		tbmax[0] = tcfg.bmax[0];
 		tbmax[1] = tcfg.bmax[2];
-		int cid[2048];// TODO: Make grow when returning too many items.
-		const int ncid = rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid, 2048);
+		// grow until every overlapping chunk fits
+		vector<int>::type cid(2048);
+		int ncid = rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid.data(), int(cid.size()));
+		while (ncid == int(cid.size()))
+		{
+			cid.resize(cid.size() * 2);
+			ncid = rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid.data(), int(cid.size()));
+		}
+
 		if (!ncid)
 		{
 			return 0; // empty
@@ -308,12 +459,12 @@ namespace Echo
 			const int ntris = node.n;
 
 			memset(rc.triareas, 0, ntris*sizeof(unsigned char));
-			//rcMarkWalkableTriangles(m_ctx, tcfg.walkableSlopeAngle,
+			//rcMarkWalkableTriangles(ctx, tcfg.walkableSlopeAngle,
 			//	verts, nverts, tris, ntris, rc.triareas);
 
-			EchoMarkWalkableTriangles(m_ctx, verts, nverts, tris, ntris, triInfos, rc.triareas);
+			EchoMarkWalkableTriangles(ctx, verts, nverts, tris, ntris, triInfos, rc.triareas);
 
-			if (!rcRasterizeTriangles(m_ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb))
+			if (!rcRasterizeTriangles(ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb))
 				return 0;
 		}
 
@@ -321,11 +472,11 @@ namespace Echo
 		// remove unwanted overhangs caused by the conservative rasterization
 		// as well as filter spans where the character cannot possibly stand.
 		if (m_filterLowHangingObstacles)
-			rcFilterLowHangingWalkableObstacles(m_ctx, tcfg.walkableClimb, *rc.solid);
+			rcFilterLowHangingWalkableObstacles(ctx, tcfg.walkableClimb, *rc.solid);
 		if (m_filterLedgeSpans)
-			rcFilterLedgeSpans(m_ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid);
+			rcFilterLedgeSpans(ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid);
 		if (m_filterWalkableLowHeightSpans)
-			rcFilterWalkableLowHeightSpans(m_ctx, tcfg.walkableHeight, *rc.solid);
+			rcFilterWalkableLowHeightSpans(ctx, tcfg.walkableHeight, *rc.solid);
 
 
 		rc.chf = rcAllocCompactHeightfield();
@@ -334,14 +485,14 @@ namespace Echo
 			EchoLogError("buildNavigation: Out of memory 'chf'.");
 			return 0;
 		}
-		if (!rcBuildCompactHeightfield(m_ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf))
+		if (!rcBuildCompactHeightfield(ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf))
 		{
 			EchoLogError("buildNavigation: Could not build compact data.");
 			return 0;
 		}
 
 		// Erode the walkable area by agent radius.
-		if (!rcErodeWalkableArea(m_ctx, tcfg.walkableRadius, *rc.chf))
+		if (!rcErodeWalkableArea(ctx, tcfg.walkableRadius, *rc.chf))
 		{
 			EchoLogError("buildNavigation: Could not erode.");
 			return 0;
@@ -350,12 +501,12 @@ namespace Echo
 		rc.lset = rcAllocHeightfieldLayerSet();
 		if (!rc.lset)
 		{
-			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
+			ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
 			return 0;
 		}
-		if (!rcBuildHeightfieldLayers(m_ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset))
+		if (!rcBuildHeightfieldLayers(ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset))
 		{
-			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
+			ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
 			return 0;
 		}
 
@@ -412,6 +563,10 @@ namespace Echo
 	{
 		EchoAssert(m_geom);
 
+		waitTileJobs();
+		m_pathQueue->setNavMesh(nullptr);
+		EchoSafeDelete(m_tileStreamer, NavigationTileStreamer);
+
 		dtStatus status;
 
 		m_tmproc->init(m_geom);
@@ -536,38 +691,66 @@ namespace Echo
 			return false;
 		}
 		
-		for (int y = 0; y < th; ++y)
+		// Rasterize tiles in parallel, rcContext of the sample isn't thread safe, so every tile gets a quiet one.
+		CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+		vector<TileCacheData>::type tileLayers(tw*th*MAX_LAYERS);
+		vector<int>::type tileLayerCounts(tw*th, 0);
+		memset(tileLayers.data(), 0, tileLayers.size() * sizeof(TileCacheData));
+		threadPool->parallelFor(ui32(tw*th), [&](ui32 i)
 		{
-			for (int x = 0; x < tw; ++x)
-			{
-				TileCacheData tiles[MAX_LAYERS];
-				memset(tiles, 0, sizeof(tiles));
-				int ntiles = rasterizeTileLayers(chunkyMesh, x, y, cfg, tiles, MAX_LAYERS);
+			rcContext ctx(false);
+			tileLayerCounts[i] = rasterizeTileLayers(&ctx, chunkyMesh, i % tw, i / tw, cfg, &tileLayers[i*MAX_LAYERS], MAX_LAYERS);
+		});
+		EchoSafeDelete(chunkyMesh, rcChunkyTriMesh);
 
-				for (int i = 0; i < ntiles; ++i)
+		for (int t = 0; t < tw*th; ++t)
+		{
+			for (int i = 0; i < tileLayerCounts[t]; ++i)
+			{
+				TileCacheData* tile = &tileLayers[t*MAX_LAYERS + i];
+				status = m_tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);
+				if (dtStatusFailed(status))
 				{
-					TileCacheData* tile = &tiles[i];
-					status = m_tileCache->addTile(tile->data, tile->dataSize, DT_COMPRESSEDTILE_FREE_DATA, 0);
-					if (dtStatusFailed(status))
-					{
-						dtFree(tile->data);
-						tile->data = 0;
-						continue;
-					}
-
-					m_cacheLayerCount++;
-					m_cacheCompressedSize += tile->dataSize;
-					m_cacheRawSize += calcLayerBufferSize(tcparams.width, tcparams.height);
+					dtFree(tile->data);
+					tile->data = 0;
+					continue;
 				}
+
+				m_cacheLayerCount++;
+				m_cacheCompressedSize += tile->dataSize;
+				m_cacheRawSize += calcLayerBufferSize(tcparams.width, tcparams.height);
 			}
 		}
 
-		// Build initial meshes
+		// Build initial meshes in parallel, a fresh tile cache has no obstacles
+		vector<dtCompressedTileRef>::type tileRefs;
 		for (int y = 0; y < th; ++y)
+		{
 			for (int x = 0; x < tw; ++x)
-				m_tileCache->buildNavMeshTilesAt(x, y, m_navMesh);
+			{
+				dtCompressedTileRef refs[MAX_LAYERS];
+				const int nrefs = m_tileCache->getTilesAt(x, y, refs, MAX_LAYERS);
+				tileRefs.insert(tileRefs.end(), refs, refs + nrefs);
+			}
+		}
 
-		m_cacheBuildMemUsage = int(m_talloc->high);
+		vector<TileCacheData>::type navTiles(tileRefs.size());
+		vector<size_t>::type navTileMemUsages(tileRefs.size(), 0);
+		memset(navTiles.data(), 0, navTiles.size() * sizeof(TileCacheData));
+		threadPool->parallelFor(ui32(tileRefs.size()), [&](ui32 i)
+		{
+			LinearAllocator talloc(32000);
+			m_tileCache->buildNavMeshTileData(tileRefs[i], nullptr, 0, &talloc, &navTiles[i].data, &navTiles[i].dataSize);
+			talloc.reset();
+			navTileMemUsages[i] = talloc.high;
+		});
+
+		m_cacheBuildMemUsage = 0;
+		for (size_t i = 0; i < tileRefs.size(); ++i)
+		{
+			m_tileCache->addNavMeshTileData(tileRefs[i], m_navMesh, navTiles[i].data, navTiles[i].dataSize);
+			m_cacheBuildMemUsage = rcMax(m_cacheBuildMemUsage, int(navTileMemUsages[i]));
+		}
 
 		const dtNavMesh* nav = m_navMesh;
 		int navmeshMemUsage = 0;
@@ -727,6 +910,56 @@ namespace Echo
 		}
 	}
 
+	// طֿļ
+	bool NavigationTempObstacles::loadStreamed(const String& filePath, float streamingRadius)
+	{
+		cleanup();
+
+		dtNavMeshParams params;
+		m_tileStreamer = EchoNew(NavigationTileStreamer);
+		if (!m_tileStreamer->open(filePath, params))
+		{
+			EchoSafeDelete(m_tileStreamer, NavigationTileStreamer);
+			return false;
+		}
+
+		m_navMesh = dtAllocNavMesh();
+		if (dtStatusFailed(m_navMesh->init(&params, nullptr)))
+		{
+			EchoLogError("Could not init Detour navmesh");
+			cleanup();
+			return false;
+		}
+
+		m_tileStreamer->setNavMesh(m_navMesh);
+		m_tileStreamer->setStreamingRadius(streamingRadius);
+
+		if (dtStatusFailed(m_navQuery->init(m_navMesh, 2048)))
+		{
+			EchoLogError("Could not init Detour navmesh query");
+			cleanup();
+			return false;
+		}
+
+		crowdInit();
+		m_isLoaded = true;
+
+		return true;
+	}
+
+	// ֿļ
+	bool NavigationTempObstacles::saveStreamed(const char* savePath)
+	{
+		return NavigationTileStreamer::save(m_navMesh, savePath);
+	}
+
+	// Ȥ
+	void NavigationTempObstacles::setPointsOfInterest(const vector<Vector3>::type& points)
+	{
+		if (m_tileStreamer)
+			m_tileStreamer->setPointsOfInterest(points);
+	}
+
 	// Բϰ
 	void NavigationTempObstacles::addTempObstacleCylinder(const Vector3& pos, float radius, float height)
 	{
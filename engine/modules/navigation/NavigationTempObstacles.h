@@ -17,6 +17,8 @@ namespace Echo
 	class DataStream;
 	class InputGeometryData;
 	class BuildContext;
+	struct NavTileJob;
+	class NavigationTileStreamer;
 
 	/**
 	 * Ѱ·ӿڷװ
@@ -39,6 +41,16 @@ namespace Echo
 		// 
 		virtual void save( const char* savePath);
 
+	public:
+		// طֿļ, ֻȤ㸽Ŀ鳣פڴ(޶̬ϰ)
+		bool loadStreamed(const String& filePath, float streamingRadius);
+
+		// ֿļ
+		bool saveStreamed(const char* savePath);
+
+		// Ȥ(, ...)
+		void setPointsOfInterest(const vector<Vector3>::type& points);
+
 	public:
 		// Բϰ
 		void addTempObstacleCylinder(const Vector3& pos, float radius, float height);
@@ -55,9 +67,22 @@ namespace Echo
 		// ϰ
 		void clearAllTempObstacles();
 
+		// ÿ֡滻ɿ
+		void setMaxTileSwapsPerFrame(int count) { m_maxTileSwapsPerFrame = count; }
+		int getMaxTileSwapsPerFrame() const { return m_maxTileSwapsPerFrame; }
+
 	protected:
 		// ֽΪ鼯
-		int rasterizeTileLayers(const rcChunkyTriMesh* chunkyMesh, const int tx, const int ty, const rcConfig& cfg, struct TileCacheData* tiles, const int maxTiles);
+		int rasterizeTileLayers(rcContext* ctx, const rcChunkyTriMesh* chunkyMesh, const int tx, const int ty, const rcConfig& cfg, struct TileCacheData* tiles, const int maxTiles);
+
+		// 滻ɵĿ
+		void swapFinishedTiles();
+
+		// ɷؽĿ鵽߳
+		void dispatchTileJobs();
+
+		// ȴпؽ
+		void waitTileJobs();
 
 		// յͼ
 		virtual void cleanup();
@@ -82,5 +107,9 @@ namespace Echo
 
 		struct dtNavMeshData*		m_navMeshData = nullptr;
 		struct dtTileCacheData*		m_tileCacheData = nullptr;
+
+		vector<NavTileJob*>::type	m_tileJobs;
+		int							m_maxTileSwapsPerFrame = 4;
+		NavigationTileStreamer*		m_tileStreamer = nullptr;
 	};
 }
@@ -0,0 +1,281 @@
+#include "NavigationTileStreamer.h"
+#include "engine/core/log/Log.h"
+#include "engine/core/io/IO.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
+
+namespace Echo
+{
+	// reads one tile on a worker thread
+	struct NavTileLoadJob : public CpuThreadPool::Job
+	{
+		DataStream*				m_stream = nullptr;
+		std::mutex*				m_streamMutex = nullptr;
+		ui32					m_entry = 0;
+		ui32					m_offset = 0;
+		ui32					m_size = 0;
+		unsigned char*			m_data = nullptr;
+		std::atomic<bool>		m_isFinished;
+
+		NavTileLoadJob() : m_isFinished(false) {}
+		~NavTileLoadJob() { dtFree(m_data); }
+
+		virtual bool process() override
+		{
+			m_data = (unsigned char*)dtAlloc(m_size, DT_ALLOC_PERM);
+			if (m_data)
+			{
+				std::lock_guard<std::mutex> lock(*m_streamMutex);
+				m_stream->seek(m_offset);
+				if (m_stream->read(m_data, m_size) != m_size)
+				{
+					dtFree(m_data);
+					m_data = nullptr;
+				}
+			}
+
+			// the main thread may delete the job once it's finished, publish the flag last
+			bool isLoaded = m_data != nullptr;
+			m_isFinished = true;
+			return isLoaded;
+		}
+
+		virtual int getType() override { return -1; }
+	};
+
+	static ui64 makeColumnKey(i32 x, i32 y)
+	{
+		return (ui64(ui32(x)) << 32) | ui32(y);
+	}
+
+	NavigationTileStreamer::NavigationTileStreamer()
+	{
+		memset(&m_params, 0, sizeof(m_params));
+	}
+
+	NavigationTileStreamer::~NavigationTileStreamer()
+	{
+		waitLoadJobs();
+		EchoSafeDeleteContainer(m_loadJobs, NavTileLoadJob);
+		EchoSafeDelete(m_stream, DataStream);
+	}
+
+	bool NavigationTileStreamer::save(const dtNavMesh* navMesh, const char* savePath)
+	{
+		if (!navMesh)
+			return false;
+
+		vector<const dtMeshTile*>::type tiles;
+		for (int i = 0; i < navMesh->getMaxTiles(); i++)
+		{
+			const dtMeshTile* tile = navMesh->getTile(i);
+			if (tile && tile->header && tile->dataSize)
+				tiles.emplace_back(tile);
+		}
+
+		FILE* fileHandle = fopen(savePath, "wb");
+		if (!fileHandle)
+		{
+			EchoLogError("NavigationTileStreamer: Could not open [%s] for writing.", savePath);
+			return false;
+		}
+
+		ui32 magic = FILE_MAGIC;
+		i32 version = FILE_VERSION;
+		ui32 tileCount = ui32(tiles.size());
+		fwrite(&magic, sizeof(ui32), 1, fileHandle);
+		fwrite(&version, sizeof(i32), 1, fileHandle);
+		fwrite(navMesh->getParams(), sizeof(dtNavMeshParams), 1, fileHandle);
+		fwrite(&tileCount, sizeof(ui32), 1, fileHandle);
+
+		// tile table, data follows in the same order
+		ui32 offset = ui32(sizeof(ui32) * 2 + sizeof(dtNavMeshParams) + sizeof(ui32) + sizeof(TileEntry) * tileCount);
+		for (const dtMeshTile* tile : tiles)
+		{
+			TileEntry entry;
+			entry.m_x = tile->header->x;
+			entry.m_y = tile->header->y;
+			entry.m_layer = tile->header->layer;
+			entry.m_offset = offset;
+			entry.m_size = ui32(tile->dataSize);
+			fwrite(&entry, sizeof(TileEntry), 1, fileHandle);
+
+			offset += entry.m_size;
+		}
+
+		for (const dtMeshTile* tile : tiles)
+			fwrite(tile->data, tile->dataSize, 1, fileHandle);
+
+		fflush(fileHandle);
+		fclose(fileHandle);
+
+		return true;
+	}
+
+	bool NavigationTileStreamer::open(const String& filePath, dtNavMeshParams& oParams)
+	{
+		waitLoadJobs();
+		EchoSafeDeleteContainer(m_loadJobs, NavTileLoadJob);
+		EchoSafeDelete(m_stream, DataStream);
+		m_entries.clear();
+		m_columns.clear();
+		m_residentCount = 0;
+
+		m_stream = IO::instance()->open(filePath);
+		if (!m_stream)
+			return false;
+
+		ui32 magic = 0;
+		i32 version = 0;
+		m_stream->read(&magic, sizeof(ui32));
+		m_stream->read(&version, sizeof(i32));
+		if (magic != FILE_MAGIC || version != FILE_VERSION)
+		{
+			EchoLogError("NavigationTileStreamer: [%s] is not a tiled navmesh file.", filePath.c_str());
+			EchoSafeDelete(m_stream, DataStream);
+			return false;
+		}
+
+		ui32 tileCount = 0;
+		m_stream->read(&m_params, sizeof(dtNavMeshParams));
+		m_stream->read(&tileCount, sizeof(ui32));
+		m_entries.resize(tileCount);
+		if (tileCount)
+			m_stream->read(m_entries.data(), sizeof(TileEntry) * tileCount);
+
+		for (ui32 i = 0; i < tileCount; i++)
+			m_columns[makeColumnKey(m_entries[i].m_x, m_entries[i].m_y)].emplace_back(i);
+
+		m_states.assign(tileCount, TS_Unloaded);
+		m_tileRefs.assign(tileCount, 0);
+		m_loadStamps.assign(tileCount, 0);
+		m_keepStamps.assign(tileCount, 0);
+
+		oParams = m_params;
+		return true;
+	}
+
+	void NavigationTileStreamer::stampTiles(float radius, vector<ui32>::type& stamps)
+	{
+		const float tileWidth = m_params.tileWidth;
+		const float tileHeight = m_params.tileHeight;
+		for (const Vector3& point : m_points)
+		{
+			i32 minX = i32(std::floor((point.x - radius - m_params.orig[0]) / tileWidth));
+			i32 maxX = i32(std::floor((point.x + radius - m_params.orig[0]) / tileWidth));
+			i32 minY = i32(std::floor((point.z - radius - m_params.orig[2]) / tileHeight));
+			i32 maxY = i32(std::floor((point.z + radius - m_params.orig[2]) / tileHeight));
+			for (i32 y = minY; y <= maxY; y++)
+			{
+				for (i32 x = minX; x <= maxX; x++)
+				{
+					auto it = m_columns.find(makeColumnKey(x, y));
+					if (it == m_columns.end())
+						continue;
+
+					// distance from point to tile rect
+					float tileMinX = m_params.orig[0] + x * tileWidth;
+					float tileMinZ = m_params.orig[2] + y * tileHeight;
+					float dx = std::max(std::max(tileMinX - point.x, point.x - (tileMinX + tileWidth)), 0.f);
+					float dz = std::max(std::max(tileMinZ - point.z, point.z - (tileMinZ + tileHeight)), 0.f);
+					if (dx * dx + dz * dz > radius * radius)
+						continue;
+
+					for (ui32 entry : it->second)
+						stamps[entry] = m_frame;
+				}
+			}
+		}
+	}
+
+	void NavigationTileStreamer::update()
+	{
+		if (!m_navMesh || !m_stream)
+			return;
+
+		m_frame++;
+
+		// unload one tile further out than load, so tiles on the border don't thrash
+		stampTiles(m_streamingRadius, m_loadStamps);
+		stampTiles(m_streamingRadius + std::max(m_params.tileWidth, m_params.tileHeight), m_keepStamps);
+
+		addLoadedTiles();
+
+		CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+		for (ui32 i = 0; i < m_entries.size(); i++)
+		{
+			if (m_states[i] == TS_Resident && m_keepStamps[i] != m_frame)
+			{
+				m_navMesh->removeTile(m_tileRefs[i], nullptr, nullptr);
+				m_tileRefs[i] = 0;
+				m_states[i] = TS_Unloaded;
+				m_residentCount--;
+			}
+			else if (m_states[i] == TS_Unloaded && m_loadStamps[i] == m_frame)
+			{
+				NavTileLoadJob* job = EchoNew(NavTileLoadJob);
+				job->m_stream = m_stream;
+				job->m_streamMutex = &m_streamMutex;
+				job->m_entry = i;
+				job->m_offset = m_entries[i].m_offset;
+				job->m_size = m_entries[i].m_size;
+				m_loadJobs.emplace_back(job);
+				m_states[i] = TS_Loading;
+
+				if (threadPool->getNumThreads() > 0)
+				{
+					CpuThreadPool::Job* jobs[] = { job };
+					threadPool->processJobs(jobs, 1);
+				}
+				else
+				{
+					job->process();
+				}
+			}
+		}
+	}
+
+	void NavigationTileStreamer::addLoadedTiles()
+	{
+		for (size_t i = 0; i < m_loadJobs.size();)
+		{
+			NavTileLoadJob* job = m_loadJobs[i];
+			if (!job->m_isFinished)
+			{
+				i++;
+				continue;
+			}
+
+			// not wanted anymore, or failed, it can be requested again
+			ui32 entry = job->m_entry;
+			m_states[entry] = TS_Unloaded;
+			if (job->m_data && m_keepStamps[entry] == m_frame)
+			{
+				dtTileRef ref = 0;
+				if (dtStatusSucceed(m_navMesh->addTile(job->m_data, int(job->m_size), DT_TILE_FREE_DATA, 0, &ref)))
+				{
+					job->m_data = nullptr;
+					m_tileRefs[entry] = ref;
+					m_states[entry] = TS_Resident;
+					m_residentCount++;
+				}
+				else
+				{
+					EchoLogWarning("NavigationTileStreamer: Could not add tile (%d, %d, %d).", m_entries[entry].m_x, m_entries[entry].m_y, m_entries[entry].m_layer);
+				}
+			}
+
+			EchoSafeDelete(job, NavTileLoadJob);
+			m_loadJobs[i] = m_loadJobs.back();
+			m_loadJobs.pop_back();
+		}
+	}
+
+	void NavigationTileStreamer::waitLoadJobs()
+	{
+		for (NavTileLoadJob* job : m_loadJobs)
+		{
+			while (!job->m_isFinished)
+				std::this_thread::yield();
+		}
+	}
+}
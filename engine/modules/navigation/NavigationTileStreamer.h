@@ -0,0 +1,98 @@
+#pragma once
+
+#include <mutex>
+#include <recast/Recast/DetourNavMesh.h>
+#include <engine/core/math/Math.h>
+
+namespace Echo
+{
+	class DataStream;
+	struct NavTileLoadJob;
+
+	/**
+	 * Navmesh tile streamer
+	 * Tiles of a tiled navmesh file are read on worker threads and added to the navmesh
+	 * when they come within the streaming radius of a point of interest, and removed
+	 * when every point of interest is one tile further away. Only the table of tiles
+	 * stays resident, so memory is bounded by the radius instead of the world size.
+	 */
+	class NavigationTileStreamer
+	{
+	public:
+		// magic & version of the tiled file
+		static const ui32 FILE_MAGIC = 0x5354564e;		// "NVTS"
+		static const i32 FILE_VERSION = 1;
+
+		// tile table entry
+		struct TileEntry
+		{
+			i32		m_x;
+			i32		m_y;
+			i32		m_layer;
+			ui32	m_offset;
+			ui32	m_size;
+		};
+
+		// tile state
+		enum TileState
+		{
+			TS_Unloaded = 0,
+			TS_Loading,
+			TS_Resident,
+		};
+
+	public:
+		NavigationTileStreamer();
+		~NavigationTileStreamer();
+
+		// write every tile of navMesh to a tiled file
+		static bool save(const dtNavMesh* navMesh, const char* savePath);
+
+		// open a tiled file, read the params and tile table
+		bool open(const String& filePath, dtNavMeshParams& oParams);
+
+		// navmesh tiles are streamed into, created by the owner with the params from open
+		void setNavMesh(dtNavMesh* navMesh) { m_navMesh = navMesh; }
+
+		// points of interest, players, cameras...
+		void setPointsOfInterest(const vector<Vector3>::type& points) { m_points = points; }
+
+		// tiles touching this radius around a point of interest are loaded
+		void setStreamingRadius(float radius) { m_streamingRadius = radius; }
+		float getStreamingRadius() const { return m_streamingRadius; }
+
+		// load & unload tiles, add finished ones
+		void update();
+
+		// stats
+		ui32 getTileCount() const { return ui32(m_entries.size()); }
+		ui32 getResidentTileCount() const { return m_residentCount; }
+
+	private:
+		// stamp tiles touching radius around points of interest
+		void stampTiles(float radius, vector<ui32>::type& stamps);
+
+		// add finished tiles
+		void addLoadedTiles();
+
+		// wait until no load is running
+		void waitLoadJobs();
+
+	private:
+		dtNavMesh*							m_navMesh = nullptr;
+		dtNavMeshParams						m_params;
+		DataStream*							m_stream = nullptr;
+		std::mutex							m_streamMutex;			// jobs share the stream
+		vector<TileEntry>::type				m_entries;
+		std::unordered_map<ui64, vector<ui32>::type> m_columns;		// (x,y) -> entries, one per layer
+		vector<ui8>::type					m_states;
+		vector<dtTileRef>::type				m_tileRefs;
+		vector<ui32>::type					m_loadStamps;
+		vector<ui32>::type					m_keepStamps;
+		vector<NavTileLoadJob*>::type		m_loadJobs;
+		vector<Vector3>::type				m_points;
+		float								m_streamingRadius = 64.f;
+		ui32								m_frame = 0;
+		ui32								m_residentCount = 0;
+	};
+}
@@ -12,7 +12,14 @@ namespace Echo
 
 	PhysxBody::~PhysxBody()
 	{
+		if (m_pxBody)
+		{
+			PhysxWorld::instance()->removeBody(this);
 
+			m_pxBody->userData = nullptr;
+			m_pxBody->release();
+			m_pxBody = nullptr;
+		}
 	}
 
 	void PhysxBody::bindMethods()
@@ -38,29 +45,69 @@ namespace Echo
 				else
 				{
 					physx::PxRigidDynamic* dyb = physics->createRigidDynamic(pxTransform);
-					if(m_type.getIdx()==1)
-						dyb->setMass(0.f);
+					if (isKinematic())
+						dyb->setRigidBodyFlag(physx::PxRigidBodyFlag::eKINEMATIC, true);
 					
 					m_pxBody = dyb;
 				}
 
+				m_pxBody->userData = this;
+				m_prevPose = pxTransform;
+				m_currPose = pxTransform;
+
 				PhysxWorld::instance()->getPxScene()->addActor(*m_pxBody);
+				PhysxWorld::instance()->addBody(this);
 			}
 		}
 
-		if (m_pxBody)
+		// in game, poses are written back and kinematic targets pushed by PhysxWorld in bulk
+		if (m_pxBody && !Engine::instance()->getConfig().m_isGame)
 		{
-			if (Engine::instance()->getConfig().m_isGame)
-			{
-				physx::PxTransform pxTransform = m_pxBody->getGlobalPose();
-				this->setWorldPosition( (Vector3&)pxTransform.p);
-				this->setWorldOrientation((Quaternion&)pxTransform.q);
-			}
-			else
-			{
-				physx::PxTransform pxTransform((physx::PxVec3&)getWorldPosition(), (physx::PxQuat&)getWorldOrientation());
-				m_pxBody->setGlobalPose( pxTransform);
-			}
+			physx::PxTransform pxTransform((physx::PxVec3&)getWorldPosition(), (physx::PxQuat&)getWorldOrientation());
+			m_pxBody->setGlobalPose( pxTransform);
+		}
+	}
+
+	bool PhysxBody::onActive(ui32 stepCount)
+	{
+		m_prevPose = m_currPose;
+		m_currPose = m_pxBody->getGlobalPose();
+		m_activeStep = stepCount;
+
+		bool isWokeUp = !m_isMoving;
+		m_isMoving = true;
+
+		return isWokeUp;
+	}
+
+	bool PhysxBody::writeInterpolatedPose(ui32 stepCount, float alpha)
+	{
+		// slept through the last step, settle on the final pose
+		if (m_activeStep != stepCount)
+		{
+			m_prevPose = m_currPose;
+			alpha = 1.f;
+		}
+
+		Vector3 position = Math::Lerp((Vector3&)m_prevPose.p, (Vector3&)m_currPose.p, alpha);
+		Quaternion orientation;
+		Quaternion::Slerp(orientation, (Quaternion&)m_prevPose.q, (Quaternion&)m_currPose.q, alpha, true);
+
+		this->setWorldPosition(position);
+		this->setWorldOrientation(orientation);
+
+		m_isMoving = m_activeStep == stepCount;
+		return m_isMoving;
+	}
+
+	void PhysxBody::pushKinematicTarget()
+	{
+		const Vector3& position = getWorldPosition();
+		const Quaternion& orientation = getWorldOrientation();
+		if ((Vector3&)m_currPose.p != position || (Quaternion&)m_currPose.q != orientation)
+		{
+			m_currPose = physx::PxTransform((physx::PxVec3&)position, (physx::PxQuat&)orientation);
+			((physx::PxRigidDynamic*)m_pxBody)->setKinematicTarget(m_currPose);
 		}
 	}
-}
\ No newline at end of file
+}
@@ -17,9 +17,23 @@ namespace Echo
 		const StringOption& getType() { return m_type; }
 		void setType(const StringOption& type) { m_type.setValue(type.getValue()); }
 
+		// type helper
+		bool isKinematic() const { return m_type.getIdx() == 1; }
+		bool isDynamic() const { return m_type.getIdx() == 2; }
+
 		// get physx body
 		physx::PxRigidActor* getPxBody() { return m_pxBody; }
 
+	public:
+		// actor was in the active list of a fetched step, return true if it just woke up
+		bool onActive(ui32 stepCount);
+
+		// blend the last two fetched poses into the node, return false once settled
+		bool writeInterpolatedPose(ui32 stepCount, float alpha);
+
+		// push the node transform as kinematic target if the node moved
+		void pushKinematicTarget();
+
 	private:
 		// update
 		virtual void update_self() override;
@@ -27,5 +41,9 @@ namespace Echo
 	private:
 		physx::PxRigidActor*m_pxBody = nullptr;
 		StringOption		m_type;
+		physx::PxTransform	m_prevPose;
+		physx::PxTransform	m_currPose;
+		ui32				m_activeStep = 0;
+		bool				m_isMoving = false;
 	};
 }
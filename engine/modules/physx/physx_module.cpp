@@ -32,8 +32,11 @@ namespace Echo
 	{
         CLASS_BIND_METHOD(PhysxModule, getDebugDrawOption, DEF_METHOD("getDebugDrawOption"));
         CLASS_BIND_METHOD(PhysxModule, setDebugDrawOption, DEF_METHOD("setDebugDrawOption"));
+        CLASS_BIND_METHOD(PhysxModule, isAsyncSimulation, DEF_METHOD("isAsyncSimulation"));
+        CLASS_BIND_METHOD(PhysxModule, setAsyncSimulation, DEF_METHOD("setAsyncSimulation"));
 
         CLASS_REGISTER_PROPERTY(PhysxModule, "DebugDraw", Variant::Type::StringOption, "getDebugDrawOption", "setDebugDrawOption");
+        CLASS_REGISTER_PROPERTY(PhysxModule, "AsyncSimulation", Variant::Type::Bool, "isAsyncSimulation", "setAsyncSimulation");
 	}
 
 	void PhysxModule::registerTypes()
@@ -52,8 +55,23 @@ namespace Echo
 		PhysxWorld::instance()->step(elapsedTime);
 	}
 
+	void PhysxModule::lateUpdate(float elapsedTime)
+	{
+		PhysxWorld::instance()->lateStep();
+	}
+
     void PhysxModule::setDebugDrawOption(const StringOption& option)
     {
         m_drawDebugOption.setValue(option.getValue());
     }
+
+    bool PhysxModule::isAsyncSimulation() const
+    {
+        return PhysxWorld::instance()->isAsyncSimulation();
+    }
+
+    void PhysxModule::setAsyncSimulation(bool isAsync)
+    {
+        PhysxWorld::instance()->setAsyncSimulation(isAsync);
+    }
 }
@@ -20,11 +20,18 @@ namespace Echo
 
 		// update physx world
 		virtual  void update(float elapsedTime) override;
+
+		// kick async step after the node tree updated
+		virtual void lateUpdate(float elapsedTime) override;
         
     public:
         // debug draw
         const StringOption& getDebugDrawOption() const { return m_drawDebugOption; }
         void setDebugDrawOption(const StringOption& option);
+
+        // async simulation, overlaps rendering, poses lag one step
+        bool isAsyncSimulation() const;
+        void setAsyncSimulation(bool isAsync);
         
     private:
         StringOption    m_drawDebugOption = StringOption("Editor", { "None","Editor","Game","All" });
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <engine/core/math/Math.h>
+
+namespace Echo
+{
+	class PhysxBody;
+
+	// ray, dir is normalized, a zero dir never hits
+	struct PhysxRaycast
+	{
+		Vector3		m_origin;
+		Vector3		m_dir;
+		float		m_distance = 1000.f;
+	};
+
+	// sphere sweep, dir is normalized, a zero dir never hits
+	struct PhysxSweep
+	{
+		Vector3		m_origin;
+		Vector3		m_dir;
+		float		m_distance = 1000.f;
+		float		m_radius = 0.5f;
+	};
+
+	// sphere overlap
+	struct PhysxOverlap
+	{
+		Vector3		m_center;
+		float		m_radius = 0.5f;
+	};
+
+	// closest hit of a raycast or sweep, m_body is null if nothing was hit
+	struct PhysxQueryHit
+	{
+		PhysxBody*	m_body = nullptr;
+		Vector3		m_position = Vector3::ZERO;
+		Vector3		m_normal = Vector3::ZERO;
+		float		m_distance = 0.f;
+	};
+}
@@ -1,11 +1,31 @@
-#include <thread>
 #include "physx_world.h"
 #include "physx_cb.cx"
 #include "physx_module.h"
+#include "physx_body.h"
 #include "engine/core/main/Engine.h"
 
 namespace Echo
 {
+	static void toQueryHit(const physx::PxLocationHit& pxHit, PhysxQueryHit& oHit)
+	{
+		oHit.m_body = pxHit.actor ? (PhysxBody*)pxHit.actor->userData : nullptr;
+		oHit.m_position = (const Vector3&)pxHit.position;
+		oHit.m_normal = (const Vector3&)pxHit.normal;
+		oHit.m_distance = pxHit.distance;
+	}
+
+	static void writeQueryHit(const PhysxQueryHit& hit, double* oResult)
+	{
+		oResult[0] = hit.m_body ? hit.m_body->getId() : -1;
+		oResult[1] = hit.m_position.x;
+		oResult[2] = hit.m_position.y;
+		oResult[3] = hit.m_position.z;
+		oResult[4] = hit.m_normal.x;
+		oResult[5] = hit.m_normal.y;
+		oResult[6] = hit.m_normal.z;
+		oResult[7] = hit.m_distance;
+	}
+
 	PhysxWorld::PhysxWorld()
 	{
 		if (initPhysx())
@@ -14,10 +34,9 @@ namespace Echo
 			pxDesc.gravity = physx::PxVec3(m_gravity.x, m_gravity.y, m_gravity.z);
 			if (!pxDesc.cpuDispatcher)
 			{
-				int threadNumber = std::min<int>(std::max<int>(1, std::thread::hardware_concurrency() - 1), 4);
-
-				m_pxCPUDispatcher = physx::PxDefaultCpuDispatcherCreate(threadNumber);
-				pxDesc.cpuDispatcher = (physx::PxDefaultCpuDispatcher*)m_pxCPUDispatcher;
+				// physx tasks share the engine thread pool
+				m_pxCPUDispatcher = EchoNew(PhysxCpuDispatcher);
+				pxDesc.cpuDispatcher = m_pxCPUDispatcher;
 			}
 
 			if (!pxDesc.filterShader)
@@ -25,7 +44,8 @@ namespace Echo
 				pxDesc.filterShader = physx::PxDefaultSimulationFilterShader;
 			}
 
-			//pxDesc.flags |= physx::PxSceneFlag::eENABLE_ACTIVETRANSFORMS;
+			// only bodies that moved are written back
+			pxDesc.flags |= physx::PxSceneFlag::eENABLE_ACTIVE_ACTORS;
 			//pxDesc.simulationOrder = physx::PxSimulationOrder::eCOLLIDE_SOLVE;
 
 			// create scene
@@ -36,16 +56,18 @@ namespace Echo
 
 	PhysxWorld::~PhysxWorld()
 	{
+		fetchResults();
+
 		physx::PxCloseVehicleSDK();
 
 		m_pxScene->release();
 		m_pxPhysics->release();
-		m_pxCPUDispatcher->release();
 		m_pxFoundation->release();
 
 		EchoSafeDelete(m_pxAllocatorCb, PxAllocatorCallback);
 		EchoSafeDelete(m_pxErrorCb, PxErrorCallback);
 		EchoSafeDelete(m_debugDraw, PhysxDebugDraw);
+		EchoSafeDelete(m_pxCPUDispatcher, PhysxCpuDispatcher);
 	}
 
 	bool PhysxWorld::initPhysx()
@@ -67,6 +89,9 @@ namespace Echo
 
 	void PhysxWorld::bindMethods()
 	{
+		CLASS_BIND_METHOD(PhysxWorld, raycastBatch, DEF_METHOD("raycastBatch"));
+		CLASS_BIND_METHOD(PhysxWorld, sweepBatch, DEF_METHOD("sweepBatch"));
+		CLASS_BIND_METHOD(PhysxWorld, overlapBatch, DEF_METHOD("overlapBatch"));
 	}
 
 	PhysxWorld* PhysxWorld::instance()
@@ -75,22 +100,122 @@ namespace Echo
 		return inst;
 	}
 
+	void PhysxWorld::fetchResults()
+	{
+		if (m_isSimulating)
+		{
+			fetchStep();
+			m_isSimulating = false;
+		}
+	}
+
+	void PhysxWorld::simulate(float stepLength)
+	{
+		for (PhysxBody* body : m_kinematicBodies)
+			body->pushKinematicTarget();
+
+		m_pxScene->simulate(stepLength);
+	}
+
+	void PhysxWorld::fetchStep()
+	{
+		m_pxScene->fetchResults(true);
+		m_stepCount++;
+
+		physx::PxU32 actorCount = 0;
+		physx::PxActor** actors = m_pxScene->getActiveActors(actorCount);
+		for (physx::PxU32 i = 0; i < actorCount; i++)
+		{
+			PhysxBody* body = (PhysxBody*)actors[i]->userData;
+			if (body && body->isDynamic() && body->onActive(m_stepCount))
+				m_movingBodies.emplace_back(body);
+		}
+	}
+
+	void PhysxWorld::writeBackPoses()
+	{
+		for (size_t i = 0; i < m_movingBodies.size();)
+		{
+			if (m_movingBodies[i]->writeInterpolatedPose(m_stepCount, m_interpolationAlpha))
+			{
+				i++;
+			}
+			else
+			{
+				m_movingBodies[i] = m_movingBodies.back();
+				m_movingBodies.pop_back();
+			}
+		}
+	}
+
+	void PhysxWorld::addBody(PhysxBody* body)
+	{
+		if (body->isKinematic())
+			m_kinematicBodies.emplace_back(body);
+	}
+
+	void PhysxWorld::removeBody(PhysxBody* body)
+	{
+		// a running step may still report it
+		fetchResults();
+
+		m_movingBodies.erase(std::remove(m_movingBodies.begin(), m_movingBodies.end(), body), m_movingBodies.end());
+		m_kinematicBodies.erase(std::remove(m_kinematicBodies.begin(), m_kinematicBodies.end(), body), m_kinematicBodies.end());
+	}
+
+	void PhysxWorld::setAsyncSimulation(bool isAsync)
+	{
+		if (m_isAsyncSimulation != isAsync)
+		{
+			fetchResults();
+			m_isStepDue = false;
+			m_isAsyncSimulation = isAsync;
+		}
+	}
+
 	void PhysxWorld::step(float elapsedTime)
 	{
 		if (m_pxScene)
 		{
 			bool isGame = Engine::instance()->getConfig().m_isGame;
 
+			// results of the step kicked last frame
+			fetchResults();
+
 			// step
 			m_accumulator += elapsedTime;
-			while (m_accumulator > m_stepLength)
+			if (m_isAsyncSimulation)
 			{
-				m_pxScene->simulate(isGame ? m_stepLength : 0.f);
-				m_pxScene->fetchResults(true);
+				// fell behind, catch up here, keep one step for lateStep
+				while (m_accumulator > m_stepLength * 2.f)
+				{
+					simulate(isGame ? m_stepLength : 0.f);
+					fetchStep();
 
-				m_accumulator -= m_stepLength;
+					m_accumulator -= m_stepLength;
+				}
+
+				if (m_accumulator > m_stepLength)
+				{
+					m_accumulator -= m_stepLength;
+					m_isStepDue = true;
+				}
+			}
+			else
+			{
+				while (m_accumulator > m_stepLength)
+				{
+					simulate(isGame ? m_stepLength : 0.f);
+					fetchStep();
+
+					m_accumulator -= m_stepLength;
+				}
 			}
 
+			m_interpolationAlpha = Math::Clamp(m_accumulator / m_stepLength, 0.f, 1.f);
+			if (isGame)
+				writeBackPoses();
+
 			// draw debug data
             const StringOption& debugDrawOption = PhysxModule::instance()->getDebugDrawOption();
 			if (debugDrawOption.getIdx() == 3 || (debugDrawOption.getIdx() == 1 && !isGame) || (debugDrawOption.getIdx() == 2 && isGame))
@@ -106,4 +231,158 @@ namespace Echo
             }
 		}
 	}
+
+	void PhysxWorld::lateStep()
+	{
+		if (m_pxScene && m_isStepDue)
+		{
+			bool isGame = Engine::instance()->getConfig().m_isGame;
+			simulate(isGame ? m_stepLength : 0.f);
+			m_isSimulating = true;
+			m_isStepDue = false;
+		}
+	}
+
+	void PhysxWorld::raycasts(const PhysxRaycast* rays, ui32 count, PhysxQueryHit* oHits)
+	{
+		if (!m_pxScene)
+			return;
+
+		// scene reads are thread safe, even while a step is running
+		OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(count, [&](ui32 i)
+		{
+			const PhysxRaycast& ray = rays[i];
+			physx::PxRaycastBuffer buffer;
+			oHits[i] = PhysxQueryHit();
+			if (!ray.m_dir.isZeroLength() && m_pxScene->raycast((const physx::PxVec3&)ray.m_origin, (const physx::PxVec3&)ray.m_dir, ray.m_distance, buffer) && buffer.hasBlock)
+				toQueryHit(buffer.block, oHits[i]);
+		});
+	}
+
+	void PhysxWorld::sweeps(const PhysxSweep* sweeps, ui32 count, PhysxQueryHit* oHits)
+	{
+		if (!m_pxScene)
+			return;
+
+		OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(count, [&](ui32 i)
+		{
+			const PhysxSweep& sweep = sweeps[i];
+			physx::PxSweepBuffer buffer;
+			oHits[i] = PhysxQueryHit();
+			if (!sweep.m_dir.isZeroLength() && m_pxScene->sweep(physx::PxSphereGeometry(sweep.m_radius), physx::PxTransform((const physx::PxVec3&)sweep.m_origin), (const physx::PxVec3&)sweep.m_dir, sweep.m_distance, buffer) && buffer.hasBlock)
+				toQueryHit(buffer.block, oHits[i]);
+		});
+	}
+
+	void PhysxWorld::overlaps(const PhysxOverlap* overlaps, ui32 count, vector<PhysxBody*>::type& oBodies, vector<ui32>::type& oOffsets, ui32 maxHitsPerQuery)
+	{
+		oBodies.clear();
+		oOffsets.assign(count + 1, 0);
+		if (!m_pxScene)
+			return;
+
+		// every query owns maxHitsPerQuery slots, compacted afterwards
+		vector<physx::PxOverlapHit>::type touches(count * maxHitsPerQuery);
+		vector<ui32>::type touchCounts(count, 0);
+		OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(count, [&](ui32 i)
+		{
+			const PhysxOverlap& overlap = overlaps[i];
+			physx::PxOverlapBuffer buffer(touches.data() + i * maxHitsPerQuery, maxHitsPerQuery);
+			physx::PxQueryFilterData filterData(physx::PxQueryFlag::eSTATIC | physx::PxQueryFlag::eDYNAMIC | physx::PxQueryFlag::eNO_BLOCK);
+			if (m_pxScene->overlap(physx::PxSphereGeometry(overlap.m_radius), physx::PxTransform((const physx::PxVec3&)overlap.m_center), buffer, filterData))
+				touchCounts[i] = buffer.getNbTouches();
+		});
+
+		for (ui32 i = 0; i < count; i++)
+		{
+			oOffsets[i] = ui32(oBodies.size());
+			for (ui32 j = 0; j < touchCounts[i]; j++)
+			{
+				PhysxBody* body = (PhysxBody*)touches[i * maxHitsPerQuery + j].actor->userData;
+				if (body)
+					oBodies.emplace_back(body);
+			}
+		}
+		oOffsets[count] = ui32(oBodies.size());
+	}
+
+	// rays: [ox, oy, oz, dx, dy, dz, distance] per ray
+	// result: [bodyId or -1, px, py, pz, nx, ny, nz, distance] per ray
+	RealVector PhysxWorld::raycastBatch(const RealVector& rays)
+	{
+		ui32 count = ui32(rays.size() / 7);
+		vector<PhysxRaycast>::type queries(count);
+		for (ui32 i = 0; i < count; i++)
+		{
+			const double* ray = rays.data() + i * 7;
+			queries[i].m_origin = Vector3(float(ray[0]), float(ray[1]), float(ray[2]));
+			queries[i].m_dir = Vector3(float(ray[3]), float(ray[4]), float(ray[5]));
+			queries[i].m_dir.normalizeLen();
+			queries[i].m_distance = float(ray[6]);
+		}
+
+		vector<PhysxQueryHit>::type hits(count);
+		raycasts(queries.data(), count, hits.data());
+
+		RealVector result(count * 8);
+		for (ui32 i = 0; i < count; i++)
+			writeQueryHit(hits[i], result.data() + i * 8);
+
+		return result;
+	}
+
+	// sweeps: [ox, oy, oz, dx, dy, dz, distance, radius] per sphere sweep
+	// result: [bodyId or -1, px, py, pz, nx, ny, nz, distance] per sweep
+	RealVector PhysxWorld::sweepBatch(const RealVector& sweeps)
+	{
+		ui32 count = ui32(sweeps.size() / 8);
+		vector<PhysxSweep>::type queries(count);
+		for (ui32 i = 0; i < count; i++)
+		{
+			const double* sweep = sweeps.data() + i * 8;
+			queries[i].m_origin = Vector3(float(sweep[0]), float(sweep[1]), float(sweep[2]));
+			queries[i].m_dir = Vector3(float(sweep[3]), float(sweep[4]), float(sweep[5]));
+			queries[i].m_dir.normalizeLen();
+			queries[i].m_distance = float(sweep[6]);
+			queries[i].m_radius = float(sweep[7]);
+		}
+
+		vector<PhysxQueryHit>::type hits(count);
+		this->sweeps(queries.data(), count, hits.data());
+
+		RealVector result(count * 8);
+		for (ui32 i = 0; i < count; i++)
+			writeQueryHit(hits[i], result.data() + i * 8);
+
+		return result;
+	}
+
+	// spheres: [cx, cy, cz, radius] per sphere
+	// result: [count, bodyId...] per sphere
+	RealVector PhysxWorld::overlapBatch(const RealVector& spheres)
+	{
+		ui32 count = ui32(spheres.size() / 4);
+		vector<PhysxOverlap>::type queries(count);
+		for (ui32 i = 0; i < count; i++)
+		{
+			const double* sphere = spheres.data() + i * 4;
+			queries[i].m_center = Vector3(float(sphere[0]), float(sphere[1]), float(sphere[2]));
+			queries[i].m_radius = float(sphere[3]);
+		}
+
+		vector<PhysxBody*>::type bodies;
+		vector<ui32>::type offsets;
+		overlaps(queries.data(), count, bodies, offsets);
+
+		RealVector result;
+		result.reserve(count + bodies.size());
+		for (ui32 i = 0; i < count; i++)
+		{
+			result.emplace_back(offsets[i + 1] - offsets[i]);
+			for (ui32 j = offsets[i]; j < offsets[i + 1]; j++)
+				result.emplace_back(bodies[j]->getId());
+		}
+
+		return result;
+	}
 }
@@ -4,9 +4,13 @@
 #include <engine/core/math/Math.h>
 #include "physx_debug_draw.h"
 #include "physx_base.h"
+#include "physx_query.h"
 
 namespace Echo
 {
+	class PhysxCpuDispatcher;
+	class PhysxBody;
+
 	class PhysxWorld : public Object
 	{
 		ECHO_SINGLETON_CLASS(PhysxWorld, Object)
@@ -17,9 +21,38 @@ namespace Echo
 		// instance
 		static PhysxWorld* instance();
 
-		// step
+		// step, fetches the async step kicked last frame
 		void step(float elapsedTime);
 
+		// kick the async step, it runs while the frame renders
+		void lateStep();
+
+		// async simulation
+		bool isAsyncSimulation() const { return m_isAsyncSimulation; }
+		void setAsyncSimulation(bool isAsync);
+
+		// fetched step count, bodies compare it to know when poses changed
+		ui32 getStepCount() const { return m_stepCount; }
+
+		// blend factor between the last two fetched poses
+		float getInterpolationAlpha() const { return m_interpolationAlpha; }
+
+		// scene queries, run in parallel over the thread pool, one hit per query
+		void raycasts(const PhysxRaycast* rays, ui32 count, PhysxQueryHit* oHits);
+		void sweeps(const PhysxSweep* sweeps, ui32 count, PhysxQueryHit* oHits);
+
+		// bodies overlapped by query i are oBodies[oOffsets[i], oOffsets[i+1])
+		void overlaps(const PhysxOverlap* overlaps, ui32 count, vector<PhysxBody*>::type& oBodies, vector<ui32>::type& oOffsets, ui32 maxHitsPerQuery = 32);
+
+		// flat array versions for lua, see cpp for the layouts
+		RealVector raycastBatch(const RealVector& rays);
+		RealVector sweepBatch(const RealVector& sweeps);
+		RealVector overlapBatch(const RealVector& spheres);
+
+		// bodies with a physx actor in the scene
+		void addBody(PhysxBody* body);
+		void removeBody(PhysxBody* body);
+
 		// get pxPhysics
 		physx::PxPhysics* getPxPhysics() { return m_pxPhysics; }
 
@@ -32,17 +65,36 @@ namespace Echo
 		// initialize
 		bool initPhysx();
 
+		// wait for the running step
+		void fetchResults();
+
+		// simulate one step, kinematic targets are pushed first
+		void simulate(float stepLength);
+
+		// fetch one step, then collect the bodies it moved
+		void fetchStep();
+
+		// write moved bodies back to their nodes
+		void writeBackPoses();
+
 	private:
 		physx::PxAllocatorCallback*		m_pxAllocatorCb = nullptr;
 		physx::PxErrorCallback*			m_pxErrorCb = nullptr;
 		physx::PxFoundation*			m_pxFoundation = nullptr;
 		physx::PxPhysics*				m_pxPhysics = nullptr;
-		physx::PxDefaultCpuDispatcher*	m_pxCPUDispatcher = nullptr;
+		PhysxCpuDispatcher*				m_pxCPUDispatcher = nullptr;
 
 		Vector3							m_gravity = Vector3(0.f, -9.8f, 0.f);
 		physx::PxScene*					m_pxScene = nullptr;
 		float							m_stepLength = 0.025f;
 		float							m_accumulator = 0.f;
+		bool							m_isAsyncSimulation = false;
+		bool							m_isSimulating = false;
+		bool							m_isStepDue = false;
+		ui32							m_stepCount = 0;
+		float							m_interpolationAlpha = 1.f;
+		vector<PhysxBody*>::type		m_movingBodies;
+		vector<PhysxBody*>::type		m_kinematicBodies;
 
 		PhysxDebugDraw*					m_debugDraw = nullptr;
 	};
@@ -4,10 +4,120 @@
 #include "base/Renderer.h"
 #include "base/ShaderProgram.h"
 #include "engine/core/main/Engine.h"
+#include "engine/core/render/base/image/PixelUtil.h"
 #include "engine/modules/ui/font/font_library.h"
 
+static const char* g_terrainVsCode = R"(#version 450
+
+// uniforms
+layout(binding = 0) uniform UBO
+{
+    mat4 u_WorldMatrix;
+    mat4 u_ViewProjMatrix;
+    vec4 u_TerrainParams;
+    vec4 u_TileParams;
+} vs_ubo;
+
+layout(binding = 2) uniform sampler2D u_HeightTexture;
+
+// inputs, patch column, skirt, patch row
+layout(location = 0) in vec3 a_Position;
+
+// outputs
+layout(location = 0) out vec3 v_Position;
+layout(location = 1) out vec3 v_Normal;
+layout(location = 2) out vec2 v_TexCoord;
+
+void main(void)
+{
+    // columns, rows, grid spacing, height range
+    vec4 terrain = vs_ubo.u_TerrainParams;
+
+    // first column, first row, step, skirt depth
+    vec4 tile = vs_ubo.u_TileParams;
+
+    vec2 grid = min(tile.xy + a_Position.xz * tile.z, terrain.xy - 1.0);
+    vec4 texel = texelFetch(u_HeightTexture, ivec2(grid), 0);
+
+    // 16 bit height in rg, normal x and z in ba
+    float height = (texel.r * 65280.0 + texel.g * 255.0) / 65535.0 * 2.0 - 1.0;
+    height = height * terrain.w - a_Position.y * tile.w;
+
+    vec3 normal;
+    normal.xz = texel.ba * 2.0 - 1.0;
+    normal.y = sqrt(max(1.0 - dot(normal.xz, normal.xz), 0.0));
+
+    vec4 position = vs_ubo.u_WorldMatrix * vec4(grid.x * terrain.z, height, grid.y * terrain.z, 1.0);
+    gl_Position = vs_ubo.u_ViewProjMatrix * position;
+
+    v_Position = position.xyz / position.w;
+    v_Normal = normalize(vec3(vs_ubo.u_WorldMatrix * vec4(normal, 0.0)));
+    v_TexCoord = (grid + 0.5) / terrain.xy;
+}
+)";
+
+static const char* g_terrainPsCode = R"(#version 450
+
+precision mediump float;
+
+// inputs
+layout(location = 0) in vec3 v_Position;
+layout(location = 1) in vec3 v_Normal;
+layout(location = 2) in vec2 v_TexCoord;
+
+// outputs
+layout(location = 0) out vec4 o_FragColor;
+
+vec3 SRgbToLinear(vec3 srgbIn)
+{
+    return pow(srgbIn, vec3(2.2));
+}
+
+vec3 LinearToSRgb(vec3 linearIn)
+{
+    return pow(linearIn, vec3(1.0/2.2));
+}
+
+void main(void)
+{
+    vec3 __BaseColor = SRgbToLinear(vec3(0.75));
+
+    vec3 _lightDir = normalize(vec3(1.0, 1.0, 1.0));
+    vec3 _lightColor = SRgbToLinear(vec3(1.2, 1.2, 1.2));
+    vec3 _AmbientColor = SRgbToLinear(vec3(0.4, 0.4, 0.4));
+    __BaseColor = max(dot(normalize(v_Normal), _lightDir), 0.0) * _lightColor * __BaseColor + _AmbientColor;
+
+    o_FragColor = vec4(LinearToSRgb(__BaseColor.rgb), 1.0);
+}
+)";
+
 namespace Echo
 {
+    // marks the tiles a frustum query finds
+    class TerrainTileQuery : public BvhCb
+    {
+    public:
+        TerrainTileQuery(const Bvh& bvh, TerrainTiles& tiles, ui32 frame)
+            : m_bvh(bvh), m_tiles(tiles), m_frame(frame)
+        {}
+
+        virtual bool queryCallback(i32 nodeId) override
+        {
+            m_tiles[m_bvh.getUserData(nodeId)]->setVisibleFrame(m_frame);
+            return true;
+        }
+
+        virtual float rayCastCallback(i32 nodeId) override
+        {
+            return -1.f;
+        }
+
+    private:
+        const Bvh&      m_bvh;
+        TerrainTiles&   m_tiles;
+        ui32            m_frame;
+    };
+
     Terrain::Terrain()
     {
         setRenderType("3d");
@@ -28,12 +138,18 @@ namespace Echo
 		CLASS_BIND_METHOD(Terrain, setHeightRange,   DEF_METHOD("setHeightRange"));
 		CLASS_BIND_METHOD(Terrain, getGridSpacing,   DEF_METHOD("getGridSpacing"));
 		CLASS_BIND_METHOD(Terrain, setGridSpacing,   DEF_METHOD("setGridSpacing"));
+		CLASS_BIND_METHOD(Terrain, getLodDistance,   DEF_METHOD("getLodDistance"));
+		CLASS_BIND_METHOD(Terrain, setLodDistance,   DEF_METHOD("setLodDistance"));
+		CLASS_BIND_METHOD(Terrain, isCompact,        DEF_METHOD("isCompact"));
+		CLASS_BIND_METHOD(Terrain, setCompact,       DEF_METHOD("setCompact"));
         CLASS_BIND_METHOD(Terrain, getMaterial,      DEF_METHOD("getMaterial"));
         CLASS_BIND_METHOD(Terrain, setMaterial,      DEF_METHOD("setMaterial"));
         
         CLASS_REGISTER_PROPERTY(Terrain, "Data", Variant::Type::ResourcePath, "getDataPath", "setDataPath");
 		CLASS_REGISTER_PROPERTY(Terrain, "HeightRange", Variant::Type::Real, "getHeightRange", "setHeightRange");
 		CLASS_REGISTER_PROPERTY(Terrain, "GridSpacing", Variant::Type::Int, "getGridSpacing", "setGridSpacing");
+		CLASS_REGISTER_PROPERTY(Terrain, "LodDistance", Variant::Type::Real, "getLodDistance", "setLodDistance");
+		CLASS_REGISTER_PROPERTY(Terrain, "Compact", Variant::Type::Bool, "isCompact", "setCompact");
         CLASS_REGISTER_PROPERTY(Terrain, "Material", Variant::Type::Object, "getMaterial", "setMaterial");
         CLASS_REGISTER_PROPERTY_HINT(Terrain, "Material", PropertyHintType::ResourceType, "Material");
     }
@@ -42,6 +158,7 @@ namespace Echo
     {
         EchoSafeDelete(m_heightmapImage, Image);
         EchoSafeDeleteContainer(m_layerImages, Image);
+        m_heights.clear();
 
         if (m_dataPath.setPath(path.getPath()))
         {
@@ -54,6 +171,14 @@ namespace Echo
 					m_columns = m_heightmapImage->getWidth();
 					m_rows = m_heightmapImage->getHeight();
 
+					// keep heights as floats, tiles read them a lot
+					m_heights.resize(m_columns * m_rows);
+					for (i32 z = 0; z < m_rows; z++)
+					{
+						for (i32 x = 0; x < m_columns; x++)
+							m_heights[z * m_columns + x] = m_heightmapImage->getColor(x, z, 0).r * 2.f - 1.f;
+					}
+
 					m_isRenderableDirty = true;
 				}
             }
@@ -88,36 +213,59 @@ namespace Echo
         m_isRenderableDirty = true;
 	}
 
+	void Terrain::setLodDistance(float distance)
+	{
+		m_lodDistance = Math::Max(distance, 1.f);
+	}
+
     void Terrain::setMaterial( Object* material)
     {
         m_material = (Material*)material;
+        m_isDefaultMaterial = false;
         
         m_isRenderableDirty = true;
     }
+
+	void Terrain::setCompact(bool isCompact)
+	{
+		m_isCompact = isCompact;
+
+		// the default material has to follow the mode
+		if (m_isDefaultMaterial)
+			m_material.reset();
+
+		m_isRenderableDirty = true;
+	}
     
     void Terrain::buildRenderable()
     {
-        if (m_isRenderableDirty && m_heightmapImage && m_columns > 0 && m_rows > 0)
+        if (m_isRenderableDirty && m_heightmapImage && m_columns > 1 && m_rows > 1)
         {
             clearRenderable();
             
             // make sure one material is valid
             if(!m_material)
             {
-                ShaderProgramPtr shader = ShaderProgram::getDefault3D({ "HAS_NORMALS" });
+                ShaderProgramPtr shader = m_isCompact ? getCompactShader() : ShaderProgram::getDefault3D({ "HAS_NORMALS" });
                 
                 // material
                 m_material = ECHO_CREATE_RES(Material);
                 m_material->setShaderPath(shader->getPath());
+                m_isDefaultMaterial = true;
+            }
+
+            // compact mode keeps no vertices per sample
+            if (m_isCompact)
+            {
+                buildPatchMesh();
+                updateTextures(0, 0, m_columns, m_rows);
             }
             
-            // mesh
-			updateMeshBuffer();
-            
-			// create renderable
-            m_renderable = Renderable::create(m_mesh, m_material, this);
+            // tiles, meshes are built once a tile gets drawn
+			buildTiles();
             
             m_isRenderableDirty = false;
+            m_dirtyRect = TerrainRect();
         }
     }
     
@@ -126,74 +274,241 @@ namespace Echo
         if (isNeedRender())
         {
             buildRenderable();
-            if (m_renderable)
-                m_renderable->submitToRenderQueue();
+            updateDirtyRegion();
+            updateTileProxies();
+            submitTiles();
         }
     }
-    
-    void Terrain::buildMeshData(VertexArray& oVertices, IndiceArray& oIndices)
+
+    void Terrain::buildTiles()
+    {
+        i32 level = 0;
+        while ((TerrainTile::Size << level) < Math::Max(m_columns - 1, m_rows - 1))
+            level++;
+
+        m_rootTile = buildTile(level, 0, 0);
+        m_rootTile->updateBounds();
+        m_localAABB = m_rootTile->getLocalAABB();
+
+        // every tile gets a proxy, the user data is the index in m_tiles
+        m_tileMatrix = getWorldMatrix();
+        for (size_t i = 0; i < m_tiles.size(); i++)
+        {
+            TerrainTile* tile = m_tiles[i];
+            tile->setWorldAABB(tile->getLocalAABB().transform(m_tileMatrix));
+            tile->setProxyId(m_tileBvh.createProxy(tile->getWorldAABB(), i32(i)));
+        }
+    }
+
+    TerrainTile* Terrain::buildTile(i32 level, i32 x, i32 z)
+    {
+        TerrainTile* tile = EchoNew(TerrainTile(this, level, x, z));
+        m_tiles.emplace_back(tile);
+
+        if (level > 0)
+        {
+            i32 half = TerrainTile::Size << (level - 1);
+            for (i32 i = 0; i < 4; i++)
+            {
+                i32 childX = x + (i & 1) * half;
+                i32 childZ = z + (i >> 1) * half;
+                if (childX < m_columns - 1 && childZ < m_rows - 1)
+                    tile->setChild(i, buildTile(level - 1, childX, childZ));
+            }
+        }
+
+        return tile;
+    }
+
+    void Terrain::updateTileProxies()
+    {
+        if (m_rootTile && m_tileMatrix != getWorldMatrix())
+        {
+            m_tileMatrix = getWorldMatrix();
+            for (TerrainTile* tile : m_tiles)
+            {
+                AABB worldAABB = tile->getLocalAABB().transform(m_tileMatrix);
+                m_tileBvh.moveProxy(tile->getProxyId(), worldAABB, worldAABB.getCenter() - tile->getWorldAABB().getCenter());
+                tile->setWorldAABB(worldAABB);
+            }
+        }
+    }
+
+    void Terrain::submitTiles()
+    {
+        Camera* camera = NodeTree::instance()->get3dCamera();
+        if (m_rootTile && camera)
+        {
+            m_frame++;
+
+            Frustum frustum;
+            frustum.setPerspective(camera->getFov(), float(camera->getWidth()) / float(camera->getHeight()), camera->getNear(), camera->getFar());
+            frustum.build(camera->getPosition(), camera->getDirection(), camera->getUp(), true);
+
+            TerrainTileQuery query(m_tileBvh, m_tiles, m_frame);
+            m_tileBvh.query(&query, frustum);
+
+            selectTile(m_rootTile, camera->getPosition());
+
+            for (TerrainTile* tile : m_tiles)
+                tile->releaseUnused(m_frame);
+        }
+    }
+
+    void Terrain::selectTile(TerrainTile* tile, const Vector3& eye)
     {
-        if(m_columns>0 && m_rows>0)
+        if (tile->getVisibleFrame() != m_frame)
+            return;
+
+        // children take over while the camera is closer than the lod distance of their level
+        if (!tile->isLeaf())
         {
-            // vertex buffer
-			for (i32 row = 0; row < m_rows; row++)
+            const AABB& box = tile->getWorldAABB();
+            Vector3 nearest(Math::Clamp(eye.x, box.vMin.x, box.vMax.x), Math::Clamp(eye.y, box.vMin.y, box.vMax.y), Math::Clamp(eye.z, box.vMin.z, box.vMax.z));
+            if ((eye - nearest).len() < m_lodDistance * (tile->getStep() >> 1))
             {
-				for (i32 column = 0; column < m_columns; column++)
+                for (i32 i = 0; i < 4; i++)
                 {
-                    VertexFormat vert;
-                    vert.m_position = Vector3(row * m_gridSpacing, getHeight(row, column), column * m_gridSpacing);
-                    vert.m_uv = Vector2(row, column);
-                    vert.m_normal = getNormal(row, column);
-                    vert.m_layerIndices = Color(0, 1, 2, 3).getABGR();
-
-                    float weight = Math::IntervalRandom(0.f, 1.f);
-                    vert.m_layerWeights = Vector4(getWeight(row, column, 0), getWeight(row, column, 1), getWeight(row, column, 2), getWeight(row, column, 3));
-                    oVertices.emplace_back(vert);
+                    if (tile->getChild(i))
+                        selectTile(tile->getChild(i), eye);
                 }
+
+                return;
             }
-            
-            // index buffer
-			i32 rowLength = m_rows - 1;
-			i32 columnLength = m_columns - 1;
-			for (i32 row = 0; row < rowLength; row++)
-			{
-				for (i32 column = 0; column < columnLength; column++)
+        }
+
+        tile->submitToRenderQueue(m_frame);
+    }
+    
+    void Terrain::updateDirtyRegion()
+    {
+        if (!m_dirtyRect.isEmpty() && m_rootTile)
+        {
+            // normals read the neighbours of a changed height
+            TerrainRect rect(Math::Max(m_dirtyRect.m_minX - 1, 0), Math::Max(m_dirtyRect.m_minZ - 1, 0), Math::Min(m_dirtyRect.m_maxX + 1, m_columns - 1), Math::Min(m_dirtyRect.m_maxZ + 1, m_rows - 1));
+            m_rootTile->updateRegion(rect);
+            m_localAABB = m_rootTile->getLocalAABB();
+
+            for (TerrainTile* tile : m_tiles)
+            {
+                if (tile->getRect().isOverlap(rect))
                 {
-                    i32 indexLeftTop = row * m_columns + column;
-                    i32 indexRightTop = indexLeftTop + 1;
-                    i32 indexLeftBottom = indexLeftTop + m_columns;
-                    i32 indexRightBottom = indexRightTop + m_columns;
-                    
-                    oIndices.emplace_back(indexLeftTop);
-                    oIndices.emplace_back(indexRightBottom);
-                    oIndices.emplace_back(indexRightTop);
-                    oIndices.emplace_back(indexLeftTop);
-                    oIndices.emplace_back(indexLeftBottom);
-                    oIndices.emplace_back(indexRightBottom);
+                    AABB worldAABB = tile->getLocalAABB().transform(m_tileMatrix);
+                    m_tileBvh.moveProxy(tile->getProxyId(), worldAABB, worldAABB.getCenter() - tile->getWorldAABB().getCenter());
+                    tile->setWorldAABB(worldAABB);
                 }
             }
+
+            if (m_isCompact)
+                updateTextures(rect.m_minX, rect.m_minZ, rect.m_maxX - rect.m_minX + 1, rect.m_maxZ - rect.m_minZ + 1);
         }
+
+        m_dirtyRect = TerrainRect();
     }
-    
-    void Terrain::updateMeshBuffer()
+
+    void Terrain::buildPatchMesh()
     {
-		// create mesh
-		if (!m_mesh) m_mesh = Mesh::create(true, true);
+        if (!m_patchMesh)
+        {
+            // x and z are the patch column and row, y is one on the skirt
+            vector<Vector3>::type vertices;
+            IndiceArray indices;
+            IndiceArray border;
+            for (i32 i = 0; i <= TerrainTile::Size; i++)
+            {
+                for (i32 j = 0; j <= TerrainTile::Size; j++)
+                    vertices.emplace_back(Vector3(float(i), 0.f, float(j)));
+            }
 
-		// update data
-        VertexArray    vertices;
-        IndiceArray    indices;
-        buildMeshData(vertices, indices);
-        
-        MeshVertexFormat define;
-        define.m_isUseNormal = true;
-        define.m_isUseUV = true;
-        define.m_isUseBlendingData = true;
-        
-        m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(ui32), indices.data());
-        m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+            TerrainTile::buildIndices(TerrainTile::Size + 1, TerrainTile::Size + 1, indices, border);
+            for (Word index : border)
+                vertices.emplace_back(vertices[index] + Vector3::UNIT_Y);
+
+            MeshVertexFormat define;
+            m_patchMesh = Mesh::create(false, false);
+            m_patchMesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
+            m_patchMesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+        }
+    }
+
+    void Terrain::updateTextures(i32 x, i32 z, i32 width, i32 height)
+    {
+        // rgba8 is the format every device samples in the vertex shader
+        vector<Byte>::type heights(width * height * 4);
+        vector<Byte>::type weights(width * height * 4);
+        for (i32 row = 0; row < height; row++)
+        {
+            for (i32 column = 0; column < width; column++)
+            {
+                i32 sampleX = x + column;
+                i32 sampleZ = z + row;
+                Byte* heightTexel = &heights[(row * width + column) * 4];
+                Byte* weightTexel = &weights[(row * width + column) * 4];
+
+                ui32 value = ui32(Math::Clamp(m_heights[sampleZ * m_columns + sampleX] * 0.5f + 0.5f, 0.f, 1.f) * 65535.f + 0.5f);
+                Vector3 normal = getNormal(sampleX, sampleZ);
+                heightTexel[0] = Byte(value >> 8);
+                heightTexel[1] = Byte(value & 0xff);
+                heightTexel[2] = Byte((normal.x * 0.5f + 0.5f) * 255.f + 0.5f);
+                heightTexel[3] = Byte((normal.z * 0.5f + 0.5f) * 255.f + 0.5f);
+
+                for (i32 i = 0; i < 4; i++)
+                    weightTexel[i] = Byte(Math::Clamp(getWeight(sampleX, sampleZ, i), 0.f, 1.f) * 255.f + 0.5f);
+            }
+        }
 
-        m_localAABB = m_mesh->getLocalBox();
+        ui32 size = ui32(heights.size());
+        if (!m_heightTexture || m_heightTexture->getWidth() != ui32(m_columns) || m_heightTexture->getHeight() != ui32(m_rows))
+        {
+            m_heightTexture = Renderer::instance()->createTexture2D();
+            m_heightTexture->updateTexture2D(PF_RGBA8_UNORM, Texture::TU_DYNAMIC, width, height, heights.data(), size);
+
+            m_weightTexture = Renderer::instance()->createTexture2D();
+            m_weightTexture->updateTexture2D(PF_RGBA8_UNORM, Texture::TU_DYNAMIC, width, height, weights.data(), size);
+        }
+        else
+        {
+            Rect rect(float(x), float(z), float(x + width), float(z + height));
+            m_heightTexture->updateSubTex2D(0, rect, heights.data(), size);
+            m_weightTexture->updateSubTex2D(0, rect, weights.data(), size);
+        }
+    }
+
+    ShaderProgramPtr Terrain::getCompactShader()
+    {
+        String shaderVirtualPath = "_echo_terrain_compact_shader_";
+        ShaderProgramPtr shader = ECHO_DOWN_CAST<ShaderProgram*>(ShaderProgram::get(shaderVirtualPath));
+        if (!shader)
+        {
+            shader = ECHO_CREATE_RES(ShaderProgram);
+            shader->setBlendMode("Opaque");
+
+            DepthStencilState::DepthStencilDesc depthDesc;
+            depthDesc.bDepthEnable = true;
+            depthDesc.bWriteDepth = true;
+            DepthStencilState* depthState = Renderer::instance()->createDepthStencilState(depthDesc);
+            shader->setDepthState(depthState);
+
+            shader->setCullMode("CULL_NONE");
+
+            shader->setPath(shaderVirtualPath);
+            shader->setType("glsl");
+            shader->setVsCode(g_terrainVsCode);
+            shader->setPsCode(g_terrainPsCode);
+        }
+
+        return shader;
+    }
+
+    void* Terrain::getGlobalUniformValue(const String& name)
+    {
+        if (name == "u_TerrainParams")
+        {
+            m_terrainParams = Vector4(float(m_columns), float(m_rows), float(m_gridSpacing), m_heightRange);
+            return &m_terrainParams;
+        }
+
+        return Render::getGlobalUniformValue(name);
     }
     
     void Terrain::clear()
@@ -203,18 +518,20 @@ namespace Echo
     
     void Terrain::clearRenderable()
     {
-        EchoSafeRelease(m_renderable);
-        m_mesh.reset();
+        for (TerrainTile* tile : m_tiles)
+            m_tileBvh.destroyProxy(tile->getProxyId());
+
+        EchoSafeDeleteContainer(m_tiles, TerrainTile);
+        m_rootTile = nullptr;
     }
     
     float Terrain::getHeight(i32 x, i32 z)
     {
-        if(m_heightmapImage)
+        if(!m_heights.empty())
         {
             i32 column = Math::Clamp(x, 0, m_columns-1);
             i32 row = Math::Clamp(z, 0, m_rows-1);
-            Color color = m_heightmapImage->getColor(column, row, 0);
-            float height = (color.r * 2.f - 1.f) * m_heightRange;
+            float height = m_heights[row * m_columns + column] * m_heightRange;
             
             return height;
         }
@@ -222,6 +539,57 @@ namespace Echo
         return 0.f;
     }
     
+    void Terrain::setHeight(i32 x, i32 z, float height)
+    {
+        if (x >= 0 && x < m_columns && z >= 0 && z < m_rows && !m_heights.empty())
+        {
+            m_heights[z * m_columns + x] = Math::Clamp(height / m_heightRange, -1.f, 1.f);
+            m_dirtyRect.merge(TerrainRect(x, z, x, z));
+        }
+    }
+
+    void Terrain::setWeight(i32 x, i32 z, i32 index, float weight)
+    {
+        Image* image = index >= 0 && index < i32(m_layerImages.size()) ? m_layerImages[index] : nullptr;
+        if (image && x >= 0 && x < m_columns && z >= 0 && z < m_rows)
+        {
+            // weights live in the red channel of the layer image
+            Color color = image->getColor(x, z, 0);
+            color.r = Math::Clamp(weight, 0.f, 1.f);
+
+            ui32 pixelSize = PixelUtil::GetPixelSize(image->getPixelFormat());
+            PixelUtil::PackColor(color, image->getPixelFormat(), image->getData() + (z * image->getWidth() + x) * pixelSize);
+            m_dirtyRect.merge(TerrainRect(x, z, x, z));
+        }
+    }
+
+    void Terrain::brushHeight(i32 centerX, i32 centerZ, i32 radius, float amount)
+    {
+        radius = Math::Max(radius, 1);
+        for (i32 z = centerZ - radius; z <= centerZ + radius; z++)
+        {
+            for (i32 x = centerX - radius; x <= centerX + radius; x++)
+            {
+                float distance = Vector2(float(x - centerX), float(z - centerZ)).len() / radius;
+                if (distance < 1.f)
+                {
+                    float falloff = (1.f - distance) * (1.f - distance);
+                    setHeight(x, z, getHeight(x, z) + amount * falloff);
+                }
+            }
+        }
+    }
+
+    void Terrain::buildVertex(i32 x, i32 z, VertexFormat& oVert)
+    {
+        float spacing = float(m_gridSpacing);
+        oVert.m_position = Vector3(x * spacing, getHeight(x, z), z * spacing);
+        oVert.m_uv = Vector2(float(x), float(z));
+        oVert.m_normal = getNormal(x, z);
+        oVert.m_layerIndices = Color(0, 1, 2, 3).getABGR();
+        oVert.m_layerWeights = Vector4(getWeight(x, z, 0), getWeight(x, z, 1), getWeight(x, z, 2), getWeight(x, z, 3));
+    }
+
     Vector3 Terrain::getNormal( i32 x, i32 z)
     {
         if(m_heightmapImage)
@@ -5,6 +5,7 @@
 #include "engine/core/render/base/Material.h"
 #include "engine/core/render/base/Renderable.h"
 #include "engine/core/render/base/image/Image.h"
+#include "engine/core/scene/bvh.h"
 #include "terrain_tile.h"
 
 namespace Echo
@@ -24,7 +25,7 @@ namespace Echo
             Vector4        m_layerWeights;
         };
         typedef vector<VertexFormat>::type  VertexArray;
-        typedef vector<ui32>::type          IndiceArray;
+        typedef vector<Word>::type          IndiceArray;
         
     public:
         Terrain();
@@ -45,10 +46,27 @@ namespace Echo
 		// grid spacing
 		i32 getGridSpacing() const { return m_gridSpacing; }
 		void setGridSpacing(i32 gridSpacing);
+
+		// distance up to which full detail tiles are drawn, doubles with every level
+		float getLodDistance() const { return m_lodDistance; }
+		void setLodDistance(float distance);
         
         // material
         Material* getMaterial() const { return m_material; }
         void setMaterial( Object* material);
+
+		// compact mode, tiles draw one shared grid patch and the vertex shader
+		// reads heights and normals from u_HeightTexture, splat weights are in u_WeightTexture
+		bool isCompact() const { return m_isCompact; }
+		void setCompact(bool isCompact);
+
+		// shared patch and textures of compact mode
+		MeshPtr getPatchMesh() { return m_patchMesh; }
+		Texture* getHeightTexture() { return m_heightTexture; }
+		Texture* getWeightTexture() { return m_weightTexture; }
+
+		// terrain params uniform of compact mode
+		virtual void* getGlobalUniformValue(const String& name) override;
         
         // get height
         float getHeight(i32 x, i32 z);
@@ -58,6 +76,16 @@ namespace Echo
 
         // get weight
         float getWeight(i32 x, i32 z, i32 index);
+
+        // edit, only the changed region is rebuilt in the next update
+        void setHeight(i32 x, i32 z, float height);
+        void setWeight(i32 x, i32 z, i32 index, float weight);
+
+        // brush, raises a round area with a smooth falloff, negative amount lowers it
+        void brushHeight(i32 centerX, i32 centerZ, i32 radius, float amount);
+
+        // vertex of mesh mode
+        void buildVertex(i32 x, i32 z, VertexFormat& oVert);
         
     protected:
         // build drawable
@@ -67,11 +95,24 @@ namespace Echo
         // update
         virtual void update_self() override;
         
-        // update vertex buffer
-        void updateMeshBuffer();
-        
-        // build mesh data by drawables data
-        void buildMeshData(VertexArray& oVertices, IndiceArray& oIndices);
+        // build tile quadtree
+        void buildTiles();
+        TerrainTile* buildTile(i32 level, i32 x, i32 z);
+        void updateTileProxies();
+
+        // cull tiles against the 3d camera and submit them at their level
+        void submitTiles();
+        void selectTile(TerrainTile* tile, const Vector3& eye);
+
+        // apply edits of the dirty region
+        void updateDirtyRegion();
+
+        // compact mode data
+        void buildPatchMesh();
+        void updateTextures(i32 x, i32 z, i32 width, i32 height);
+
+        // shader reading heights from textures
+        static ShaderProgramPtr getCompactShader();
         
         // clear
         void clear();
@@ -81,13 +122,24 @@ namespace Echo
         ResourcePath            m_dataPath = ResourcePath("", "");
         Image*                  m_heightmapImage = nullptr;
         vector<Image*>::type    m_layerImages;
+        vector<float>::type     m_heights;
 		float					m_heightRange = 256.f;
 		i32						m_gridSpacing = 1;
-        MeshPtr              m_mesh;
+		float					m_lodDistance = 128.f;
         MaterialPtr             m_material;
-        Renderable*             m_renderable = nullptr;
+        bool                    m_isDefaultMaterial = false;
+		bool					m_isCompact = false;
+		MeshPtr					m_patchMesh;
+		TexturePtr				m_heightTexture;
+		TexturePtr				m_weightTexture;
+		Vector4					m_terrainParams;
         i32                     m_columns = 0;
         i32                     m_rows = 0;
-		//TerrainTiles			m_tiles;
+		TerrainTiles			m_tiles;
+		TerrainTile*			m_rootTile = nullptr;
+		Bvh						m_tileBvh;
+		Matrix4					m_tileMatrix;
+		ui32					m_frame = 0;
+		TerrainRect				m_dirtyRect;
     };
 }
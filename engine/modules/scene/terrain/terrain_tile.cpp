@@ -3,13 +3,304 @@
 
 namespace Echo
 {
-	TerrainTile::TerrainTile()
+	TerrainTile::TerrainTile(Terrain* terrain, i32 level, i32 x, i32 z)
+		: m_terrain(terrain)
+		, m_level(level)
+		, m_x(x)
+		, m_z(z)
 	{
-
 	}
 
 	TerrainTile::~TerrainTile()
 	{
+		releaseRenderable();
+	}
+
+	TerrainRect TerrainTile::getRect() const
+	{
+		i32 step = getStep();
+		return TerrainRect(m_x, m_z, Math::Min(m_x + Size * step, m_terrain->getColumns() - 1), Math::Min(m_z + Size * step, m_terrain->getRows() - 1));
+	}
+
+	void TerrainTile::getGridSize(i32& columns, i32& rows) const
+	{
+		i32 step = getStep();
+		TerrainRect rect = getRect();
+		columns = (rect.m_maxX - m_x + step - 1) / step + 1;
+		rows = (rect.m_maxZ - m_z + step - 1) / step + 1;
+	}
+
+	void TerrainTile::updateBounds()
+	{
+		m_localAABB.reset();
+		if (isLeaf())
+		{
+			TerrainRect rect = getRect();
+			i32 xEnd = rect.m_maxX;
+			i32 zEnd = rect.m_maxZ;
+			float minHeight = m_terrain->getHeight(m_x, m_z);
+			float maxHeight = minHeight;
+			for (i32 z = m_z; z <= zEnd; z++)
+			{
+				for (i32 x = m_x; x <= xEnd; x++)
+				{
+					float height = m_terrain->getHeight(x, z);
+					minHeight = Math::Min(minHeight, height);
+					maxHeight = Math::Max(maxHeight, height);
+				}
+			}
+
+			float spacing = float(m_terrain->getGridSpacing());
+			m_localAABB.addPoint(Vector3(m_x * spacing, minHeight, m_z * spacing));
+			m_localAABB.addPoint(Vector3(xEnd * spacing, maxHeight, zEnd * spacing));
+		}
+		else
+		{
+			for (TerrainTile* child : m_children)
+			{
+				if (child)
+				{
+					child->updateBounds();
+					m_localAABB.unionBox(child->getLocalAABB());
+				}
+			}
+		}
+	}
+
+	void TerrainTile::updateRegion(const TerrainRect& rect)
+	{
+		if (!getRect().isOverlap(rect))
+			return;
+
+		if (isLeaf())
+		{
+			updateBounds();
+		}
+		else
+		{
+			m_localAABB.reset();
+			for (TerrainTile* child : m_children)
+			{
+				if (child)
+				{
+					child->updateRegion(rect);
+					m_localAABB.unionBox(child->getLocalAABB());
+				}
+			}
+		}
+
+		if (m_mesh)
+			updateMesh(rect);
+
+		if (m_material)
+			updateTileParams();
+	}
+
+	void TerrainTile::submitToRenderQueue(ui32 frame)
+	{
+		if (!m_renderable)
+		{
+			if (m_terrain->isCompact())
+			{
+				buildMaterial();
+				m_renderable = Renderable::create(m_terrain->getPatchMesh(), m_material, m_terrain);
+			}
+			else
+			{
+				buildMesh();
+				m_renderable = Renderable::create(m_mesh, m_terrain->getMaterial(), m_terrain);
+			}
+		}
+
+		m_renderable->submitToRenderQueue();
+		m_drawFrame = frame;
+	}
+
+	void TerrainTile::releaseUnused(ui32 frame)
+	{
+		if (m_renderable && frame - m_drawFrame > KeepFrames)
+			releaseRenderable();
+	}
+
+	void TerrainTile::releaseRenderable()
+	{
+		EchoSafeRelease(m_renderable);
+		m_mesh.reset();
+		m_material.reset();
+	}
+
+	float TerrainTile::getSkirtDepth() const
+	{
+		return Math::Max(m_localAABB.vMax.y - m_localAABB.vMin.y, float(m_terrain->getGridSpacing() * getStep()));
+	}
+
+	void TerrainTile::buildIndices(i32 columns, i32 rows, vector<Word>::type& oIndices, vector<Word>::type& oBorder)
+	{
+		for (i32 i = 0; i < columns - 1; i++)
+		{
+			for (i32 j = 0; j < rows - 1; j++)
+			{
+				Word indexLeftTop = Word(i * rows + j);
+				Word indexRightTop = indexLeftTop + 1;
+				Word indexLeftBottom = indexLeftTop + rows;
+				Word indexRightBottom = indexRightTop + rows;
+
+				oIndices.emplace_back(indexLeftTop);
+				oIndices.emplace_back(indexRightBottom);
+				oIndices.emplace_back(indexRightTop);
+				oIndices.emplace_back(indexLeftTop);
+				oIndices.emplace_back(indexLeftBottom);
+				oIndices.emplace_back(indexRightBottom);
+			}
+		}
+
+		// walk the border so every skirt wall faces outwards
+		for (i32 j = 0; j < rows - 1; j++)				oBorder.emplace_back(Word(j));
+		for (i32 i = 0; i < columns - 1; i++)			oBorder.emplace_back(Word(i * rows + rows - 1));
+		for (i32 j = rows - 1; j > 0; j--)				oBorder.emplace_back(Word((columns - 1) * rows + j));
+		for (i32 i = columns - 1; i > 0; i--)			oBorder.emplace_back(Word(i * rows));
+
+		Word skirtStart = Word(columns * rows);
+		for (size_t i = 0; i < oBorder.size(); i++)
+		{
+			size_t next = (i + 1) % oBorder.size();
+			oIndices.emplace_back(oBorder[i]);
+			oIndices.emplace_back(oBorder[next]);
+			oIndices.emplace_back(Word(skirtStart + next));
+			oIndices.emplace_back(oBorder[i]);
+			oIndices.emplace_back(Word(skirtStart + next));
+			oIndices.emplace_back(Word(skirtStart + i));
+		}
+	}
+
+	void TerrainTile::buildMesh()
+	{
+		i32 step = getStep();
+		i32 columns, rows;
+		getGridSize(columns, rows);
+		TerrainRect rect = getRect();
+
+		Terrain::VertexArray vertices;
+		Terrain::IndiceArray indices;
+		vertices.reserve(columns * rows + 2 * (columns + rows));
+
+		// grid, the last row and column end on the terrain border
+		for (i32 i = 0; i < columns; i++)
+		{
+			i32 x = Math::Min(m_x + i * step, rect.m_maxX);
+			for (i32 j = 0; j < rows; j++)
+			{
+				Terrain::VertexFormat vert;
+				m_terrain->buildVertex(x, Math::Min(m_z + j * step, rect.m_maxZ), vert);
+				vertices.emplace_back(vert);
+			}
+		}
+
+		// skirt vertices hang below the border ones
+		Terrain::IndiceArray border;
+		buildIndices(columns, rows, indices, border);
+
+		float skirtDepth = getSkirtDepth();
+		for (Word index : border)
+		{
+			Terrain::VertexFormat vert = vertices[index];
+			vert.m_position.y -= skirtDepth;
+			vertices.emplace_back(vert);
+		}
+
+		MeshVertexFormat define;
+		define.m_isUseNormal = true;
+		define.m_isUseUV = true;
+		define.m_isUseBlendingData = true;
+
+		if (!m_mesh) m_mesh = Mesh::create(true, true);
+		m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
+		m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+	}
+
+	void TerrainTile::buildMaterial()
+	{
+		// copy of the terrain material with the tile placement on top
+		Material* source = m_terrain->getMaterial();
+		m_material = ECHO_CREATE_RES(Material);
+		m_material->setShaderPath(source->getShaderPath());
+		for (auto& it : source->GetAllUniforms())
+		{
+			Material::UniformValue* uniform = m_material->getUniform(it.first);
+			if (uniform && it.second->getTexture())
+				uniform->setTexture(it.second->getTexture());
+			else if (uniform && it.second->getValue())
+				uniform->setValue(it.second->getValue());
+		}
+
+		Material::UniformValue* heightTexture = m_material->getUniform("u_HeightTexture");
+		if (heightTexture)
+			heightTexture->setTexture(m_terrain->getHeightTexture());
+
+		Material::UniformValue* weightTexture = m_material->getUniform("u_WeightTexture");
+		if (weightTexture)
+			weightTexture->setTexture(m_terrain->getWeightTexture());
+
+		updateTileParams();
+	}
+
+	void TerrainTile::updateTileParams()
+	{
+		Material::UniformValue* tileParams = m_material->getUniform("u_TileParams");
+		if (tileParams)
+		{
+			Vector4 params(float(m_x), float(m_z), float(getStep()), getSkirtDepth());
+			tileParams->setValue(&params);
+		}
+	}
+
+	void TerrainTile::updateMesh(const TerrainRect& rect)
+	{
+		i32 step = getStep();
+		i32 columns, rows;
+		getGridSize(columns, rows);
+		TerrainRect tileRect = getRect();
+
+		// vertices are rewritten in place, only the changed ranges are uploaded
+		MeshVertexData& vertexData = m_mesh->getVertexData();
+		Terrain::VertexFormat* vertices = (Terrain::VertexFormat*)vertexData.getVertices();
+
+		// grid vertices on changed samples, columns are contiguous
+		i32 firstColumn = columns;
+		i32 lastColumn = -1;
+		for (i32 i = 0; i < columns; i++)
+		{
+			i32 x = Math::Min(m_x + i * step, tileRect.m_maxX);
+			if (x < rect.m_minX || x > rect.m_maxX)
+				continue;
+
+			for (i32 j = 0; j < rows; j++)
+			{
+				i32 z = Math::Min(m_z + j * step, tileRect.m_maxZ);
+				if (z >= rect.m_minZ && z <= rect.m_maxZ)
+					m_terrain->buildVertex(x, z, vertices[i * rows + j]);
+			}
+
+			firstColumn = Math::Min(firstColumn, i);
+			lastColumn = i;
+		}
+
+		// the skirt depth follows the bounds, so the whole skirt is rewritten
+		Terrain::IndiceArray indices;
+		Terrain::IndiceArray border;
+		buildIndices(columns, rows, indices, border);
+
+		float skirtDepth = getSkirtDepth();
+		for (size_t i = 0; i < border.size(); i++)
+		{
+			Terrain::VertexFormat& vert = vertices[columns * rows + i];
+			vert = vertices[border[i]];
+			vert.m_position.y -= skirtDepth;
+		}
+
+		if (lastColumn >= firstColumn)
+			m_mesh->updateVertexRange(ui32(firstColumn * rows), ui32((lastColumn - firstColumn + 1) * rows));
 
+		m_mesh->updateVertexRange(ui32(columns * rows), ui32(border.size()));
 	}
 }
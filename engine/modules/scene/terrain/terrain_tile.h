@@ -1,16 +1,142 @@
 #pragma once
 
+#include "engine/core/geom/AABB.h"
+#include "engine/core/render/base/mesh/mesh.h"
+#include "engine/core/render/base/Renderable.h"
+#include "engine/core/render/base/Material.h"
+
 namespace Echo
 {
+	// inclusive range of heightmap samples
+	struct TerrainRect
+	{
+		i32		m_minX = 0;
+		i32		m_minZ = 0;
+		i32		m_maxX = -1;
+		i32		m_maxZ = -1;
+
+		TerrainRect() {}
+		TerrainRect(i32 minX, i32 minZ, i32 maxX, i32 maxZ) : m_minX(minX), m_minZ(minZ), m_maxX(maxX), m_maxZ(maxZ) {}
+
+		// is empty
+		bool isEmpty() const { return m_maxX < m_minX || m_maxZ < m_minZ; }
+
+		// grow to contain another rect
+		void merge(const TerrainRect& rect)
+		{
+			if (isEmpty())
+			{
+				*this = rect;
+			}
+			else if (!rect.isEmpty())
+			{
+				m_minX = Math::Min(m_minX, rect.m_minX);
+				m_minZ = Math::Min(m_minZ, rect.m_minZ);
+				m_maxX = Math::Max(m_maxX, rect.m_maxX);
+				m_maxZ = Math::Max(m_maxZ, rect.m_maxZ);
+			}
+		}
+
+		// is overlap
+		bool isOverlap(const TerrainRect& rect) const
+		{
+			return m_minX <= rect.m_maxX && rect.m_minX <= m_maxX && m_minZ <= rect.m_maxZ && rect.m_minZ <= m_maxZ;
+		}
+	};
+
+	// quadtree node of the terrain. every tile draws the same Size x Size
+	// grid, a tile of level n covers 2^n times the samples of a leaf
 	class Terrain;
-    class TerrainTile
-    {
-    public:
-		TerrainTile();
+	class TerrainTile
+	{
+	public:
+		// quads per tile edge
+		static const i32 Size = 64;
+
+		// frames a tile keeps its mesh after it was last drawn
+		static const ui32 KeepFrames = 120;
+
+	public:
+		TerrainTile(Terrain* terrain, i32 level, i32 x, i32 z);
 		~TerrainTile();
 
+		// level, 0 is the most detailed
+		i32 getLevel() const { return m_level; }
+		i32 getStep() const { return 1 << m_level; }
+
+		// is leaf
+		bool isLeaf() const { return m_level == 0; }
+
+		// children, null where the tile is outside of the terrain
+		TerrainTile* getChild(i32 index) { return m_children[index]; }
+		void setChild(i32 index, TerrainTile* child) { m_children[index] = child; }
+
+		// samples covered by the tile
+		TerrainRect getRect() const;
+
+		// bounds, leaves read the heights, parents merge their children
+		void updateBounds();
+
+		// refresh bounds and built data after the samples in rect changed
+		void updateRegion(const TerrainRect& rect);
+		const AABB& getLocalAABB() const { return m_localAABB; }
+
+		// world bounds used by culling and lod
+		const AABB& getWorldAABB() const { return m_worldAABB; }
+		void setWorldAABB(const AABB& aabb) { m_worldAABB = aabb; }
+
+		// bvh proxy
+		i32 getProxyId() const { return m_proxyId; }
+		void setProxyId(i32 proxyId) { m_proxyId = proxyId; }
+
+		// frame the tile was last found in the frustum
+		ui32 getVisibleFrame() const { return m_visibleFrame; }
+		void setVisibleFrame(ui32 frame) { m_visibleFrame = frame; }
+
+		// submit, builds the mesh at first use
+		void submitToRenderQueue(ui32 frame);
+
+		// release renderable that was not drawn for a while
+		void releaseUnused(ui32 frame);
+		void releaseRenderable();
+
+		// indices of a columns x rows grid followed by its skirt, the skirt
+		// vertices are expected after the grid in the order of oBorder
+		static void buildIndices(i32 columns, i32 rows, vector<Word>::type& oIndices, vector<Word>::type& oBorder);
+
+	private:
+		// vertices per tile edge, less where the terrain ends
+		void getGridSize(i32& columns, i32& rows) const;
+
+		// build mesh data, a grid plus a skirt hiding cracks to coarser neighbours
+		void buildMesh();
+
+		// rewrite the vertices inside rect, the skirt follows the border
+		void updateMesh(const TerrainRect& rect);
+
+		// tile placement of compact mode
+		void updateTileParams();
+
+		// compact mode draws the shared patch, the material tells where
+		void buildMaterial();
+
+		// deep enough to cover the gap to a neighbour drawn at another level
+		float getSkirtDepth() const;
+
 	private:
-		//Terrain*	m_terrain;
-    };
-	typedef map<String, TerrainTile*> TerrainTiles;
+		Terrain*		m_terrain = nullptr;
+		i32				m_level = 0;
+		i32				m_x = 0;
+		i32				m_z = 0;
+		TerrainTile*	m_children[4] = { nullptr, nullptr, nullptr, nullptr };
+		AABB			m_localAABB;
+		AABB			m_worldAABB;
+		i32				m_proxyId = -1;
+		MeshPtr			m_mesh;
+		MaterialPtr		m_material;
+		Renderable*		m_renderable = nullptr;
+		ui32			m_visibleFrame = 0;
+		ui32			m_drawFrame = 0;
+	};
+	typedef vector<TerrainTile*>::type TerrainTiles;
 }
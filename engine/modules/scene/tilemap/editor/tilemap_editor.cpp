@@ -37,6 +37,25 @@ namespace Echo
 
 				m_gizmo->clear();
 
+				if (tileMap->getTileShape().getIdx() != 0)
+				{
+					// outline every tile, large maps only show their first tiles
+					i32 width = Math::Min(tileMap->getWidth(), 128);
+					i32 height = Math::Min(tileMap->getHeight(), 128);
+					for (i32 y = 0; y < height; y++)
+					{
+						for (i32 x = 0; x < width; x++)
+						{
+							vector<Vector3>::type corners = tileMap->getTileCorners(x, y);
+							for (size_t i = 0; i < corners.size(); i++)
+								m_gizmo->drawLine(corners[i] * worldMatrix, corners[(i + 1) % corners.size()] * worldMatrix, Color(0.f, 0.f, 1.f, 0.65f));
+						}
+					}
+
+					m_gizmo->update(Engine::instance()->getFrameTime(), true);
+					return;
+				}
+
 				// draw rows
 				for (i32 i = 0; i <= tileMap->getHeight(); i++)
 				{
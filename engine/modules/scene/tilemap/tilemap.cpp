@@ -5,18 +5,22 @@
 #include "base/ShaderProgram.h"
 #include "engine/core/main/Engine.h"
 #include "engine/modules/ui/font/font_library.h"
+#include "engine/modules/effect/sprite.h"
 
 namespace Echo
 {
     TileMap::TileMap()
-    : Node()
+    : Render()
     {
+        setRenderType("2d");
+        resize(m_width, m_height);
     }
-    
+
     TileMap::~TileMap()
     {
+        clearChunks();
     }
-    
+
     void TileMap::bindMethods()
     {
         CLASS_BIND_METHOD(TileMap, getTileShape, DEF_METHOD("getTileShape"));
@@ -32,8 +36,14 @@ namespace Echo
 		CLASS_BIND_METHOD(TileMap, isFlipY, DEF_METHOD("isFlipY"));
 		CLASS_BIND_METHOD(TileMap, setFlipY, DEF_METHOD("setFlipY"));
         CLASS_BIND_METHOD(TileMap, getTileCenter, DEF_METHOD("getTileCenter"));
+        CLASS_BIND_METHOD(TileMap, pickTile, DEF_METHOD("pickTile"));
         CLASS_BIND_METHOD(TileMap, getTile, DEF_METHOD("getTile"));
         CLASS_BIND_METHOD(TileMap, setTile, DEF_METHOD("setTile"));
+        CLASS_BIND_METHOD(TileMap, getTileNodePath, DEF_METHOD("getTileNodePath"));
+        CLASS_BIND_METHOD(TileMap, getPalette, DEF_METHOD("getPalette"));
+        CLASS_BIND_METHOD(TileMap, setPalette, DEF_METHOD("setPalette"));
+        CLASS_BIND_METHOD(TileMap, getTileData, DEF_METHOD("getTileData"));
+        CLASS_BIND_METHOD(TileMap, setTileData, DEF_METHOD("setTileData"));
 
         CLASS_REGISTER_PROPERTY(TileMap, "TileShape", Variant::Type::StringOption, "getTileShape", "setTileShape");
         CLASS_REGISTER_PROPERTY(TileMap, "Width", Variant::Type::Int, "getWidth", "setWidth");
@@ -41,11 +51,44 @@ namespace Echo
         CLASS_REGISTER_PROPERTY(TileMap, "TileSize", Variant::Type::Vector2, "getTileSize", "setTileSize");
         CLASS_REGISTER_PROPERTY(TileMap, "FlipX", Variant::Type::Bool, "isFlipX", "setFlipX");
         CLASS_REGISTER_PROPERTY(TileMap, "FlipY", Variant::Type::Bool, "isFlipY", "setFlipY");
+        CLASS_REGISTER_PROPERTY(TileMap, "Palette", Variant::Type::String, "getPalette", "setPalette");
+        CLASS_REGISTER_PROPERTY(TileMap, "TileData", Variant::Type::String, "getTileData", "setTileData");
     }
 
     void TileMap::setTileShape(const StringOption& option)
     {
         m_tileShape.setValue(option.getValue());
+        m_isChunksDirty = true;
+    }
+
+    void TileMap::setWidth(i32 width)
+    {
+        if (m_width != width)
+            resize(width, m_height);
+    }
+
+    void TileMap::setHeight(i32 height)
+    {
+        if (m_height != height)
+            resize(m_width, height);
+    }
+
+    void TileMap::setTileSize(const Vector2& tileSize)
+    {
+        m_tileSize = tileSize;
+        m_isChunksDirty = true;
+    }
+
+    void TileMap::setFlipX(bool isFlipX)
+    {
+        m_isFlipX = isFlipX;
+        m_isChunksDirty = true;
+    }
+
+    void TileMap::setFlipY(bool isFlipY)
+    {
+        m_isFlipY = isFlipY;
+        m_isChunksDirty = true;
     }
 
     Vector3 TileMap::flip(const Vector3& pos)
@@ -62,12 +105,260 @@ namespace Echo
 
     Vector3 TileMap::getTileCenter(i32 x, i32 y)
     {
-        return flip(Vector3( (x+0.5)*getTileSize().x, (y+0.5)*getTileSize().y, 0.f));
+        const Vector2& size = getTileSize();
+        switch (m_tileShape.getIdx())
+        {
+        case 1:  return flip(Vector3((x - y) * 0.5f * size.x, (x + y + 1) * 0.5f * size.y, 0.f));
+        case 2:  return flip(Vector3((x + 0.5f * (y & 1) + 0.5f) * size.x, (y * 0.75f + 0.5f) * size.y, 0.f));
+        default: return flip(Vector3( (x+0.5)*getTileSize().x, (y+0.5)*getTileSize().y, 0.f));
+        }
+    }
+
+    i32 TileMap::getDrawRow(i32 x, i32 y) const
+    {
+        // larger screen y is further back, flipping y turns the order around
+        i32 row = m_tileShape.getIdx() == 1 ? x + y : y;
+        i32 lastRow = m_tileShape.getIdx() == 1 ? m_width + m_height - 2 : m_height - 1;
+        return m_isFlipY ? row : lastRow - row;
+    }
+
+    vector<Vector3>::type TileMap::getTileCorners(i32 x, i32 y)
+    {
+        Vector3 center = getTileCenter(x, y);
+        float hw = getTileSize().x * 0.5f;
+        float hh = getTileSize().y * 0.5f;
+
+        vector<Vector3>::type corners;
+        switch (m_tileShape.getIdx())
+        {
+        case 1:
+            corners = { Vector3(0.f, -hh, 0.f), Vector3(hw, 0.f, 0.f), Vector3(0.f, hh, 0.f), Vector3(-hw, 0.f, 0.f) };
+            break;
+        case 2:
+            corners = { Vector3(0.f, -hh, 0.f), Vector3(hw, -hh * 0.5f, 0.f), Vector3(hw, hh * 0.5f, 0.f), Vector3(0.f, hh, 0.f), Vector3(-hw, hh * 0.5f, 0.f), Vector3(-hw, -hh * 0.5f, 0.f) };
+            break;
+        default:
+            corners = { Vector3(-hw, -hh, 0.f), Vector3(hw, -hh, 0.f), Vector3(hw, hh, 0.f), Vector3(-hw, hh, 0.f) };
+            break;
+        }
+
+        for (Vector3& corner : corners)
+            corner += center;
+
+        return corners;
+    }
+
+    void TileMap::localToTile(const Vector3& localPos, i32& x, i32& y)
+    {
+        Vector3 pos = flip(localPos);
+        float u = pos.x / getTileSize().x;
+        float v = pos.y / getTileSize().y;
+        switch (m_tileShape.getIdx())
+        {
+        case 1:
+            {
+                // diamonds are squares rotated by 45 degrees
+                float a = u * 2.f;
+                float b = v * 2.f - 1.f;
+                x = i32(std::floor((a + b) * 0.5f + 0.5f));
+                y = i32(std::floor((b - a) * 0.5f + 0.5f));
+            }
+            break;
+        case 2:
+            {
+                // fractional axial coordinate, rounded in cube space
+                float r = (v - 0.5f) / 0.75f;
+                float q = u - 0.5f - r * 0.5f;
+                float s = -q - r;
+
+                float rq = std::floor(q + 0.5f);
+                float rr = std::floor(r + 0.5f);
+                float rs = std::floor(s + 0.5f);
+                float dq = std::abs(rq - q);
+                float dr = std::abs(rr - r);
+                float ds = std::abs(rs - s);
+                if (dq > dr && dq > ds)
+                    rq = -rr - rs;
+                else if (dr > ds)
+                    rr = -rq - rs;
+
+                y = i32(rr);
+                x = i32(rq) + (y - (y & 1)) / 2;
+            }
+            break;
+        default:
+            x = i32(std::floor(u));
+            y = i32(std::floor(v));
+            break;
+        }
+    }
+
+    Vector2 TileMap::pickTile(const Vector3& worldPos)
+    {
+        i32 x, y;
+        localToTile(worldPos * getInverseWorldMatrix(), x, y);
+
+        return x >= 0 && y >= 0 && x < m_width && y < m_height ? Vector2(float(x), float(y)) : Vector2(-1.f, -1.f);
+    }
+
+    void TileMap::resize(i32 width, i32 height)
+    {
+        width = Math::Max(width, 0);
+        height = Math::Max(height, 0);
+
+        vector<ui16>::type tiles(width * height, 0);
+        for (i32 y = 0; y < Math::Min(height, m_height); y++)
+        {
+            for (i32 x = 0; x < Math::Min(width, m_width); x++)
+            {
+                size_t oldIdx = y * m_width + x;
+                if (oldIdx < m_tiles.size())
+                    tiles[y * width + x] = m_tiles[oldIdx];
+            }
+        }
+
+        m_tiles.swap(tiles);
+        m_width = width;
+        m_height = height;
+        m_isChunksDirty = true;
+    }
+
+    i32 TileMap::getTileId(i32 x, i32 y) const
+    {
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+            return 0;
+
+        return m_tiles[y * m_width + x];
+    }
+
+    const TileMap::TileType* TileMap::getTileType(i32 id) const
+    {
+        return id > 0 && id <= i32(m_types.size()) ? &m_types[id - 1] : nullptr;
+    }
+
+    const String& TileMap::getTileNodePath(i32 x, i32 y)
+    {
+        const TileType* type = getTileType(getTileId(x, y));
+        return type ? type->m_path : StringUtil::BLANK;
+    }
+
+    i32 TileMap::getTypeId(const String& nodePath)
+    {
+        for (size_t i = 0; i < m_types.size(); i++)
+        {
+            if (m_types[i].m_path == nodePath)
+                return i32(i + 1);
+        }
+
+        if (m_types.size() >= 0xffff)
+        {
+            EchoLogError("TileMap [%s] has too many tile types", getName().c_str());
+            return 0;
+        }
+
+        // inspect the prototype once, a plain sprite can share a chunk mesh
+        TileType type;
+        type.m_path = nodePath;
+        type.m_isNode = true;
+
+        Node* node = Node::loadLink(nodePath, false);
+        if (node)
+        {
+            Sprite* sprite = dynamic_cast<Sprite*>(node);
+            if (sprite && sprite->getScript().isEmpty() && !sprite->getChildNum())
+            {
+                if (!sprite->getMaterial())
+                {
+                    if (!m_defaultMaterial)
+                    {
+                        StringArray macros = { "ALPHA_ADJUST" };
+                        ShaderProgramPtr shader = ShaderProgram::getDefault2D(macros);
+
+                        m_defaultMaterial = ECHO_CREATE_RES(Material);
+                        m_defaultMaterial->setShaderPath(shader->getPath());
+                    }
+
+                    type.m_material = m_defaultMaterial;
+                }
+                else
+                {
+                    type.m_material = sprite->getMaterial();
+                }
+
+                type.m_isNode = false;
+                type.m_size = Vector2(float(sprite->getWidth()), float(sprite->getHeight()));
+                type.m_offset = sprite->getLocalPosition();
+            }
+
+            EchoSafeDelete(node, Node);
+        }
+        else
+        {
+            EchoLogError("TileMap [%s] load tile [%s] failed", getName().c_str(), nodePath.c_str());
+        }
+
+        m_types.emplace_back(type);
+        m_palette.clear();
+
+        return i32(m_types.size());
+    }
+
+    TextureAtla* TileMap::getTileAtla(const TileType& type)
+    {
+        Material* material = type.m_material;
+        Material::UniformValue* baseColor = material ? material->getUniform("BaseColor") : nullptr;
+        TextureAtla* atla = baseColor ? baseColor->getAtla() : nullptr;
+
+        return atla && atla->getAtlas() ? atla : nullptr;
+    }
+
+    Vector4 TileMap::getTileUv(const TileType& type)
+    {
+        // materials with a viewport uniform map the sub rect in the shader
+        Material* material = type.m_material;
+        TextureAtla* atla = getTileAtla(type);
+        if (atla && !material->getUniform("BaseColorViewport"))
+            return atla->getViewportNormalized();
+
+        return Vector4(0.f, 0.f, 1.f, 1.f);
+    }
+
+    void TileMap::updateAtlasVersions()
+    {
+        for (size_t i = 0; i < m_types.size(); i++)
+        {
+            TileType& type = m_types[i];
+            TextureAtla* atla = !type.m_isNode ? getTileAtla(type) : nullptr;
+            if (!atla || atla->getAtlas()->getVersion() == type.m_atlasVersion)
+                continue;
+
+            type.m_atlasVersion = atla->getAtlas()->getVersion();
+
+            Vector4 viewport = atla->getViewportNormalized();
+            Material::UniformValue* viewportValue = type.m_material->getUniform("BaseColorViewport");
+            if (viewportValue)
+            {
+                viewportValue->setValue(&viewport);
+            }
+            else
+            {
+                i32 id = i32(i + 1);
+                for (TileMapChunk* chunk : m_chunks)
+                {
+                    if (!chunk->isDirty() && chunk->hasTile(id))
+                        chunk->setDirty();
+                }
+            }
+        }
     }
 
     void TileMap::setTile(i32 x, i32 y, const String& nodePath)
     {
-        Vector3 position = getTileCenter(x, y);
+        if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+        {
+            EchoLogError("TileMap [%s] tile (%d, %d) is out of range", getName().c_str(), x, y);
+            return;
+        }
 
         Node* node = getTile(x, y);
         if (node)
@@ -75,12 +366,28 @@ namespace Echo
             EchoSafeDelete(node, Node);
         }
 
-        node = Echo::Node::loadLink(nodePath, false);
-        if (node)
+        i32 id = nodePath.empty() ? 0 : getTypeId(nodePath);
+        const TileType* type = getTileType(id);
+        if (type && type->m_isNode)
+        {
+            node = Echo::Node::loadLink(nodePath, false);
+            if (node)
+            {
+                node->setLocalPosition(getTileCenter(x, y) + node->getLocalPosition());
+                node->setParent(this);
+                node->setName(getTileName(x, y));
+            }
+        }
+
+        ui16& tile = m_tiles[y * m_width + x];
+        if (tile != id)
         {
-			node->setLocalPosition(position + node->getLocalPosition());
-			node->setParent(this);
-			node->setName(getTileName(x, y));
+            tile = ui16(id);
+            m_tileData.clear();
+
+            TileMapChunk* chunk = getChunk(x, y);
+            if (chunk)
+                chunk->setDirty();
         }
     }
 
@@ -88,4 +395,177 @@ namespace Echo
     {
         return getChild(getTileName(x, y).c_str());
     }
+
+    const String& TileMap::getPalette()
+    {
+        if (m_palette.empty())
+        {
+            for (const TileType& type : m_types)
+            {
+                if (!m_palette.empty())
+                    m_palette += ";";
+
+                m_palette += type.m_path;
+            }
+        }
+
+        return m_palette;
+    }
+
+    void TileMap::setPalette(const String& palette)
+    {
+        m_types.clear();
+        for (const String& nodePath : StringUtil::Split(palette, ";"))
+            getTypeId(nodePath);
+
+        m_isChunksDirty = true;
+    }
+
+    const String& TileMap::getTileData()
+    {
+        if (m_tileData.empty())
+        {
+            // runs of "id*count"
+            for (size_t i = 0; i < m_tiles.size();)
+            {
+                size_t end = i + 1;
+                while (end < m_tiles.size() && m_tiles[end] == m_tiles[i])
+                    end++;
+
+                if (!m_tileData.empty())
+                    m_tileData += ",";
+
+                m_tileData += StringUtil::Format("%d*%d", m_tiles[i], i32(end - i));
+                i = end;
+            }
+        }
+
+        return m_tileData;
+    }
+
+    void TileMap::setTileData(const String& data)
+    {
+        std::fill(m_tiles.begin(), m_tiles.end(), 0);
+
+        size_t idx = 0;
+        for (const String& run : StringUtil::Split(data, ","))
+        {
+            StringArray values = StringUtil::Split(run, "*");
+            if (values.size() != 2)
+                continue;
+
+            ui16 id = ui16(StringUtil::ParseInt(values[0]));
+            i32 count = StringUtil::ParseInt(values[1]);
+            for (i32 i = 0; i < count && idx < m_tiles.size(); i++)
+                m_tiles[idx++] = id;
+        }
+
+        m_tileData.clear();
+        m_isChunksDirty = true;
+    }
+
+    TileMapChunk* TileMap::getChunk(i32 x, i32 y)
+    {
+        if (m_isChunksDirty)
+            return nullptr;
+
+        i32 columns = (m_width + TileMapChunk::Size - 1) / TileMapChunk::Size;
+        size_t idx = (y / TileMapChunk::Size) * columns + x / TileMapChunk::Size;
+
+        return idx < m_chunks.size() ? m_chunks[idx] : nullptr;
+    }
+
+    void TileMap::clearChunks()
+    {
+        EchoSafeDeleteContainer(m_chunks, TileMapChunk);
+        m_drawBatches.clear();
+    }
+
+    void TileMap::rebuildChunks()
+    {
+        clearChunks();
+
+        for (i32 y = 0; y < m_height; y += TileMapChunk::Size)
+        {
+            for (i32 x = 0; x < m_width; x += TileMapChunk::Size)
+                m_chunks.emplace_back(EchoNew(TileMapChunk(this, x, y)));
+        }
+
+        m_isChunksDirty = false;
+    }
+
+    bool TileMap::isChunkVisible(const TileMapChunk* chunk)
+    {
+        const AABB& localAABB = chunk->getLocalAABB();
+        if (!localAABB.isValid())
+            return false;
+
+        Camera* camera = NodeTree::instance()->get2dCamera();
+        if (!camera)
+            return true;
+
+        // clip space of the orthographic 2d camera
+        AABB box = localAABB.transform(getWorldMatrix() * camera->getViewProjMatrix());
+        return box.vMax.x >= -1.f && box.vMin.x <= 1.f && box.vMax.y >= -1.f && box.vMin.y <= 1.f;
+    }
+
+    void TileMap::update_self()
+    {
+        if (isNeedRender())
+        {
+            if (m_isChunksDirty)
+                rebuildChunks();
+
+            updateAtlasVersions();
+
+            // only chunks with changed tiles are re-meshed
+            bool isBoundsDirty = false;
+            for (TileMapChunk* chunk : m_chunks)
+            {
+                if (chunk->isDirty())
+                {
+                    chunk->build();
+                    isBoundsDirty = true;
+                }
+            }
+
+            if (isBoundsDirty)
+            {
+                m_localAABB.reset();
+                for (TileMapChunk* chunk : m_chunks)
+                {
+                    if (chunk->getLocalAABB().isValid())
+                        m_localAABB.unionBox(chunk->getLocalAABB());
+                }
+            }
+
+            submitChunks();
+        }
+    }
+
+    void TileMap::submitChunks()
+    {
+        // a whole chunk spans many rows, tiles overlapping a neighbour in another chunk
+        // only draw over it when the rows of both are merged
+        m_drawBatches.clear();
+        for (TileMapChunk* chunk : m_chunks)
+        {
+            if (isChunkVisible(chunk))
+            {
+                for (const TileMapChunk::Batch& batch : chunk->getBatches())
+                    m_drawBatches.emplace_back(&batch);
+            }
+        }
+
+        std::stable_sort(m_drawBatches.begin(), m_drawBatches.end(), [](const TileMapChunk::Batch* a, const TileMapChunk::Batch* b)
+        {
+            return a->m_row < b->m_row;
+        });
+
+        for (const TileMapChunk::Batch* batch : m_drawBatches)
+        {
+            if (batch->m_renderable)
+                batch->m_renderable->submitToRenderQueue();
+        }
+    }
 }
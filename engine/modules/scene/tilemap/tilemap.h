@@ -1,42 +1,56 @@
 #pragma once
 
-#include "engine/core/scene/node.h"
+#include "engine/core/scene/render_node.h"
+#include "tilemap_chunk.h"
 
 namespace Echo
 {
-    class TileMap : public Node
+    class TileMap : public Render
     {
-        ECHO_CLASS(TileMap, Node)
+        ECHO_CLASS(TileMap, Render)
 
-        typedef std::unordered_map<i32, Node*> Tiles;
+    public:
+        // tile prototype, sprites without scripts are batched into the chunks,
+        // everything else keeps a node per tile
+        struct TileType
+        {
+            String          m_path;
+            bool            m_isNode = false;
+            MaterialPtr     m_material;
+            Vector2         m_size;
+            Vector3         m_offset;
+            ui32            m_atlasVersion = 0;     // atlas layout the chunks were built with
+        };
+        typedef vector<TileType>::type TileTypes;
 
     public:
         TileMap();
         virtual ~TileMap();
-        
-        // tile shape
+
+        // tile shape, isometric tiles are diamonds, hexagons are pointy topped
+        // with odd rows shifted half a tile right
         const StringOption& getTileShape() const { return m_tileShape; }
         void setTileShape(const StringOption& option);
 
 		// width
 		i32 getWidth() const { return m_width; }
-        void setWidth(i32 width) { m_width = width; }
+        void setWidth(i32 width);
 
 		// height
 		i32 getHeight() const { return m_height; }
-        void setHeight(i32 height) { m_height = height; }
+        void setHeight(i32 height);
 
 		// grid size
 		const Vector2& getTileSize() const { return m_tileSize; }
-        void setTileSize(const Vector2& tileSize) { m_tileSize = tileSize; }
+        void setTileSize(const Vector2& tileSize);
 
 		// flip x
 		bool isFlipX() const { return m_isFlipX; }
-		void setFlipX(bool isFlipX) { m_isFlipX = isFlipX; }
+		void setFlipX(bool isFlipX);
 
 		// flip y
 		bool isFlipY() const { return m_isFlipY; }
-		void setFlipY(bool isFlipY) { m_isFlipY = isFlipY; }
+		void setFlipY(bool isFlipY);
 
         // flip
         Vector3 flip(const Vector3& pos);
@@ -44,19 +58,86 @@ namespace Echo
         // position
         Vector3 getTileCenter(i32 x, i32 y);
 
+        // draw order of a tile, rows are drawn from 0 up and tiles of one row share their screen y
+        i32 getDrawRow(i32 x, i32 y) const;
+
+        // outline of a tile in local space
+        vector<Vector3>::type getTileCorners(i32 x, i32 y);
+
+        // tile under a world position, (-1, -1) when outside of the map
+        Vector2 pickTile(const Vector3& worldPos);
+
         // tile
         void setTile(i32 x, i32 y, const String& nodePath);
         Node* getTile(i32 x, i32 y);
 
+        // prototype path of a tile, empty when there is none
+        const String& getTileNodePath(i32 x, i32 y);
+
         // tile name
         String getTileName(i32 x, i32 y) const { return StringUtil::Format("tile_x%d_y%d", x, y); }
-   
+
+        // tile ids, 0 is empty, otherwise one more than the index of the type
+        i32 getTileId(i32 x, i32 y) const;
+        const TileType* getTileType(i32 id) const;
+
+        // uv viewport of a batched type, 0..1 when its material maps the atla viewport itself
+        Vector4 getTileUv(const TileType& type);
+
+        // prototype paths separated by ';'
+        const String& getPalette();
+        void setPalette(const String& palette);
+
+        // run length encoded tile ids
+        const String& getTileData();
+        void setTileData(const String& data);
+
+    protected:
+        // update
+        virtual void update_self() override;
+
+        // id of a prototype, loaded at first use
+        i32 getTypeId(const String& nodePath);
+
+        // atla of a batched type's base color
+        TextureAtla* getTileAtla(const TileType& type);
+
+        // refresh viewports of types whose atlas was repacked, re-mesh the chunks baking them
+        void updateAtlasVersions();
+
+        // chunk containing a tile
+        TileMapChunk* getChunk(i32 x, i32 y);
+
+        // rebuild chunk layout, tiles are re-meshed at next draw
+        void rebuildChunks();
+        void clearChunks();
+
+        // resize dense id array, keeps overlapping tiles
+        void resize(i32 width, i32 height);
+
+        // is chunk inside of the 2d camera view
+        bool isChunkVisible(const TileMapChunk* chunk);
+
+        // submit visible chunks row by row, so rows of neighbour chunks interleave back to front
+        void submitChunks();
+
+        // tile coordinate of a local position, may be outside of the map
+        void localToTile(const Vector3& localPos, i32& x, i32& y);
+
     private:
-        StringOption        m_tileShape = StringOption("Square", { "Square"/*,"Isometric","Hexagon"*/ });
+        StringOption        m_tileShape = StringOption("Square", { "Square", "Isometric", "Hexagon" });
 		i32                 m_width = 8;
 		i32                 m_height = 8;
         Vector2             m_tileSize = Vector2(60.f, 60.f);
         bool                m_isFlipX = false;
         bool                m_isFlipY = false;
+        TileTypes           m_types;
+        vector<ui16>::type  m_tiles;
+        TileMapChunks       m_chunks;
+        vector<const TileMapChunk::Batch*>::type m_drawBatches;    // batches of visible chunks, by row
+        bool                m_isChunksDirty = true;
+        MaterialPtr         m_defaultMaterial;
+        String              m_palette;
+        String              m_tileData;
     };
 }
@@ -0,0 +1,141 @@
+#include "tilemap.h"
+#include "tilemap_chunk.h"
+
+namespace Echo
+{
+	TileMapChunk::TileMapChunk(TileMap* tileMap, i32 x, i32 y)
+		: m_tileMap(tileMap)
+		, m_x(x)
+		, m_y(y)
+	{
+	}
+
+	TileMapChunk::~TileMapChunk()
+	{
+		clear();
+	}
+
+	void TileMapChunk::clear()
+	{
+		for (Batch& batch : m_batches)
+		{
+			EchoSafeRelease(batch.m_renderable);
+			batch.m_mesh.reset();
+		}
+
+		m_batches.clear();
+	}
+
+	bool TileMapChunk::hasTile(i32 id) const
+	{
+		i32 xEnd = Math::Min(m_x + Size, m_tileMap->getWidth());
+		i32 yEnd = Math::Min(m_y + Size, m_tileMap->getHeight());
+		for (i32 y = m_y; y < yEnd; y++)
+		{
+			for (i32 x = m_x; x < xEnd; x++)
+			{
+				if (m_tileMap->getTileId(x, y) == id)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	void TileMapChunk::build()
+	{
+		clear();
+		m_localAABB.reset();
+		m_isDirty = false;
+
+		// back to front, so tiles taller than their cell overlap the ones behind.
+		// tiles of one row share their screen y, so only rows need ordering
+		struct Tile
+		{
+			i32							m_row;
+			Vector3						m_center;
+			const TileMap::TileType*	m_type;
+		};
+		vector<Tile>::type tiles;
+		i32 xEnd = Math::Min(m_x + Size, m_tileMap->getWidth());
+		i32 yEnd = Math::Min(m_y + Size, m_tileMap->getHeight());
+		for (i32 y = m_y; y < yEnd; y++)
+		{
+			for (i32 x = m_x; x < xEnd; x++)
+			{
+				const TileMap::TileType* type = m_tileMap->getTileType(m_tileMap->getTileId(x, y));
+				if (type && !type->m_isNode)
+					tiles.push_back({ m_tileMap->getDrawRow(x, y), m_tileMap->getTileCenter(x, y), type });
+			}
+		}
+
+		std::stable_sort(tiles.begin(), tiles.end(), [](const Tile& a, const Tile& b)
+		{
+			return a.m_row < b.m_row;
+		});
+
+		// group quads of a row by material
+		vector<VertexArray>::type batchVertices;
+		size_t rowBegin = 0;
+		for (const Tile& tile : tiles)
+		{
+			const TileMap::TileType* type = tile.m_type;
+			if (!m_batches.empty() && m_batches.back().m_row != tile.m_row)
+				rowBegin = m_batches.size();
+
+			size_t batchIdx = rowBegin;
+			while (batchIdx < m_batches.size() && m_batches[batchIdx].m_material != type->m_material)
+				batchIdx++;
+
+			if (batchIdx == m_batches.size())
+			{
+				m_batches.emplace_back();
+				m_batches.back().m_row = tile.m_row;
+				m_batches.back().m_material = type->m_material;
+				batchVertices.emplace_back();
+			}
+
+			Vector3 center = tile.m_center + type->m_offset;
+			float hw = type->m_size.x * 0.5f;
+			float hh = type->m_size.y * 0.5f;
+			Vector4 vp = m_tileMap->getTileUv(*type);
+			float u0 = vp.x, u1 = vp.x + vp.z;
+			float v0 = vp.y, v1 = vp.y + vp.w;
+
+			VertexArray& vertices = batchVertices[batchIdx];
+			vertices.emplace_back(center + Vector3(-hw, -hh, 0.f), Vector2(u0, v1));
+			vertices.emplace_back(center + Vector3(-hw,  hh, 0.f), Vector2(u0, v0));
+			vertices.emplace_back(center + Vector3( hw,  hh, 0.f), Vector2(u1, v0));
+			vertices.emplace_back(center + Vector3( hw, -hh, 0.f), Vector2(u1, v1));
+
+			m_localAABB.addPoint(center + Vector3(-hw, -hh, 0.f));
+			m_localAABB.addPoint(center + Vector3( hw,  hh, 0.f));
+		}
+
+		MeshVertexFormat define;
+		define.m_isUseUV = true;
+
+		for (size_t i = 0; i < m_batches.size(); i++)
+		{
+			const VertexArray& vertices = batchVertices[i];
+
+			IndiceArray indices;
+			indices.reserve(vertices.size() / 4 * 6);
+			for (Word base = 0; base < vertices.size(); base += 4)
+			{
+				indices.emplace_back(base);
+				indices.emplace_back(base + 1);
+				indices.emplace_back(base + 2);
+				indices.emplace_back(base);
+				indices.emplace_back(base + 2);
+				indices.emplace_back(base + 3);
+			}
+
+			Batch& batch = m_batches[i];
+			batch.m_mesh = Mesh::create(true, true);
+			batch.m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
+			batch.m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+			batch.m_renderable = Renderable::create(batch.m_mesh, batch.m_material, m_tileMap);
+		}
+	}
+}
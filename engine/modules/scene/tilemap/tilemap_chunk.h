@@ -0,0 +1,77 @@
+#pragma once
+
+#include "engine/core/geom/AABB.h"
+#include "engine/core/render/base/mesh/mesh.h"
+#include "engine/core/render/base/Renderable.h"
+#include "engine/core/render/base/Material.h"
+
+namespace Echo
+{
+	// a fixed block of tiles drawn with one mesh per draw row and material
+	class TileMap;
+	class TileMapChunk
+	{
+	public:
+		// tiles per chunk edge
+		static const i32 Size = 16;
+
+		struct VertexFormat
+		{
+			Vector3		m_position;
+			Vector2		m_uv;
+
+			VertexFormat(const Vector3& pos, const Vector2& uv)
+				: m_position(pos), m_uv(uv)
+			{}
+		};
+		typedef vector<VertexFormat>::type	VertexArray;
+		typedef vector<Word>::type			IndiceArray;
+
+		// tiles of one draw row sharing a material
+		struct Batch
+		{
+			i32				m_row = 0;
+			MaterialPtr		m_material;
+			MeshPtr			m_mesh;
+			Renderable*		m_renderable = nullptr;
+		};
+		typedef vector<Batch>::type Batches;
+
+	public:
+		TileMapChunk(TileMap* tileMap, i32 x, i32 y);
+		~TileMapChunk();
+
+		// first tile of the chunk
+		i32 getX() const { return m_x; }
+		i32 getY() const { return m_y; }
+
+		// re-mesh at next submit
+		void setDirty() { m_isDirty = true; }
+		bool isDirty() const { return m_isDirty; }
+
+		// is any tile of the chunk of this id
+		bool hasTile(i32 id) const;
+
+		// bounds in tile map space
+		const AABB& getLocalAABB() const { return m_localAABB; }
+
+		// batches ordered by draw row, the tile map interleaves the rows of all chunks
+		const Batches& getBatches() const { return m_batches; }
+
+		// rebuild meshes from the tile ids
+		void build();
+
+	private:
+		// release batches
+		void clear();
+
+	private:
+		TileMap*		m_tileMap = nullptr;
+		i32				m_x = 0;
+		i32				m_y = 0;
+		bool			m_isDirty = true;
+		AABB			m_localAABB;
+		Batches			m_batches;
+	};
+	typedef vector<TileMapChunk*>::type TileMapChunks;
+}
@@ -107,6 +107,11 @@ namespace Echo
     {
         if (isNeedRender())
         {
+            // atlas repacked, rewrite uvs or viewport
+            TextureAtla* atla = getBaseColorAtla();
+            if (m_mesh && atla && atla->getAtlas()->getVersion() != m_atlasVersion)
+                updateMeshBuffer();
+            
             if (m_renderable)
             {
                 m_renderable->submitToRenderQueue();
@@ -126,11 +131,27 @@ namespace Echo
         float hw = m_width * 0.5f;
         float hh = m_height * 0.5f;
         
+        // uv, atla textures use a part of the atlas
+        Vector4 vp(0.f, 0.f, 1.f, 1.f);
+        TextureAtla* atla = getBaseColorAtla();
+        if (atla)
+        {
+            // materials with a viewport uniform map the sub rect in the shader
+            Vector4 atlaVp = atla->getViewportNormalized();
+            Material::UniformValue* viewportValue = m_materialDefault->getUniform("BaseColorViewport");
+            if (viewportValue)
+                viewportValue->setValue(&atlaVp);
+            else
+                vp = atlaVp;
+            
+            m_atlasVersion = atla->getAtlas()->getVersion();
+        }
+        
         // vertices
-        oVertices.emplace_back(Vector3(-hw, -hh, 0.f), Vector2(0.f, 1.f));
-        oVertices.emplace_back(Vector3(-hw,  hh, 0.f), Vector2(0.f, 0.f));
-        oVertices.emplace_back(Vector3(hw,   hh, 0.f), Vector2(1.f, 0.f));
-        oVertices.emplace_back(Vector3(hw,  -hh, 0.f), Vector2(1.f, 1.f));
+        oVertices.emplace_back(Vector3(-hw, -hh, 0.f), Vector2(vp.x, vp.y + vp.w));
+        oVertices.emplace_back(Vector3(-hw,  hh, 0.f), Vector2(vp.x, vp.y));
+        oVertices.emplace_back(Vector3(hw,   hh, 0.f), Vector2(vp.x + vp.z, vp.y));
+        oVertices.emplace_back(Vector3(hw,  -hh, 0.f), Vector2(vp.x + vp.z, vp.y + vp.w));
         
         // calc aabb
         m_localAABB.reset();
@@ -159,6 +180,14 @@ namespace Echo
         m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
     }
     
+    TextureAtla* UiImage::getBaseColorAtla()
+    {
+        Material::UniformValue* baseColor = m_materialDefault ? m_materialDefault->getUniform("BaseColor") : nullptr;
+        TextureAtla* atla = baseColor ? baseColor->getAtla() : nullptr;
+        
+        return atla && atla->getAtlas() ? atla : nullptr;
+    }
+    
     void UiImage::clear()
     {
         clearRenderable();
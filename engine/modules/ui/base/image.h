@@ -45,6 +45,9 @@ namespace Echo
         // build mesh data by drawables data
         void buildMeshData(Ui::VertexArray& oVertices, Ui::IndiceArray& oIndices);
         
+        // atla of base color texture, its viewport goes to the uvs or the BaseColorViewport uniform
+        TextureAtla* getBaseColorAtla();
+        
         // clear
         void clear();
         void clearRenderable();
@@ -59,5 +62,6 @@ namespace Echo
         Matrix4                 m_matWVP;
         i32                     m_width;
         i32                     m_height;
+        ui32                    m_atlasVersion = 0;
     };
 }
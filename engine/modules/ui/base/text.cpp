@@ -10,9 +10,6 @@ namespace Echo
 {
     UiText::UiText()
     : UiRender()
-	, m_mesh(nullptr)
-    , m_material(nullptr)
-    , m_renderable(nullptr)
     , m_width(0)
     , m_height(0)
     {
@@ -31,6 +28,14 @@ namespace Echo
         CLASS_BIND_METHOD(UiText, setFont,          DEF_METHOD("setFont"));
 		CLASS_BIND_METHOD(UiText, getFontSize,		DEF_METHOD("getFontSize"));
 		CLASS_BIND_METHOD(UiText, setFontSize,		DEF_METHOD("setFontSize"));
+		CLASS_BIND_METHOD(UiText, getWrapWidth,		DEF_METHOD("getWrapWidth"));
+		CLASS_BIND_METHOD(UiText, setWrapWidth,		DEF_METHOD("setWrapWidth"));
+		CLASS_BIND_METHOD(UiText, isSdf,			DEF_METHOD("isSdf"));
+		CLASS_BIND_METHOD(UiText, setSdf,			DEF_METHOD("setSdf"));
+		CLASS_BIND_METHOD(UiText, getOutlineWidth,	DEF_METHOD("getOutlineWidth"));
+		CLASS_BIND_METHOD(UiText, setOutlineWidth,	DEF_METHOD("setOutlineWidth"));
+		CLASS_BIND_METHOD(UiText, getOutlineColor,	DEF_METHOD("getOutlineColor"));
+		CLASS_BIND_METHOD(UiText, setOutlineColor,	DEF_METHOD("setOutlineColor"));
         CLASS_BIND_METHOD(UiText, getWidth,         DEF_METHOD("getWidth"));
         CLASS_BIND_METHOD(UiText, setWidth,         DEF_METHOD("setWidth"));
         CLASS_BIND_METHOD(UiText, getHeight,        DEF_METHOD("getHeight"));
@@ -41,11 +46,20 @@ namespace Echo
         CLASS_REGISTER_PROPERTY(UiText, "Text", Variant::Type::String, "getText", "setText");
         CLASS_REGISTER_PROPERTY(UiText, "Font", Variant::Type::ResourcePath, "getFont", "setFont");
 		CLASS_REGISTER_PROPERTY(UiText, "FontSize", Variant::Type::Int, "getFontSize", "setFontSize");
+		CLASS_REGISTER_PROPERTY(UiText, "WrapWidth", Variant::Type::Int, "getWrapWidth", "setWrapWidth");
+		CLASS_REGISTER_PROPERTY(UiText, "Sdf", Variant::Type::Bool, "isSdf", "setSdf");
+		CLASS_REGISTER_PROPERTY(UiText, "OutlineWidth", Variant::Type::Real, "getOutlineWidth", "setOutlineWidth");
+		CLASS_REGISTER_PROPERTY(UiText, "OutlineColor", Variant::Type::Color, "getOutlineColor", "setOutlineColor");
     }
     
     void UiText::setText(const String& text)
     {
-        m_text = StringUtil::MBS2WCS(text);
+        WString newText = StringUtil::MBS2WCS(text);
+        
+        // glyphs before the first changed char keep their layout
+        size_t from = getChangedFrom(m_text, newText);
+        m_text = newText;
+        invalidateLayout(from);
 		updateMeshBuffer();
     }
     
@@ -53,6 +67,8 @@ namespace Echo
     {
         if (m_fontRes.setPath(path.getPath()))
         {
+            m_fontFace = !m_fontRes.isEmpty() ? FontLibrary::instance()->loadFace(m_fontRes.getPath().c_str()) : nullptr;
+            invalidateLayout(0);
 			updateMeshBuffer();
         }
     }
@@ -62,6 +78,30 @@ namespace Echo
 		m_fontSize = fontSize;
 		if (m_fontSize > 0)
 		{
+            invalidateLayout(0);
+			updateMeshBuffer();
+		}
+	}
+    
+    void UiText::setWrapWidth(i32 wrapWidth)
+    {
+        if (m_wrapWidth != wrapWidth)
+        {
+            m_wrapWidth = wrapWidth;
+            invalidateLayout(0);
+            updateMeshBuffer();
+        }
+    }
+    
+	void UiText::setSdf(bool isSdf)
+	{
+		if (m_isSdf != isSdf)
+		{
+			m_isSdf = isSdf;
+
+			// shader and glyphs change
+			clearRenderable();
+			invalidateLayout(0);
 			updateMeshBuffer();
 		}
 	}
@@ -93,25 +133,57 @@ namespace Echo
             clearRenderable();
             
             StringArray macros = {"ALPHA_ADJUST"};
-            m_shader = ShaderProgram::getDefault2D(macros);
-            
-            // material
-            m_material = EchoNew(Material(StringUtil::Format("UiTextMaterial_%d", getId())));
-            m_material->setShaderPath(m_shader->getPath());
+            if (m_isSdf)
+                macros.emplace_back("SDF");
             
-            // mesh
-            Ui::VertexArray vertices;
-            Ui::IndiceArray indices;
-            buildMeshData(vertices, indices);
+            m_shader = ShaderProgram::getDefault2D(macros);
             
-            MeshVertexFormat define;
-            define.m_isUseUV = true;
+            // pages are created when their first glyph shows up
+            m_meshDirtyFrom = 0;
+            m_indices.clear();
+        }
+    }
+    
+    i32 UiText::getPageBatch(Texture* texture)
+    {
+        for (size_t i = 0; i < m_pages.size(); i++)
+        {
+            if (m_pages[i]->m_texture == texture)
+                return i32(i);
+        }
+        
+        PageBatch* page = EchoNew(PageBatch);
+        page->m_texture = texture;
+        page->m_material = EchoNew(Material(StringUtil::Format("UiTextMaterial_%d_%d", getId(), i32(m_pages.size()))));
+        page->m_material->setShaderPath(m_shader->getPath());
+        page->m_material->getUniform("BaseColor")->setTexture(texture);
+        page->m_mesh = Mesh::create(true, true);
+        page->m_renderable = Renderable::create(page->m_mesh, page->m_material, this);
+        page->m_vertices.resize(m_glyphPages.size() * 4, Ui::VertexFormat(Vector3::ZERO, Vector2::ZERO));
+        m_pages.emplace_back(page);
+        
+        return i32(m_pages.size() - 1);
+    }
+    
+    void UiText::setGlyphPage(size_t idx, i32 page)
+    {
+        i32 oldPage = m_glyphPages[idx];
+        if (oldPage != page)
+        {
+            if (oldPage >= 0)
+            {
+                Ui::VertexFormat* vertices = &m_pages[oldPage]->m_vertices[idx * 4];
+                for (i32 v = 0; v < 4; v++)
+                    vertices[v] = Ui::VertexFormat(Vector3::ZERO, Vector2::ZERO);
+                
+                m_pages[oldPage]->m_glyphCount--;
+                m_pages[oldPage]->m_isDirty = true;
+            }
             
-            m_mesh = Mesh::create(true, true);
-            m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
-            m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+            if (page >= 0)
+                m_pages[page]->m_glyphCount++;
             
-            m_renderable = Renderable::create(m_mesh, m_material, this);
+            m_glyphPages[idx] = page;
         }
     }
     
@@ -119,84 +191,343 @@ namespace Echo
     {
         if (isNeedRender())
         {
-            if (m_renderable)
+            // glyphs evicted from the cache, uvs may be stale. layout is still valid
+            if (m_shader && m_fontFace && m_fontVersion != FontLibrary::instance()->getVersion())
+                updateEvictedGlyphs();
+            
+            // sdf glyphs finished by the jobs
+            if (m_fontFace && !m_pendingGlyphs.empty())
+                updatePendingGlyphs();
+            
+            for (PageBatch* page : m_pages)
+            {
+                if (page->m_glyphCount)
+                    page->m_renderable->submitToRenderQueue();
+            }
+        }
+    }
+    
+    void UiText::invalidateLayout(size_t from)
+    {
+        m_layoutDirtyFrom = std::min(m_layoutDirtyFrom, from);
+        m_meshDirtyFrom = std::min(m_meshDirtyFrom, from);
+    }
+    
+    size_t UiText::getChangedFrom(const WString& oldText, const WString& newText)
+    {
+        size_t same = 0;
+        size_t count = std::min(newText.size(), oldText.size());
+        while (same < count && newText[same] == oldText[same])
+            same++;
+        
+        return same;
+    }
+    
+    void UiText::layoutGlyphs(vector<LayoutGlyph>::type& glyphs, const WString& text, size_t from, FontFace* fontFace, i32 fontSize, i32 wrapWidth)
+    {
+        glyphs.resize(text.size());
+        
+        // continue from the pen position after the last kept glyph
+        float x = from > 0 ? glyphs[from - 1].m_nextX : 0.f;
+        i32 line = from > 0 ? glyphs[from - 1].m_nextLine : 0;
+        for (size_t i = from; i < text.size(); i++)
+        {
+            LayoutGlyph& glyph = glyphs[i];
+            glyph.m_code = text[i];
+            if (glyph.m_code == L'\n')
+            {
+                glyph.m_x = x;
+                glyph.m_line = line;
+                glyph.m_nextX = 0.f;
+                glyph.m_nextLine = line + 1;
+                x = glyph.m_nextX;
+                line = glyph.m_nextLine;
+                continue;
+            }
+            
+            // kerning with the previous glyph of the same line
+            if (fontFace && i > 0 && glyphs[i - 1].m_code != L'\n')
+                x += fontFace->getKerning(glyphs[i - 1].m_code, glyph.m_code) * fontSize;
+            
+            // wrap per char, so appending never moves earlier glyphs
+            if (wrapWidth > 0 && x > 0.f && x + fontSize > wrapWidth)
+            {
+                x = 0.f;
+                line++;
+            }
+            
+            glyph.m_x = x;
+            glyph.m_line = line;
+            glyph.m_nextX = x + fontSize;
+            glyph.m_nextLine = line;
+            x = glyph.m_nextX;
+        }
+    }
+    
+    void UiText::layout(size_t from)
+    {
+        if (!m_fontFace)
+            return;
+        
+        layoutGlyphs(m_layout, m_text, from, m_fontFace, m_fontSize, m_wrapWidth);
+        
+        // size
+        float width = 0.f;
+        for (const LayoutGlyph& glyph : m_layout)
+            width = std::max(width, glyph.m_code == L'\n' ? glyph.m_x : glyph.m_nextX);
+        
+        i32 lines = m_layout.empty() ? 0 : m_layout.back().m_nextLine + 1;
+        m_width = i32(width);
+        m_height = lines * m_fontSize;
+        
+        // lines go down from the first one
+        m_localAABB.reset();
+        if (lines > 0)
+        {
+            m_localAABB.addPoint(Vector3(0.f, float(m_fontSize), 0.f));
+            m_localAABB.addPoint(Vector3(width, float(m_fontSize - m_height), 0.f));
+        }
+    }
+    
+    void UiText::buildMeshData(size_t from)
+    {
+        ui32 version = FontLibrary::instance()->getVersion();
+        
+        // chars cut from the end leave their pages
+        for (size_t i = m_layout.size(); i < m_glyphPages.size(); i++)
+            setGlyphPage(i, -1);
+        
+        // four vertices per char on every page, hidden glyphs get an empty quad
+        size_t oldCount = m_indices.size() / 6;
+        m_glyphPages.resize(m_layout.size(), -1);
+        for (PageBatch* page : m_pages)
+        {
+            page->m_isDirty = page->m_isDirty || page->m_vertices.size() != m_layout.size() * 4;
+            page->m_vertices.resize(m_layout.size() * 4, Ui::VertexFormat(Vector3::ZERO, Vector2::ZERO));
+        }
+        
+        m_indices.resize(m_layout.size() * 6);
+        for (size_t i = oldCount; i < m_layout.size(); i++)
+        {
+            Word vertBase = Word(i * 4);
+            Word* indices = &m_indices[i * 6];
+            indices[0] = vertBase + 0;
+            indices[1] = vertBase + 1;
+            indices[2] = vertBase + 2;
+            indices[3] = vertBase + 0;
+            indices[4] = vertBase + 2;
+            indices[5] = vertBase + 3;
+        }
+        
+        // pending chars from index are built again below
+        for (size_t i = 0; i < m_pendingGlyphs.size();)
+        {
+            if (m_pendingGlyphs[i] >= from)
             {
-                m_renderable->submitToRenderQueue();
+                m_pendingGlyphs[i] = m_pendingGlyphs.back();
+                m_pendingGlyphs.pop_back();
             }
+            else
+            {
+                i++;
+            }
+        }
+        
+        for (size_t i = from; i < m_layout.size(); i++)
+            buildGlyph(i);
+        
+        // upload new glyphs. chars kept from before may still miss evictions, update_self catches them
+        FontLibrary::instance()->flush();
+        if (from == 0)
+            m_fontVersion = version;
+    }
+    
+    void UiText::buildGlyph(size_t idx)
+    {
+        const LayoutGlyph& glyph = m_layout[idx];
+        
+        // pending glyphs have no texture yet, they are checked every frame until the job is done
+        // or the cache has room again (a null glyph)
+        if (glyph.m_code == L'\n')
+        {
+            setGlyphPage(idx, -1);
+            return;
+        }
+        
+        FontGlyph* fontGlyph = m_fontFace->getGlyph(glyph.m_code, m_fontSize, m_isSdf);
+        if (fontGlyph && fontGlyph->m_texture)
+        {
+            // sdf cells carry the spread around the glyph, grow the quad to match
+            float pad = m_isSdf ? float(m_fontSize * FontFace::SDF_SPREAD) / FontFace::SDF_GLYPH_SIZE : 0.f;
+            float left = glyph.m_x - pad;
+            float right = glyph.m_x + m_fontSize + pad;
+            float bottom = float(-glyph.m_line * m_fontSize) - pad;
+            float top = float(-glyph.m_line * m_fontSize) + m_fontSize + pad;
+            
+            Vector4 uv = fontGlyph->getUV();
+            float uvLeft = uv.x;
+            float uvTop = uv.y;
+            float uvRight = uv.x + uv.z;
+            float uvBottom = uv.y + uv.w;
+            
+            // glyphs draw with the renderable of their page
+            i32 page = getPageBatch(fontGlyph->m_texture->getTexture());
+            setGlyphPage(idx, page);
+            
+            Ui::VertexFormat* vertices = &m_pages[page]->m_vertices[idx * 4];
+            vertices[0] = Ui::VertexFormat(Vector3(left, top, 0.f), Vector2(uvLeft, uvTop));
+            vertices[1] = Ui::VertexFormat(Vector3(left, bottom, 0.f), Vector2(uvLeft, uvBottom));
+            vertices[2] = Ui::VertexFormat(Vector3(right, bottom, 0.f), Vector2(uvRight, uvBottom));
+            vertices[3] = Ui::VertexFormat(Vector3(right, top, 0.f), Vector2(uvRight, uvTop));
+            m_pages[page]->m_isDirty = true;
+        }
+        else
+        {
+            setGlyphPage(idx, -1);
+            if (!fontGlyph || fontGlyph->isPending())
+                m_pendingGlyphs.emplace_back(idx);
         }
     }
     
-    void UiText::buildMeshData(Ui::VertexArray& oVertices, Ui::IndiceArray& oIndices)
+    void UiText::updatePendingGlyphs()
     {
-        if(!m_text.empty() && !m_fontRes.isEmpty())
+        vector<size_t>::type pendingGlyphs;
+        pendingGlyphs.swap(m_pendingGlyphs);
+        
+        bool isChanged = false;
+        for (size_t idx : pendingGlyphs)
+        {
+            const LayoutGlyph& glyph = m_layout[idx];
+            FontGlyph* fontGlyph = m_fontFace->getGlyph(glyph.m_code, m_fontSize, m_isSdf);
+            if (!fontGlyph || fontGlyph->isPending())
+            {
+                m_pendingGlyphs.emplace_back(idx);
+            }
+            else
+            {
+                buildGlyph(idx);
+                isChanged = true;
+            }
+        }
+        
+        if (isChanged)
+        {
+            FontLibrary::instance()->flush();
+            uploadPages();
+        }
+    }
+    
+    void UiText::updateEvictedGlyphs()
+    {
+        // evictions made while rebuilding are picked up next frame
+        FontLibrary* library = FontLibrary::instance();
+        ui32 version = library->getVersion();
+        
+        vector<FontLibrary::EvictedGlyph>::type evictedGlyphs;
+        if (!library->getEvictedGlyphs(m_fontVersion, evictedGlyphs))
+        {
+            m_meshDirtyFrom = 0;
+            updateMeshBuffer();
+            return;
+        }
+        
+        std::unordered_set<ui64> evictedKeys;
+        for (const FontLibrary::EvictedGlyph& evicted : evictedGlyphs)
+        {
+            if (evicted.m_face == m_fontFace)
+                evictedKeys.insert(evicted.m_key);
+        }
+        
+        // only chars showing an evicted glyph need it back
+        m_fontVersion = version;
+        if (!evictedKeys.empty())
         {
-			m_width = 0;
-            m_height = m_fontSize;
-            for(wchar_t glyphCode : m_text)
+            bool isChanged = false;
+            for (size_t i = 0; i < m_glyphPages.size(); i++)
             {
-                FontGlyph* fontGlyph = FontLibrary::instance()->getFontGlyph( glyphCode, m_fontRes, m_fontSize);
-                if(fontGlyph)
+                if (m_glyphPages[i] >= 0 && evictedKeys.count(FontFace::makeKey(m_layout[i].m_code, m_isSdf ? 0 : m_fontSize)))
                 {
-					float left = m_width;
-					float right = left + m_fontSize;
-					float top = m_height;
-					float bottom = 0;
-
-					Vector4 uv = fontGlyph->getUV();
-					float uvLeft = uv.x;
-					float uvTop = uv.y;
-					float uvRight = uv.x + uv.z;
-					float uvBottom = uv.y + uv.w;
-
-					// vertices
-					Word vertBase = oVertices.size();
-					oVertices.emplace_back(Vector3(left, top, 0.f), Vector2(uvLeft, uvTop));
-					oVertices.emplace_back(Vector3(left, bottom, 0.f), Vector2(uvLeft, uvBottom));
-					oVertices.emplace_back(Vector3(right, bottom, 0.f), Vector2(uvRight, uvBottom));
-					oVertices.emplace_back(Vector3(right, top, 0.f), Vector2(uvRight, uvTop));
-
-					// indices
-					oIndices.emplace_back(vertBase + 0);
-					oIndices.emplace_back(vertBase + 1);
-					oIndices.emplace_back(vertBase + 2);
-					oIndices.emplace_back(vertBase + 0);
-					oIndices.emplace_back(vertBase + 2);
-					oIndices.emplace_back(vertBase + 3);
-
-                    m_material->getUniform("BaseColor")->setTexture(fontGlyph->m_texture->getTexture());
+                    buildGlyph(i);
+                    isChanged = true;
                 }
-
-				m_width += m_fontSize;
+            }
+            
+            if (isChanged)
+            {
+                library->flush();
+                uploadPages();
             }
         }
-          
-        // Calculate aabb
-        m_localAABB.reset();
-        for (Ui::VertexFormat& vert : oVertices)
-            m_localAABB.addPoint(vert.m_position);
+    }
+    
+    void UiText::uploadPages()
+    {
+        MeshVertexFormat define;
+        define.m_isUseUV = true;
+        
+        // empty pages are not drawn, they upload once a glyph lands on them
+        for (PageBatch* page : m_pages)
+        {
+            if (!page->m_glyphCount || !page->m_isDirty)
+                continue;
+            
+            if (page->m_indexCount != m_indices.size())
+            {
+                page->m_mesh->updateIndices(static_cast<ui32>(m_indices.size()), sizeof(Word), m_indices.data());
+                page->m_indexCount = m_indices.size();
+            }
+            
+            page->m_mesh->updateVertexs(define, static_cast<ui32>(page->m_vertices.size()), (const Byte*)page->m_vertices.data());
+            page->m_isDirty = false;
+        }
     }
     
     void UiText::updateMeshBuffer()
     {
-		if (!m_mesh)
+		if (!m_shader)
 		{
 			buildRenderable();
 		}
 
-		if (m_mesh)
+		if (m_shader && m_fontFace)
 		{
-			Ui::VertexArray    vertices;
-			Ui::IndiceArray    indices;
-			buildMeshData(vertices, indices);
-
-			MeshVertexFormat define;
-			define.m_isUseUV = true;
-
-			m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
-			m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+            if (m_layoutDirtyFrom < m_text.size() || m_layout.size() != m_text.size())
+                layout(m_layoutDirtyFrom);
+            
+            buildMeshData(std::min(m_meshDirtyFrom, m_layout.size()));
+            m_layoutDirtyFrom = m_text.size();
+            m_meshDirtyFrom = m_text.size();
+            
+            uploadPages();
 		}
     }
     
+    void* UiText::getGlobalUniformValue(const String& name)
+    {
+        if (m_isSdf)
+        {
+            // one screen pixel in distance field units
+            float scale = std::max(getWorldScaling().x, 0.001f) * std::max(m_fontSize, 1);
+            float pixel = float(FontFace::SDF_GLYPH_SIZE) / (scale * 2.f * FontFace::SDF_SPREAD);
+            if (name == "u_SdfSmoothing")
+            {
+                m_sdfSmoothing = pixel * 0.5f;
+                return &m_sdfSmoothing;
+            }
+            else if (name == "u_SdfOutline")
+            {
+                m_sdfOutline = std::min(m_outlineWidth * pixel, 0.45f);
+                return &m_sdfOutline;
+            }
+            else if (name == "u_SdfOutlineColor")
+            {
+                return &m_outlineColor;
+            }
+        }
+        
+        return UiRender::getGlobalUniformValue(name);
+    }
+    
     void UiText::clear()
     {
         clearRenderable();
@@ -204,7 +535,15 @@ namespace Echo
     
     void UiText::clearRenderable()
     {
-        EchoSafeRelease(m_renderable);
-        m_mesh.reset();
+        for (PageBatch* page : m_pages)
+        {
+            EchoSafeRelease(page->m_renderable);
+            EchoSafeDelete(page, PageBatch);
+        }
+        
+        m_pages.clear();
+        m_glyphPages.clear();
+        m_pendingGlyphs.clear();
+        m_shader.reset();
     }
 }
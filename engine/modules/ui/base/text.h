@@ -8,6 +8,7 @@
 
 namespace Echo
 {
+    class FontFace;
     class UiText : public UiRender
     {
         ECHO_CLASS(UiText, UiRender)
@@ -27,6 +28,22 @@ namespace Echo
 		// Font size
 		void setFontSize(i32 fontSize);
 		i32 getFontSize() const { return m_fontSize; }
+
+		// Signed distance field, one glyph set serves all font sizes and supports outline
+		void setSdf(bool isSdf);
+		bool isSdf() const { return m_isSdf; }
+
+		// outline width in pixels (sdf only)
+		void setOutlineWidth(float width) { m_outlineWidth = width; }
+		float getOutlineWidth() const { return m_outlineWidth; }
+
+		// outline color (sdf only)
+		void setOutlineColor(const Color& color) { m_outlineColor = color; }
+		const Color& getOutlineColor() const { return m_outlineColor; }
+        
+        // max line width in pixels, 0 means no wrapping
+        void setWrapWidth(i32 wrapWidth);
+        i32 getWrapWidth() const { return m_wrapWidth; }
         
         // width
         i32 getWidth() const { return m_width; }
@@ -36,6 +53,30 @@ namespace Echo
         i32 getHeight() const { return m_height; }
         void setHeight(i32 height);
         
+    protected:
+        // Glyph layout, cached until text or font settings change
+        struct LayoutGlyph
+        {
+            wchar_t     m_code;
+            float       m_x;            // left of the quad
+            i32         m_line;
+            float       m_nextX;        // pen position after this glyph
+            i32         m_nextLine;
+        };
+        
+        // Glyphs of one cache page, chars on other pages get empty quads so char i always owns vertices [4i, 4i+4)
+        struct PageBatch
+        {
+            Texture*            m_texture = nullptr;
+            MeshPtr             m_mesh;
+            MaterialPtr         m_material;
+            Renderable*         m_renderable = nullptr;
+            Ui::VertexArray     m_vertices;
+            size_t              m_glyphCount = 0;
+            size_t              m_indexCount = 0;   // indices uploaded to the mesh
+            bool                m_isDirty = false;
+        };
+        
     protected:
         // build drawable
         void buildRenderable();
@@ -46,8 +87,41 @@ namespace Echo
         // update vertex buffer
         void updateMeshBuffer();
         
-        // build mesh data by drawable data
-        void buildMeshData(Ui::VertexArray& oVertices, Ui::IndiceArray& oIndices);
+        // layout glyphs from index, glyphs before it are kept
+        void layout(size_t from);
+        
+        // first char that differs, chars before it keep layout and vertices
+        static size_t getChangedFrom(const WString& oldText, const WString& newText);
+        
+        // layout text from index into glyphs, no kerning without a face
+        static void layoutGlyphs(vector<LayoutGlyph>::type& glyphs, const WString& text, size_t from, FontFace* fontFace, i32 fontSize, i32 wrapWidth);
+        
+        // rebuild vertices of glyphs from index
+        void buildMeshData(size_t from);
+        
+        // rebuild vertices of one char
+        void buildGlyph(size_t idx);
+        
+        // rebuild chars whose sdf glyphs are done
+        void updatePendingGlyphs();
+        
+        // rebuild chars whose glyphs were evicted from the cache
+        void updateEvictedGlyphs();
+        
+        // upload dirty pages
+        void uploadPages();
+        
+        // mark glyphs from index dirty
+        void invalidateLayout(size_t from);
+        
+        // batch of the page texture, created on first use
+        i32 getPageBatch(Texture* texture);
+        
+        // move char quad to another page, -1 hides it
+        void setGlyphPage(size_t idx, i32 page);
+        
+        // get global uniforms
+        virtual void* getGlobalUniformValue(const String& name) override;
         
         // clear
         void clear();
@@ -57,12 +131,24 @@ namespace Echo
         WString                 m_text;
         ResourcePath            m_fontRes = ResourcePath("", ".ttf");
 		i32						m_fontSize = 24;
-        MeshPtr              m_mesh;            // Geometry Data for render
+        i32                     m_wrapWidth = 0;
+        FontFace*               m_fontFace = nullptr;
+		bool					m_isSdf = false;
+		float					m_outlineWidth = 0.f;
+		Color					m_outlineColor = Color::BLACK;
+		float					m_sdfSmoothing = 0.f;
+		float					m_sdfOutline = 0.f;
         ShaderProgramPtr        m_shader;
-        MaterialPtr             m_material;        // Material Instance
-        Renderable*             m_renderable;
+        vector<PageBatch*>::type m_pages;          // one renderable per glyph cache page
+        vector<i32>::type       m_glyphPages;      // page of each char, -1 for none
+        vector<size_t>::type    m_pendingGlyphs;   // chars waiting for their sdf glyph
         Matrix4                 m_matWVP;
         i32                     m_width;
         i32                     m_height;
+        ui32                    m_fontVersion = 0;  // glyph cache version the uvs were built with
+        vector<LayoutGlyph>::type m_layout;
+        size_t                  m_layoutDirtyFrom = 0;
+        size_t                  m_meshDirtyFrom = 0;
+        Ui::IndiceArray         m_indices;         // shared by all pages
     };
 }
@@ -1,8 +1,8 @@
 #include "font_face.h"
+#include "font_library.h"
+#include "font_sdf.h"
 #include "engine/core/log/Log.h"
 
-#define DEFAULT_FONT_TEXTURE_SIZE	1024
-
 namespace Echo
 {
     FontFace::FontFace(FT_Library& library, const char* filePath)
@@ -26,47 +26,141 @@ namespace Echo
     FontFace::~FontFace()
     {
         EchoSafeDelete(m_memory, MemoryReader);
-        EchoSafeDeleteContainer(m_fontTextures, FontTexture);
+        FontLibrary::instance()->releaseGlyphs(m_glyphs);
         EchoSafeDeleteMap(m_glyphs, FontGlyph);
     }
     
-    FontGlyph* FontFace::getGlyph(i32 charCode, i32 fontSize)
+    FontGlyph* FontFace::getGlyph(i32 charCode, i32 fontSize, bool isSdf)
     {
-        // if exist, return it
-        auto it = m_glyphs.find(charCode);
+        // if exist, return it. sdf glyphs share one size
+        ui64 key = makeKey(charCode, isSdf ? 0 : fontSize);
+        auto it = m_glyphs.find(key);
         if(it!=m_glyphs.end())
         {
+            if(it->second->m_texture)
+                FontLibrary::instance()->touchGlyph(it->second);
+            
             return it->second;
         }
         
-        // create new one
+        // sdf glyphs are generated by a job, the glyph gets its texture when done
+        if(isSdf)
+        {
+            FontGlyph* fontGlyph = EchoNew(FontGlyph);
+            fontGlyph->m_face = this;
+            fontGlyph->m_key = key;
+            m_glyphs[key] = fontGlyph;
+            
+            FontLibrary::instance()->requestSdfGlyph(fontGlyph, charCode);
+            return fontGlyph;
+        }
+        
+        // create new one, nullptr while the cache is full
         return loadGlyph( charCode, fontSize);
     }
     
-    FontGlyph* FontFace::loadGlyph(i32 charCode, i32 fontSize)
+    float FontFace::getKerning(i32 leftCharCode, i32 rightCharCode)
+    {
+        if(!m_face || !FT_HAS_KERNING(m_face))
+            return 0.f;
+        
+        ui64 key = (ui64(ui32(leftCharCode)) << 32) | ui32(rightCharCode);
+        auto it = m_kernings.find(key);
+        if(it!=m_kernings.end())
+            return it->second;
+        
+        // unscaled kerning doesn't depend on the current pixel size
+        float kerning = 0.f;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            FT_Vector delta;
+            FT_UInt left = FT_Get_Char_Index(m_face, leftCharCode);
+            FT_UInt right = FT_Get_Char_Index(m_face, rightCharCode);
+            if(!FT_Get_Kerning(m_face, left, right, FT_KERNING_UNSCALED, &delta) && m_face->units_per_EM)
+                kerning = float(delta.x) / float(m_face->units_per_EM);
+        }
+        
+        m_kernings[key] = kerning;
+        return kerning;
+    }
+    
+    void FontFace::removeGlyph(ui64 key)
+    {
+        m_glyphs.erase(key);
+    }
+    
+    bool FontFace::renderGlyph(i32 charCode, i32 pixelSize)
     {
         // get glyph index
         i32 glyphIndex = FT_Get_Char_Index( m_face, charCode);
 
-		// set pixel size
-		FT_Error error = FT_Set_Pixel_Sizes(m_face, fontSize * 2, fontSize * 2);
-		if (error)
-			return nullptr;
+		// set pixel size, only when it changes
+		if (m_pixelSize != pixelSize)
+		{
+			FT_Error error = FT_Set_Pixel_Sizes(m_face, pixelSize, pixelSize);
+			if (error)
+				return false;
+
+			m_pixelSize = pixelSize;
+		}
         
         // load glyph
         i32 loadFlags = FT_LOAD_DEFAULT;
-        error = FT_Load_Glyph( m_face, glyphIndex, loadFlags);
+        FT_Error error = FT_Load_Glyph( m_face, glyphIndex, loadFlags);
         if(error)
-            return nullptr;
+            return false;
         
         // convert to an anti-aliased bitmap
         error = FT_Render_Glyph(m_face->glyph, FT_RENDER_MODE_NORMAL);
         if(error)
-            return nullptr;
+            return false;
+        
+        return true;
+    }
+    
+    FontGlyph* FontFace::loadGlyph(i32 charCode, i32 fontSize)
+    {
+        // glyphs freetype can't render are kept too, so they aren't loaded again
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!renderGlyph(charCode, fontSize * 2))
+            return newGlyph(makeKey(charCode, fontSize), nullptr, FontTexture::IRect());
         
         return copyGlyphToTexture(charCode, m_face->glyph, fontSize);
     }
     
+    bool FontFace::renderSdfGlyph(i32 charCode, vector<Color>::type& oBitmap)
+    {
+        // coverage of the glyph centered in the cell, the spread around it keeps the field and outline whole.
+        // glyphs overhanging the cell are clipped
+        vector<Byte>::type coverage(SDF_CELL_SIZE * SDF_CELL_SIZE, 0);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(!renderGlyph(charCode, SDF_GLYPH_SIZE))
+                return false;
+            
+            FT_Bitmap* bitmap = &m_face->glyph->bitmap;
+            i32 width = i32(bitmap->width);
+            i32 rows = i32(bitmap->rows);
+            i32 wOffset = (SDF_CELL_SIZE - width) / 2;
+            i32 hOffset = (SDF_CELL_SIZE - rows) / 2;
+            for(i32 h=std::max(-hOffset, 0); h<std::min(rows, SDF_CELL_SIZE - hOffset); h++)
+            {
+                for(i32 w=std::max(-wOffset, 0); w<std::min(width, SDF_CELL_SIZE - wOffset); w++)
+                    coverage[(h + hOffset) * SDF_CELL_SIZE + w + wOffset] = bitmap->buffer[h * bitmap->pitch + w];
+            }
+        }
+        
+        // distance goes to alpha
+        vector<Byte>::type distance(coverage.size());
+        FontSdf::generate(coverage.data(), SDF_CELL_SIZE, SDF_CELL_SIZE, float(SDF_SPREAD), distance.data());
+        
+        oBitmap.resize(distance.size());
+        for(size_t i=0; i<distance.size(); i++)
+            oBitmap[i] = Color(1.f, 1.f, 1.f, distance[i] / 255.f);
+        
+        return true;
+    }
+    
     FontGlyph* FontFace::copyGlyphToTexture(i32 charCode, FT_GlyphSlot glyphSlot, i32 fontSize)
     {
         // convert glyph to bitmap(color array)
@@ -74,28 +168,13 @@ namespace Echo
         i32 glyphHeight = fontSize * 2;
         vector<Color>::type glyphBitmap(glyphWidth * glyphHeight, Color(0.f, 0.f, 0.f, 0.f));
         if(!copyGlyphToBitmap( &glyphBitmap[0], glyphWidth, glyphHeight, charCode, glyphSlot))
-            return nullptr;
+            return newGlyph(makeKey(charCode, fontSize), nullptr, FontTexture::IRect());
         
-        // try to insert to exist font texture
-        for(FontTexture* fontTexture : m_fontTextures)
-        {
-			i32 nodeIndex = fontTexture->insert(glyphBitmap.data(), glyphWidth, glyphHeight);
-            if(nodeIndex !=-1)
-            {
-				fontTexture->refreshTexture();
-				return newGlyph(charCode, fontTexture, nodeIndex);
-            }
-        }
-        
-        // create new one
-        FontTexture* newTexture = EchoNew(FontTexture(DEFAULT_FONT_TEXTURE_SIZE, DEFAULT_FONT_TEXTURE_SIZE));
-        m_fontTextures.emplace_back(newTexture);
-		i32 nodeIndex = newTexture->insert(glyphBitmap.data(), glyphWidth, glyphHeight);
-		if (nodeIndex != -1)
-		{
-			newTexture->refreshTexture();
-			return newGlyph(charCode, newTexture, nodeIndex);
-		}
+        // pack into one of the library pages, a full cache is retried on a later frame
+        FontTexture::IRect rect;
+        FontTexture* fontTexture = FontLibrary::instance()->allocGlyph(glyphBitmap.data(), glyphWidth, glyphHeight, rect);
+        if(fontTexture)
+            return newGlyph(makeKey(charCode, fontSize), fontTexture, rect);
 
         return nullptr;
     }
@@ -103,16 +182,18 @@ namespace Echo
     bool FontFace::copyGlyphToBitmap(Color* oColor, i32 ioWidth, i32 ioHeight, i32 charCode, FT_GlyphSlot glyphSlot)
     {
         FT_Bitmap* bitmap = &glyphSlot->bitmap;
-        if(ioWidth>=bitmap->width && ioHeight>=bitmap->rows)
+        if(ioWidth>=i32(bitmap->width) && ioHeight>=i32(bitmap->rows))
         {
-			i32 wOffset = (ioWidth - bitmap->width) / 2;
-			i32 hOffset = (ioHeight - bitmap->rows) / 2;
+			i32 width = i32(bitmap->width);
+			i32 rows = i32(bitmap->rows);
+			i32 wOffset = (ioWidth - width) / 2;
+			i32 hOffset = (ioHeight - rows) / 2;
 
-            for(i32 w=0; w<bitmap->width; w++)
+            for(i32 w=0; w<width; w++)
             {
-                for(i32 h=0; h<bitmap->rows; h++)
+                for(i32 h=0; h<rows; h++)
                 {
-                    i32 index0 = h * bitmap->width + w;
+                    i32 index0 = h * width + w;
 					i32 index1 = (h + hOffset) * ioWidth + w + wOffset;
                     oColor[index1].r = bitmap->buffer[index0];
                     oColor[index1].g = bitmap->buffer[index0];
@@ -127,13 +208,19 @@ namespace Echo
         return false;
     }
 
-	FontGlyph* FontFace::newGlyph(i32 charCode, FontTexture* texture, i32 nodeIndex)
+	FontGlyph* FontFace::newGlyph(ui64 key, FontTexture* texture, const FontTexture::IRect& rect)
 	{
 		// organize glyph data
-		FontGlyph* fontGlyph = new FontGlyph;
+		FontGlyph* fontGlyph = EchoNew(FontGlyph);
+		fontGlyph->m_face = this;
+		fontGlyph->m_key = key;
 		fontGlyph->m_texture = texture;
-		fontGlyph->m_nodeIndex = nodeIndex;
-		m_glyphs[charCode] = fontGlyph;
+		fontGlyph->m_rect = rect;
+		fontGlyph->m_isFailed = !texture;
+		m_glyphs[key] = fontGlyph;
+
+		if (texture)
+			FontLibrary::instance()->addGlyph(fontGlyph);
 
 		return fontGlyph;
 	}
@@ -2,6 +2,7 @@
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
+#include <mutex>
 #include "engine/core/util/StringUtil.h"
 #include "engine/core/io/IO.h"
 #include "font_glyph.h"
@@ -11,6 +12,14 @@ namespace Echo
 {
     class FontFace
     {
+    public:
+        typedef std::unordered_map<ui64, FontGlyph*> Glyphs;
+        
+        // sdf glyphs are generated once at this pixel size and serve all font sizes
+        static const i32 SDF_GLYPH_SIZE = 64;
+        static const i32 SDF_SPREAD = 6;
+        static const i32 SDF_CELL_SIZE = SDF_GLYPH_SIZE + 2 * SDF_SPREAD;   // glyph plus spread on each side
+        
     public:
         FontFace(FT_Library& library, const char* filePath);
         ~FontFace();
@@ -18,25 +27,42 @@ namespace Echo
         // file
         const String& getFile() const { return m_file;}
         
-        // get glyph
-        FontGlyph* getGlyph(i32 charCode, i32 fontSize);
+        // get glyph, sdf glyphs are generated off-thread and have no texture until ready
+        FontGlyph* getGlyph(i32 charCode, i32 fontSize, bool isSdf=false);
+        
+        // render sdf glyph bitmap (thread safe)
+        bool renderSdfGlyph(i32 charCode, vector<Color>::type& oBitmap);
+        
+        // kerning between two chars in em units (font size 1)
+        float getKerning(i32 leftCharCode, i32 rightCharCode);
+        
+        // remove glyph, called when library evicts it
+        void removeGlyph(ui64 key);
+        
+        // glyph key
+        static ui64 makeKey(i32 charCode, i32 fontSize) { return (ui64(ui32(fontSize)) << 32) | ui32(charCode); }
         
     private:
         // load glyph
         FontGlyph* loadGlyph(i32 charCode, i32 fontSize);
         
+        // load and render glyph into the face slot, m_mutex must be locked
+        bool renderGlyph(i32 charCode, i32 pixelSize);
+        
         // copy glyph bitmap to texture
         FontGlyph* copyGlyphToTexture(i32 charCode, FT_GlyphSlot glyphSlot, i32 fontSize);
         bool copyGlyphToBitmap(Color* oColor, i32 ioWidth, i32 ioHeight, i32 charCode, FT_GlyphSlot glyphSlot);
 
 		// new glyph
-		FontGlyph* newGlyph(i32 charCode, FontTexture* texture, i32 nodeIndex);
+		FontGlyph* newGlyph(ui64 key, FontTexture* texture, const FontTexture::IRect& rect);
         
     private:
         String						m_file;
 		MemoryReader*				m_memory = nullptr;
-        FT_Face						m_face;
-		map<i32, FontGlyph*>::type	m_glyphs;
-        vector<FontTexture*>::type  m_fontTextures;
+        FT_Face						m_face = nullptr;
+        std::mutex                  m_mutex;                // FT_Face is used by sdf jobs too
+        i32                         m_pixelSize = 0;        // current FT pixel size
+		Glyphs						m_glyphs;
+        std::unordered_map<ui64, float> m_kernings;         // cached by char pair
     };
 }
@@ -4,15 +4,24 @@
 
 namespace Echo
 {
+    class FontFace;
     struct FontGlyph
     {
-		FontTexture*	m_texture = nullptr;
-		i32				m_nodeIndex = 0;
+		FontFace*					m_face = nullptr;
+		ui64						m_key = 0;				// (font size, char code) in its face
+		FontTexture*				m_texture = nullptr;
+		FontTexture::IRect			m_rect;
+		ui32						m_lastUsedFrame = 0;
+		bool						m_isFailed = false;		// freetype couldn't render it, never requested again
+		list<FontGlyph*>::iterator	m_lruIt;				// position in library lru list
 
 		FontGlyph();
 		~FontGlyph();
 
+		// sdf glyph still generated by its job or waiting for room in the cache
+		bool isPending() const { return !m_texture && !m_isFailed; }
+
 		// get uv
-		Vector4 getUV() const { return m_texture->getViewport(m_nodeIndex); }
+		Vector4 getUV() const { return m_texture->getViewport(m_rect); }
     };
 }
@@ -1,8 +1,37 @@
 #include "font_library.h"
 #include "engine/core/log/Log.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
+
+#define DEFAULT_FONT_TEXTURE_SIZE	1024
+#define MAX_FONT_TEXTURES			4
+#define MAX_EVICTED_GLYPHS			1024
+#define MAX_EVICTIONS_PER_GLYPH		16
 
 namespace Echo
 {
+    // generates one sdf glyph bitmap on a worker thread
+    struct FontSdfJob : public CpuThreadPool::Job
+    {
+        FontGlyph*              m_glyph = nullptr;
+        i32                     m_charCode = 0;
+        vector<Color>::type     m_bitmap;
+        bool                    m_isSucceed = false;
+        std::atomic<bool>       m_isFinished;
+        
+        FontSdfJob() : m_isFinished(false) {}
+        
+        virtual bool process() override
+        {
+            // the main thread may delete the job once it's finished, publish the flag last
+            bool isSucceed = m_glyph->m_face->renderSdfGlyph(m_charCode, m_bitmap);
+            m_isSucceed = isSucceed;
+            m_isFinished = true;
+            return isSucceed;
+        }
+        
+        virtual int getType() override { return -1; }
+    };
+    
     FontLibrary::FontLibrary()
     {
         FT_Error result = FT_Init_FreeType(&m_library);
@@ -14,7 +43,10 @@ namespace Echo
     
     FontLibrary::~FontLibrary()
     {
+        waitSdfJobs();
+        EchoSafeDeleteContainer(m_sdfJobs, FontSdfJob);
         EchoSafeDeleteContainer(m_fontFaces, FontFace);
+        EchoSafeDeleteContainer(m_fontTextures, FontTexture);
     }
     
     FontLibrary* FontLibrary::instance()
@@ -23,12 +55,12 @@ namespace Echo
         return inst;
     }
     
-    FontGlyph* FontLibrary::getFontGlyph(i32 charCode, const ResourcePath& fontPath, i32 fontSize)
+    FontGlyph* FontLibrary::getFontGlyph(i32 charCode, const ResourcePath& fontPath, i32 fontSize, bool isSdf)
     {
         FontFace* fontFace = loadFace( fontPath.getPath().c_str());
         if(fontFace)
         {
-            return fontFace->getGlyph(charCode, fontSize);
+            return fontFace->getGlyph(charCode, fontSize, isSdf);
         }
         
         return nullptr;
@@ -54,4 +86,196 @@ namespace Echo
     {
         return true;
     }
+    
+    FontTexture* FontLibrary::allocGlyph(Color* data, i32 width, i32 height, FontTexture::IRect& oRect)
+    {
+        // try to insert to exist font texture
+        for(FontTexture* fontTexture : m_fontTextures)
+        {
+            if(fontTexture->insert(data, width, height, oRect))
+                return fontTexture;
+        }
+        
+        // create new one
+        if(m_fontTextures.size() < MAX_FONT_TEXTURES)
+        {
+            FontTexture* newTexture = EchoNew(FontTexture(DEFAULT_FONT_TEXTURE_SIZE, DEFAULT_FONT_TEXTURE_SIZE));
+            m_fontTextures.emplace_back(newTexture);
+            if(newTexture->insert(data, width, height, oRect))
+                return newTexture;
+            
+            return nullptr;
+        }
+        
+        // all pages are full, evict glyphs until there is room. a glyph that doesn't fit after a few
+        // evictions waits for a later frame instead of emptying whole pages
+        for(i32 i=0; i<MAX_EVICTIONS_PER_GLYPH; i++)
+        {
+            FontTexture* fontTexture = evictGlyph();
+            if(!fontTexture)
+            {
+                EchoLogWarning("Font textures are full, glyphs used in one frame exceed the cache size");
+                break;
+            }
+            
+            if(fontTexture->insert(data, width, height, oRect))
+                return fontTexture;
+        }
+        
+        return nullptr;
+    }
+    
+    void FontLibrary::addGlyph(FontGlyph* glyph)
+    {
+        m_lruGlyphs.push_front(glyph);
+        glyph->m_lruIt = m_lruGlyphs.begin();
+        glyph->m_lastUsedFrame = m_frame;
+    }
+    
+    void FontLibrary::touchGlyph(FontGlyph* glyph)
+    {
+        if(glyph->m_lastUsedFrame != m_frame)
+        {
+            m_lruGlyphs.splice(m_lruGlyphs.begin(), m_lruGlyphs, glyph->m_lruIt);
+            glyph->m_lastUsedFrame = m_frame;
+        }
+    }
+    
+    void FontLibrary::releaseGlyphs(const FontFace::Glyphs& glyphs)
+    {
+        for(auto& it : glyphs)
+        {
+            // pending sdf glyphs aren't packed yet
+            FontGlyph* glyph = it.second;
+            if(glyph->m_texture)
+            {
+                glyph->m_texture->remove(glyph->m_rect);
+                m_lruGlyphs.erase(glyph->m_lruIt);
+            }
+        }
+        
+        // a whole face is gone, texts refresh all their glyphs
+        if(!glyphs.empty())
+        {
+            m_version++;
+            m_evictedGlyphs.clear();
+            m_evictedFrom = m_version;
+        }
+    }
+    
+    bool FontLibrary::getEvictedGlyphs(ui32 sinceVersion, vector<EvictedGlyph>::type& oGlyphs) const
+    {
+        if(sinceVersion < m_evictedFrom)
+            return false;
+        
+        for(auto it = m_evictedGlyphs.rbegin(); it != m_evictedGlyphs.rend() && it->m_version > sinceVersion; it++)
+            oGlyphs.emplace_back(*it);
+        
+        return true;
+    }
+    
+    FontTexture* FontLibrary::evictGlyph()
+    {
+        if(m_lruGlyphs.empty())
+            return nullptr;
+        
+        // the tail is the least recently used, glyphs of this frame are still referenced
+        FontGlyph* glyph = m_lruGlyphs.back();
+        if(glyph->m_lastUsedFrame == m_frame)
+            return nullptr;
+        
+        FontTexture* fontTexture = glyph->m_texture;
+        fontTexture->remove(glyph->m_rect);
+        m_lruGlyphs.pop_back();
+        glyph->m_face->removeGlyph(glyph->m_key);
+        m_version++;
+        
+        // remember it, so only texts using it rebuild their uvs
+        if(m_evictedGlyphs.size() >= MAX_EVICTED_GLYPHS)
+        {
+            m_evictedFrom = m_evictedGlyphs.front().m_version;
+            m_evictedGlyphs.pop_front();
+        }
+        m_evictedGlyphs.push_back({ m_version, glyph->m_face, glyph->m_key });
+        EchoSafeDelete(glyph, FontGlyph);
+        
+        return fontTexture;
+    }
+    
+    void FontLibrary::beginFrame()
+    {
+        m_frame++;
+        
+        updateSdfJobs();
+    }
+    
+    void FontLibrary::requestSdfGlyph(FontGlyph* glyph, i32 charCode)
+    {
+        FontSdfJob* job = EchoNew(FontSdfJob);
+        job->m_glyph = glyph;
+        job->m_charCode = charCode;
+        m_sdfJobs.emplace_back(job);
+        
+        CpuThreadPool* threadPool = OpenMPTaskMgr::instance()->getThreadPool();
+        if(threadPool->getNumThreads() > 0)
+        {
+            CpuThreadPool::Job* jobs[] = { job };
+            threadPool->processJobs(jobs, 1);
+        }
+        else
+        {
+            job->process();
+        }
+    }
+    
+    void FontLibrary::updateSdfJobs()
+    {
+        for(size_t i=0; i<m_sdfJobs.size();)
+        {
+            FontSdfJob* job = m_sdfJobs[i];
+            if(!job->m_isFinished)
+            {
+                i++;
+                continue;
+            }
+            
+            // texts waiting for it pick it up themselves, the version only tracks evictions
+            FontGlyph* glyph = job->m_glyph;
+            if(job->m_isSucceed)
+            {
+                glyph->m_texture = allocGlyph(job->m_bitmap.data(), FontFace::SDF_CELL_SIZE, FontFace::SDF_CELL_SIZE, glyph->m_rect);
+                if(!glyph->m_texture)
+                {
+                    // cache is full of glyphs of this frame, keep the bitmap and try again next frame
+                    i++;
+                    continue;
+                }
+                
+                addGlyph(glyph);
+            }
+            else
+            {
+                glyph->m_isFailed = true;
+            }
+            
+            EchoSafeDelete(job, FontSdfJob);
+            m_sdfJobs[i] = m_sdfJobs.back();
+            m_sdfJobs.pop_back();
+        }
+    }
+    
+    void FontLibrary::waitSdfJobs()
+    {
+        for(FontSdfJob* job : m_sdfJobs)
+        {
+            while(!job->m_isFinished)
+                std::this_thread::yield();
+        }
+    }
+    
+    void FontLibrary::flush()
+    {
+        for(FontTexture* fontTexture : m_fontTextures)
+            fontTexture->flush();
+    }
 }
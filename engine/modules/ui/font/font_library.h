@@ -6,8 +6,18 @@
 
 namespace Echo
 {
+    struct FontSdfJob;
     class FontLibrary
     {
+    public:
+        // glyph evicted from the cache
+        struct EvictedGlyph
+        {
+            ui32        m_version;      // library version after the eviction
+            FontFace*   m_face;
+            ui64        m_key;
+        };
+        
     public:
         ~FontLibrary();
         
@@ -15,18 +25,54 @@ namespace Echo
         static FontLibrary* instance();
         
         // get glyph
-        FontGlyph* getFontGlyph(i32 charCode, const ResourcePath& fontPath, i32 fontSize);
+        FontGlyph* getFontGlyph(i32 charCode, const ResourcePath& fontPath, i32 fontSize, bool isSdf=false);
+        
+        // new frame, glyphs used in current frame are never evicted. finished sdf glyphs are packed here
+        void beginFrame();
+        
+        // upload dirty regions of all pages
+        void flush();
+        
+        // changes whenever glyphs are evicted, cached uvs should be rebuilt
+        ui32 getVersion() const { return m_version; }
+        
+        // glyphs evicted after the version, false if the history doesn't reach back that far
+        bool getEvictedGlyphs(ui32 sinceVersion, vector<EvictedGlyph>::type& oGlyphs) const;
         
     public:
         // face manager
 		FontFace* loadFace(const char* filePath);
         bool unloadFace(const char* filePath);
         
+    public:
+        // glyph cache, used by FontFace
+        FontTexture* allocGlyph(Color* data, i32 width, i32 height, FontTexture::IRect& oRect);
+        void addGlyph(FontGlyph* glyph);
+        void touchGlyph(FontGlyph* glyph);
+        void releaseGlyphs(const FontFace::Glyphs& glyphs);
+        void requestSdfGlyph(FontGlyph* glyph, i32 charCode);
+        
     private:
         FontLibrary();
         
+        // evict least recently used glyph, return it's page
+        FontTexture* evictGlyph();
+        
+        // pack finished sdf glyphs
+        void updateSdfJobs();
+        
+        // wait until no sdf job is running
+        void waitSdfJobs();
+        
     private:
         FT_Library					m_library;
 		vector<FontFace*>::type		m_fontFaces;
+        vector<FontTexture*>::type  m_fontTextures;
+        vector<FontSdfJob*>::type   m_sdfJobs;
+        list<FontGlyph*>::type      m_lruGlyphs;        // front is the most recently used
+        ui32                        m_frame = 1;
+        ui32                        m_version = 0;
+        deque<EvictedGlyph>::type   m_evictedGlyphs;    // recent evictions, oldest first
+        ui32                        m_evictedFrom = 0;  // evictions after this version are all recorded
     };
 }
@@ -0,0 +1,94 @@
+#include "font_sdf.h"
+#include <cmath>
+#include <algorithm>
+
+#define SDF_INF 1e20f
+
+namespace Echo
+{
+	void FontSdf::generate(const Byte* coverage, i32 width, i32 height, float spread, Byte* oDistance)
+	{
+		i32 count = width * height;
+		vector<float>::type toOutside(count);
+		vector<float>::type toInside(count);
+		for (i32 i = 0; i < count; i++)
+		{
+			bool isInside = coverage[i] >= 128;
+			toOutside[i] = isInside ? SDF_INF : 0.f;
+			toInside[i] = isInside ? 0.f : SDF_INF;
+		}
+
+		transform(toOutside.data(), width, height);
+		transform(toInside.data(), width, height);
+
+		// pixel centers, the edge lies half a pixel away
+		for (i32 i = 0; i < count; i++)
+		{
+			bool isInside = coverage[i] >= 128;
+			float distance = isInside ? std::sqrt(toOutside[i]) - 0.5f : 0.5f - std::sqrt(toInside[i]);
+			float value = 0.5f + distance / (2.f * spread);
+			oDistance[i] = Byte(std::min(std::max(value, 0.f), 1.f) * 255.f + 0.5f);
+		}
+	}
+
+	void FontSdf::transform(float* grid, i32 width, i32 height)
+	{
+		i32 n = std::max(width, height);
+		vector<float>::type f(n);
+		vector<float>::type d(n);
+		vector<i32>::type v(n);
+		vector<float>::type z(n + 1);
+
+		// columns
+		for (i32 x = 0; x < width; x++)
+		{
+			for (i32 y = 0; y < height; y++)
+				f[y] = grid[y * width + x];
+
+			transform1D(f.data(), d.data(), v.data(), z.data(), height);
+			for (i32 y = 0; y < height; y++)
+				grid[y * width + x] = d[y];
+		}
+
+		// rows
+		for (i32 y = 0; y < height; y++)
+		{
+			float* row = grid + y * width;
+			transform1D(row, d.data(), v.data(), z.data(), width);
+			std::copy(d.begin(), d.begin() + width, row);
+		}
+	}
+
+	void FontSdf::transform1D(const float* f, float* d, i32* v, float* z, i32 n)
+	{
+		// lower envelope of parabolas rooted at (q, f(q))
+		i32 k = 0;
+		v[0] = 0;
+		z[0] = -SDF_INF;
+		z[1] = SDF_INF;
+		for (i32 q = 1; q < n; q++)
+		{
+			float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / float(2 * q - 2 * v[k]);
+			while (k > 0 && s <= z[k])
+			{
+				k--;
+				s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / float(2 * q - 2 * v[k]);
+			}
+
+			k++;
+			v[k] = q;
+			z[k] = s;
+			z[k + 1] = SDF_INF;
+		}
+
+		k = 0;
+		for (i32 q = 0; q < n; q++)
+		{
+			while (z[k + 1] < q)
+				k++;
+
+			float dq = float(q - v[k]);
+			d[q] = dq * dq + f[v[k]];
+		}
+	}
+}
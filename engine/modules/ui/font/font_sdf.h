@@ -0,0 +1,24 @@
+#pragma once
+
+#include "engine/core/base/type_def.h"
+#include "engine/core/memory/MemAllocDef.h"
+
+namespace Echo
+{
+	/**
+	 * Signed distance field from a coverage bitmap
+	 * Exact euclidean distance transform (Felzenszwalb & Huttenlocher)
+	 */
+	struct FontSdf
+	{
+		// coverage >= 128 is inside, output 128 is the edge and spread pixels map to 0 or 255
+		static void generate(const Byte* coverage, i32 width, i32 height, float spread, Byte* oDistance);
+
+	private:
+		// squared distance to the nearest pixel where grid is 0, in place
+		static void transform(float* grid, i32 width, i32 height);
+
+		// one dimension pass
+		static void transform1D(const float* f, float* d, i32* v, float* z, i32 n);
+	};
+}
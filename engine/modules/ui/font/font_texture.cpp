@@ -3,31 +3,13 @@
 #include "engine/core/resource/Res.h"
 #include "engine/core/render/base/Texture.h"
 
-#define INVALID -1
-
 namespace Echo
 {
-	FontTexture::Node::Node()
-		: m_id(INVALID)
-	{
-		m_child[0] = INVALID;
-		m_child[1] = INVALID;
-	}
-
-	bool FontTexture::Node::IsLeaf() const
-	{
-		return m_child[0] == INVALID && m_child[1] == INVALID;
-	}
-
 	FontTexture::FontTexture(int width, int height)
 		: m_width(width)
 		, m_height(height)
-		, m_textureData(NULL)
 	{
-		Node rootNode;
-		rootNode.m_rc = IRect(0, 0, m_width, m_height);
-		m_nodes.reserve(256);
-		m_nodes.emplace_back(rootNode);
+		reset();
 	}
 
 	FontTexture::~FontTexture()
@@ -35,151 +17,342 @@ namespace Echo
 		EchoSafeFree(m_textureData);
 	}
 
-	const Vector4 FontTexture::getViewport(int nodeIdx) const
+	void FontTexture::reset()
+	{
+		SkylineNode node;
+		node.m_x = 0;
+		node.m_y = 0;
+		node.m_width = m_width;
+
+		m_skyline.clear();
+		m_skyline.emplace_back(node);
+		m_freeRects.clear();
+		m_glyphCount = 0;
+	}
+
+	const Vector4 FontTexture::getViewport(const IRect& rect) const
 	{
 		Vector4	result;
-		const IRect& tRc = m_nodes[nodeIdx].m_rc;
-		result.x = static_cast<float>(tRc.left) / static_cast<float>(m_width);
-		result.y = static_cast<float>(tRc.top) / static_cast<float>(m_height);
-		result.z = static_cast<float>(tRc.width) / static_cast<float>(m_width);
-		result.w = static_cast<float>(tRc.height) / static_cast<float>(m_height);
+		result.x = static_cast<float>(rect.left) / static_cast<float>(m_width);
+		result.y = static_cast<float>(rect.top) / static_cast<float>(m_height);
+		result.z = static_cast<float>(rect.width) / static_cast<float>(m_width);
+		result.w = static_cast<float>(rect.height) / static_cast<float>(m_height);
 
 		return result;
 	}
 
-	int FontTexture::insert(Color* data, int width, int height)
+	bool FontTexture::insert(Color* data, int width, int height, IRect& oRect)
 	{
-		if (!data)
-			return INVALID;
+		if (!data || !allocate(width, height, oRect))
+			return false;
 
-		int nodeIdx = insert(0, data, width, height);
+		overWrite(oRect, data);
+		m_glyphCount++;
 
-		return overWrite(nodeIdx, data, width, height);
+		return true;
 	}
 
-	int FontTexture::overWrite(int nodeIdx, Color* data, int width, int height)
+	void FontTexture::remove(const IRect& rect)
 	{
-		if (nodeIdx != INVALID)
-		{
-			m_nodes[nodeIdx].m_id = nodeIdx;
-			size_t pixelsize = PixelUtil::GetPixelSize(m_format);
+		m_glyphCount--;
 
-			// copy pixels over from texture to pNode->m_rc part of texture
-			if (!m_textureData)
+		// page is empty, start over with a flat skyline
+		if (m_glyphCount <= 0)
+			reset();
+		else
+			addFreeRect(rect);
+	}
+
+	void FontTexture::addFreeRect(IRect rect)
+	{
+		for (size_t i = 0; i < m_freeRects.size();)
+		{
+			const IRect& rc = m_freeRects[i];
+			bool isRow = rc.top == rect.top && rc.height == rect.height && (rc.left + rc.width == rect.left || rect.left + rect.width == rc.left);
+			bool isColumn = rc.left == rect.left && rc.width == rect.width && (rc.top + rc.height == rect.top || rect.top + rect.height == rc.top);
+			if (isRow || isColumn)
 			{
-				m_textureData = EchoMalloc(m_width*m_height*pixelsize);
-				memset(m_textureData, 0, m_width*m_height*pixelsize);
+				// the merged rect may now match another neighbour, start over
+				rect = isRow ? IRect(std::min(rc.left, rect.left), rect.top, rc.width + rect.width, rect.height)
+							 : IRect(rect.left, std::min(rc.top, rect.top), rect.width, rc.height + rect.height);
+				m_freeRects[i] = m_freeRects.back();
+				m_freeRects.pop_back();
+				i = 0;
 			}
-			const IRect& rc = m_nodes[nodeIdx].m_rc;
-
-			Dword* pDestData = (Dword*)m_textureData;
-			for (int h = 0; h < height; h++)
+			else
 			{
-				for (int w = 0; w < width; w++)
-				{
-					int destIdx = (rc.top + h) * m_width + w + rc.left;
-					int srcIdx = h * width + w;
-					const Color& color = data[srcIdx];
-					pDestData[destIdx] = color.getABGR();
-				}
+				i++;
 			}
+		}
 
-			return nodeIdx;
+		if (!sinkSkyline(rect))
+		{
+			m_freeRects.emplace_back(rect);
+			return;
 		}
 
-		return INVALID;
+		// free rects right under the lowered skyline go back too
+		for (size_t i = 0; i < m_freeRects.size();)
+		{
+			if (sinkSkyline(m_freeRects[i]))
+			{
+				m_freeRects[i] = m_freeRects.back();
+				m_freeRects.pop_back();
+				i = 0;
+			}
+			else
+			{
+				i++;
+			}
+		}
 	}
 
-	void FontTexture::refreshTexture()
+	bool FontTexture::sinkSkyline(const IRect& rect)
 	{
-		size_t pixelsize = PixelUtil::GetPixelSize(m_format);
-		Buffer buffer(ui32(m_width*m_height*pixelsize), m_textureData, false);
-		if (m_texture)
+		int right = rect.left + rect.width;
+		int bottom = rect.top + rect.height;
+		for (const SkylineNode& node : m_skyline)
 		{
-            m_texture->updateTexture2D(m_format, Texture::TU_GPU_READ, m_width, m_height, buffer.getData(), buffer.getSize());
+			if (node.m_x < right && node.m_x + node.m_width > rect.left && node.m_y != bottom)
+				return false;
 		}
-		else
+
+		splitSkyline(rect.left);
+		splitSkyline(right);
+		for (SkylineNode& node : m_skyline)
 		{
-            m_texture = Texture::createTexture2D(m_format, Texture::TU_GPU_READ, m_width, m_height, buffer.getData(), buffer.getSize());
+			if (node.m_x >= rect.left && node.m_x + node.m_width <= right)
+				node.m_y = rect.top;
 		}
+
+		mergeSkyline();
+		return true;
 	}
 
-	int FontTexture::insert(int nodeIdx, Color* data, int width, int height)
+	void FontTexture::splitSkyline(int x)
 	{
-		if (nodeIdx == INVALID)
-			return INVALID;
+		for (size_t i = 0; i < m_skyline.size(); i++)
+		{
+			SkylineNode& node = m_skyline[i];
+			if (node.m_x < x && x < node.m_x + node.m_width)
+			{
+				SkylineNode right = node;
+				right.m_x = x;
+				right.m_width = node.m_x + node.m_width - x;
+				node.m_width = x - node.m_x;
+				m_skyline.insert(m_skyline.begin() + i + 1, right);
+				return;
+			}
+		}
+	}
+
+	bool FontTexture::allocate(int width, int height, IRect& oRect)
+	{
+		if (width <= 0 || height <= 0 || width > m_width || height > m_height)
+			return false;
+
+		// evicted glyphs first, keeps the skyline low
+		if (allocateFromFreeRects(width, height, oRect))
+			return true;
 
-		// if we're not a leaf then
-		if (!m_nodes[nodeIdx].IsLeaf())
+		return allocateFromSkyline(width, height, oRect);
+	}
+
+	bool FontTexture::allocateFromFreeRects(int width, int height, IRect& oRect)
+	{
+		int bestIdx = -1;
+		for (size_t i = 0; i < m_freeRects.size(); i++)
 		{
-			int child0Idx = m_nodes[nodeIdx].m_child[0];
-			int child1Idx = m_nodes[nodeIdx].m_child[1];
-			if (child0Idx != INVALID && child1Idx != INVALID)
+			const IRect& rc = m_freeRects[i];
+			if (rc.width >= width && rc.height >= height)
 			{
-				if (m_nodes[child0Idx].m_rc.getArea() > m_nodes[child1Idx].m_rc.getArea())
-					std::swap(child0Idx, child1Idx);
+				if (bestIdx == -1 || rc.getArea() < m_freeRects[bestIdx].getArea())
+					bestIdx = int(i);
 			}
+		}
+
+		if (bestIdx == -1)
+			return false;
+
+		IRect freeRect = m_freeRects[bestIdx];
+		m_freeRects[bestIdx] = m_freeRects.back();
+		m_freeRects.pop_back();
 
-			// try inserting into first child
-			int newIdx = insert(child0Idx, data, width, height);
-			if (newIdx != INVALID)
-				return newIdx;
+		// give the remainder back
+		if (freeRect.width > width)
+			m_freeRects.emplace_back(freeRect.left + width, freeRect.top, freeRect.width - width, height);
+		if (freeRect.height > height)
+			m_freeRects.emplace_back(freeRect.left, freeRect.top + height, freeRect.width, freeRect.height - height);
 
-			// no room, insert into second
-			return insert(child1Idx, data, width, height);
+		oRect = IRect(freeRect.left, freeRect.top, width, height);
+		return true;
+	}
+
+	bool FontTexture::allocateFromSkyline(int width, int height, IRect& oRect)
+	{
+		// bottom left rule
+		int bestIdx = -1;
+		int bestBottom = m_height + 1;
+		int bestWidth = m_width + 1;
+		for (size_t i = 0; i < m_skyline.size(); i++)
+		{
+			int y = fitSkyline(int(i), width, height);
+			if (y >= 0)
+			{
+				int bottom = y + height;
+				if (bottom < bestBottom || (bottom == bestBottom && m_skyline[i].m_width < bestWidth))
+				{
+					bestIdx = int(i);
+					bestBottom = bottom;
+					bestWidth = m_skyline[i].m_width;
+					oRect = IRect(m_skyline[i].m_x, y, width, height);
+				}
+			}
 		}
-		else
+
+		if (bestIdx == -1)
+			return false;
+
+		addSkylineLevel(bestIdx, oRect);
+		return true;
+	}
+
+	int FontTexture::fitSkyline(int index, int width, int height) const
+	{
+		int x = m_skyline[index].m_x;
+		if (x + width > m_width)
+			return -1;
+
+		int y = m_skyline[index].m_y;
+		int widthLeft = width;
+		for (size_t i = index; widthLeft > 0 && i < m_skyline.size(); i++)
 		{
-			// if there is already a lightmap here, return
-			if (m_nodes[nodeIdx].m_id != INVALID)
-				return INVALID;
+			y = std::max(y, m_skyline[i].m_y);
+			if (y + height > m_height)
+				return -1;
 
-			int texWidth = static_cast<int>(width);
-			int texHeight = static_cast<int>(height);
+			widthLeft -= m_skyline[i].m_width;
+		}
 
-			// if we're too small, return
-			if (m_nodes[nodeIdx].m_rc.width < texWidth || m_nodes[nodeIdx].m_rc.height < texHeight)
-				return INVALID;
+		return y;
+	}
 
-			// if we'rs just right accept, "no surplus space"
-			if (m_nodes[nodeIdx].m_rc.width == texWidth && m_nodes[nodeIdx].m_rc.height == texHeight)
-				return nodeIdx;
+	void FontTexture::addSkylineLevel(int index, const IRect& rect)
+	{
+		SkylineNode node;
+		node.m_x = rect.left;
+		node.m_y = rect.top + rect.height;
+		node.m_width = rect.width;
+		m_skyline.insert(m_skyline.begin() + index, node);
+
+		// shrink or remove the segments covered by the new one
+		for (size_t i = index + 1; i < m_skyline.size();)
+		{
+			const SkylineNode& prev = m_skyline[i - 1];
+			SkylineNode& cur = m_skyline[i];
+			if (cur.m_x >= prev.m_x + prev.m_width)
+				break;
 
-			// otherwise, gotta split this node and create some kids
-			Node node0, node1;
+			int shrink = prev.m_x + prev.m_width - cur.m_x;
+			cur.m_x += shrink;
+			cur.m_width -= shrink;
+			if (cur.m_width > 0)
+				break;
 
-			// deside split pattern
-			int dw = m_nodes[nodeIdx].m_rc.width - texWidth;
-			int dh = m_nodes[nodeIdx].m_rc.height - texHeight;
+			m_skyline.erase(m_skyline.begin() + i);
+		}
 
-			const IRect& nRect = m_nodes[nodeIdx].m_rc;
-			if (dw > dh)
+		mergeSkyline();
+	}
+
+	void FontTexture::mergeSkyline()
+	{
+		for (size_t i = 0; i + 1 < m_skyline.size();)
+		{
+			if (m_skyline[i].m_y == m_skyline[i + 1].m_y)
 			{
-				node0.m_rc = IRect(nRect.left + texWidth, nRect.top, nRect.width - texWidth, nRect.height);
-				node1.m_rc = IRect(nRect.left, nRect.top + texHeight, texWidth, nRect.height - texHeight);
+				m_skyline[i].m_width += m_skyline[i + 1].m_width;
+				m_skyline.erase(m_skyline.begin() + i + 1);
 			}
 			else
 			{
-				node0.m_rc = IRect(nRect.left + texWidth, nRect.top, nRect.width - texWidth, texHeight);
-				node1.m_rc = IRect(nRect.left, nRect.top + texHeight, nRect.width, nRect.height - texHeight);
+				i++;
 			}
+		}
+	}
 
-			// add to subnode with space
-			if (node0.m_rc.getArea() > 0)
+	void FontTexture::overWrite(const IRect& rect, Color* data)
+	{
+		if (!m_textureData)
+		{
+			size_t pixelsize = PixelUtil::GetPixelSize(m_format);
+			m_textureData = (Dword*)EchoMalloc(m_width*m_height*pixelsize);
+			memset(m_textureData, 0, m_width*m_height*pixelsize);
+		}
+
+		for (int h = 0; h < rect.height; h++)
+		{
+			for (int w = 0; w < rect.width; w++)
 			{
-				m_nodes[nodeIdx].m_child[0] = int(m_nodes.size());
-				m_nodes.emplace_back(node0);
+				int destIdx = (rect.top + h) * m_width + w + rect.left;
+				int srcIdx = h * rect.width + w;
+				m_textureData[destIdx] = data[srcIdx].getABGR();
 			}
-			if (node1.m_rc.getArea() > 0)
+		}
+
+		// grow dirty region
+		if (m_isDirty)
+		{
+			int right = std::max(m_dirtyRect.left + m_dirtyRect.width, rect.left + rect.width);
+			int bottom = std::max(m_dirtyRect.top + m_dirtyRect.height, rect.top + rect.height);
+			m_dirtyRect.left = std::min(m_dirtyRect.left, rect.left);
+			m_dirtyRect.top = std::min(m_dirtyRect.top, rect.top);
+			m_dirtyRect.width = right - m_dirtyRect.left;
+			m_dirtyRect.height = bottom - m_dirtyRect.top;
+		}
+		else
+		{
+			m_dirtyRect = rect;
+			m_isDirty = true;
+		}
+	}
+
+	Texture* FontTexture::getTexture()
+	{
+		if (!m_texture)
+			flush();
+
+		return m_texture;
+	}
+
+	void FontTexture::flush()
+	{
+		size_t pixelsize = PixelUtil::GetPixelSize(m_format);
+		if (!m_texture)
+		{
+			if (!m_textureData)
 			{
-				m_nodes[nodeIdx].m_child[1] = int(m_nodes.size());
-				m_nodes.emplace_back(node1);
+				m_textureData = (Dword*)EchoMalloc(m_width*m_height*pixelsize);
+				memset(m_textureData, 0, m_width*m_height*pixelsize);
 			}
 
-			m_nodes[nodeIdx].m_rc.width = texWidth;
-			m_nodes[nodeIdx].m_rc.height = texHeight;
+			Buffer buffer(ui32(m_width*m_height*pixelsize), m_textureData, false);
+			m_texture = Texture::createTexture2D(m_format, Texture::TU_GPU_READ, m_width, m_height, buffer.getData(), buffer.getSize());
+		}
+		else if (m_isDirty)
+		{
+			// sub rect upload needs tightly packed rows
+			m_uploadData.resize(m_dirtyRect.getArea());
+			for (int h = 0; h < m_dirtyRect.height; h++)
+			{
+				const Dword* src = m_textureData + (m_dirtyRect.top + h) * m_width + m_dirtyRect.left;
+				std::memcpy(&m_uploadData[h * m_dirtyRect.width], src, m_dirtyRect.width * sizeof(Dword));
+			}
 
-			return nodeIdx;
+			Rect rect(float(m_dirtyRect.left), float(m_dirtyRect.top), float(m_dirtyRect.left + m_dirtyRect.width), float(m_dirtyRect.top + m_dirtyRect.height));
+			m_texture->updateSubTex2D(0, rect, m_uploadData.data(), ui32(m_uploadData.size() * sizeof(Dword)));
 		}
+
+		m_isDirty = false;
 	}
 }
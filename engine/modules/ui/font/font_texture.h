@@ -6,6 +6,13 @@
 
 namespace Echo
 {
+	/**
+	 * Font texture page
+	 * Glyphs are packed by a skyline allocator, removed glyphs leave
+	 * free rects which merge with their neighbours and sink the skyline
+	 * when they lie on top of it. Only the dirty region is uploaded when
+	 * the page is flushed.
+	 */
     class FontTexture
     {
 	public:
@@ -30,55 +37,86 @@ namespace Echo
 		};
 		typedef TRect<int> IRect;
 
-		// Node
-		struct Node
+		// Skyline segment
+		struct SkylineNode
 		{
-			int			m_id;
-			int			m_child[2];
-			IRect		m_rc;
-
-			Node();
-
-			// is leaf node
-			bool IsLeaf() const;
+			int			m_x;
+			int			m_y;
+			int			m_width;
 		};
 
 	public:
 		FontTexture(int width, int height);
 		~FontTexture();
 
-		// insert data, return node idx
-		int insert(Color* data, int width, int height);
+		// insert data, return false if there is no space
+		bool insert(Color* data, int width, int height, IRect& oRect);
 
-		// overwrite data
-		int overWrite(int nodeIdx, Color* data, int width, int height);
+		// release the rect of a removed glyph
+		void remove(const IRect& rect);
 
-		// get node viewport
-		const Vector4 getViewport(int nodeIdx) const;
-
-		// get node info
-		const Node& getNode(int nodeIdx) const { return m_nodes[nodeIdx]; }
+		// get rect viewport
+		const Vector4 getViewport(const IRect& rect) const;
 
 		// width & height
 		int getWidth() const { return m_width; }
 		int getHeight() const { return m_height; }
 
+		// glyph count
+		int getGlyphCount() const { return m_glyphCount; }
+
+		// free rects left by removed glyphs, below the skyline
+		const vector<IRect>::type& getFreeRects() const { return m_freeRects; }
+
+		// skyline
+		const vector<SkylineNode>::type& getSkyline() const { return m_skyline; }
+
 		// get texture
-		Texture* getTexture() { return m_texture; }
- 
-		// refresh texture
-		void refreshTexture();
+		Texture* getTexture();
+
+		// upload dirty region to texture
+		void flush();
 
 	private:
-		// modify data
-		int insert(int nodeIdx, Color* data, int width, int height);
+		// allocate rect
+		bool allocate(int width, int height, IRect& oRect);
+		bool allocateFromFreeRects(int width, int height, IRect& oRect);
+		bool allocateFromSkyline(int width, int height, IRect& oRect);
+
+		// the y a rect of width would rest on when placed at skyline node index, -1 if it doesn't fit
+		int fitSkyline(int index, int width, int height) const;
+
+		// raise skyline by placed rect
+		void addSkylineLevel(int index, const IRect& rect);
+
+		// merge skyline segments of same height
+		void mergeSkyline();
+
+		// split the skyline segment crossing x
+		void splitSkyline(int x);
+
+		// lower the skyline over a free rect lying right below it, return false if it isn't on top
+		bool sinkSkyline(const IRect& rect);
+
+		// merge free rect with the ones sharing a whole edge, then give it back to the skyline if possible
+		void addFreeRect(IRect rect);
+		// copy pixels
+		void overWrite(const IRect& rect, Color* data);
+
+		// reset
+		void reset();
 
 	private:
-		int					m_width = 0;
-		int					m_height = 0;
-		vector<Node>::type	m_nodes;
-		void*				m_textureData = nullptr;
-		PixelFormat			m_format = PF_RGBA8_UNORM;
-		TexturePtr			m_texture;
+		int							m_width = 0;
+		int							m_height = 0;
+		int							m_glyphCount = 0;
+		vector<SkylineNode>::type	m_skyline;
+		vector<IRect>::type			m_freeRects;
+		Dword*						m_textureData = nullptr;
+		PixelFormat					m_format = PF_RGBA8_UNORM;
+		TexturePtr					m_texture;
+		bool						m_isDirty = false;
+		IRect						m_dirtyRect;
+		vector<Dword>::type			m_uploadData;
     };
 }
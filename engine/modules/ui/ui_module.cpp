@@ -61,4 +61,9 @@ namespace Echo
 		REGISTER_OBJECT_EDITOR(UiImage, UiImageEditor)
         REGISTER_OBJECT_EDITOR(UiEventRegionRect, UiEventRegionRectEditor)
 	}
+
+	void UiModule::update(float elapsedTime)
+	{
+		FontLibrary::instance()->beginFrame();
+	}
 }
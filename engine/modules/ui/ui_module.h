@@ -18,6 +18,7 @@ namespace Echo
 		// register all types of the module
 		virtual void registerTypes() override;
 
-		// get font
+		// update
+		virtual void update(float elapsedTime) override;
 	};
 }
@@ -0,0 +1,228 @@
+#include "video_decoder.h"
+#include "engine/core/io/IO.h"
+#include "engine/core/log/Log.h"
+#include "engine/core/thread/OpenMPTaskMgr.h"
+
+namespace Echo
+{
+	VideoDecoder::VideoDecoder(const String& path, bool isLoop)
+		: m_isLoop(isLoop)
+		, m_width(0)
+		, m_height(0)
+		, m_codedWidth(0)
+		, m_codedHeight(0)
+	{
+		m_stream = IO::instance()->open(path);
+		if (!m_stream)
+		{
+			EchoLogError("VideoDecoder: Could not open [%s].", path.c_str());
+			return;
+		}
+
+		for (ui32 i = 0; i < FRAME_QUEUE_SIZE + 1; i++)
+			m_freeFrames.emplace_back(EchoNew(Frame));
+
+		restart();
+
+#ifndef ECHO_PLATFORM_HTML5
+		m_thread = std::thread(&VideoDecoder::run, this);
+#endif
+	}
+
+	VideoDecoder::~VideoDecoder()
+	{
+#ifndef ECHO_PLATFORM_HTML5
+		if (m_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_isExit = true;
+			}
+
+			m_condition.notify_one();
+			m_thread.join();
+		}
+#endif
+
+		delete m_demuxer;
+		delete m_decoder;
+		EchoSafeDeleteContainer(m_frames, Frame);
+		EchoSafeDeleteContainer(m_freeFrames, Frame);
+		EchoSafeDelete(m_stream, DataStream);
+	}
+
+	void VideoDecoder::restart()
+	{
+		delete m_demuxer;
+		delete m_decoder;
+
+		m_decoder = new cmpeg::decoder_mpeg1();
+		m_decoder->connect(this);
+
+		// slices of a picture are independent, the decoder thread helps the pool with them
+		m_decoder->set_parallel_for([](int count, const std::function<void(int)>& task)
+		{
+			OpenMPTaskMgr::instance()->getThreadPool()->parallelFor(ui32(count), [&task](ui32 i) { task(i32(i)); });
+		});
+
+		m_demuxer = new cmpeg::demuxer_ts();
+		m_demuxer->connect(cmpeg::demuxer_ts::VIDEO_1, m_decoder);
+
+		m_stream->seek(0);
+	}
+
+	bool VideoDecoder::decode()
+	{
+		if (!m_stream->eof())
+		{
+			m_chunk.resize(READ_SIZE);
+			m_chunk.resize(m_stream->read(m_chunk.data(), READ_SIZE));
+			if (!m_chunk.empty())
+				m_demuxer->write(m_chunk);
+
+			if (m_stream->eof())
+				m_demuxer->flush();
+
+			return true;
+		}
+
+		// pictures still buffered in the decoder
+		if (m_decoder->decode())
+			return true;
+
+		if (m_isLoop && m_decoder->get_current_frame() > 0)
+		{
+			// timeline keeps running, the next pass starts a frame after the last one
+			m_loopOffset = m_lastTime + 1.0 / std::max(m_decoder->get_frame_rate(), 1.0);
+			m_isLoopStart = true;
+			restart();
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isEnd = true;
+		return false;
+	}
+
+	void VideoDecoder::run()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_isExit)
+		{
+			// bounded queue, a chunk rarely holds more than one picture
+			if (m_frames.size() >= FRAME_QUEUE_SIZE || m_isEnd)
+			{
+				m_condition.wait(lock);
+				continue;
+			}
+
+			lock.unlock();
+			decode();
+			lock.lock();
+		}
+	}
+
+	void VideoDecoder::update()
+	{
+#ifdef ECHO_PLATFORM_HTML5
+		while (true)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_frames.size() >= FRAME_QUEUE_SIZE || m_isEnd)
+					break;
+			}
+
+			decode();
+		}
+#endif
+	}
+
+	void VideoDecoder::resize(int width, int height)
+	{
+		// mpeg1 planes are padded to whole macroblocks
+		m_width = width;
+		m_height = height;
+		m_codedWidth = (width + 15) & ~15;
+		m_codedHeight = (height + 15) & ~15;
+	}
+
+	void VideoDecoder::render(const uint8_t* Y, const uint8_t* Cr, const uint8_t* Cb)
+	{
+		Frame* frame = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_freeFrames.empty())
+			{
+				frame = m_freeFrames.front();
+				m_freeFrames.pop_front();
+			}
+		}
+
+		// pool ran dry, the queue is over it's bound by a picture or two
+		if (!frame)
+			frame = EchoNew(Frame);
+
+		size_t lumaSize = size_t(m_codedWidth) * m_codedHeight;
+		frame->m_y.assign(Y, Y + lumaSize);
+		frame->m_cb.assign(Cb, Cb + lumaSize / 4);
+		frame->m_cr.assign(Cr, Cr + lumaSize / 4);
+
+		// pictures are evenly spaced, skipped b frames included
+		m_lastTime = m_loopOffset + (m_decoder->get_current_frame() - 1) / std::max(m_decoder->get_frame_rate(), 1.0);
+		frame->m_time = m_lastTime;
+		frame->m_isLoopStart = m_isLoopStart;
+		m_isLoopStart = false;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_frames.emplace_back(frame);
+	}
+
+	VideoDecoder::Frame* VideoDecoder::acquireFrame(double time)
+	{
+		Frame* result = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			while (!m_frames.empty() && m_frames.front()->m_time <= time)
+			{
+				// late frames are dropped, but a loop start is never skipped
+				if (result)
+				{
+					if (result->m_isLoopStart)
+						break;
+
+					m_freeFrames.emplace_back(result);
+				}
+
+				result = m_frames.front();
+				m_frames.pop_front();
+			}
+		}
+
+		if (result)
+			m_condition.notify_one();
+
+		return result;
+	}
+
+	void VideoDecoder::releaseFrame(Frame* frame)
+	{
+		if (frame)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_freeFrames.size() < FRAME_QUEUE_SIZE + 1)
+			{
+				m_freeFrames.emplace_back(frame);
+				return;
+			}
+		}
+
+		EchoSafeDelete(frame, Frame);
+	}
+
+	bool VideoDecoder::isEnd()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_isEnd && m_frames.empty();
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "engine/core/io/stream/DataStream.h"
+#include "video_base.h"
+#include <thirdparty/jplayer/render_base.h>
+#include <thirdparty/jplayer/demuxer_ts.h>
+#include <thirdparty/jplayer/decoder_mpeg1.h>
+
+namespace Echo
+{
+	/**
+	 * Video decoder
+	 * Demuxes a local MPEG-TS file read through IO and decodes the MPEG1 video
+	 * on it's own thread, a few frames ahead of the presentation clock.
+	 */
+	class VideoDecoder : public cmpeg::render_base
+	{
+	public:
+		static const ui32 FRAME_QUEUE_SIZE = 4;
+		static const ui32 READ_SIZE = 188 * 32;			// whole ts packets
+
+		// decoded frame, planes are macroblock aligned
+		struct Frame
+		{
+			double					m_time = 0.0;		// seconds from the start of the video
+			bool					m_isLoopStart = false;
+			vector<ui8>::type		m_y;
+			vector<ui8>::type		m_cb;
+			vector<ui8>::type		m_cr;
+		};
+		typedef list<Frame*>::type FrameList;
+
+	public:
+		VideoDecoder(const String& path, bool isLoop);
+		virtual ~VideoDecoder();
+
+		// file opened
+		bool isValid() const { return m_stream != nullptr; }
+
+		// loop, decoding restarts at the end of the file
+		void setLoop(bool isLoop) { m_isLoop = isLoop; }
+
+		// picture size, aligned size of the planes
+		i32 getWidth() const { return m_width; }
+		i32 getHeight() const { return m_height; }
+		i32 getCodedWidth() const { return m_codedWidth; }
+		i32 getCodedHeight() const { return m_codedHeight; }
+
+		// latest frame due at time, older ones are dropped. null if none is due
+		Frame* acquireFrame(double time);
+		void releaseFrame(Frame* frame);
+
+		// every frame was presented
+		bool isEnd();
+
+		// main thread, every frame. decodes inline where there are no threads
+		void update();
+
+	public:
+		// cmpeg::render_base, decoder thread
+		virtual void resize(int width, int height) override;
+		virtual void render(const uint8_t* Y, const uint8_t* Cr, const uint8_t* Cb) override;
+
+	private:
+		// (re)create demuxer & decoder, rewind the file
+		void restart();
+
+		// feed one chunk of the file, return false if there's nothing left to decode
+		bool decode();
+
+		// thread loop
+		void run();
+
+	private:
+		DataStream*					m_stream = nullptr;
+		cmpeg::demuxer_ts*			m_demuxer = nullptr;
+		cmpeg::decoder_mpeg1*		m_decoder = nullptr;
+		std::vector<uint8_t>		m_chunk;
+		std::atomic<bool>			m_isLoop;
+		std::atomic<i32>			m_width;
+		std::atomic<i32>			m_height;
+		std::atomic<i32>			m_codedWidth;
+		std::atomic<i32>			m_codedHeight;
+		double						m_loopOffset = 0.0;
+		double						m_lastTime = 0.0;
+		bool						m_isLoopStart = false;
+		std::thread					m_thread;
+		std::mutex					m_mutex;
+		std::condition_variable		m_condition;
+		FrameList					m_frames;			// decoded, oldest first
+		FrameList					m_freeFrames;
+		bool						m_isEnd = false;
+		bool						m_isExit = false;
+	};
+}
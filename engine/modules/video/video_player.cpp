@@ -1,15 +1,82 @@
 #include "video_player.h"
 #include "engine/core/main/Engine.h"
 #include "engine/core/io/IO.h"
+#include "engine/core/log/Log.h"
+#include "engine/core/render/base/Renderer.h"
+#include "engine/core/render/base/ShaderProgram.h"
+#include "engine/modules/audio/audio_device.h"
+
+static const char* g_yuvVsCode = R"(#version 450
+
+// uniforms
+layout(binding = 0) uniform UBO
+{
+	mat4 u_WorldMatrix;
+	mat4 u_ViewProjMatrix;
+} vs_ubo;
+
+// inputs
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec2 a_UV;
+
+// outputs
+layout(location = 0) out vec2 v_TexCoord;
+
+void main(void)
+{
+    vec4 position = vs_ubo.u_WorldMatrix * vec4(a_Position, 1.0);
+    position = vs_ubo.u_ViewProjMatrix * position;
+    gl_Position = position;
+    
+    v_TexCoord = a_UV;
+}
+)";
+
+static const char* g_yuvPsCode = R"(#version 450
+
+precision mediump float;
+
+// uniforms
+layout(binding = 3) uniform sampler2D TextureY;
+layout(binding = 4) uniform sampler2D TextureCb;
+layout(binding = 5) uniform sampler2D TextureCr;
+
+// inputs
+layout(location = 0) in vec2  v_TexCoord;
+
+// outputs
+layout(location = 0) out vec4 o_FragColor;
+
+void main(void)
+{
+    // bt.601, video range
+    float y = texture(TextureY, v_TexCoord).r;
+    float cb = texture(TextureCb, v_TexCoord).r - 0.5;
+    float cr = texture(TextureCr, v_TexCoord).r - 0.5;
+    y = (y - 0.0625) * 1.164;
+
+    vec3 color = vec3(y + 1.596 * cr, y - 0.391 * cb - 0.813 * cr, y + 2.018 * cb);
+    o_FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
+)";
 
 namespace Echo
 {
 	VideoPlayer::VideoPlayer()
+		: Render()
 	{
+		m_texture = ECHO_CREATE_RES(TextureVideo);
 	}
 
 	VideoPlayer::~VideoPlayer()
 	{
+		stop();
+
+		if (m_voice)
+			AudioDevice::instance()->getVoiceManager()->destroyVoice(m_voice);
+
+		EchoSafeRelease(m_renderable);
+		m_mesh.reset();
 	}
 
 	void VideoPlayer::bindMethods()
@@ -20,29 +87,75 @@ namespace Echo
         CLASS_BIND_METHOD(VideoPlayer, setLoop,             DEF_METHOD("setLoop"));
         CLASS_BIND_METHOD(VideoPlayer, isPlayOnAwake,       DEF_METHOD("isPlayOnAwake"));
         CLASS_BIND_METHOD(VideoPlayer, setPlayOnAwake,      DEF_METHOD("setPlayOnAwake"));
+		CLASS_BIND_METHOD(VideoPlayer, getWidth,		    DEF_METHOD("getWidth"));
+		CLASS_BIND_METHOD(VideoPlayer, setWidth,		    DEF_METHOD("setWidth"));
+		CLASS_BIND_METHOD(VideoPlayer, getHeight,		    DEF_METHOD("getHeight"));
+		CLASS_BIND_METHOD(VideoPlayer, setHeight,		    DEF_METHOD("setHeight"));
+		CLASS_BIND_METHOD(VideoPlayer, getVolume,		    DEF_METHOD("getVolume"));
+		CLASS_BIND_METHOD(VideoPlayer, setVolume,		    DEF_METHOD("setVolume"));
+		CLASS_BIND_METHOD(VideoPlayer, isPlaying,		    DEF_METHOD("isPlaying"));
+		CLASS_BIND_METHOD(VideoPlayer, play,			    DEF_METHOD("play"));
+		CLASS_BIND_METHOD(VideoPlayer, pause,			    DEF_METHOD("pause"));
+		CLASS_BIND_METHOD(VideoPlayer, stop,			    DEF_METHOD("stop"));
         CLASS_BIND_METHOD(VideoPlayer, getVideo,	        DEF_METHOD("getVideo"));
         CLASS_BIND_METHOD(VideoPlayer, setVideo,	        DEF_METHOD("setVideo"));
+		CLASS_BIND_METHOD(VideoPlayer, getAudio,	        DEF_METHOD("getAudio"));
+		CLASS_BIND_METHOD(VideoPlayer, setAudio,	        DEF_METHOD("setAudio"));
 
-		CLASS_REGISTER_PROPERTY(VideoPlayer, "Is2D", Variant::Type::Bool, "is2d", "set2d");
         CLASS_REGISTER_PROPERTY(VideoPlayer, "Loop", Variant::Type::Bool, "isLoop", "setLoop");
         CLASS_REGISTER_PROPERTY(VideoPlayer, "PlayOnAwake", Variant::Type::Bool, "isPlayOnAwake", "setPlayOnAwake");
+		CLASS_REGISTER_PROPERTY(VideoPlayer, "Width", Variant::Type::Int, "getWidth", "setWidth");
+		CLASS_REGISTER_PROPERTY(VideoPlayer, "Height", Variant::Type::Int, "getHeight", "setHeight");
         CLASS_REGISTER_PROPERTY(VideoPlayer, "Volume", Variant::Type::Real, "getVolume", "setVolume");
         CLASS_REGISTER_PROPERTY(VideoPlayer, "Video", Variant::Type::ResourcePath, "getVideo", "setVideo");
+		CLASS_REGISTER_PROPERTY(VideoPlayer, "Audio", Variant::Type::ResourcePath, "getAudio", "setAudio");
 	}
 
 	void VideoPlayer::setLoop(bool loop)
 	{
 		m_isLoop = loop;
+
+		if (m_decoder)
+			m_decoder->setLoop(loop);
 	}
     
     void VideoPlayer::set2d(bool is2d)
     {     
-        m_is2D = is2d;
+		setRenderType(StringOption(is2d ? "2d" : "3d"));
     }
 
+	void VideoPlayer::setWidth(i32 width)
+	{
+		if (m_width != width)
+		{
+			m_width = width;
+			m_isRenderableDirty = true;
+		}
+	}
+
+	void VideoPlayer::setHeight(i32 height)
+	{
+		if (m_height != height)
+		{
+			m_height = height;
+			m_isRenderableDirty = true;
+		}
+	}
+
+	void VideoPlayer::setVolume(float volume)
+	{
+		m_volume = volume;
+
+		if (m_voice)
+		{
+			m_voice->m_gain = volume;
+			AudioDevice::instance()->getVoiceManager()->applyParams(m_voice);
+		}
+	}
+
 	bool VideoPlayer::isPlaying()
 	{
-		return false;
+		return m_state == Playing;
 	}
     
     void VideoPlayer::start()
@@ -55,40 +168,229 @@ namespace Echo
 
 	void VideoPlayer::update_self()
 	{
-		const Vector3& position = getWorldPosition();
-		
-		// update self position
-		updatePosition(position);
+		if (m_decoder)
+		{
+			m_decoder->update();
+			if (m_state == Playing)
+				updateFrame();
+		}
+
+		if (isNeedRender() && m_texture->getPlane(TextureVideo::Plane_Y))
+		{
+			if (m_isRenderable2d != is2d())
+				m_isRenderableDirty = true;
+
+			buildRenderable();
+			if (m_renderable)
+			{
+				// planes are recreated when the picture size changes
+				static const char* planeNames[TextureVideo::Plane_Count] = { "TextureY", "TextureCb", "TextureCr" };
+				for (i32 i = 0; i < TextureVideo::Plane_Count; i++)
+				{
+					Material::UniformValue* uniform = m_material->getUniform(planeNames[i]);
+					if (uniform)
+						uniform->setTexture(m_texture->getPlane(TextureVideo::Plane(i)));
+				}
+
+				m_renderable->submitToRenderQueue();
+			}
+		}
 	}
 
-	void VideoPlayer::updatePosition(const Vector3& position)
+	void VideoPlayer::updateFrame()
 	{
+		// the sound track is the master clock, wall time fills in before and after it
+		if (m_voice && m_voice->m_state == AudioVoice::Playing)
+			m_time = m_clockBase + m_voice->m_time;
+		else
+			m_time += Engine::instance()->getFrameTime();
+
+		VideoDecoder::Frame* frame = m_decoder->acquireFrame(m_time);
+		if (frame)
+		{
+			if (frame->m_isLoopStart)
+			{
+				m_time = m_clockBase = frame->m_time;
+				if (m_voice)
+					AudioDevice::instance()->getVoiceManager()->play(m_voice);
+			}
 
+			i32 codedWidth = m_decoder->getCodedWidth();
+			i32 codedHeight = m_decoder->getCodedHeight();
+			m_texture->updateFrame(codedWidth, codedHeight, frame->m_y.data(), frame->m_cb.data(), frame->m_cr.data());
+			m_decoder->releaseFrame(frame);
+
+			// padding of the planes is cropped by the uvs
+			Vector2 uvScale(float(m_decoder->getWidth()) / codedWidth, float(m_decoder->getHeight()) / codedHeight);
+			if (uvScale != m_uvScale)
+			{
+				m_uvScale = uvScale;
+				m_isRenderableDirty = true;
+			}
+		}
+		else if (m_decoder->isEnd())
+		{
+			stop();
+		}
+	}
+
+	ShaderProgramPtr VideoPlayer::getYuvShader(bool is2d)
+	{
+		String shaderVirtualPath = is2d ? "_echo_video_yuv_shader_2d_" : "_echo_video_yuv_shader_3d_";
+		ShaderProgramPtr shader = ECHO_DOWN_CAST<ShaderProgram*>(ShaderProgram::get(shaderVirtualPath));
+		if (!shader)
+		{
+			shader = ECHO_CREATE_RES(ShaderProgram);
+			shader->setBlendMode("Opaque");
+
+			// in world screens are depth tested
+			DepthStencilState::DepthStencilDesc depthDesc;
+			depthDesc.bDepthEnable = !is2d;
+			depthDesc.bWriteDepth = !is2d;
+			DepthStencilState* depthState = Renderer::instance()->createDepthStencilState(depthDesc);
+			shader->setDepthState(depthState);
+
+			shader->setCullMode("CULL_NONE");
+
+			shader->setPath(shaderVirtualPath);
+			shader->setType("glsl");
+			shader->setVsCode(g_yuvVsCode);
+			shader->setPsCode(g_yuvPsCode);
+		}
+
+		return shader;
+	}
+
+	void VideoPlayer::buildRenderable()
+	{
+		if (m_isRenderableDirty)
+		{
+			EchoSafeRelease(m_renderable);
+
+			m_isRenderable2d = is2d();
+			m_material = ECHO_CREATE_RES(Material);
+			m_material->setShaderPath(getYuvShader(m_isRenderable2d)->getPath());
+
+			// mesh
+			updateMeshBuffer();
+
+			// create render able
+			m_renderable = Renderable::create(m_mesh, m_material, this);
+
+			m_isRenderableDirty = false;
+		}
+	}
+
+	void VideoPlayer::updateMeshBuffer()
+	{
+		if (!m_mesh)
+			m_mesh = Mesh::create(true, true);
+
+		// indices
+		IndiceArray indices = { 0, 1, 2, 0, 2, 3 };
+
+		float hw = m_width * 0.5f;
+		float hh = m_height * 0.5f;
+		float u1 = m_uvScale.x;
+		float v1 = m_uvScale.y;
+
+		// vertices
+		VertexArray vertices;
+		vertices.emplace_back(Vector3(-hw, -hh, 0.f), Vector2(0.f, v1));
+		vertices.emplace_back(Vector3(-hw,  hh, 0.f), Vector2(0.f, 0.f));
+		vertices.emplace_back(Vector3(hw,   hh, 0.f), Vector2(u1, 0.f));
+		vertices.emplace_back(Vector3(hw,  -hh, 0.f), Vector2(u1, v1));
+
+		// format
+		MeshVertexFormat define;
+		define.m_isUseUV = true;
+
+		m_mesh->updateIndices(static_cast<ui32>(indices.size()), sizeof(Word), indices.data());
+		m_mesh->updateVertexs(define, static_cast<ui32>(vertices.size()), (const Byte*)vertices.data());
+
+		m_localAABB = m_mesh->getLocalBox();
 	}
 
 	void VideoPlayer::play()
 	{
-		if (m_isCustomRender)
+		AudioVoiceManager* voiceManager = AudioDevice::instance()->getVoiceManager();
+		if (m_state == Paused)
+		{
+			if (m_voice)
+				voiceManager->play(m_voice);
+
+			m_state = Playing;
+			return;
+		}
+
+		stop();
+
+		if (m_videoRes.isEmpty())
+			return;
+
+		m_decoder = EchoNew(VideoDecoder(m_videoRes.getPath(), m_isLoop));
+		if (!m_decoder->isValid())
 		{
-			m_videoRender = nullptr;
+			EchoSafeDelete(m_decoder, VideoDecoder);
+			return;
 		}
 
-		m_jplayer = EchoNew(cmpeg::player(m_videoRender, m_videoRes.getPath().c_str()));
-		m_jplayer->play();
+		if (m_voice)
+			voiceManager->play(m_voice);
+
+		m_state = Playing;
 	}
     
     void VideoPlayer::pause()
     {
+		if (m_state == Playing)
+		{
+			if (m_voice)
+				AudioDevice::instance()->getVoiceManager()->pause(m_voice);
 
+			m_state = Paused;
+		}
     }
     
     void VideoPlayer::stop()
     {
+		EchoSafeDelete(m_decoder, VideoDecoder);
+
+		if (m_voice)
+			AudioDevice::instance()->getVoiceManager()->stop(m_voice);
 
+		m_state = Stopped;
+		m_time = 0.0;
+		m_clockBase = 0.0;
     }
     
     void VideoPlayer::setVideo(const ResourcePath& res)
     {
         m_videoRes=res;
+		if (m_state != Stopped)
+			play();
     }
+
+	void VideoPlayer::setAudio(const ResourcePath& res)
+	{
+		m_audioRes = res;
+
+		AudioVoiceManager* voiceManager = AudioDevice::instance()->getVoiceManager();
+		if (!m_voice)
+		{
+			m_voice = voiceManager->createVoice();
+			m_voice->m_priority = 255;
+			m_voice->m_category = AudioVoiceManager::getCategoryIndex("Music");
+		}
+
+		if (m_audioRes.isEmpty() || !voiceManager->setClip(m_voice, m_audioRes.getPath()))
+		{
+			voiceManager->destroyVoice(m_voice);
+			m_voice = nullptr;
+			return;
+		}
+
+		m_voice->m_gain = m_volume;
+		voiceManager->applyParams(m_voice);
+	}
 }
@@ -1,17 +1,40 @@
 #pragma once
 
-#include "engine/core/scene/node.h"
+#include "engine/core/scene/render_node.h"
+#include "engine/core/render/base/mesh/mesh.h"
+#include "engine/core/render/base/Material.h"
+#include "engine/core/render/base/Renderable.h"
+#include "engine/core/render/base/TextureVideo.h"
 #include "video_base.h"
-#include <thirdparty/jplayer/player.h>
+#include "video_decoder.h"
 
 namespace Echo
 {
-	class VideoPlayer : public Node 
+	struct AudioVoice;
+
+	class VideoPlayer : public Render 
 	{
-		ECHO_CLASS(VideoPlayer, Node)
+		ECHO_CLASS(VideoPlayer, Render)
+
+		struct VertexFormat
+		{
+			Vector3		m_position;
+			Vector2		m_uv;
+
+			VertexFormat(const Vector3& pos, const Vector2& uv)
+				: m_position(pos), m_uv(uv)
+			{}
+		};
+		typedef vector<VertexFormat>::type	VertexArray;
+		typedef vector<Word>::type	IndiceArray;
 
 	public:
-		typedef vector<VideoPlayer*>::type VideoPlayerArray;
+		enum State
+		{
+			Stopped = 0,
+			Playing,
+			Paused,
+		};
 
 	public:
 		VideoPlayer();
@@ -22,25 +45,45 @@ namespace Echo
 		void setLoop(bool loop);
 
 		// 2d
-		bool is2d() const { return m_is2D; }
+		bool is2d() const { return m_renderType.getIdx() == 0; }
         void set2d(bool is2d);
         
         // is play on awake
         bool isPlayOnAwake() const { return m_isPlayOnAwake; }
         void setPlayOnAwake(bool isPlayOnAwake) { m_isPlayOnAwake = isPlayOnAwake;}
 
+		// size of the quad
+		i32 getWidth() const { return m_width; }
+		void setWidth(i32 width);
+		i32 getHeight() const { return m_height; }
+		void setHeight(i32 height);
+
+		// volume of the sound track
+		float getVolume() const { return m_volume; }
+		void setVolume(float volume);
+
 		// is playing
 		bool isPlaying();
 
+		// seconds since play, follows the sound track when there is one
+		double getTime() const { return m_time; }
+
 		// operates
 		void play();
         void pause();
         void stop();
         
-        // audio file
+        // video file, MPEG-TS with MPEG1 video
         void setVideo(const ResourcePath& res);
         const ResourcePath& getVideo() const { return m_videoRes; }
 
+		// sound track, it's the master clock while playing
+		void setAudio(const ResourcePath& res);
+		const ResourcePath& getAudio() const { return m_audioRes; }
+
+		// frames
+		TextureVideo* getTexture() { return m_texture; }
+
 	protected:
         // start
         virtual void start() override;
@@ -48,16 +91,37 @@ namespace Echo
 		// update
 		virtual void update_self() override;
 
-		// update position
-		void updatePosition(const Vector3& position);
+		// advance clock, upload the frame due
+		void updateFrame();
+
+		// build drawable
+		void buildRenderable();
+
+		// update vertex buffer
+		void updateMeshBuffer();
+
+		// yuv to rgb shader
+		static ShaderProgramPtr getYuvShader(bool is2d);
 
 	private:
+		State				m_state = Stopped;
 		bool				m_isLoop = false;
 		bool				m_isPlayOnAwake = true;
-		bool				m_is2D = true;
-        ResourcePath		m_videoRes = ResourcePath("", ".mp4|.video");
-		cmpeg::player*		m_jplayer = nullptr;
-		bool				m_isCustomRender = false;
-		cmpeg::render_base* m_videoRender = nullptr;
+		i32					m_width = 256;
+		i32					m_height = 144;
+		float				m_volume = 1.f;
+        ResourcePath		m_videoRes = ResourcePath("", ".ts|.mpg|.mpeg|.video");
+		ResourcePath		m_audioRes = ResourcePath("", ".mp3");
+		VideoDecoder*		m_decoder = nullptr;
+		AudioVoice*			m_voice = nullptr;
+		double				m_time = 0.0;
+		double				m_clockBase = 0.0;			// time the sound track (re)started at
+		TextureVideoPtr		m_texture;
+		Vector2				m_uvScale = Vector2::ONE;
+		bool                m_isRenderableDirty = true;
+		bool				m_isRenderable2d = true;
+		MeshPtr				m_mesh;
+		MaterialPtr			m_material;
+		Renderable*			m_renderable = nullptr;
 	};
 }
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <engine/core/thread/pool/CpuThreadPool.h>
+#include <jplayer/demuxer_ts.h>
+#include <jplayer/decoder_mpeg1.h>
+
+// usage: benchmark_video <stream.ts> [runs] [threads]
+// a 1080p sample can be made with
+// ffmpeg -f lavfi -i testsrc2=size=1920x1080:rate=30 -t 10 -c:v mpeg1video -b:v 8M -bf 0 -f mpegts sample.ts
+
+// counts pictures, keeps the last one to compare the runs
+class FrameCounter : public cmpeg::render_base
+{
+public:
+	virtual void resize(int width, int height) override
+	{
+		m_width = width;
+		m_height = height;
+	}
+
+	virtual void render(const uint8_t* Y, const uint8_t* /*Cr*/, const uint8_t* /*Cb*/) override
+	{
+		m_frames++;
+		m_lastY = Y;
+	}
+
+	// fnv-1a of the visible luma of the last picture
+	uint64_t hashLastFrame() const
+	{
+		uint64_t hash = 14695981039346656037ull;
+		int codedWidth = (m_width + 15) & ~15;
+		for (int y = 0; y < m_height && m_lastY; y++)
+		{
+			for (int x = 0; x < m_width; x++)
+			{
+				hash ^= m_lastY[y * codedWidth + x];
+				hash *= 1099511628211ull;
+			}
+		}
+
+		return hash;
+	}
+
+public:
+	int				m_width = 0;
+	int				m_height = 0;
+	int				m_frames = 0;
+	const uint8_t*	m_lastY = nullptr;
+};
+
+struct Result
+{
+	int			m_frames = 0;
+	double		m_seconds = 0.0;
+	uint64_t	m_hash = 0;
+	int			m_width = 0;
+	int			m_height = 0;
+};
+
+// decode the whole stream the way VideoDecoder feeds it
+static Result decodeStream(const std::vector<uint8_t>& stream, const cmpeg::mpeg1_dsp* dsp, Echo::CpuThreadPool* pool)
+{
+	const size_t readSize = 188 * 32;
+
+	FrameCounter counter;
+	cmpeg::decoder_mpeg1 decoder;
+	decoder.connect(&counter);
+	decoder.set_dsp(dsp);
+	if (pool)
+		decoder.set_parallel_for([pool](int count, const std::function<void(int)>& task) { pool->parallelFor(Echo::ui32(count), [&task](Echo::ui32 i) { task(int(i)); }); });
+
+	cmpeg::demuxer_ts demuxer;
+	demuxer.connect(cmpeg::demuxer_ts::VIDEO_1, &decoder);
+
+	std::chrono::high_resolution_clock::time_point begin = std::chrono::high_resolution_clock::now();
+
+	std::vector<uint8_t> chunk;
+	for (size_t offset = 0; offset < stream.size(); offset += readSize)
+	{
+		chunk.assign(stream.begin() + offset, stream.begin() + std::min(stream.size(), offset + readSize));
+		demuxer.write(chunk);
+	}
+
+	demuxer.flush();
+	while (decoder.decode()) {}
+
+	Result result;
+	result.m_seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count();
+	result.m_frames = counter.m_frames;
+	result.m_hash = counter.hashLastFrame();
+	result.m_width = counter.m_width;
+	result.m_height = counter.m_height;
+
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		printf("usage: benchmark_video <stream.ts> [runs] [threads]\n");
+		return 1;
+	}
+
+	FILE* file = fopen(argv[1], "rb");
+	if (!file)
+	{
+		printf("could not open [%s]\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<uint8_t> stream;
+	uint8_t buffer[64 * 1024];
+	for (size_t size = fread(buffer, 1, sizeof(buffer), file); size > 0; size = fread(buffer, 1, sizeof(buffer), file))
+		stream.insert(stream.end(), buffer, buffer + size);
+
+	fclose(file);
+
+	int runs = argc > 2 ? std::max(atoi(argv[2]), 1) : 3;
+	int threads = argc > 3 ? std::max(atoi(argv[3]), 1) : std::max<int>(std::thread::hardware_concurrency(), 1);
+
+	// workers plus the calling thread, the same pool VideoDecoder slices on
+	Echo::CpuThreadPool::Cinfo poolInfo;
+	poolInfo.m_numThreads = Echo::ui32(threads - 1);
+	Echo::CpuThreadPool pool(poolInfo);
+
+	struct Mode
+	{
+		const char*				m_name;
+		const cmpeg::mpeg1_dsp*	m_dsp;
+		Echo::CpuThreadPool*	m_pool;
+	};
+
+	const cmpeg::mpeg1_dsp* simd = cmpeg::mpeg1_dsp_detect();
+	Mode modes[] =
+	{
+		{ "serial", cmpeg::mpeg1_dsp_scalar(), nullptr },
+		{ "serial", simd, nullptr },
+		{ "slices", simd, &pool },
+	};
+
+	uint64_t referenceHash = 0;
+	for (const Mode& mode : modes)
+	{
+		// best of the runs
+		Result best;
+		for (int i = 0; i < runs; i++)
+		{
+			Result result = decodeStream(stream, mode.m_dsp, mode.m_pool);
+			if (i == 0 || result.m_seconds < best.m_seconds)
+				best = result;
+		}
+
+		if (!referenceHash)
+			referenceHash = best.m_hash;
+
+		printf("%dx%d %-7s %-6s threads %2d : %4d frames %8.3fs %8.1f fps%s\n",
+			best.m_width, best.m_height, mode.m_dsp->name, mode.m_name, mode.m_pool ? threads : 1,
+			best.m_frames, best.m_seconds, best.m_seconds > 0.0 ? best.m_frames / best.m_seconds : 0.0,
+			best.m_hash == referenceHash ? "" : "  MISMATCH");
+	}
+
+	return 0;
+}
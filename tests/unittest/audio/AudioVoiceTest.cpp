@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <engine/modules/audio/audio_voice.h>
+
+TEST(AudioVoiceManager, selectVoices)
+{
+	using namespace Echo;
+
+	AudioVoice voices[4];
+	voices[0].m_priority = 128; voices[0].m_audibility = 0.5f;
+	voices[1].m_priority = 200; voices[1].m_audibility = 0.1f;
+	voices[2].m_priority = 128; voices[2].m_audibility = 0.9f;
+	voices[3].m_priority = 255; voices[3].m_audibility = 0.001f;
+
+	ui32 limits[AudioVoiceManager::MAX_CATEGORIES];
+	std::fill(limits, limits + AudioVoiceManager::MAX_CATEGORIES, ui32(-1));
+
+	// priority first, then audibility, inaudible ones never get a source
+	vector<AudioVoice*>::type candidates = { &voices[0], &voices[1], &voices[2], &voices[3] };
+	vector<AudioVoice*>::type reals;
+	AudioVoiceManager::selectVoices(candidates, 2, limits, 0.01f, reals);
+	ASSERT_EQ(reals.size(), 2u);
+	EXPECT_EQ(reals[0], &voices[1]);
+	EXPECT_EQ(reals[1], &voices[2]);
+
+	// category limit leaves the source to the next voice
+	voices[1].m_category = 1;
+	voices[2].m_category = 1;
+	limits[1] = 1;
+	AudioVoiceManager::selectVoices(candidates, 2, limits, 0.01f, reals);
+	ASSERT_EQ(reals.size(), 2u);
+	EXPECT_EQ(reals[0], &voices[1]);
+	EXPECT_EQ(reals[1], &voices[0]);
+
+	// voice holding a source wins a tie
+	AudioVoice a, b;
+	b.m_source = 1;
+	candidates = { &a, &b };
+	AudioVoiceManager::selectVoices(candidates, 1, limits, 0.f, reals);
+	ASSERT_EQ(reals.size(), 1u);
+	EXPECT_EQ(reals[0], &b);
+}
+
+TEST(AudioVoiceManager, virtualize)
+{
+	using namespace Echo;
+
+	// openal soft's null backend mixes without a sound card
+#ifdef ECHO_PLATFORM_WINDOWS
+	_putenv_s("ALSOFT_DRIVERS", "null");
+#else
+	setenv("ALSOFT_DRIVERS", "null", 1);
+#endif
+
+	ALCdevice* device = alcOpenDevice(nullptr);
+	if (!device)
+		GTEST_SKIP();
+
+	ALCcontext* context = alcCreateContext(device, nullptr);
+	alcMakeContextCurrent(context);
+
+	// one second of silence
+	vector<i16>::type pcm(44100, 0);
+	ALuint buffer = 0;
+	alGenBuffers(1, &buffer);
+	alBufferData(buffer, AL_FORMAT_MONO16, pcm.data(), ALsizei(pcm.size() * sizeof(i16)), 44100);
+
+	{
+		AudioVoiceManager manager(1);
+		ASSERT_EQ(manager.getSourceCount(), 1u);
+
+		AudioVoice* low = manager.createVoice();
+		low->m_buffer = buffer;
+		low->m_duration = 1.f;
+		low->m_isLoop = true;
+
+		AudioVoice* high = manager.createVoice();
+		high->m_buffer = buffer;
+		high->m_duration = 1.f;
+		high->m_priority = 200;
+
+		// a free source is taken right away
+		manager.play(low);
+		EXPECT_NE(low->m_source, 0u);
+
+		// the next update hands it to the better voice, the other one keeps playing virtually
+		manager.play(high);
+		EXPECT_EQ(high->m_source, 0u);
+		manager.update(0.f, Vector3::ZERO);
+		EXPECT_NE(high->m_source, 0u);
+		EXPECT_EQ(low->m_source, 0u);
+		EXPECT_EQ(low->m_state, AudioVoice::Playing);
+		EXPECT_EQ(manager.getRealVoiceCount(), 1u);
+
+		float time = low->m_time;
+		manager.update(0.25f, Vector3::ZERO);
+		EXPECT_NEAR(low->m_time, time + 0.25f, 0.001f);
+
+		// realized where the virtual timeline got to
+		manager.stop(high);
+		manager.update(0.f, Vector3::ZERO);
+		ASSERT_NE(low->m_source, 0u);
+		EXPECT_EQ(high->m_state, AudioVoice::Stopped);
+
+		float offset = 0.f;
+		alGetSourcef(low->m_source, AL_SEC_OFFSET, &offset);
+		EXPECT_NEAR(offset, low->m_time, 0.1f);
+
+		// looping virtual timeline wraps at the end of the clip
+		manager.play(high);
+		manager.update(0.f, Vector3::ZERO);
+		EXPECT_EQ(low->m_source, 0u);
+		manager.update(1.f, Vector3::ZERO);
+		EXPECT_LT(low->m_time, 1.f);
+		EXPECT_EQ(low->m_state, AudioVoice::Playing);
+
+		// the buffer isn't owned by the clip cache
+		low->m_buffer = 0;
+		high->m_buffer = 0;
+	}
+
+	alDeleteBuffers(1, &buffer);
+	alcMakeContextCurrent(nullptr);
+	alcDestroyContext(context);
+	alcCloseDevice(device);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <engine/modules/effect/particle/particle_group.h>
+#include <engine/modules/effect/emitter/emitter.h>
+
+TEST(ParticleGroup, spawnAndRemoveDead)
+{
+	using namespace Echo;
+
+	ParticleGroup group;
+	group.setCapacity(600);
+
+	// spawn across block borders, capacity clamps the last request
+	i32 spawned = 0;
+	EXPECT_EQ(group.spawn(300, spawned), 0);
+	EXPECT_EQ(spawned, 300);
+	EXPECT_EQ(group.spawn(400, spawned), 300);
+	EXPECT_EQ(spawned, 300);
+	EXPECT_EQ(group.getBlockCount(), 3);
+
+	// even particles live one second, odd ones half a second
+	for (i32 i = 0; i < group.getCount(); i++)
+	{
+		ParticleBlock& block = group.getBlock(i);
+		i32 idx = i % ParticleBlock::Size;
+		block.m_age[idx] = 0.f;
+		block.m_invLife[idx] = i % 2 ? 2.f : 1.f;
+		block.m_positionX[idx] = float(i);
+		block.m_velocityX[idx] = 1.f;
+	}
+
+	ParticleModifiers modifiers;
+	group.tick(modifiers, 0.25f);
+	EXPECT_EQ(group.getCount(), 600);
+	EXPECT_FLOAT_EQ(group.getBlock(10).m_positionX[10], 10.25f);
+
+	group.tick(modifiers, 0.25f);
+	EXPECT_EQ(group.getCount(), 300);
+	EXPECT_EQ(group.getBlockCount(), 2);
+	for (i32 i = 0; i < group.getCount(); i++)
+	{
+		ParticleBlock& block = group.getBlock(i);
+		EXPECT_FLOAT_EQ(block.m_invLife[i % ParticleBlock::Size], 1.f);
+	}
+}
+
+TEST(ParticleGroup, modifiers)
+{
+	using namespace Echo;
+
+	ParticleGroup group;
+	i32 spawned = 0;
+	group.spawn(5, spawned);
+	for (i32 i = 0; i < group.getCount(); i++)
+	{
+		ParticleBlock& block = group.getBlock(i);
+		block.m_age[i] = 0.f;
+		block.m_invLife[i] = 0.5f;
+		block.m_positionX[i] = block.m_positionY[i] = block.m_positionZ[i] = 0.f;
+		block.m_velocityX[i] = block.m_velocityY[i] = block.m_velocityZ[i] = 0.f;
+	}
+
+	ParticleGravityModifier gravity(Vector3(0.f, -10.f, 0.f));
+	ParticleSizeModifier size(0.f, 8.f);
+	ParticleModifiers modifiers = { &gravity, &size };
+	group.tick(modifiers, 1.f);
+
+	// velocity first, then position, size follows the age
+	ParticleBlock& block = group.getBlock(4);
+	EXPECT_FLOAT_EQ(block.m_velocityY[4], -10.f);
+	EXPECT_FLOAT_EQ(block.m_positionY[4], -10.f);
+	EXPECT_FLOAT_EQ(block.m_size[4], 4.f);
+
+	AABB bounds = group.calcBounds();
+	EXPECT_FLOAT_EQ(bounds.vMin.y, -10.f);
+	EXPECT_FLOAT_EQ(bounds.vMax.y, -10.f);
+}
+
+TEST(ParticleEmitter, catchUp)
+{
+	using namespace Echo;
+
+	ParticleEmitter emitter;
+	emitter.setRate(100.f);
+	emitter.setLife(Vector2(1.f, 1.f));
+	emitter.setSpeed(Vector2(10.f, 10.f));
+	emitter.setDirection(Vector3::UNIT_Y);
+	emitter.setSpread(0.f);
+
+	// a lod halves the rate, a long step only emits what can still be alive
+	EXPECT_EQ(emitter.advance(0.5f, 0.5f), 25);
+	EXPECT_EQ(emitter.advance(10.f, 1.f), 100);
+
+	// births are spread over the step, positions follow the age
+	ParticleGroup group;
+	EXPECT_EQ(emitter.emit(group, Matrix4::IDENTITY, 0.5f, 50), 50);
+	for (i32 i = 0; i < group.getCount(); i++)
+	{
+		ParticleBlock& block = group.getBlock(i);
+		EXPECT_GE(block.m_age[i], 0.f);
+		EXPECT_LE(block.m_age[i], 0.5f);
+		EXPECT_NEAR(block.m_positionY[i], block.m_age[i] * 10.f, 1e-4f);
+	}
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <engine/modules/ui/font/font_library.h>
+
+TEST(FontTexture, mergeFreeRects)
+{
+	using namespace Echo;
+
+	vector<Color>::type data(128 * 64);
+	FontTexture page(128, 128);
+	FontTexture::IRect a, b, c, d;
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, a));
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, b));
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, c));
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, d));
+
+	FontTexture::IRect rect;
+	EXPECT_FALSE(page.insert(data.data(), 1, 1, rect));
+
+	// two neighbours under other glyphs become one free rect
+	page.remove(a);
+	page.remove(b);
+	ASSERT_EQ(page.getFreeRects().size(), 1u);
+	EXPECT_EQ(page.getFreeRects()[0].width, 128);
+	EXPECT_TRUE(page.insert(data.data(), 128, 64, rect));
+	EXPECT_EQ(rect.left, 0);
+	EXPECT_EQ(rect.top, 0);
+}
+
+TEST(FontTexture, sinkSkyline)
+{
+	using namespace Echo;
+
+	vector<Color>::type data(128 * 64);
+	FontTexture page(128, 128);
+	FontTexture::IRect a, b, c, d;
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, a));
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, b));
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, c));
+	EXPECT_TRUE(page.insert(data.data(), 64, 64, d));
+
+	// glyphs on top of the skyline give their space back to it
+	page.remove(c);
+	page.remove(d);
+	EXPECT_TRUE(page.getFreeRects().empty());
+	ASSERT_EQ(page.getSkyline().size(), 1u);
+	EXPECT_EQ(page.getSkyline()[0].m_y, 64);
+
+	FontTexture::IRect rect;
+	EXPECT_TRUE(page.insert(data.data(), 128, 64, rect));
+	EXPECT_EQ(rect.top, 64);
+}
+
+TEST(FontLibrary, evictLeastRecentlyUsed)
+{
+	using namespace Echo;
+
+	FontLibrary* library = FontLibrary::instance();
+	FontFace* face = library->loadFace("FontLibraryTest.ttf");
+	vector<Color>::type data(128 * 128);
+
+	// fill every page with glyphs used in the same frame
+	library->beginFrame();
+	vector<FontGlyph*>::type glyphs;
+	for (;;)
+	{
+		FontTexture::IRect rect;
+		FontTexture* page = library->allocGlyph(data.data(), 64, 64, rect);
+		if (!page)
+			break;
+
+		FontGlyph* glyph = EchoNew(FontGlyph);
+		glyph->m_face = face;
+		glyph->m_key = glyphs.size();
+		glyph->m_texture = page;
+		glyph->m_rect = rect;
+		library->addGlyph(glyph);
+		glyphs.emplace_back(glyph);
+	}
+	ASSERT_GT(glyphs.size(), 16u);
+
+	// the oldest glyph not used this frame goes first
+	library->beginFrame();
+	library->touchGlyph(glyphs[0]);
+	ui32 version = library->getVersion();
+	FontTexture::IRect rect;
+	EXPECT_NE(library->allocGlyph(data.data(), 64, 64, rect), nullptr);
+	EXPECT_EQ(rect.left, glyphs[1]->m_rect.left);
+	EXPECT_EQ(rect.top, glyphs[1]->m_rect.top);
+
+	vector<FontLibrary::EvictedGlyph>::type evicted;
+	EXPECT_TRUE(library->getEvictedGlyphs(version, evicted));
+	ASSERT_EQ(evicted.size(), 1u);
+	EXPECT_EQ(evicted[0].m_key, 1u);
+
+	// eviction stops as soon as the freed neighbours fit
+	version = library->getVersion();
+	EXPECT_NE(library->allocGlyph(data.data(), 128, 64, rect), nullptr);
+	EXPECT_EQ(library->getVersion(), version + 2);
+
+	// and gives up after a few glyphs instead of emptying a page
+	version = library->getVersion();
+	EXPECT_EQ(library->allocGlyph(data.data(), 128, 128, rect), nullptr);
+	EXPECT_EQ(library->getVersion(), version + 16);
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <engine/core/render/base/image/Image.h>
+#include <engine/core/render/base/image/PixelBox.h>
+
+TEST(ImageMipmap, fullChain)
+{
+	using namespace Echo;
+
+	Image image(nullptr, 37, 16, 1, PF_RGBA8_UNORM);
+	EXPECT_TRUE(image.generateMipmaps());
+	EXPECT_EQ(image.getNumMipmaps(), 5);
+
+	PixelBox last = image.getPixelBox(0, image.getNumMipmaps());
+	EXPECT_EQ(last.getWidth(), 1);
+	EXPECT_EQ(last.getHeight(), 1);
+}
+
+TEST(ImageMipmap, gammaCorrectBox)
+{
+	using namespace Echo;
+
+	// black and white columns average to 50% linear gray, which is 188 in srgb
+	Byte data[4 * 4 * 4];
+	for (int i = 0; i < 16; i++)
+	{
+		Byte value = (i % 2) ? 255 : 0;
+		data[i * 4 + 0] = value;
+		data[i * 4 + 1] = value;
+		data[i * 4 + 2] = value;
+		data[i * 4 + 3] = 255;
+	}
+
+	Image image(data, 4, 4, 1, PF_RGBA8_UNORM);
+	EXPECT_TRUE(image.generateMipmaps(Image::IMGFILTER_BOX, true));
+
+	Byte* level1 = (Byte*)image.getPixelBox(0, 1).pData;
+	EXPECT_EQ(level1[0], 188);
+	EXPECT_EQ(level1[3], 255);
+
+	Image linearImage(data, 4, 4, 1, PF_RGBA8_UNORM);
+	EXPECT_TRUE(linearImage.generateMipmaps(Image::IMGFILTER_BOX, false));
+	EXPECT_EQ(((Byte*)linearImage.getPixelBox(0, 1).pData)[0], 128);
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <engine/core/render/base/atla/TextureAtlasPacker.h>
+
+TEST(TextureAtlasPacker, insertRemove)
+{
+	using namespace Echo;
+
+	TextureAtlasPacker packer(64, 64, 0);
+	i32 a = packer.insert(32, 32);
+	i32 b = packer.insert(32, 32);
+	i32 c = packer.insert(32, 32);
+	i32 d = packer.insert(32, 32);
+	EXPECT_TRUE(a >= 0 && b >= 0 && c >= 0 && d >= 0);
+	EXPECT_EQ(packer.insert(1, 1), -1);
+	EXPECT_FLOAT_EQ(packer.getOccupancy(), 1.f);
+
+	// released space is reused
+	TextureAtlasPacker::IRect rect;
+	EXPECT_TRUE(packer.getRect(b, rect));
+	EXPECT_TRUE(packer.remove(b));
+	i32 e = packer.insert(32, 32);
+	TextureAtlasPacker::IRect rectE;
+	EXPECT_TRUE(packer.getRect(e, rectE));
+	EXPECT_EQ(rect.left, rectE.left);
+	EXPECT_EQ(rect.top, rectE.top);
+}
+
+TEST(TextureAtlasPacker, defragment)
+{
+	using namespace Echo;
+
+	// two free 32x32 holes in opposite corners can't hold a half size item until repacked
+	TextureAtlasPacker packer(64, 64, 0);
+	i32 a = packer.insert(32, 32);
+	i32 b = packer.insert(32, 32);
+	i32 c = packer.insert(32, 32);
+	i32 d = packer.insert(32, 32);
+
+	TextureAtlasPacker::IRect ra, rd;
+	packer.getRect(a, ra);
+	packer.getRect(d, rd);
+	bool isDiagonal = ra.left != rd.left && ra.top != rd.top;
+	packer.remove(isDiagonal ? b : a);
+	packer.remove(isDiagonal ? c : d);
+	EXPECT_EQ(packer.getItems().size(), 2);
+	EXPECT_EQ(packer.insert(64, 32), -1);
+	EXPECT_EQ(packer.insert(32, 64), -1);
+
+	EXPECT_TRUE(packer.defragment());
+	EXPECT_EQ(packer.getItems().size(), 2);
+	EXPECT_TRUE(packer.insert(64, 32) >= 0 || packer.insert(32, 64) >= 0);
+}
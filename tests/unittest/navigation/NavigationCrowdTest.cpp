@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <engine/modules/navigation/NavigationCrowd.h>
+#include <recast/Recast/DetourNavMeshBuilder.h>
+
+namespace
+{
+	const float TILE_SIZE = 10.f;
+	const float CELL_SIZE = 0.5f;
+
+	// one flat quad covering the tile, all edges are portals to neighbour tiles
+	dtTileRef addFlatTile(dtNavMesh* navMesh, int tileX)
+	{
+		const unsigned short size = (unsigned short)(TILE_SIZE / CELL_SIZE);
+		unsigned short verts[] = { 0, 0, 0,  0, 0, size,  size, 0, size,  size, 0, 0 };
+		unsigned short polys[] = { 0, 1, 2, 3, 0x8000 | 0, 0x8000 | 1, 0x8000 | 2, 0x8000 | 3 };
+		unsigned short polyFlags[] = { 1 };
+		unsigned char polyAreas[] = { 0 };
+
+		dtNavMeshCreateParams params;
+		memset(&params, 0, sizeof(params));
+		params.verts = verts;
+		params.vertCount = 4;
+		params.polys = polys;
+		params.polyFlags = polyFlags;
+		params.polyAreas = polyAreas;
+		params.polyCount = 1;
+		params.nvp = 4;
+		params.tileX = tileX;
+		params.tileY = 0;
+		params.bmin[0] = tileX * TILE_SIZE;
+		params.bmin[1] = 0.f;
+		params.bmin[2] = 0.f;
+		params.bmax[0] = (tileX + 1) * TILE_SIZE;
+		params.bmax[1] = 2.f;
+		params.bmax[2] = TILE_SIZE;
+		params.walkableHeight = 2.f;
+		params.walkableRadius = 0.6f;
+		params.walkableClimb = 0.9f;
+		params.cs = CELL_SIZE;
+		params.ch = CELL_SIZE;
+		params.buildBvTree = true;
+
+		unsigned char* data = nullptr;
+		int dataSize = 0;
+		if (!dtCreateNavMeshData(&params, &data, &dataSize))
+			return 0;
+
+		dtTileRef tileRef = 0;
+		if (dtStatusFailed(navMesh->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, &tileRef)))
+		{
+			dtFree(data);
+			return 0;
+		}
+
+		return tileRef;
+	}
+}
+
+TEST(NavigationCrowd, tileRebuiltUnderAgent)
+{
+	using namespace Echo;
+
+	dtNavMeshParams meshParams;
+	memset(&meshParams, 0, sizeof(meshParams));
+	meshParams.tileWidth = TILE_SIZE;
+	meshParams.tileHeight = TILE_SIZE;
+	meshParams.maxTiles = 4;
+	meshParams.maxPolys = 4;
+
+	dtNavMesh* navMesh = dtAllocNavMesh();
+	ASSERT_TRUE(dtStatusSucceed(navMesh->init(&meshParams)));
+	ASSERT_NE(addFlatTile(navMesh, 0), 0u);
+	dtTileRef tileRef = addFlatTile(navMesh, 1);
+	ASSERT_NE(tileRef, 0u);
+
+	dtQueryFilter filter;
+	NavigationPathQueue pathQueue;
+	NavigationCrowd* crowd = EchoNew(NavigationCrowd(&pathQueue, &filter, 0.6f));
+	crowd->update(0.f, navMesh);
+
+	NavigationCrowd::AgentParams params;
+	i32 agent = crowd->addAgent(Vector3(2.f, 0.f, 5.f), params);
+	ASSERT_GE(agent, 0);
+
+	Vector3 target(18.f, 0.f, 5.f);
+	crowd->setTargets(&agent, 1, target);
+	for (i32 i = 0; i < 300 && crowd->getAgentState(agent) != NavigationCrowd::STATE_IDLE; i++)
+	{
+		pathQueue.update(navMesh);
+		crowd->update(1.f / 30.f, navMesh);
+
+		// rebuild the second tile once the agent walks on it, it's polygons get new refs
+		if (tileRef && crowd->getPositions()[agent].x > 12.f)
+		{
+			ASSERT_TRUE(dtStatusSucceed(navMesh->removeTile(tileRef, nullptr, nullptr)));
+			pathQueue.update(navMesh);
+			crowd->update(1.f / 30.f, navMesh);
+
+			ASSERT_NE(addFlatTile(navMesh, 1), 0u);
+			tileRef = 0;
+		}
+	}
+
+	EXPECT_EQ(tileRef, 0u);
+	EXPECT_EQ(crowd->getAgentState(agent), NavigationCrowd::STATE_IDLE);
+	EXPECT_LT((crowd->getPositions()[agent] - target).len(), 0.5f);
+
+	EchoSafeDelete(crowd, NavigationCrowd);
+	dtFreeNavMesh(navMesh);
+}
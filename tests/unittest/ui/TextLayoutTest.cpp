@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <engine/modules/ui/base/text.h>
+
+namespace
+{
+	// exposes the layout helpers, never instanced
+	class TextLayout : public Echo::UiText
+	{
+	public:
+		using UiText::LayoutGlyph;
+		using UiText::getChangedFrom;
+		using UiText::layoutGlyphs;
+	};
+
+	void expectSameLayout(const Echo::vector<TextLayout::LayoutGlyph>::type& a, const Echo::vector<TextLayout::LayoutGlyph>::type& b)
+	{
+		ASSERT_EQ(a.size(), b.size());
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			EXPECT_EQ(a[i].m_code, b[i].m_code);
+			EXPECT_FLOAT_EQ(a[i].m_x, b[i].m_x);
+			EXPECT_EQ(a[i].m_line, b[i].m_line);
+			EXPECT_FLOAT_EQ(a[i].m_nextX, b[i].m_nextX);
+			EXPECT_EQ(a[i].m_nextLine, b[i].m_nextLine);
+		}
+	}
+}
+
+TEST(UiText, changedFrom)
+{
+	EXPECT_EQ(TextLayout::getChangedFrom(L"hello world", L"hello there"), 6u);
+	EXPECT_EQ(TextLayout::getChangedFrom(L"hello", L"hello world"), 5u);
+	EXPECT_EQ(TextLayout::getChangedFrom(L"hello world", L"hello"), 5u);
+	EXPECT_EQ(TextLayout::getChangedFrom(L"hello", L"hello"), 5u);
+	EXPECT_EQ(TextLayout::getChangedFrom(L"hello", L"jello"), 0u);
+	EXPECT_EQ(TextLayout::getChangedFrom(L"", L"hello"), 0u);
+}
+
+TEST(UiText, rebuildFromChangedChar)
+{
+	using namespace Echo;
+
+	// edits in the middle, at the end and across wrapped lines and newlines
+	const wchar_t* edits[][2] =
+	{
+		{ L"hello world", L"hello there" },
+		{ L"hello", L"hello world, more text" },
+		{ L"a long line that wraps", L"a long line" },
+		{ L"first\nsecond line", L"first\nthird line\nfourth" },
+		{ L"abc", L"xyz" },
+	};
+
+	for (auto& edit : edits)
+	{
+		WString oldText = edit[0];
+		WString newText = edit[1];
+
+		vector<TextLayout::LayoutGlyph>::type glyphs;
+		TextLayout::layoutGlyphs(glyphs, oldText, 0, nullptr, 10, 80);
+
+		// glyphs before the changed char are kept, the rest continue from them
+		size_t from = TextLayout::getChangedFrom(oldText, newText);
+		vector<TextLayout::LayoutGlyph>::type kept(glyphs.begin(), glyphs.begin() + from);
+		TextLayout::layoutGlyphs(glyphs, newText, from, nullptr, 10, 80);
+
+		vector<TextLayout::LayoutGlyph>::type full;
+		TextLayout::layoutGlyphs(full, newText, 0, nullptr, 10, 80);
+		expectSameLayout(glyphs, full);
+
+		glyphs.resize(from);
+		expectSameLayout(glyphs, kept);
+	}
+}
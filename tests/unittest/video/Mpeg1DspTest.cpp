@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <jplayer/decoder_mpeg1_dsp.h>
+
+namespace
+{
+	// simd kernels of this cpu, null if it only has the scalar ones
+	const cmpeg::mpeg1_dsp* getSimdDsp()
+	{
+		const cmpeg::mpeg1_dsp* dsp = cmpeg::mpeg1_dsp_detect();
+		return dsp != cmpeg::mpeg1_dsp_scalar() ? dsp : nullptr;
+	}
+
+	void randomBlock(std::mt19937& random, int32_t* block, int32_t range)
+	{
+		std::uniform_int_distribution<int32_t> value(-range, range);
+		std::uniform_int_distribution<int> zero(0, 3);
+		for (int i = 0; i < 64; i++)
+			block[i] = zero(random) ? 0 : value(random);
+	}
+}
+
+TEST(Mpeg1Dsp, idct)
+{
+	const cmpeg::mpeg1_dsp* simd = getSimdDsp();
+	if (!simd)
+		GTEST_SKIP();
+
+	// premultiplied coefficients are levels clipped to 2048 times matrix values up to 62
+	std::mt19937 random(1);
+	for (int i = 0; i < 10000; i++)
+	{
+		int32_t scalarBlock[64];
+		int32_t simdBlock[64];
+		randomBlock(random, scalarBlock, i % 2 ? 2048 * 62 : 4096);
+		memcpy(simdBlock, scalarBlock, sizeof(scalarBlock));
+
+		cmpeg::mpeg1_dsp_scalar()->idct(scalarBlock);
+		simd->idct(simdBlock);
+		ASSERT_EQ(memcmp(scalarBlock, simdBlock, sizeof(scalarBlock)), 0) << simd->name << " block " << i;
+	}
+}
+
+TEST(Mpeg1Dsp, copyAndAddBlock)
+{
+	const cmpeg::mpeg1_dsp* simd = getSimdDsp();
+	if (!simd)
+		GTEST_SKIP();
+
+	// residuals past the 0..255 and the 16 bit range must clamp the same way
+	const int stride = 24;
+	std::mt19937 random(2);
+	std::uniform_int_distribution<int> pixel(0, 255);
+	for (int i = 0; i < 10000; i++)
+	{
+		int32_t block[64];
+		randomBlock(random, block, i % 2 ? 70000 : 300);
+
+		uint8_t scalarDest[stride * 8];
+		uint8_t simdDest[stride * 8];
+		for (uint8_t& v : scalarDest)
+			v = uint8_t(pixel(random));
+
+		memcpy(simdDest, scalarDest, sizeof(scalarDest));
+		cmpeg::mpeg1_dsp_scalar()->add_block(block, scalarDest + 4, stride);
+		simd->add_block(block, simdDest + 4, stride);
+		ASSERT_EQ(memcmp(scalarDest, simdDest, sizeof(scalarDest)), 0) << simd->name << " add block " << i;
+
+		cmpeg::mpeg1_dsp_scalar()->copy_block(block, scalarDest + 4, stride);
+		simd->copy_block(block, simdDest + 4, stride);
+		ASSERT_EQ(memcmp(scalarDest, simdDest, sizeof(scalarDest)), 0) << simd->name << " copy block " << i;
+	}
+}
+
+TEST(Mpeg1Dsp, predict)
+{
+	const cmpeg::mpeg1_dsp* simd = getSimdDsp();
+	if (!simd)
+		GTEST_SKIP();
+
+	// source blocks at odd offsets, half pel ones read one more row and column
+	const int stride = 40;
+	std::mt19937 random(3);
+	std::uniform_int_distribution<int> pixel(0, 255);
+	std::uniform_int_distribution<int> offset(0, 7);
+	uint8_t src[stride * 18];
+	for (int i = 0; i < 4000; i++)
+	{
+		for (uint8_t& v : src)
+			v = uint8_t(pixel(random));
+
+		int size = i % 2 ? 16 : 8;
+		bool oddH = (i / 2) % 2 != 0;
+		bool oddV = (i / 4) % 2 != 0;
+		const uint8_t* block = src + (i / 8) % 2 * stride + offset(random);
+
+		uint8_t scalarDest[stride * 16];
+		uint8_t simdDest[stride * 16];
+		memset(scalarDest, 0xcd, sizeof(scalarDest));
+		memset(simdDest, 0xcd, sizeof(simdDest));
+		cmpeg::mpeg1_dsp_scalar()->predict(block, scalarDest + 3, stride, size, oddH, oddV);
+		simd->predict(block, simdDest + 3, stride, size, oddH, oddV);
+		ASSERT_EQ(memcmp(scalarDest, simdDest, sizeof(scalarDest)), 0) << simd->name << " size " << size << " odd " << oddH << oddV;
+	}
+}
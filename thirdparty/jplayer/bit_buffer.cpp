@@ -13,7 +13,7 @@ namespace cmpeg
 
 	int bit_buffer::read(int count)
 	{
-		assert(size()>count);
+		assert(size()>=count);
 
 		int result = peek(count);
 		m_read_index += count;
@@ -80,7 +80,7 @@ namespace cmpeg
 
 	int bit_buffer::find_next_start_code()
 	{
-		for (int i = ((m_read_index + 7) >> 3); i < byte_size(); i++) {
+		for (int i = ((m_read_index + 7) >> 3); i + 3 < byte_size(); i++) {
 			if (m_bytes[i] == 0x00 && m_bytes[i + 1] == 0x00 && m_bytes[i + 2] == 0x01) {
 				m_read_index = (i + 4) << 3;
 				return m_bytes[i + 3];
@@ -120,7 +120,7 @@ namespace cmpeg
 	{
 		int i = ((m_read_index + 7) >> 3);
 		return (
-			i >= this->byte_size() || (
+			i + 2 >= this->byte_size() || (
 					m_bytes[i] == 0x00 &&
 					m_bytes[i+1] == 0x00 &&
 					m_bytes[i+2] == 0x01
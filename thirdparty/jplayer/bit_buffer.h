@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vector>
+#include <stdint.h>
+#include <stddef.h>
 
 namespace cmpeg
 {
@@ -17,7 +19,8 @@ namespace cmpeg
 		int find_start_code(uint8_t code);
 		int find_next_start_code();
 		int size() { return m_write_index - m_read_index; }
-		int byte_size() { return size() >> 3; }
+		int byte_size() { return int(m_write_index >> 3); }
+		const uint8_t* data() const { return m_bytes.data(); }
 		uint8_t byte(size_t idx) { return m_bytes[idx]; }
 		int read_index() const { return m_read_index; }
 		void set_read_indx(size_t index) { m_read_index = index; }
@@ -31,4 +34,50 @@ namespace cmpeg
 		size_t				 m_write_index;		// unit bit, m_write_index % 8 == 0
 		size_t				 m_read_index;		// unit bit
 	};
+
+	// read only cursor over bytes owned by someone else, several of them may
+	// read different parts of one bit_buffer from different threads
+	class bit_reader
+	{
+	public:
+		bit_reader(const uint8_t* bytes = NULL, int byte_size = 0, int index = 0)
+			: m_bytes(bytes), m_byte_size(byte_size), m_index(index)
+		{}
+
+		int read(int count)
+		{
+			int result = peek(count);
+			m_index += count;
+
+			return result;
+		}
+
+		int peek(int count)
+		{
+			// count <= 24, four bytes always cover it
+			if (!count)
+				return 0;
+
+			int offset = m_index >> 3;
+			uint32_t value = 0;
+			for (int i = 0; i < 4; i++)
+				value = (value << 8) | (offset + i < m_byte_size ? m_bytes[offset + i] : 0);
+
+			return int((value << (m_index & 7)) >> (32 - count));
+		}
+
+		void skip(int count) { m_index += count; }
+		int index() const { return m_index; }
+
+		bool next_bytes_are_start_code()
+		{
+			int i = ((m_index + 7) >> 3);
+			return i >= m_byte_size || (i + 2 < m_byte_size && m_bytes[i] == 0x00 && m_bytes[i + 1] == 0x00 && m_bytes[i + 2] == 0x01);
+		}
+
+	private:
+		const uint8_t*	m_bytes;
+		int				m_byte_size;
+		int				m_index;		// unit bit
+	};
 }
\ No newline at end of file
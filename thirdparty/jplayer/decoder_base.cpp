@@ -7,6 +7,7 @@ namespace cmpeg
 		, m_can_play(false)
 		, m_start_time(0)
 		, m_decoded_time(0)
+		, m_collect_time_stamps(false)
 		, m_time_stamp_index(0)
 	{
 		m_bits = new bit_buffer(8 * 64 * 1024);
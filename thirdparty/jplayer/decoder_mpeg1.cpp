@@ -1,5 +1,6 @@
 #include "decoder_mpeg1.h"
 #include <assert.h>
+#include <stdlib.h>
 
 static int CLAMP(int v, int m, int ma) 
 { 
@@ -716,17 +717,6 @@ namespace cmpeg
 		, m_forward_f_code(0)
 		, m_forward_r_size(0)
 		, m_forward_f(0)
-		, m_slice_begin(false)
-		, m_macro_block_address(0)
-		, m_macro_block_type(0)
-		, m_macro_block_intra(0)
-		, m_macro_block_motFw(0)
-		, m_mb_row(0)
-		, m_mb_col(0)
-		, m_motion_FwH(0)
-		, m_motion_FwH_prev(0)
-		, m_motion_FwV(0)
-		, m_motion_FwV_prev(0)
 		, m_intra_quant_matrix(NULL)
 		, m_non_intra_quant_matrix(NULL)
 		, m_current_Y(NULL)
@@ -736,19 +726,16 @@ namespace cmpeg
 		, m_forward_Cr(NULL)
 		, m_forward_Cb(NULL)
 		, m_current_frame(0)
+		, m_dsp(mpeg1_dsp_detect())
 	{
 		m_custom_intra_quant_matrix = new int[64];
 		m_custom_non_intra_quant_matrix = new int[64];
-
-		m_block_data = new int32_t[64];
-		fill(m_block_data, 0);
 	}
 
 	decoder_mpeg1::~decoder_mpeg1()
 	{
 		SAFLE_DELETE_ARRAY(m_custom_intra_quant_matrix);
 		SAFLE_DELETE_ARRAY(m_custom_non_intra_quant_matrix);
-		SAFLE_DELETE_ARRAY(m_block_data);
 
 		SAFLE_DELETE_ARRAY(m_current_Y);
 		SAFLE_DELETE_ARRAY(m_current_Cr);
@@ -903,9 +890,21 @@ namespace cmpeg
 			code = m_bits->find_next_start_code();
 		} while (code==MPEG1::START::EXTENSION || code==MPEG1::START::USER_DATA);
 
+		// find every slice first, each one gets it's own reader ending at the next start code
+		size_t slice_count = 0;
 		while (code >= MPEG1::START::SLICE_FIRST && code <= MPEG1::START::SLICE_LAST) {
-			decode_slice(code & 0x000000FF);
+			int begin = m_bits->read_index();
+			int slice = code & 0x000000FF;
+
 			code = m_bits->find_next_start_code();
+			int end = (code != -1) ? (m_bits->read_index() >> 3) - 4 : m_bits->byte_size();
+
+			if (m_slices.size() <= slice_count)
+				m_slices.resize(slice_count + 1);
+
+			slice_context& s = m_slices[slice_count++];
+			s.bits = bit_reader(m_bits->data(), end, begin);
+			s.slice = slice;
 		}
 
 		if (code != -1)
@@ -913,6 +912,17 @@ namespace cmpeg
 			m_bits->rewind(32);
 		}
 
+		// slices only share the forward reference, which is read only
+		if (m_parallel_for && slice_count > 1)
+		{
+			m_parallel_for(int(slice_count), [this](int i) { decode_slice(m_slices[i]); });
+		}
+		else
+		{
+			for (size_t i = 0; i < slice_count; i++)
+				decode_slice(m_slices[i]);
+		}
+
 		// invoke decode callbacks
 		if (m_destination)
 		{
@@ -928,365 +938,165 @@ namespace cmpeg
 		}
 	}
 
-	void decoder_mpeg1::decode_slice(int slice)
+	void decoder_mpeg1::decode_slice(slice_context& s)
 	{
-		m_slice_begin = true;
-		m_macro_block_address = (slice - 1) * m_mb_width - 1;
+		s.slice_begin = true;
+		s.macro_block_address = (s.slice - 1) * m_mb_width - 1;
 
 		// reset motion vectors are DC predictors
-		m_motion_FwH = m_motion_FwH_prev = 0;
-		m_motion_FwV = m_motion_FwV_prev = 0;
-		m_dc_predictor_Y = 128;
-		m_dc_predictor_Cr = 128;
-		m_dc_predictor_Cb = 128;
+		s.motion_FwH = s.motion_FwH_prev = 0;
+		s.motion_FwV = s.motion_FwV_prev = 0;
+		s.dc_predictor_Y = 128;
+		s.dc_predictor_Cr = 128;
+		s.dc_predictor_Cb = 128;
+		fill(s.block_data, 0);
 
-		m_quantizer_scale = m_bits->read(5);
+		s.quantizer_scale = s.bits.read(5);
 
-		while (m_bits->read(1)) {
-			m_bits->skip(8);
+		while (s.bits.read(1)) {
+			s.bits.skip(8);
 		}
 
 		do {
-			decode_macro_block();
-		} while (!m_bits->next_bytes_are_start_code());
+			decode_macro_block(s);
+		} while (!s.bits.next_bytes_are_start_code());
 	}
 
-	void decoder_mpeg1::decode_macro_block()
+	void decoder_mpeg1::decode_macro_block(slice_context& s)
 	{
 		int increment = 0;
-		int t = read_huffman(MPEG1::MACROBLOCK_ADDRESS_INCREMENT);
+		int t = read_huffman(s.bits, MPEG1::MACROBLOCK_ADDRESS_INCREMENT);
 
 		while (t == 34) {
 			// macroblock stuffing
-			t = read_huffman(MPEG1::MACROBLOCK_ADDRESS_INCREMENT);
+			t = read_huffman(s.bits, MPEG1::MACROBLOCK_ADDRESS_INCREMENT);
 		}
 
 		while (t == 35) {
 			// macroblock escape
 			increment += 33;
-			t = read_huffman(MPEG1::MACROBLOCK_ADDRESS_INCREMENT);
+			t = read_huffman(s.bits, MPEG1::MACROBLOCK_ADDRESS_INCREMENT);
 		}
 
 		increment += t;
 
 		// process any skipped macroblocks
-		if (m_slice_begin) {
+		if (s.slice_begin) {
 			// the first macroblock_address_increment of each slice is relative
 			// to beginning of the preverious row, not the preverious macroblock
-			m_slice_begin = false;
-			m_macro_block_address += increment;
+			s.slice_begin = false;
+			s.macro_block_address += increment;
+			if (s.macro_block_address >= m_mb_size) {
+				return;
+			}
 		}
 		else{
-			if (m_macro_block_address + increment >= m_mb_size) {
+			if (s.macro_block_address + increment >= m_mb_size) {
 				return;
 			}
 
 			if (increment > 1) {
 				// skipped macroblock reset DC predictors
-				m_dc_predictor_Y = 128;
-				m_dc_predictor_Cr = 128;
-				m_dc_predictor_Cb = 128;
+				s.dc_predictor_Y = 128;
+				s.dc_predictor_Cr = 128;
+				s.dc_predictor_Cb = 128;
 
 				// skipped macroblocks in P-pictures reset motion vectors
 				if (m_picture_type == MPEG1::PICTURE_TYPE::PREDICTIVE) {
-					m_motion_FwH = m_motion_FwH_prev = 0;
-					m_motion_FwV = m_motion_FwV_prev = 0;
+					s.motion_FwH = s.motion_FwH_prev = 0;
+					s.motion_FwV = s.motion_FwV_prev = 0;
 				}
 			}
 
 			// predict skipped macroblocks
 			while (increment > 1) {
-				m_macro_block_address++;
-				m_mb_row = (m_macro_block_address / m_mb_width) | 0;
-				m_mb_col = (m_macro_block_address % m_mb_width);
+				s.macro_block_address++;
+				s.mb_row = (s.macro_block_address / m_mb_width) | 0;
+				s.mb_col = (s.macro_block_address % m_mb_width);
 
-				copy_macro_block( m_motion_FwH, m_motion_FwV, m_forward_Y, m_forward_Cr, m_forward_Cb);
+				copy_macro_block(s, s.motion_FwH, s.motion_FwV, m_forward_Y, m_forward_Cr, m_forward_Cb);
 
 				increment--;
 			}
 
-			m_macro_block_address++;
+			s.macro_block_address++;
 		}
 
-		m_mb_row = (m_macro_block_address / m_mb_width) | 0;
-		m_mb_col = (m_macro_block_address % m_mb_width);
+		s.mb_row = (s.macro_block_address / m_mb_width) | 0;
+		s.mb_col = (s.macro_block_address % m_mb_width);
 
 		// process the current macroblock
 		int* mb_table = MPEG1::MACROBLOCK_TYPE[m_picture_type];
-		m_macro_block_type = read_huffman(mb_table);
-		m_macro_block_intra = (m_macro_block_type & 0x01);
-		m_macro_block_motFw = (m_macro_block_type & 0x08);
+		s.macro_block_type = read_huffman(s.bits, mb_table);
+		s.macro_block_intra = (s.macro_block_type & 0x01);
+		s.macro_block_motFw = (s.macro_block_type & 0x08);
 
-		if ((m_macro_block_type & 0x10) != 0) {
-			m_quantizer_scale = m_bits->read(5);
+		if ((s.macro_block_type & 0x10) != 0) {
+			s.quantizer_scale = s.bits.read(5);
 		}
 
-		if (m_macro_block_intra) {
+		if (s.macro_block_intra) {
 			// intra-code macroblocks reset motion vectors
-			m_motion_FwH = m_motion_FwH_prev = 0;
-			m_motion_FwV = m_motion_FwV_prev = 0;
+			s.motion_FwH = s.motion_FwH_prev = 0;
+			s.motion_FwV = s.motion_FwV_prev = 0;
 		}
 		else {
-			m_dc_predictor_Y = 128;
-			m_dc_predictor_Cr = 128;
-			m_dc_predictor_Cb = 128;
+			s.dc_predictor_Y = 128;
+			s.dc_predictor_Cr = 128;
+			s.dc_predictor_Cb = 128;
 
-			decode_motion_vectors();
-			copy_macro_block( m_motion_FwH, m_motion_FwV, m_forward_Y, m_forward_Cr, m_forward_Cb);
+			decode_motion_vectors(s);
+			copy_macro_block(s, s.motion_FwH, s.motion_FwV, m_forward_Y, m_forward_Cr, m_forward_Cb);
 		}
 
 		// decode blocks
-		int16_t cbp = ((m_macro_block_type & 0x02) != 0) ? read_huffman(MPEG1::CODE_BLOCK_PATTERN) : (m_macro_block_intra ? 0x3f : 0);
+		int16_t cbp = ((s.macro_block_type & 0x02) != 0) ? read_huffman(s.bits, MPEG1::CODE_BLOCK_PATTERN) : (s.macro_block_intra ? 0x3f : 0);
 
 		for (int block = 0, mask = 0x20; block < 6; block++) {
 			if ((cbp & mask) != 0) {
-				decode_block(block);
+				decode_block(s, block);
 			}
 
 			mask >>= 1;
 		}
 	}
 
-	void decoder_mpeg1::copy_macro_block(int motionH, int motionV, uint8_t* sY, uint8_t* sCr, uint8_t* sCb) 
+	void decoder_mpeg1::copy_macro_block(slice_context& s, int motionH, int motionV, uint8_t* sY, uint8_t* sCr, uint8_t* sCb) 
 	{
-		int width, scan,
-			H, V, oddH, oddV,
-			src, dest, last;
-
-		// We use 32bit writes here
-		uint32_t* dY = (uint32_t*)m_current_Y;
-		uint32_t* dCb = (uint32_t*)m_current_Cb;
-		uint32_t* dCr = (uint32_t*)m_current_Cr;
-
 		// Luminance
-		width = m_coded_width;
-		scan = width - 16;
-
-		H = motionH >> 1;
-		V = motionV >> 1;
-		oddH = (motionH & 1) == 1;
-		oddV = (motionV & 1) == 1;
-
-		src = ((m_mb_row << 4) + V) * width + (m_mb_col << 4) + H;
-		dest = (m_mb_row * width + m_mb_col) << 2;
-		last = dest + (width << 2);
-
-		int x, y1, y2, y;
-		if (oddH) {
-			if (oddV) {
-				while (dest < last) {
-					y1 = sY[src] + sY[src + width]; src++;
-					for (x = 0; x < 4; x++) {
-						y2 = sY[src] + sY[src + width]; src++;
-						y = (((y1 + y2 + 2) >> 2) & 0xff);
-
-						y1 = sY[src] + sY[src + width]; src++;
-						y |= (((y1 + y2 + 2) << 6) & 0xff00);
-
-						y2 = sY[src] + sY[src + width]; src++;
-						y |= (((y1 + y2 + 2) << 14) & 0xff0000);
-
-						y1 = sY[src] + sY[src + width]; src++;
-						y |= (((y1 + y2 + 2) << 22) & 0xff000000);
-
-						dY[dest++] = y;
-					}
-					dest += scan >> 2; src += scan - 1;
-				}
-			}
-			else {
-				while (dest < last) {
-					y1 = sY[src++];
-					for (x = 0; x < 4; x++) {
-						y2 = sY[src++];
-						y = (((y1 + y2 + 1) >> 1) & 0xff);
-
-						y1 = sY[src++];
-						y |= (((y1 + y2 + 1) << 7) & 0xff00);
-
-						y2 = sY[src++];
-						y |= (((y1 + y2 + 1) << 15) & 0xff0000);
+		int width = m_coded_width;
+		int H = motionH >> 1;
+		int V = motionV >> 1;
+		bool oddH = (motionH & 1) == 1;
+		bool oddV = (motionV & 1) == 1;
 
-						y1 = sY[src++];
-						y |= (((y1 + y2 + 1) << 23) & 0xff000000);
-
-						dY[dest++] = y;
-					}
-					dest += scan >> 2; src += scan - 1;
-				}
-			}
-		}
-		else {
-			if (oddV) {
-				while (dest < last) {
-					for (x = 0; x < 4; x++) {
-						y = (((sY[src] + sY[src + width] + 1) >> 1) & 0xff); src++;
-						y |= (((sY[src] + sY[src + width] + 1) << 7) & 0xff00); src++;
-						y |= (((sY[src] + sY[src + width] + 1) << 15) & 0xff0000); src++;
-						y |= (((sY[src] + sY[src + width] + 1) << 23) & 0xff000000); src++;
-
-						dY[dest++] = y;
-					}
-					dest += scan >> 2; src += scan;
-				}
-			}
-			else {
-				while (dest < last) {
-					for (x = 0; x < 4; x++) {
-						y = sY[src]; src++;
-						y |= sY[src] << 8; src++;
-						y |= sY[src] << 16; src++;
-						y |= sY[src] << 24; src++;
-
-						dY[dest++] = y;
-					}
-					dest += scan >> 2; src += scan;
-				}
-			}
-		}
+		int src = ((s.mb_row << 4) + V) * width + (s.mb_col << 4) + H;
+		int dest = (s.mb_row * width + s.mb_col) << 4;
+		m_dsp->predict(sY + src, m_current_Y + dest, width, 16, oddH, oddV);
 
 		// Chrominance
-
 		width = m_half_width;
-		scan = width - 8;
-
 		H = (motionH / 2) >> 1;
 		V = (motionV / 2) >> 1;
 		oddH = ((motionH / 2) & 1) == 1;
 		oddV = ((motionV / 2) & 1) == 1;
 
-		src = ((m_mb_row << 3) + V) * width + (m_mb_col << 3) + H;
-		dest = (m_mb_row * width + m_mb_col) << 1;
-		last = dest + (width << 1);
-
-		int cr1, cr2, cr,
-			cb1, cb2, cb;
-		if (oddH) {
-			if (oddV) {
-				while (dest < last) {
-					cr1 = sCr[src] + sCr[src + width];
-					cb1 = sCb[src] + sCb[src + width];
-					src++;
-					for (x = 0; x < 2; x++) {
-						cr2 = sCr[src] + sCr[src + width];
-						cb2 = sCb[src] + sCb[src + width]; src++;
-						cr = (((cr1 + cr2 + 2) >> 2) & 0xff);
-						cb = (((cb1 + cb2 + 2) >> 2) & 0xff);
-
-						cr1 = sCr[src] + sCr[src + width];
-						cb1 = sCb[src] + sCb[src + width]; src++;
-						cr |= (((cr1 + cr2 + 2) << 6) & 0xff00);
-						cb |= (((cb1 + cb2 + 2) << 6) & 0xff00);
-
-						cr2 = sCr[src] + sCr[src + width];
-						cb2 = sCb[src] + sCb[src + width]; src++;
-						cr |= (((cr1 + cr2 + 2) << 14) & 0xff0000);
-						cb |= (((cb1 + cb2 + 2) << 14) & 0xff0000);
-
-						cr1 = sCr[src] + sCr[src + width];
-						cb1 = sCb[src] + sCb[src + width]; src++;
-						cr |= (((cr1 + cr2 + 2) << 22) & 0xff000000);
-						cb |= (((cb1 + cb2 + 2) << 22) & 0xff000000);
-
-						dCr[dest] = cr;
-						dCb[dest] = cb;
-						dest++;
-					}
-					dest += scan >> 2; src += scan - 1;
-				}
-			}
-			else {
-				while (dest < last) {
-					cr1 = sCr[src];
-					cb1 = sCb[src];
-					src++;
-					for (x = 0; x < 2; x++) {
-						cr2 = sCr[src];
-						cb2 = sCb[src++];
-						cr = (((cr1 + cr2 + 1) >> 1) & 0xff);
-						cb = (((cb1 + cb2 + 1) >> 1) & 0xff);
-
-						cr1 = sCr[src];
-						cb1 = sCb[src++];
-						cr |= (((cr1 + cr2 + 1) << 7) & 0xff00);
-						cb |= (((cb1 + cb2 + 1) << 7) & 0xff00);
-
-						cr2 = sCr[src];
-						cb2 = sCb[src++];
-						cr |= (((cr1 + cr2 + 1) << 15) & 0xff0000);
-						cb |= (((cb1 + cb2 + 1) << 15) & 0xff0000);
-
-						cr1 = sCr[src];
-						cb1 = sCb[src++];
-						cr |= (((cr1 + cr2 + 1) << 23) & 0xff000000);
-						cb |= (((cb1 + cb2 + 1) << 23) & 0xff000000);
-
-						dCr[dest] = cr;
-						dCb[dest] = cb;
-						dest++;
-					}
-					dest += scan >> 2; src += scan - 1;
-				}
-			}
-		}
-		else {
-			if (oddV) {
-				while (dest < last) {
-					for (x = 0; x < 2; x++) {
-						cr = (((sCr[src] + sCr[src + width] + 1) >> 1) & 0xff);
-						cb = (((sCb[src] + sCb[src + width] + 1) >> 1) & 0xff); src++;
-
-						cr |= (((sCr[src] + sCr[src + width] + 1) << 7) & 0xff00);
-						cb |= (((sCb[src] + sCb[src + width] + 1) << 7) & 0xff00); src++;
-
-						cr |= (((sCr[src] + sCr[src + width] + 1) << 15) & 0xff0000);
-						cb |= (((sCb[src] + sCb[src + width] + 1) << 15) & 0xff0000); src++;
-
-						cr |= (((sCr[src] + sCr[src + width] + 1) << 23) & 0xff000000);
-						cb |= (((sCb[src] + sCb[src + width] + 1) << 23) & 0xff000000); src++;
-
-						dCr[dest] = cr;
-						dCb[dest] = cb;
-						dest++;
-					}
-					dest += scan >> 2; src += scan;
-				}
-			}
-			else {
-				while (dest < last) {
-					for (x = 0; x < 2; x++) {
-						cr = sCr[src];
-						cb = sCb[src]; src++;
-
-						cr |= sCr[src] << 8;
-						cb |= sCb[src] << 8; src++;
-
-						cr |= sCr[src] << 16;
-						cb |= sCb[src] << 16; src++;
-
-						cr |= sCr[src] << 24;
-						cb |= sCb[src] << 24; src++;
-
-						dCr[dest] = cr;
-						dCb[dest] = cb;
-						dest++;
-					}
-					dest += scan >> 2; src += scan;
-				}
-			}
-		}
+		src = ((s.mb_row << 3) + V) * width + (s.mb_col << 3) + H;
+		dest = (s.mb_row * width + s.mb_col) << 3;
+		m_dsp->predict(sCr + src, m_current_Cr + dest, width, 8, oddH, oddV);
+		m_dsp->predict(sCb + src, m_current_Cb + dest, width, 8, oddH, oddV);
 	};
 
-	void decoder_mpeg1::decode_motion_vectors() {
+	void decoder_mpeg1::decode_motion_vectors(slice_context& s) {
 
 		int code, d, r = 0;
 
 		// Forward
-		if ( m_macro_block_motFw) {
+		if ( s.macro_block_motFw) {
 			// Horizontal forward
-			code = read_huffman(MPEG1::MOTION);
+			code = read_huffman(s.bits, MPEG1::MOTION);
 			if ((code != 0) && (m_forward_f !=1)) {
-				r = m_bits->read( m_forward_r_size);
+				r = s.bits.read( m_forward_r_size);
 				d = ((abs(code) - 1) << m_forward_r_size) + r + 1;
 				if (code < 0) {
 					d = -d;
@@ -1296,23 +1106,23 @@ namespace cmpeg
 				d = code;
 			}
 	
-			m_motion_FwH_prev += d;
-			if (m_motion_FwH_prev > (m_forward_f << 4) - 1) {
-				m_motion_FwH_prev -= m_forward_f << 5;
+			s.motion_FwH_prev += d;
+			if (s.motion_FwH_prev > (m_forward_f << 4) - 1) {
+				s.motion_FwH_prev -= m_forward_f << 5;
 			}
-			else if ( m_motion_FwH_prev < ((-m_forward_f) << 4)) {
-				m_motion_FwH_prev += m_forward_f << 5;
+			else if ( s.motion_FwH_prev < ((-m_forward_f) << 4)) {
+				s.motion_FwH_prev += m_forward_f << 5;
 			}
 
-			m_motion_FwH = m_motion_FwH_prev;
+			s.motion_FwH = s.motion_FwH_prev;
 			if ( m_full_pel_foward) {
-				m_motion_FwH <<= 1;
+				s.motion_FwH <<= 1;
 			}
 
 			// Vertical forward
-			code = read_huffman(MPEG1::MOTION);
+			code = read_huffman(s.bits, MPEG1::MOTION);
 			if ((code != 0) && (m_forward_f != 1)) {
-				r = m_bits->read(m_forward_r_size);
+				r = s.bits.read(m_forward_r_size);
 				d = ((abs(code) - 1) << m_forward_r_size) + r + 1;
 				if (code < 0) {
 					d = -d;
@@ -1322,74 +1132,74 @@ namespace cmpeg
 				d = code;
 			}
 
-			m_motion_FwV_prev += d;
-			if (m_motion_FwV_prev > (m_forward_f << 4) - 1) {
-				m_motion_FwV_prev -= m_forward_f << 5;
+			s.motion_FwV_prev += d;
+			if (s.motion_FwV_prev > (m_forward_f << 4) - 1) {
+				s.motion_FwV_prev -= m_forward_f << 5;
 			}
-			else if (m_motion_FwV_prev < ((-m_forward_f) << 4)) {
-				m_motion_FwV_prev += m_forward_f << 5;
+			else if (s.motion_FwV_prev < ((-m_forward_f) << 4)) {
+				s.motion_FwV_prev += m_forward_f << 5;
 			}
 
-			m_motion_FwV = m_motion_FwV_prev;
+			s.motion_FwV = s.motion_FwV_prev;
 			if (m_full_pel_foward) {
-				m_motion_FwV <<= 1;
+				s.motion_FwV <<= 1;
 			}
 		}
 		else if (m_picture_type == MPEG1::PICTURE_TYPE::PREDICTIVE) {
 			// No motion information in P-picture, reset vectors
-			m_motion_FwH = m_motion_FwH_prev = 0;
-			m_motion_FwV = m_motion_FwV_prev = 0;
+			s.motion_FwH = s.motion_FwH_prev = 0;
+			s.motion_FwV = s.motion_FwV_prev = 0;
 		}
 	};
 
-	void decoder_mpeg1::decode_block(int block) {
+	void decoder_mpeg1::decode_block(slice_context& s, int block) {
 
 		int n = 0;
 		int* quantMatrix = NULL;
 
 		// Decode DC coefficient of intra-coded blocks
-		if (m_macro_block_intra) {
+		if (s.macro_block_intra) {
 			int predictor;
 			int	dctSize;
 
 			// DC prediction
 
 			if (block < 4) {
-				predictor = m_dc_predictor_Y;
-				dctSize = read_huffman(MPEG1::DCT_DC_SIZE_LUMINANCE);
+				predictor = s.dc_predictor_Y;
+				dctSize = read_huffman(s.bits, MPEG1::DCT_DC_SIZE_LUMINANCE);
 			}
 			else {
-				predictor = (block == 4 ? m_dc_predictor_Cr : m_dc_predictor_Cb);
-				dctSize = read_huffman(MPEG1::DCT_DC_SIZE_CHROMINANCE);
+				predictor = (block == 4 ? s.dc_predictor_Cr : s.dc_predictor_Cb);
+				dctSize = read_huffman(s.bits, MPEG1::DCT_DC_SIZE_CHROMINANCE);
 			}
 
 			// Read DC coeff
 			if (dctSize > 0) {
-				int differential = m_bits->read(dctSize);
+				int differential = s.bits.read(dctSize);
 				if ((differential & (1 << (dctSize - 1))) != 0) {
-					m_block_data[0] = predictor + differential;
+					s.block_data[0] = predictor + differential;
 				}
 				else {
-					m_block_data[0] = predictor + ((-1 << dctSize) | (differential + 1));
+					s.block_data[0] = predictor + ((-1 << dctSize) | (differential + 1));
 				}
 			}
 			else {
-				m_block_data[0] = predictor;
+				s.block_data[0] = predictor;
 			}
 
 			// Save predictor value
 			if (block < 4) {
-				m_dc_predictor_Y = m_block_data[0];
+				s.dc_predictor_Y = s.block_data[0];
 			}
 			else if (block == 4) {
-				m_dc_predictor_Cr = m_block_data[0];
+				s.dc_predictor_Cr = s.block_data[0];
 			}
 			else {
-				m_dc_predictor_Cb = m_block_data[0];
+				s.dc_predictor_Cb = s.block_data[0];
 			}
 
 			// Dequantize + premultiply
-			m_block_data[0] <<= (3 + 5);
+			s.block_data[0] <<= (3 + 5);
 
 			quantMatrix = m_intra_quant_matrix;
 			n = 1;
@@ -1402,21 +1212,21 @@ namespace cmpeg
 		int level = 0;
 		while (true) {
 			int run = 0;
-			int32_t coeff = read_huffman(MPEG1::DCT_COEFF);
+			int32_t coeff = read_huffman(s.bits, MPEG1::DCT_COEFF);
 
-			if ((coeff == 0x0001) && (n > 0) && (m_bits->read(1) == 0)) {
+			if ((coeff == 0x0001) && (n > 0) && (s.bits.read(1) == 0)) {
 				// end_of_block
 				break;
 			}
 			if (coeff == 0xffff) {
 				// escape
-				run = m_bits->read(6);
-				level = m_bits->read(8);
+				run = s.bits.read(6);
+				level = s.bits.read(8);
 				if (level == 0) {
-					level = m_bits->read(8);
+					level = s.bits.read(8);
 				}
 				else if (level == 128) {
-					level = m_bits->read(8) - 256;
+					level = s.bits.read(8) - 256;
 				}
 				else if (level > 128) {
 					level = level - 256;
@@ -1425,7 +1235,7 @@ namespace cmpeg
 			else {
 				run = coeff >> 8;
 				level = coeff & 0xff;
-				if (m_bits->read(1)) {
+				if (s.bits.read(1)) {
 					level = -level;
 				}
 			}
@@ -1436,10 +1246,10 @@ namespace cmpeg
 
 			// Dequantize, oddify, clip
 			level <<= 1;
-			if (!m_macro_block_intra) {
+			if (!s.macro_block_intra) {
 				level += (level < 0 ? -1 : 1);
 			}
-			level = (level * m_quantizer_scale * quantMatrix[dezigZagged]) >> 4;
+			level = (level * s.quantizer_scale * quantMatrix[dezigZagged]) >> 4;
 			if ((level & 1) == 0) {
 				level -= level > 0 ? 1 : -1;
 			}
@@ -1451,7 +1261,7 @@ namespace cmpeg
 			}
 
 			// Save premultiplied coefficient
-			m_block_data[dezigZagged] = level * MPEG1::PREMULTIPLIER_MATRIX[dezigZagged];
+			s.block_data[dezigZagged] = level * MPEG1::PREMULTIPLIER_MATRIX[dezigZagged];
 		}
 
 		// Move block to its place
@@ -1462,7 +1272,7 @@ namespace cmpeg
 		if (block < 4) {
 			destArray = m_current_Y;
 			scan = m_coded_width - 8;
-			destIndex = (m_mb_row * m_coded_width + m_mb_col) << 4;
+			destIndex = (s.mb_row * m_coded_width + s.mb_col) << 4;
 			if ((block & 1) != 0) {
 				destIndex += 8;
 			}
@@ -1473,38 +1283,38 @@ namespace cmpeg
 		else {
 			destArray = (block == 4) ? m_current_Cb : m_current_Cr;
 			scan = (m_coded_width >> 1) - 8;
-			destIndex = ((m_mb_row * m_coded_width) << 2) + (m_mb_col << 3);
+			destIndex = ((s.mb_row * m_coded_width) << 2) + (s.mb_col << 3);
 		}
 
-		if (m_macro_block_intra) {
+		if (s.macro_block_intra) {
 			// Overwrite (no prediction)
 			if (n == 1) {
-				copy_value_to_destination((m_block_data[0] + 128) >> 8, destArray, destIndex, scan);
-				m_block_data[0] = 0;
+				copy_value_to_destination((s.block_data[0] + 128) >> 8, destArray, destIndex, scan);
+				s.block_data[0] = 0;
 			}
 			else {
-				IDCT(m_block_data);
-				copy_block_to_destination(m_block_data, destArray, destIndex, scan);
-				fill(m_block_data, 0);
+				m_dsp->idct(s.block_data);
+				m_dsp->copy_block(s.block_data, destArray + destIndex, scan + 8);
+				fill(s.block_data, 0);
 			}
 		}
 		else {
 			// Add data to the predicted macroblock
 			if (n == 1) {
-				add_value_to_destination((m_block_data[0] + 128) >> 8, destArray, destIndex, scan);
-				m_block_data[0] = 0;
+				add_value_to_destination((s.block_data[0] + 128) >> 8, destArray, destIndex, scan);
+				s.block_data[0] = 0;
 			}
 			else {
-				IDCT( m_block_data);
-				add_block_to_destination(m_block_data, destArray, destIndex, scan);
-				fill(m_block_data, 0);
+				m_dsp->idct(s.block_data);
+				m_dsp->add_block(s.block_data, destArray + destIndex, scan + 8);
+				fill(s.block_data, 0);
 			}
 		}
 
 		n = 0;
 	};
 
-	void decoder_mpeg1::fill( int* block_data, int value) {
+	void decoder_mpeg1::fill(int32_t* block_data, int value) {
 		for (int i = 0; i < 64; i++)
 		{
 			block_data[i] = value;
@@ -1530,96 +1340,4 @@ namespace cmpeg
 			}
 		}
 	}
-
-	void decoder_mpeg1::copy_block_to_destination(int* block, uint8_t* dest, int index, int scan) {
-		for (int n = 0; n < 64; n += 8, index += scan + 8) {
-
-			for (int i = 0; i < 8; i++)
-			{
-				int result = block[n+i];
-				dest[index + i] = CLAMP(result, 0, 255);
-			}
-		}
-	};
-
-	void decoder_mpeg1::add_block_to_destination(int* block, uint8_t* dest, int index, int scan) {
-		for (int n = 0; n < 64; n += 8, index += scan + 8) {
-			
-			for (int i = 0; i < 8; i++)
-			{
-				int result = dest[index + i] + block[n + i];
-				dest[index + i] = CLAMP(result, 0, 255);
-			}
-		}
-	};
-
-	void decoder_mpeg1::IDCT( int* block) {
-		// See http://vsr.informatik.tu-chemnitz.de/~jan/MPEG/HTML/IDCT.html
-		// for more info.
-
-		int
-			b1, b3, b4, b6, b7, tmp1, tmp2, m0,
-			x0, x1, x2, x3, x4, y3, y4, y5, y6, y7;
-
-		// Transform columns
-		for (int i = 0; i < 8; ++i) {
-			b1 = block[4 * 8 + i];
-			b3 = block[2 * 8 + i] + block[6 * 8 + i];
-			b4 = block[5 * 8 + i] - block[3 * 8 + i];
-			tmp1 = block[1 * 8 + i] + block[7 * 8 + i];
-			tmp2 = block[3 * 8 + i] + block[5 * 8 + i];
-			b6 = block[1 * 8 + i] - block[7 * 8 + i];
-			b7 = tmp1 + tmp2;
-			m0 = block[0 * 8 + i];
-			x4 = ((b6 * 473 - b4 * 196 + 128) >> 8) - b7;
-			x0 = x4 - (((tmp1 - tmp2) * 362 + 128) >> 8);
-			x1 = m0 - b1;
-			x2 = (((block[2 * 8 + i] - block[6 * 8 + i]) * 362 + 128) >> 8) - b3;
-			x3 = m0 + b1;
-			y3 = x1 + x2;
-			y4 = x3 + b3;
-			y5 = x1 - x2;
-			y6 = x3 - b3;
-			y7 = -x0 - ((b4 * 473 + b6 * 196 + 128) >> 8);
-			block[0 * 8 + i] = b7 + y4;
-			block[1 * 8 + i] = x4 + y3;
-			block[2 * 8 + i] = y5 - x0;
-			block[3 * 8 + i] = y6 - y7;
-			block[4 * 8 + i] = y6 + y7;
-			block[5 * 8 + i] = x0 + y5;
-			block[6 * 8 + i] = y3 - x4;
-			block[7 * 8 + i] = y4 - b7;
-		}
-
-		// Transform rows
-		for (int i = 0; i < 64; i += 8) {
-			b1 = block[4 + i];
-			b3 = block[2 + i] + block[6 + i];
-			b4 = block[5 + i] - block[3 + i];
-			tmp1 = block[1 + i] + block[7 + i];
-			tmp2 = block[3 + i] + block[5 + i];
-			b6 = block[1 + i] - block[7 + i];
-			b7 = tmp1 + tmp2;
-			m0 = block[0 + i];
-			x4 = ((b6 * 473 - b4 * 196 + 128) >> 8) - b7;
-			x0 = x4 - (((tmp1 - tmp2) * 362 + 128) >> 8);
-			x1 = m0 - b1;
-			x2 = (((block[2 + i] - block[6 + i]) * 362 + 128) >> 8) - b3;
-			x3 = m0 + b1;
-			y3 = x1 + x2;
-			y4 = x3 + b3;
-			y5 = x1 - x2;
-			y6 = x3 - b3;
-			y7 = -x0 - ((b4 * 473 + b6 * 196 + 128) >> 8);
-			block[0 + i] = (b7 + y4 + 128) >> 8;
-			block[1 + i] = (x4 + y3 + 128) >> 8;
-			block[2 + i] = (y5 - x0 + 128) >> 8;
-			block[3 + i] = (y6 - y7 + 128) >> 8;
-			block[4 + i] = (y6 + y7 + 128) >> 8;
-			block[5 + i] = (x0 + y5 + 128) >> 8;
-			block[6 + i] = (y3 - x4 + 128) >> 8;
-			block[7 + i] = (y4 - b7 + 128) >> 8;
-		}
-	};
-
 }
\ No newline at end of file
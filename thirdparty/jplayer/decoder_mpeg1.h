@@ -1,40 +1,79 @@
 #pragma once
 
+#include <functional>
 #include "decoder_base.h"
+#include "decoder_mpeg1_dsp.h"
 
 namespace cmpeg
 {
 	class decoder_mpeg1 : public decoder_base
 	{
+	public:
+		// runs task(0) .. task(count-1), on any thread, returns when all of them are done
+		typedef std::function<void(int count, const std::function<void(int)>& task)> parallel_for;
+
 	public:
 		decoder_mpeg1();
 		virtual ~decoder_mpeg1();
 		virtual bool write(int pts, const std::vector<uint8_t>& buffer);
+		virtual bool decode();
+
+		// pictures decoded so far, skipped ones included
+		int get_current_frame() const { return m_current_frame; }
+		double get_frame_rate() const { return m_frame_rate; }
+
+		// block kernels, mpeg1_dsp_detect() by default
+		const mpeg1_dsp* get_dsp() const { return m_dsp; }
+		void set_dsp(const mpeg1_dsp* dsp) { m_dsp = dsp; }
+
+		// the slices of a picture are decoded through it, one after another by default
+		void set_parallel_for(const parallel_for& func) { m_parallel_for = func; }
 		
+	private:
+		// state of one slice, slices of a picture are independent of each other
+		struct slice_context
+		{
+			bit_reader	bits;
+			int			slice;
+			bool		slice_begin;
+			int			macro_block_address;
+			int			macro_block_type;
+			int			macro_block_intra;
+			int			macro_block_motFw;
+			int			mb_row;
+			int			mb_col;
+			int			motion_FwH;
+			int			motion_FwH_prev;
+			int			motion_FwV;
+			int			motion_FwV_prev;
+			int			dc_predictor_Y;
+			int			dc_predictor_Cr;
+			int			dc_predictor_Cb;
+			int			quantizer_scale;
+			int32_t		block_data[64];
+		};
+		typedef std::vector<slice_context> slice_context_arr;
+
 	private:
 		void decode_sequence_header();
-		virtual bool decode();
 		void init_buffers();
 		void decode_picture();
-		void decode_slice(int slice);
-		void decode_macro_block();
-		void decode_motion_vectors();
-		void decode_block(int block);
-		void copy_macro_block(int motionH, int motionV, uint8_t* sY, uint8_t* sCr, uint8_t* sCb);
+		void decode_slice(slice_context& s);
+		void decode_macro_block(slice_context& s);
+		void decode_motion_vectors(slice_context& s);
+		void decode_block(slice_context& s, int block);
+		void copy_macro_block(slice_context& s, int motionH, int motionV, uint8_t* sY, uint8_t* sCr, uint8_t* sCb);
 		void copy_value_to_destination(int value, uint8_t* dest, int index, int scan);
 		void add_value_to_destination(int value, uint8_t* dest, int index, int scan);
-		void copy_block_to_destination(int* block, uint8_t* dest, int index, int scan);
-		void add_block_to_destination(int* block, uint8_t* dest, int index, int scan);
-		void IDCT(int* block);
-		void fill(int* block_data, int value);
+		void fill(int32_t* block_data, int value);
 
 	private:
-		template<typename T> T read_huffman(T* code_table)
+		template<typename T> static T read_huffman(bit_reader& bits, T* code_table)
 		{
 			int state = 0;
 			do
 			{
-				state = code_table[state + m_bits->read(1)];
+				state = code_table[state + bits.read(1)];
 			} while (state >= 0 && code_table[state] != 0);
 
 			return code_table[state + 2];
@@ -57,24 +96,6 @@ namespace cmpeg
 		int			m_picture_type;
 		int			m_current_frame;
 
-		bool		m_slice_begin;
-		int			m_macro_block_address;
-		int			m_macro_block_type;
-		int			m_macro_block_intra;
-		int			m_macro_block_motFw;
-		int			m_mb_row;
-		int			m_mb_col;
-
-		int			m_motion_FwH;
-		int			m_motion_FwH_prev;
-		int			m_motion_FwV;
-		int			m_motion_FwV_prev;
-
-		int			m_dc_predictor_Y;
-		int			m_dc_predictor_Cr;
-		int			m_dc_predictor_Cb;
-		int			m_quantizer_scale;
-
 		bool		m_full_pel_foward;
 		int			m_forward_f_code;
 		int			m_forward_r_size;
@@ -85,13 +106,15 @@ namespace cmpeg
 		int*		m_custom_intra_quant_matrix;
 		int*		m_custom_non_intra_quant_matrix;
 
-		int32_t*	m_block_data;
-
 		uint8_t*	m_current_Y;
 		uint8_t*	m_current_Cr;
 		uint8_t*	m_current_Cb;
 		uint8_t*	m_forward_Y;
 		uint8_t*	m_forward_Cr;
 		uint8_t*	m_forward_Cb;
+
+		const mpeg1_dsp*	m_dsp;
+		parallel_for		m_parallel_for;
+		slice_context_arr	m_slices;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include "decoder_mpeg1_dsp.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || (defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__)))
+	#define CMPEG_SSE2
+	#include <emmintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define CMPEG_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace cmpeg
+{
+	static inline uint8_t clamp_u8(int32_t v)
+	{
+		return uint8_t(v < 0 ? 0 : (v > 255 ? 255 : v));
+	}
+
+	// one dimension of the idct on 8 values, v[0], v[stride] ... v[7*stride].
+	// T is an int or a simd vector of them, OPS does the arithmetic on it.
+	// See http://vsr.informatik.tu-chemnitz.de/~jan/MPEG/HTML/IDCT.html
+	template<typename T, typename OPS> static inline void idct_1d(T* v, int stride, bool last)
+	{
+		T b1 = v[4 * stride];
+		T b3 = OPS::add(v[2 * stride], v[6 * stride]);
+		T b4 = OPS::sub(v[5 * stride], v[3 * stride]);
+		T tmp1 = OPS::add(v[1 * stride], v[7 * stride]);
+		T tmp2 = OPS::add(v[3 * stride], v[5 * stride]);
+		T b6 = OPS::sub(v[1 * stride], v[7 * stride]);
+		T b7 = OPS::add(tmp1, tmp2);
+		T m0 = v[0];
+		T x4 = OPS::sub(OPS::round(OPS::sub(OPS::mul(b6, 473), OPS::mul(b4, 196))), b7);
+		T x0 = OPS::sub(x4, OPS::round(OPS::mul(OPS::sub(tmp1, tmp2), 362)));
+		T x1 = OPS::sub(m0, b1);
+		T x2 = OPS::sub(OPS::round(OPS::mul(OPS::sub(v[2 * stride], v[6 * stride]), 362)), b3);
+		T x3 = OPS::add(m0, b1);
+		T y3 = OPS::add(x1, x2);
+		T y4 = OPS::add(x3, b3);
+		T y5 = OPS::sub(x1, x2);
+		T y6 = OPS::sub(x3, b3);
+		T y7 = OPS::sub(OPS::sub(OPS::zero(), x0), OPS::round(OPS::add(OPS::mul(b4, 473), OPS::mul(b6, 196))));
+
+		T out[8] = {
+			OPS::add(b7, y4), OPS::add(x4, y3), OPS::sub(y5, x0), OPS::sub(y6, y7),
+			OPS::add(y6, y7), OPS::add(x0, y5), OPS::sub(y3, x4), OPS::sub(y4, b7)
+		};
+
+		for (int i = 0; i < 8; i++)
+			v[i * stride] = last ? OPS::round(out[i]) : out[i];
+	}
+
+	struct scalar_ops
+	{
+		static int32_t zero() { return 0; }
+		static int32_t add(int32_t a, int32_t b) { return a + b; }
+		static int32_t sub(int32_t a, int32_t b) { return a - b; }
+		static int32_t mul(int32_t a, int32_t c) { return a * c; }
+		static int32_t round(int32_t a) { return (a + 128) >> 8; }		// drops the 8 fraction bits of the constants
+	};
+
+	static void idct_scalar(int32_t* block)
+	{
+		// columns, then rows
+		for (int i = 0; i < 8; i++)
+			idct_1d<int32_t, scalar_ops>(block + i, 8, false);
+
+		for (int i = 0; i < 64; i += 8)
+			idct_1d<int32_t, scalar_ops>(block + i, 1, true);
+	}
+
+	static void copy_block_scalar(const int32_t* block, uint8_t* dest, int stride)
+	{
+		for (int y = 0; y < 8; y++, block += 8, dest += stride)
+		{
+			for (int x = 0; x < 8; x++)
+				dest[x] = clamp_u8(block[x]);
+		}
+	}
+
+	static void add_block_scalar(const int32_t* block, uint8_t* dest, int stride)
+	{
+		for (int y = 0; y < 8; y++, block += 8, dest += stride)
+		{
+			for (int x = 0; x < 8; x++)
+				dest[x] = clamp_u8(dest[x] + block[x]);
+		}
+	}
+
+	static void predict_scalar(const uint8_t* src, uint8_t* dest, int stride, int size, bool odd_h, bool odd_v)
+	{
+		for (int y = 0; y < size; y++, src += stride, dest += stride)
+		{
+			if (odd_h && odd_v)
+			{
+				for (int x = 0; x < size; x++)
+					dest[x] = uint8_t((src[x] + src[x + 1] + src[x + stride] + src[x + stride + 1] + 2) >> 2);
+			}
+			else if (odd_h)
+			{
+				for (int x = 0; x < size; x++)
+					dest[x] = uint8_t((src[x] + src[x + 1] + 1) >> 1);
+			}
+			else if (odd_v)
+			{
+				for (int x = 0; x < size; x++)
+					dest[x] = uint8_t((src[x] + src[x + stride] + 1) >> 1);
+			}
+			else
+			{
+				for (int x = 0; x < size; x++)
+					dest[x] = src[x];
+			}
+		}
+	}
+
+	static const mpeg1_dsp DSP_SCALAR = { "scalar", idct_scalar, copy_block_scalar, add_block_scalar, predict_scalar };
+
+#ifdef CMPEG_SSE2
+	struct sse2_ops
+	{
+		static __m128i zero() { return _mm_setzero_si128(); }
+		static __m128i add(__m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+		static __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi32(a, b); }
+		static __m128i round(__m128i a) { return _mm_srai_epi32(_mm_add_epi32(a, _mm_set1_epi32(128)), 8); }
+
+		// no 32 bit mullo in sse2, the low halves of the unsigned products are the same
+		static __m128i mul(__m128i a, int32_t c)
+		{
+			__m128i k = _mm_set1_epi32(c);
+			__m128i even = _mm_mul_epu32(a, k);
+			__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), k);
+			return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+		}
+	};
+
+	static inline void transpose_4x4_sse2(__m128i& a, __m128i& b, __m128i& c, __m128i& d)
+	{
+		__m128i t0 = _mm_unpacklo_epi32(a, b);
+		__m128i t1 = _mm_unpacklo_epi32(c, d);
+		__m128i t2 = _mm_unpackhi_epi32(a, b);
+		__m128i t3 = _mm_unpackhi_epi32(c, d);
+		a = _mm_unpacklo_epi64(t0, t1);
+		b = _mm_unpackhi_epi64(t0, t1);
+		c = _mm_unpacklo_epi64(t2, t3);
+		d = _mm_unpackhi_epi64(t2, t3);
+	}
+
+	// r[row * 2 + half]
+	static inline void transpose_8x8_sse2(__m128i* r)
+	{
+		transpose_4x4_sse2(r[0], r[2], r[4], r[6]);
+		transpose_4x4_sse2(r[1], r[3], r[5], r[7]);
+		transpose_4x4_sse2(r[8], r[10], r[12], r[14]);
+		transpose_4x4_sse2(r[9], r[11], r[13], r[15]);
+		for (int i = 1; i < 8; i += 2)
+		{
+			__m128i t = r[i];
+			r[i] = r[i + 7];
+			r[i + 7] = t;
+		}
+	}
+
+	static void idct_sse2(int32_t* block)
+	{
+		__m128i r[16];
+		for (int i = 0; i < 16; i++)
+			r[i] = _mm_loadu_si128((const __m128i*)(block + i * 4));
+
+		// columns of both halves, the rows are columns after transposing
+		idct_1d<__m128i, sse2_ops>(r, 2, false);
+		idct_1d<__m128i, sse2_ops>(r + 1, 2, false);
+		transpose_8x8_sse2(r);
+		idct_1d<__m128i, sse2_ops>(r, 2, true);
+		idct_1d<__m128i, sse2_ops>(r + 1, 2, true);
+		transpose_8x8_sse2(r);
+
+		for (int i = 0; i < 16; i++)
+			_mm_storeu_si128((__m128i*)(block + i * 4), r[i]);
+	}
+
+	static inline __m128i pack_row_sse2(const int32_t* block)
+	{
+		return _mm_packs_epi32(_mm_loadu_si128((const __m128i*)block), _mm_loadu_si128((const __m128i*)(block + 4)));
+	}
+
+	static void copy_block_sse2(const int32_t* block, uint8_t* dest, int stride)
+	{
+		for (int y = 0; y < 8; y++, block += 8, dest += stride)
+		{
+			__m128i row = pack_row_sse2(block);
+			_mm_storel_epi64((__m128i*)dest, _mm_packus_epi16(row, row));
+		}
+	}
+
+	static void add_block_sse2(const int32_t* block, uint8_t* dest, int stride)
+	{
+		// saturating steps clamp the same way as the scalar add
+		__m128i zero = _mm_setzero_si128();
+		for (int y = 0; y < 8; y++, block += 8, dest += stride)
+		{
+			__m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)dest), zero);
+			__m128i row = _mm_adds_epi16(pack_row_sse2(block), pixels);
+			_mm_storel_epi64((__m128i*)dest, _mm_packus_epi16(row, row));
+		}
+	}
+
+	template<int SIZE> static inline __m128i load_sse2(const uint8_t* src)
+	{
+		return SIZE == 16 ? _mm_loadu_si128((const __m128i*)src) : _mm_loadl_epi64((const __m128i*)src);
+	}
+
+	template<int SIZE> static inline void store_sse2(uint8_t* dest, __m128i v)
+	{
+		if (SIZE == 16)
+			_mm_storeu_si128((__m128i*)dest, v);
+		else
+			_mm_storel_epi64((__m128i*)dest, v);
+	}
+
+	template<int SIZE> static void predict_sse2(const uint8_t* src, uint8_t* dest, int stride, bool odd_h, bool odd_v)
+	{
+		__m128i zero = _mm_setzero_si128();
+		__m128i two = _mm_set1_epi16(2);
+		for (int y = 0; y < SIZE; y++, src += stride, dest += stride)
+		{
+			if (odd_h && odd_v)
+			{
+				// (a + b + c + d + 2) >> 2 needs 16 bits
+				__m128i a = load_sse2<SIZE>(src);
+				__m128i b = load_sse2<SIZE>(src + 1);
+				__m128i c = load_sse2<SIZE>(src + stride);
+				__m128i d = load_sse2<SIZE>(src + stride + 1);
+				__m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)), _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+				__m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)), _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+				lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+				hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+				store_sse2<SIZE>(dest, _mm_packus_epi16(lo, hi));
+			}
+			else if (odd_h)
+			{
+				store_sse2<SIZE>(dest, _mm_avg_epu8(load_sse2<SIZE>(src), load_sse2<SIZE>(src + 1)));
+			}
+			else if (odd_v)
+			{
+				store_sse2<SIZE>(dest, _mm_avg_epu8(load_sse2<SIZE>(src), load_sse2<SIZE>(src + stride)));
+			}
+			else
+			{
+				store_sse2<SIZE>(dest, load_sse2<SIZE>(src));
+			}
+		}
+	}
+
+	static void predict_sse2(const uint8_t* src, uint8_t* dest, int stride, int size, bool odd_h, bool odd_v)
+	{
+		if (size == 16)
+			predict_sse2<16>(src, dest, stride, odd_h, odd_v);
+		else
+			predict_sse2<8>(src, dest, stride, odd_h, odd_v);
+	}
+
+	static bool has_sse2()
+	{
+	#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+	#else
+		return __builtin_cpu_supports("sse2") != 0;
+	#endif
+	}
+
+	static const mpeg1_dsp DSP_SSE2 = { "sse2", idct_sse2, copy_block_sse2, add_block_sse2, predict_sse2 };
+#endif
+
+#ifdef CMPEG_NEON
+	struct neon_ops
+	{
+		static int32x4_t zero() { return vdupq_n_s32(0); }
+		static int32x4_t add(int32x4_t a, int32x4_t b) { return vaddq_s32(a, b); }
+		static int32x4_t sub(int32x4_t a, int32x4_t b) { return vsubq_s32(a, b); }
+		static int32x4_t mul(int32x4_t a, int32_t c) { return vmulq_n_s32(a, c); }
+		static int32x4_t round(int32x4_t a) { return vshrq_n_s32(vaddq_s32(a, vdupq_n_s32(128)), 8); }
+	};
+
+	static inline void transpose_4x4_neon(int32x4_t& a, int32x4_t& b, int32x4_t& c, int32x4_t& d)
+	{
+		int32x4x2_t ab = vtrnq_s32(a, b);
+		int32x4x2_t cd = vtrnq_s32(c, d);
+		a = vcombine_s32(vget_low_s32(ab.val[0]), vget_low_s32(cd.val[0]));
+		b = vcombine_s32(vget_low_s32(ab.val[1]), vget_low_s32(cd.val[1]));
+		c = vcombine_s32(vget_high_s32(ab.val[0]), vget_high_s32(cd.val[0]));
+		d = vcombine_s32(vget_high_s32(ab.val[1]), vget_high_s32(cd.val[1]));
+	}
+
+	// r[row * 2 + half]
+	static inline void transpose_8x8_neon(int32x4_t* r)
+	{
+		transpose_4x4_neon(r[0], r[2], r[4], r[6]);
+		transpose_4x4_neon(r[1], r[3], r[5], r[7]);
+		transpose_4x4_neon(r[8], r[10], r[12], r[14]);
+		transpose_4x4_neon(r[9], r[11], r[13], r[15]);
+		for (int i = 1; i < 8; i += 2)
+		{
+			int32x4_t t = r[i];
+			r[i] = r[i + 7];
+			r[i + 7] = t;
+		}
+	}
+
+	static void idct_neon(int32_t* block)
+	{
+		int32x4_t r[16];
+		for (int i = 0; i < 16; i++)
+			r[i] = vld1q_s32(block + i * 4);
+
+		idct_1d<int32x4_t, neon_ops>(r, 2, false);
+		idct_1d<int32x4_t, neon_ops>(r + 1, 2, false);
+		transpose_8x8_neon(r);
+		idct_1d<int32x4_t, neon_ops>(r, 2, true);
+		idct_1d<int32x4_t, neon_ops>(r + 1, 2, true);
+		transpose_8x8_neon(r);
+
+		for (int i = 0; i < 16; i++)
+			vst1q_s32(block + i * 4, r[i]);
+	}
+
+	static inline int16x8_t pack_row_neon(const int32_t* block)
+	{
+		return vcombine_s16(vqmovn_s32(vld1q_s32(block)), vqmovn_s32(vld1q_s32(block + 4)));
+	}
+
+	static void copy_block_neon(const int32_t* block, uint8_t* dest, int stride)
+	{
+		for (int y = 0; y < 8; y++, block += 8, dest += stride)
+			vst1_u8(dest, vqmovun_s16(pack_row_neon(block)));
+	}
+
+	static void add_block_neon(const int32_t* block, uint8_t* dest, int stride)
+	{
+		for (int y = 0; y < 8; y++, block += 8, dest += stride)
+		{
+			int16x8_t pixels = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(dest)));
+			vst1_u8(dest, vqmovun_s16(vqaddq_s16(pack_row_neon(block), pixels)));
+		}
+	}
+
+	static void predict_16_neon(const uint8_t* src, uint8_t* dest, int stride, bool odd_h, bool odd_v)
+	{
+		for (int y = 0; y < 16; y++, src += stride, dest += stride)
+		{
+			if (odd_h && odd_v)
+			{
+				uint8x16_t a = vld1q_u8(src);
+				uint8x16_t b = vld1q_u8(src + 1);
+				uint8x16_t c = vld1q_u8(src + stride);
+				uint8x16_t d = vld1q_u8(src + stride + 1);
+				uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)), vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+				uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)), vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+				vst1q_u8(dest, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+			}
+			else if (odd_h)
+			{
+				vst1q_u8(dest, vrhaddq_u8(vld1q_u8(src), vld1q_u8(src + 1)));
+			}
+			else if (odd_v)
+			{
+				vst1q_u8(dest, vrhaddq_u8(vld1q_u8(src), vld1q_u8(src + stride)));
+			}
+			else
+			{
+				vst1q_u8(dest, vld1q_u8(src));
+			}
+		}
+	}
+
+	static void predict_8_neon(const uint8_t* src, uint8_t* dest, int stride, bool odd_h, bool odd_v)
+	{
+		for (int y = 0; y < 8; y++, src += stride, dest += stride)
+		{
+			if (odd_h && odd_v)
+			{
+				uint16x8_t sum = vaddq_u16(vaddl_u8(vld1_u8(src), vld1_u8(src + 1)), vaddl_u8(vld1_u8(src + stride), vld1_u8(src + stride + 1)));
+				vst1_u8(dest, vrshrn_n_u16(sum, 2));
+			}
+			else if (odd_h)
+			{
+				vst1_u8(dest, vrhadd_u8(vld1_u8(src), vld1_u8(src + 1)));
+			}
+			else if (odd_v)
+			{
+				vst1_u8(dest, vrhadd_u8(vld1_u8(src), vld1_u8(src + stride)));
+			}
+			else
+			{
+				vst1_u8(dest, vld1_u8(src));
+			}
+		}
+	}
+
+	static void predict_neon(const uint8_t* src, uint8_t* dest, int stride, int size, bool odd_h, bool odd_v)
+	{
+		if (size == 16)
+			predict_16_neon(src, dest, stride, odd_h, odd_v);
+		else
+			predict_8_neon(src, dest, stride, odd_h, odd_v);
+	}
+
+	static const mpeg1_dsp DSP_NEON = { "neon", idct_neon, copy_block_neon, add_block_neon, predict_neon };
+#endif
+
+	const mpeg1_dsp* mpeg1_dsp_scalar()
+	{
+		return &DSP_SCALAR;
+	}
+
+	const mpeg1_dsp* mpeg1_dsp_detect()
+	{
+	#if defined(CMPEG_SSE2)
+		// x86 builds may run on cpus without it, arm ones are compiled for neon
+		if (has_sse2())
+			return &DSP_SSE2;
+	#elif defined(CMPEG_NEON)
+		return &DSP_NEON;
+	#endif
+
+		return &DSP_SCALAR;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace cmpeg
+{
+	// per block kernels of decoder_mpeg1. every implementation gives bit exact
+	// the same pictures as the scalar one
+	struct mpeg1_dsp
+	{
+		const char* name;
+
+		// inverse dct of the premultiplied coefficients, in place
+		void (*idct)(int32_t* block);
+
+		// clamp an 8x8 block to 0..255 and write / add it to dest
+		void (*copy_block)(const int32_t* block, uint8_t* dest, int stride);
+		void (*add_block)(const int32_t* block, uint8_t* dest, int stride);
+
+		// motion compensation of a size x size (16 or 8) block, half pel
+		// offsets average the neighbours
+		void (*predict)(const uint8_t* src, uint8_t* dest, int stride, int size, bool odd_h, bool odd_v);
+	};
+
+	// plain c++ kernels
+	const mpeg1_dsp* mpeg1_dsp_scalar();
+
+	// best kernels the cpu supports, sse2 on x86, neon on arm
+	const mpeg1_dsp* mpeg1_dsp_detect();
+}
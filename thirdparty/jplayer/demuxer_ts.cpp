@@ -14,6 +14,11 @@ namespace cmpeg
 	demuxer_ts::~demuxer_ts()
 	{
 		if (m_bits) delete m_bits; m_bits = NULL;
+
+		for (auto& it : m_pes_packet_info)
+			delete it.second;
+
+		m_pes_packet_info.clear();
 	}
 
 	void demuxer_ts::connect(uint8_t stream_id, decoder_base* decoder)
@@ -28,6 +33,18 @@ namespace cmpeg
 		while(m_bits->has(188<<3) && parse_packet()) {}
 	}
 
+	void demuxer_ts::flush()
+	{
+		// the last packet of a stream has no next payload start to complete it
+		for (auto& it : m_pes_packet_info)
+		{
+			packet_info* pi = it.second;
+			if (pi && pi->current_length) {
+				packet_complete(pi);
+			}
+		}
+	}
+
 	bool demuxer_ts::parse_packet()
 	{
 		// check if we're in sync with packet boundaries; attempt to resync if not
@@ -24,6 +24,7 @@ namespace cmpeg
 		~demuxer_ts();
 		void connect(uint8_t stream_id, decoder_base* decoder);
 		void write(const std::vector<uint8_t>& data);
+		void flush();
 		bool parse_packet();
 		bool resync();
 		void packet_complete(packet_info* pi);
@@ -558,117 +558,131 @@ dtStatus dtTileCache::update(const float /*dt*/, dtNavMesh* navmesh,
 							 bool* upToDate)
 {
 	if (m_nupdate == 0)
+		processRequests();
+	
+	dtStatus status = DT_SUCCESS;
+	// Process updates
+	if (m_nupdate)
 	{
-		// Process requests.
-		for (int i = 0; i < m_nreqs; ++i)
+		// Build mesh
+		const dtCompressedTileRef ref = m_update[0];
+		status = buildNavMeshTile(ref, navmesh);
+		removeUpdate(0);
+		completeTileUpdate(ref);
+	}
+	
+	if (upToDate)
+		*upToDate = m_nupdate == 0 && m_nreqs == 0;
+
+	return status;
+}
+
+void dtTileCache::processRequests()
+{
+	for (int i = 0; i < m_nreqs; ++i)
+	{
+		ObstacleRequest* req = &m_reqs[i];
+		
+		unsigned int idx = decodeObstacleIdObstacle(req->ref);
+		if ((int)idx >= m_params.maxObstacles)
+			continue;
+		dtTileCacheObstacle* ob = &m_obstacles[idx];
+		unsigned int salt = decodeObstacleIdSalt(req->ref);
+		if (ob->salt != salt)
+			continue;
+		
+		if (req->action == REQUEST_ADD)
 		{
-			ObstacleRequest* req = &m_reqs[i];
-			
-			unsigned int idx = decodeObstacleIdObstacle(req->ref);
-			if ((int)idx >= m_params.maxObstacles)
-				continue;
-			dtTileCacheObstacle* ob = &m_obstacles[idx];
-			unsigned int salt = decodeObstacleIdSalt(req->ref);
-			if (ob->salt != salt)
-				continue;
-			
-			if (req->action == REQUEST_ADD)
+			// Find touched tiles.
+			float bmin[3], bmax[3];
+			getObstacleBounds(ob, bmin, bmax);
+
+			int ntouched = 0;
+			queryTiles(bmin, bmax, ob->touched, &ntouched, DT_MAX_TOUCHED_TILES);
+			ob->ntouched = (unsigned char)ntouched;
+			// Add tiles to update list.
+			ob->npending = 0;
+			for (int j = 0; j < ob->ntouched; ++j)
 			{
-				// Find touched tiles.
-				float bmin[3], bmax[3];
-				getObstacleBounds(ob, bmin, bmax);
-
-				int ntouched = 0;
-				queryTiles(bmin, bmax, ob->touched, &ntouched, DT_MAX_TOUCHED_TILES);
-				ob->ntouched = (unsigned char)ntouched;
-				// Add tiles to update list.
-				ob->npending = 0;
-				for (int j = 0; j < ob->ntouched; ++j)
+				if (m_nupdate < MAX_UPDATE)
 				{
-					if (m_nupdate < MAX_UPDATE)
-					{
-						if (!contains(m_update, m_nupdate, ob->touched[j]))
-							m_update[m_nupdate++] = ob->touched[j];
-						ob->pending[ob->npending++] = ob->touched[j];
-					}
+					if (!contains(m_update, m_nupdate, ob->touched[j]))
+						m_update[m_nupdate++] = ob->touched[j];
+					ob->pending[ob->npending++] = ob->touched[j];
 				}
 			}
-			else if (req->action == REQUEST_REMOVE)
+		}
+		else if (req->action == REQUEST_REMOVE)
+		{
+			// Prepare to remove obstacle.
+			ob->state = DT_OBSTACLE_REMOVING;
+			// Add tiles to update list.
+			ob->npending = 0;
+			for (int j = 0; j < ob->ntouched; ++j)
 			{
-				// Prepare to remove obstacle.
-				ob->state = DT_OBSTACLE_REMOVING;
-				// Add tiles to update list.
-				ob->npending = 0;
-				for (int j = 0; j < ob->ntouched; ++j)
+				if (m_nupdate < MAX_UPDATE)
 				{
-					if (m_nupdate < MAX_UPDATE)
-					{
-						if (!contains(m_update, m_nupdate, ob->touched[j]))
-							m_update[m_nupdate++] = ob->touched[j];
-						ob->pending[ob->npending++] = ob->touched[j];
-					}
+					if (!contains(m_update, m_nupdate, ob->touched[j]))
+						m_update[m_nupdate++] = ob->touched[j];
+					ob->pending[ob->npending++] = ob->touched[j];
 				}
 			}
 		}
-		
-		m_nreqs = 0;
 	}
 	
-	dtStatus status = DT_SUCCESS;
-	// Process updates
-	if (m_nupdate)
-	{
-		// Build mesh
-		const dtCompressedTileRef ref = m_update[0];
-		status = buildNavMeshTile(ref, navmesh);
-		m_nupdate--;
-		if (m_nupdate > 0)
-			memmove(m_update, m_update+1, m_nupdate*sizeof(dtCompressedTileRef));
+	m_nreqs = 0;
+}
+
+void dtTileCache::removeUpdate(const int i)
+{
+	if (i < 0 || i >= m_nupdate)
+		return;
 
-		// Update obstacle states.
-		for (int i = 0; i < m_params.maxObstacles; ++i)
+	m_nupdate--;
+	if (m_nupdate > i)
+		memmove(m_update+i, m_update+i+1, (m_nupdate-i)*sizeof(dtCompressedTileRef));
+}
+
+void dtTileCache::completeTileUpdate(const dtCompressedTileRef ref)
+{
+	// Update obstacle states.
+	for (int i = 0; i < m_params.maxObstacles; ++i)
+	{
+		dtTileCacheObstacle* ob = &m_obstacles[i];
+		if (ob->state == DT_OBSTACLE_PROCESSING || ob->state == DT_OBSTACLE_REMOVING)
 		{
-			dtTileCacheObstacle* ob = &m_obstacles[i];
-			if (ob->state == DT_OBSTACLE_PROCESSING || ob->state == DT_OBSTACLE_REMOVING)
+			// Remove handled tile from pending list.
+			for (int j = 0; j < (int)ob->npending; j++)
 			{
-				// Remove handled tile from pending list.
-				for (int j = 0; j < (int)ob->npending; j++)
+				if (ob->pending[j] == ref)
 				{
-					if (ob->pending[j] == ref)
-					{
-						ob->pending[j] = ob->pending[(int)ob->npending-1];
-						ob->npending--;
-						break;
-					}
+					ob->pending[j] = ob->pending[(int)ob->npending-1];
+					ob->npending--;
+					break;
 				}
-				
-				// If all pending tiles processed, change state.
-				if (ob->npending == 0)
+			}
+			
+			// If all pending tiles processed, change state.
+			if (ob->npending == 0)
+			{
+				if (ob->state == DT_OBSTACLE_PROCESSING)
+				{
+					ob->state = DT_OBSTACLE_PROCESSED;
+				}
+				else if (ob->state == DT_OBSTACLE_REMOVING)
 				{
-					if (ob->state == DT_OBSTACLE_PROCESSING)
-					{
-						ob->state = DT_OBSTACLE_PROCESSED;
-					}
-					else if (ob->state == DT_OBSTACLE_REMOVING)
-					{
-						ob->state = DT_OBSTACLE_EMPTY;
-						// Update salt, salt should never be zero.
-						ob->salt = (ob->salt+1) & ((1<<16)-1);
-						if (ob->salt == 0)
-							ob->salt++;
-						// Return obstacle to free list.
-						ob->next = m_nextFreeObstacle;
-						m_nextFreeObstacle = ob;
-					}
+					ob->state = DT_OBSTACLE_EMPTY;
+					// Update salt, salt should never be zero.
+					ob->salt = (ob->salt+1) & ((1<<16)-1);
+					if (ob->salt == 0)
+						ob->salt++;
+					// Return obstacle to free list.
+					ob->next = m_nextFreeObstacle;
+					m_nextFreeObstacle = ob;
 				}
 			}
 		}
 	}
-	
-	if (upToDate)
-		*upToDate = m_nupdate == 0 && m_nreqs == 0;
-
-	return status;
 }
 
 
@@ -691,8 +705,25 @@ dtStatus dtTileCache::buildNavMeshTilesAt(const int tx, const int ty, dtNavMesh*
 dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh* navmesh)
 {	
 	dtAssert(m_talloc);
+	
+	unsigned char* navData = 0;
+	int navDataSize = 0;
+	dtStatus status = buildNavMeshTileData(ref, m_obstacles, m_params.maxObstacles, m_talloc, &navData, &navDataSize);
+	if (dtStatusFailed(status))
+		return status;
+
+	return addNavMeshTileData(ref, navmesh, navData, navDataSize);
+}
+
+dtStatus dtTileCache::buildNavMeshTileData(const dtCompressedTileRef ref, const dtTileCacheObstacle* obstacles, const int nobstacles,
+										   struct dtTileCacheAlloc* talloc, unsigned char** navData, int* navDataSize) const
+{
+	dtAssert(talloc);
 	dtAssert(m_tcomp);
 	
+	*navData = 0;
+	*navDataSize = 0;
+
 	unsigned int idx = decodeTileIdTile(ref);
 	if (idx > (unsigned int)m_params.maxTiles)
 		return DT_FAILURE | DT_INVALID_PARAM;
@@ -701,21 +732,21 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	if (tile->salt != salt)
 		return DT_FAILURE | DT_INVALID_PARAM;
 	
-	m_talloc->reset();
+	talloc->reset();
 	
-	NavMeshTileBuildContext bc(m_talloc);
+	NavMeshTileBuildContext bc(talloc);
 	const int walkableClimbVx = (int)(m_params.walkableClimb / m_params.ch);
 	dtStatus status;
 	
 	// Decompress tile layer data. 
-	status = dtDecompressTileCacheLayer(m_talloc, m_tcomp, tile->data, tile->dataSize, &bc.layer);
+	status = dtDecompressTileCacheLayer(talloc, m_tcomp, tile->data, tile->dataSize, &bc.layer);
 	if (dtStatusFailed(status))
 		return status;
 	
 	// Rasterize obstacles.
-	for (int i = 0; i < m_params.maxObstacles; ++i)
+	for (int i = 0; i < nobstacles; ++i)
 	{
-		const dtTileCacheObstacle* ob = &m_obstacles[i];
+		const dtTileCacheObstacle* ob = &obstacles[i];
 		if (ob->state == DT_OBSTACLE_EMPTY || ob->state == DT_OBSTACLE_REMOVING)
 			continue;
 		if (contains(ob->touched, ob->ntouched, ref))
@@ -739,32 +770,28 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	}
 	
 	// Build navmesh
-	status = dtBuildTileCacheRegions(m_talloc, *bc.layer, walkableClimbVx);
+	status = dtBuildTileCacheRegions(talloc, *bc.layer, walkableClimbVx);
 	if (dtStatusFailed(status))
 		return status;
 	
-	bc.lcset = dtAllocTileCacheContourSet(m_talloc);
+	bc.lcset = dtAllocTileCacheContourSet(talloc);
 	if (!bc.lcset)
 		return status;
-	status = dtBuildTileCacheContours(m_talloc, *bc.layer, walkableClimbVx,
+	status = dtBuildTileCacheContours(talloc, *bc.layer, walkableClimbVx,
 									  m_params.maxSimplificationError, *bc.lcset);
 	if (dtStatusFailed(status))
 		return status;
 	
-	bc.lmesh = dtAllocTileCachePolyMesh(m_talloc);
+	bc.lmesh = dtAllocTileCachePolyMesh(talloc);
 	if (!bc.lmesh)
 		return status;
-	status = dtBuildTileCachePolyMesh(m_talloc, *bc.lcset, *bc.lmesh);
+	status = dtBuildTileCachePolyMesh(talloc, *bc.lcset, *bc.lmesh);
 	if (dtStatusFailed(status))
 		return status;
 	
-	// Early out if the mesh tile is empty.
+	// Early out if the mesh tile is empty, no data removes the existing tile.
 	if (!bc.lmesh->npolys)
-	{
-		// Remove existing tile.
-		navmesh->removeTile(navmesh->getTileRefAt(tile->header->tx,tile->header->ty,tile->header->tlayer),0,0);
 		return DT_SUCCESS;
-	}
 	
 	dtNavMeshCreateParams params;
 	memset(&params, 0, sizeof(params));
@@ -792,11 +819,28 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 		m_tmproc->process(&params, bc.lmesh->areas, bc.lmesh->flags);
 	}
 	
-	unsigned char* navData = 0;
-	int navDataSize = 0;
-	if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+	if (!dtCreateNavMeshData(&params, navData, navDataSize))
 		return DT_FAILURE;
 
+	return DT_SUCCESS;
+}
+
+dtStatus dtTileCache::addNavMeshTileData(const dtCompressedTileRef ref, dtNavMesh* navmesh, unsigned char* navData, const int navDataSize)
+{
+	unsigned int idx = decodeTileIdTile(ref);
+	if (idx > (unsigned int)m_params.maxTiles)
+	{
+		dtFree(navData);
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+	const dtCompressedTile* tile = &m_tiles[idx];
+	unsigned int salt = decodeTileIdSalt(ref);
+	if (tile->salt != salt)
+	{
+		dtFree(navData);
+		return DT_FAILURE | DT_INVALID_PARAM;
+	}
+
 	// Remove existing tile.
 	navmesh->removeTile(navmesh->getTileRefAt(tile->header->tx,tile->header->ty,tile->header->tlayer),0,0);
 
@@ -804,7 +848,7 @@ dtStatus dtTileCache::buildNavMeshTile(const dtCompressedTileRef ref, dtNavMesh*
 	if (navData)
 	{
 		// Let the navmesh own the data.
-		status = navmesh->addTile(navData,navDataSize,DT_TILE_FREE_DATA,0,0);
+		dtStatus status = navmesh->addTile(navData,navDataSize,DT_TILE_FREE_DATA,0,0);
 		if (dtStatusFailed(status))
 		{
 			dtFree(navData);
@@ -175,6 +175,27 @@ public:
 	dtStatus buildNavMeshTilesAt(const int tx, const int ty, class dtNavMesh* navmesh);
 	
 	dtStatus buildNavMeshTile(const dtCompressedTileRef ref, class dtNavMesh* navmesh);
+
+	/// Builds the navmesh data of one tile without touching the navmesh, safe to call from a worker thread
+	/// as long as the tile isn't removed meanwhile and every caller uses its own allocator.
+	///  @param[in]		obstacles	Obstacles to rasterize, usually a snapshot of the touching ones.
+	///  @param[out]	navData		Tile data, null if the tile is empty. Owned by the caller.
+	dtStatus buildNavMeshTileData(const dtCompressedTileRef ref, const dtTileCacheObstacle* obstacles, const int nobstacles,
+								  struct dtTileCacheAlloc* talloc, unsigned char** navData, int* navDataSize) const;
+
+	/// Replaces the navmesh tile with data built by buildNavMeshTileData, the navmesh takes ownership of the data.
+	dtStatus addNavMeshTileData(const dtCompressedTileRef ref, class dtNavMesh* navmesh, unsigned char* navData, const int navDataSize);
+
+	/// Moves queued obstacle requests to the tile update list.
+	void processRequests();
+
+	/// Tiles waiting for a rebuild.
+	inline int getUpdateCount() const { return m_nupdate; }
+	inline dtCompressedTileRef getUpdate(const int i) const { return m_update[i]; }
+	void removeUpdate(const int i);
+
+	/// Updates obstacle states once the tile has been rebuilt.
+	void completeTileUpdate(const dtCompressedTileRef ref);
 	
 	void calcTightTileBounds(const struct dtTileCacheLayerHeader* header, float* bmin, float* bmax) const;
 	